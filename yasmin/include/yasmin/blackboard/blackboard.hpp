@@ -16,49 +16,609 @@
 #ifndef YASMIN__BLACKBOARD__BLACKBOARD_HPP
 #define YASMIN__BLACKBOARD__BLACKBOARD_HPP
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <exception>
+#include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <stdexcept>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "yasmin/blackboard/blackboard_key.hpp"
+#include "yasmin/blackboard/blackboard_storage.hpp"
 #include "yasmin/blackboard/blackboard_value.hpp"
 #include "yasmin/blackboard/blackboard_value_interface.hpp"
+#include "yasmin/blackboard/shared_memory_segment.hpp"
+#include "yasmin/blackboard/type_registry.hpp"
 #include "yasmin/logs.hpp"
 
 namespace yasmin {
 namespace blackboard {
 
+// Forward declaration
+class BlackboardTransaction;
+
 /**
  * @class Blackboard
  * @brief A thread-safe storage for key-value pairs of varying types.
  *
  * The Blackboard class allows storing, retrieving, and managing
  * values associated with string keys in a thread-safe manner using
- * a recursive mutex. Values are stored as pointers to
- * BlackboardValueInterface instances.
+ * a shared mutex: reads run in parallel and writes are exclusive. Values are
+ * BlackboardValueInterface instances built inside the entry of their key.
+ *
+ * Keys can also be resolved once into a BlackboardKey, which accesses the
+ * entry of the key directly. A BlackboardView shares the storage of a
+ * blackboard and applies its own remappings.
+ *
+ * A blackboard can be forked into another one with its own storage, which
+ * holds the changes made in the fork until they are merged back.
+ *
+ * Each key has a version that increases when it changes. Threads can wait
+ * for a key to change and callbacks can watch keys, so there is no need to
+ * poll.
+ *
+ * Groups of keys can be read and written under one lock with get_many() and
+ * set_many(), or with a BlackboardTransaction, so other threads never see a
+ * group half-written.
+ *
+ * A blackboard can be backed by a SharedMemorySegment, so the keys of its
+ * layout are shared with other processes without copies. States access them
+ * with the same API. Each shared key is updated atomically, but groups of
+ * shared keys are only atomic for the threads of this process. Watches are
+ * called for the changes made in this process, while wait_for_change() also
+ * wakes up on the changes of other processes.
+ *
+ * The blackboard estimates the memory held by each value with
+ * BlackboardValueSize. With a memory budget, the least recently used values
+ * are evicted when the values hold more bytes than the budget. Keys can also
+ * have a time to live, after which their values are stale: they are no longer
+ * returned, but is_stale() tells them apart from missing ones until they are
+ * overwritten, removed or purged.
  */
 class Blackboard {
+  friend class BlackboardTransaction;
+
 private:
-  /// Mutex for thread safety.
-  std::recursive_mutex mutex;
-  /// Storage for key-value pairs.
-  std::map<std::string, BlackboardValueInterface *> values;
-  /// Storage for type information for each key.
-  std::map<std::string, std::string> type_registry;
+  /// Storage for the entries, shared with the views of the blackboard.
+  std::shared_ptr<BlackboardStorage> storage;
+  /// Blackboard this one is a view of, nullptr if it owns its storage.
+  std::shared_ptr<Blackboard> parent;
   /// Storage for key remappings.
   std::map<std::string, std::string> remappings;
+  /// Remappings composed with the ones of the parent, for O(1) lookups.
+  std::unordered_map<std::string, std::string> resolved_remappings;
 
   /** @brief Internal method that acquires the maped key. In the case the key is
    * not remaped, retruns the arg key.
    *  @param other The instance to copy from.
    */
-  const std::string &remap(const std::string &key);
+  const std::string &remap(const std::string &key) const;
+
+  /**
+   * @brief Internal method that composes the remappings of the blackboard
+   * with the ones of its parent.
+   */
+  void resolve_remappings();
+
+  /**
+   * @brief Internal method that finds the shared memory field of a key.
+   * @param key The key, already remapped.
+   * @return The field, or nullptr if the key is not shared.
+   */
+  const SharedMemoryField *find_shared(const std::string &key) const {
+    return this->storage->segment != nullptr
+               ? this->storage->segment->find(key)
+               : nullptr;
+  }
+
+  /**
+   * @brief Internal method that finds the entry of a key in the storage.
+   * @param key The key, already remapped.
+   * @return A pointer to the entry, which may have no value, or nullptr if
+   * the key has no entry.
+   */
+  BlackboardEntry *find_entry(const std::string &key);
+
+  /**
+   * @brief Internal method that checks if an entry has a value that is not
+   * stale.
+   *
+   * With a memory budget, the access is recorded to find the least recently
+   * used value.
+   *
+   * @param entry The entry, or nullptr.
+   * @return True if the entry has a value that is not stale.
+   */
+  bool is_present(const BlackboardEntry *entry) const {
+    if (entry == nullptr || entry->value == nullptr || entry->is_stale()) {
+      return false;
+    }
+
+    if (this->storage->memory_budget != 0) {
+      this->touch(*entry);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Internal method that records an access to the value of an entry.
+   * @param entry The entry.
+   */
+  void touch(const BlackboardEntry &entry) const {
+    entry.last_access.store(
+        this->storage->access_clock.fetch_add(1, std::memory_order_relaxed) +
+            1,
+        std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Internal method that calls a function with the entry holding the
+   * value of a key.
+   *
+   * The lock of the storage must be held. In a fork, the keys that have not
+   * changed are looked up in the base storages, holding their locks while
+   * the function runs. Stale values are seen as missing.
+   *
+   * @param key The key, already remapped.
+   * @param entry The entry of the key in the storage, or nullptr.
+   * @param function The function, called with the entry or with nullptr if
+   * the key has no value.
+   * @return The result of the function.
+   */
+  template <class F>
+  auto read_entry(const std::string &key, const BlackboardEntry *entry,
+                  F &&function) {
+    if (this->storage->base == nullptr ||
+        (entry != nullptr &&
+         (entry->value != nullptr || entry->version != 0))) {
+      return function(this->is_present(entry) ? entry : nullptr);
+    }
+
+    return read_base(*this->storage->base, key, std::forward<F>(function));
+  }
+
+  /**
+   * @brief Internal method that calls a function with the entry holding the
+   * value of a key in a base storage.
+   * @param storage The base storage, which is locked while it is read.
+   * @param key The key, already remapped.
+   * @param function The function, called with the entry or with nullptr if
+   * the key has no value.
+   * @return The result of the function.
+   */
+  template <class F>
+  static auto read_base(const BlackboardStorage &storage,
+                        const std::string &key, F &&function) {
+    std::shared_lock<std::shared_mutex> lk(storage.mutex);
+    auto it = storage.entries.find(key);
+
+    if (it != storage.entries.end() &&
+        (it->second.value != nullptr || it->second.version != 0)) {
+      return function(it->second.value != nullptr && !it->second.is_stale()
+                          ? &it->second
+                          : nullptr);
+    }
+
+    if (storage.base != nullptr) {
+      return read_base(*storage.base, key, std::forward<F>(function));
+    }
+
+    return function(nullptr);
+  }
+
+  /**
+   * @brief Internal method that collects the entries with a value of a
+   * storage and its bases.
+   *
+   * The lock of the storage must be held. The locks of the bases are added
+   * to the list, so the entries stay valid while it exists.
+   *
+   * @param storage The storage.
+   * @param entries The entries of each key.
+   * @param locks The locks of the bases.
+   */
+  static void
+  collect_entries(const BlackboardStorage &storage,
+                  std::map<std::string, const BlackboardEntry *> &entries,
+                  std::vector<std::shared_lock<std::shared_mutex>> &locks);
+
+  /**
+   * @brief Internal method that gets the value of an entry.
+   * @tparam T The type of the value.
+   * @param name The key of the entry, used in the error messages.
+   * @param entry The entry of the key.
+   * @return A pointer to the value.
+   * @throws std::runtime_error if the entry has no value or it is of another
+   * type.
+   */
+  template <class T>
+  static BlackboardValue<T> *get_value(const std::string &name,
+                                       const BlackboardEntry *entry) {
+    if (entry == nullptr || entry->value == nullptr) {
+      throw std::runtime_error("Element '" + name +
+                               "' does not exist in the blackboard");
+    }
+
+    auto *b_value = dynamic_cast<BlackboardValue<T> *>(entry->value.get());
+
+    if (b_value == nullptr) {
+      throw std::runtime_error(
+          "Element '" + name + "' is of type '" +
+          TypeRegistry::get_name(entry->value->get_type_index()) +
+          "' in the blackboard");
+    }
+
+    return b_value;
+  }
+
+  /**
+   * @brief Internal method that stores a value in an entry.
+   *
+   * If the entry already holds a value of the same type, it is overwritten in
+   * place without allocating. Otherwise, the old value is freed and a new one
+   * is built in the entry.
+   *
+   * @tparam T The type of the value.
+   * @param entry The entry of the key.
+   * @param value The value to store.
+   */
+  template <class T> void set_value(BlackboardEntry &entry, T &&value) {
+    using ValueType = std::decay_t<T>;
+
+    if (entry.value != nullptr &&
+        typeid(*entry.value) == typeid(BlackboardValue<ValueType>)) {
+      static_cast<BlackboardValue<ValueType> *>(entry.value.get())
+          ->set(std::forward<T>(value));
+
+    } else {
+      if (entry.value == nullptr) {
+        this->storage->num_values++;
+      }
+
+      // The value of the old type is freed first
+      entry.value.emplace<BlackboardValue<ValueType>>(std::forward<T>(value));
+    }
+
+    this->bump_version(entry);
+    this->account_value(entry);
+  }
+
+  /**
+   * @brief Internal method that records a change of an entry.
+   *
+   * The lock of the storage must be held. The new version is higher than
+   * the ones of the erased entries, so a key that was erased and set again
+   * does not get back a version it had.
+   *
+   * @param entry The changed entry.
+   */
+  void bump_version(BlackboardEntry &entry) {
+    entry.version =
+        std::max(entry.version, this->storage->erased_version) + 1;
+  }
+
+  /**
+   * @brief Internal method that erases an entry without value.
+   *
+   * The lock of the storage must be held. The entry is kept if a key handle
+   * points to it, if the key has a time to live, or if the storage is a
+   * fork, where the entry hides the value of the base.
+   *
+   * @param it The entry.
+   * @return True if the entry was erased.
+   */
+  bool erase_entry(std::map<std::string, BlackboardEntry>::iterator it);
+
+  /**
+   * @brief Internal method that updates the size, expiration and last
+   * access of a value that was set, evicting other values if the memory
+   * budget is exceeded.
+   *
+   * The lock of the storage must be held.
+   *
+   * @param entry The entry of the value.
+   */
+  void account_value(BlackboardEntry &entry);
+
+  /**
+   * @brief Internal method that frees the value of an entry.
+   *
+   * The lock of the storage must be held. The version of the entry is not
+   * changed.
+   *
+   * @param entry The entry, which may have no value.
+   */
+  void clear_value(BlackboardEntry &entry);
+
+  /**
+   * @brief Internal method that evicts the least recently used values until
+   * the memory budget is met.
+   *
+   * The lock of the storage must be held. Stale values are purged first.
+   *
+   * @param keep The entry that must not be evicted, or nullptr.
+   */
+  void enforce_budget(const BlackboardEntry *keep);
+
+  /**
+   * @brief Internal method that removes the stale values of the storage.
+   *
+   * The lock of the storage must be held.
+   *
+   * @return The keys of the removed values.
+   */
+  std::vector<std::string> purge_stale_values();
+
+  /**
+   * @brief Internal method that stores the value of a key, in the shared
+   * memory segment if the key is shared.
+   *
+   * The lock of the storage must be held.
+   *
+   * @tparam T The type of the value.
+   * @param key The key, already remapped.
+   * @param value The value to store.
+   * @throws std::runtime_error if the key is shared with another type.
+   */
+  template <class T> void write_value(const std::string &key, T &&value) {
+    if (this->find_shared(key) != nullptr) {
+      this->storage->segment->store(key, value);
+      return;
+    }
+
+    this->set_value(this->storage->entries[key], std::forward<T>(value));
+  }
+
+  /**
+   * @brief Internal method that stores the value of a key handle.
+   *
+   * The lock of the storage must be held.
+   *
+   * @tparam T The type of the value.
+   * @param key The key handle.
+   * @param value The value to store.
+   * @throws std::runtime_error if the key is shared with another type.
+   */
+  template <class T> void write_value(const BlackboardKey<T> &key, T &&value) {
+    if (key.shared) {
+      this->storage->segment->store(key.get_name(), value);
+      return;
+    }
+
+    if (key.storage == this->storage) {
+      this->set_value(*key.entry, std::move(value));
+    } else {
+      // A key of a base is written in the fork
+      this->set_value(this->storage->entries[key.get_name()],
+                      std::move(value));
+    }
+  }
+
+  /**
+   * @brief Internal method that reads the value of a key, from the shared
+   * memory segment if the key is shared.
+   *
+   * The lock of the storage must be held.
+   *
+   * @tparam T The type of the value.
+   * @param key The key, used in the error messages.
+   * @param name The key, already remapped.
+   * @return A copy of the value.
+   * @throws std::runtime_error if the key does not exist or its value is of
+   * another type.
+   */
+  template <class T> T read_value(const std::string &key,
+                                  const std::string &name) {
+    if (this->find_shared(name) != nullptr) {
+      return this->storage->segment->load<T>(name);
+    }
+
+    return this->read_entry(
+        name, this->find_entry(name), [&key](const BlackboardEntry *entry) {
+          return get_value<T>(key, entry)->get();
+        });
+  }
+
+  /**
+   * @brief Internal method that reads the value of a key handle.
+   *
+   * The lock of the storage must be held.
+   *
+   * @tparam T The type of the value.
+   * @param key The key handle.
+   * @return A copy of the value.
+   * @throws std::runtime_error if the key does not exist or its value is of
+   * another type.
+   */
+  template <class T> T read_value(const BlackboardKey<T> &key) {
+    if (key.shared) {
+      return this->storage->segment->load<T>(key.get_name());
+    }
+
+    return this->read_entry(key.get_name(), this->find_key_entry(key),
+                            [&key](const BlackboardEntry *entry) {
+                              return get_value<T>(key.get_name(), entry)->get();
+                            });
+  }
+
+  /**
+   * @brief Internal method that calls a function with the value of a key of
+   * any type.
+   *
+   * The lock of the storage must be held. Shared values are copied into a
+   * temporary holder.
+   *
+   * @param key The key, used in the error messages.
+   * @param name The key, already remapped.
+   * @param function The function, which receives the value as a
+   * BlackboardValueInterface.
+   * @return The result of the function.
+   * @throws std::runtime_error if the key does not exist.
+   */
+  template <class F>
+  auto visit_value(const std::string &key, const std::string &name,
+                   F &&function) {
+    if (const SharedMemoryField *field = this->find_shared(name)) {
+      BlackboardValueHolder value;
+      field->load(*this->storage->segment, name, value);
+      return function(static_cast<const BlackboardValueInterface &>(*value));
+    }
+
+    return this->read_entry(
+        name, this->find_entry(name), [&](const BlackboardEntry *entry) {
+          if (entry == nullptr) {
+            throw std::runtime_error("Element '" + key +
+                                     "' does not exist in the blackboard");
+          }
+          return function(
+              static_cast<const BlackboardValueInterface &>(*entry->value));
+        });
+  }
+
+  /**
+   * @brief Internal method that removes the value of a key.
+   *
+   * The lock of the storage must be held.
+   *
+   * @param key The key, used in the error messages.
+   * @param name The key, already remapped.
+   * @throws std::runtime_error if the key does not exist.
+   */
+  void remove_value(const std::string &key, const std::string &name);
+
+  /**
+   * @brief Internal method that gets the version of a key.
+   *
+   * The lock of the storage must be held.
+   *
+   * @param key The key, already remapped.
+   * @return The number of times the key has changed in the storage and its
+   * bases, 0 if it never changed.
+   */
+  std::uint64_t read_version(const std::string &key);
+
+  /**
+   * @brief Internal method that notifies the change of a key.
+   *
+   * The lock of the storage must be held and it is released if there are
+   * watchers.
+   *
+   * @param key The key, already remapped.
+   * @param lk The lock of the storage.
+   */
+  void notify_change(const std::string &key,
+                     std::unique_lock<std::shared_mutex> &lk) {
+    if (this->storage->num_watchers.load() != 0) {
+      this->notify_changes({key}, lk);
+    }
+  }
+
+  /**
+   * @brief Internal method that wakes up the threads waiting for changes and
+   * calls the watches of the changed keys.
+   *
+   * The lock of the storage must be held. It is released before calling the
+   * watches, so they can access the blackboard. The keys evicted since the
+   * last notification are also notified, and the threads waiting in the
+   * forks of the storage are woken up too.
+   *
+   * @param keys The changed keys, already remapped.
+   * @param lk The lock of the storage.
+   */
+  void notify_changes(const std::vector<std::string> &keys,
+                      std::unique_lock<std::shared_mutex> &lk);
+
+  /**
+   * @brief Internal method that registers a thread waiting in this fork in
+   * its bases, so their changes wake it up.
+   *
+   * It must be called without holding the lock of the storage, since the
+   * bases lock it to notify it.
+   */
+  void add_waiting_fork();
+
+  /**
+   * @brief Internal method that removes a thread waiting in this fork from
+   * its bases.
+   *
+   * It must be called without holding the lock of the storage.
+   */
+  void remove_waiting_fork();
+
+  /**
+   * @brief Internal method that checks if a key handle belongs to this
+   * blackboard.
+   * @param key The key handle.
+   * @throws std::invalid_argument if the key belongs to another blackboard.
+   */
+  template <class T> void check_key(const BlackboardKey<T> &key) const {
+    // The keys of the bases can be used in their forks
+    for (const BlackboardStorage *storage = this->storage.get();
+         storage != nullptr; storage = storage->base.get()) {
+      if (key.storage.get() == storage) {
+        return;
+      }
+    }
+
+    throw std::invalid_argument("Key '" + key.get_name() +
+                                "' does not belong to this blackboard");
+  }
+
+  /**
+   * @brief Internal method that finds the entry of a key handle in this
+   * storage.
+   *
+   * The lock of the storage must be held. The handles of a base are looked
+   * up by name, since their entry belongs to the base.
+   *
+   * @param key The key handle, which belongs to this blackboard.
+   * @return The entry, or nullptr if a key of a base is not in the fork.
+   */
+  template <class T>
+  BlackboardEntry *find_key_entry(const BlackboardKey<T> &key) {
+    if (key.storage == this->storage) {
+      return key.entry;
+    }
+    return this->find_entry(key.get_name());
+  }
+
+protected:
+  /**
+   * @brief Constructor for a view of a blackboard.
+   * @param parent The blackboard whose storage is shared.
+   * @param remappings The remappings of the view, applied before the ones of
+   * the parent.
+   */
+  Blackboard(std::shared_ptr<Blackboard> parent,
+             const std::map<std::string, std::string> &remappings);
 
 public:
   /** @brief Default constructor for Blackboard. */
   Blackboard();
 
+  /**
+   * @brief Constructor for a blackboard backed by a shared memory segment.
+   *
+   * The keys of the layout of the segment are stored in it and shared with
+   * the other processes that open it. The other keys are stored in this
+   * process.
+   *
+   * @param segment The shared memory segment.
+   */
+  explicit Blackboard(std::shared_ptr<SharedMemorySegment> segment);
+
   /** @brief Copy constructor for Blackboard.
    *  @param other The instance to copy from.
    */
@@ -69,6 +629,10 @@ public:
 
   /**
    * @brief Set a value in the blackboard.
+   *
+   * The value is moved into the blackboard, so passing an rvalue hands over
+   * its buffers without copying them.
+   *
    * @tparam T The type of the value to store.
    * @param name The key to associate with the value.
    * @param value The value to store.
@@ -77,29 +641,30 @@ public:
 
     YASMIN_LOG_DEBUG("Setting '%s' in the blackboard", name.c_str());
 
-    std::lock_guard<std::recursive_mutex> lk(this->mutex);
-
-    BlackboardValue<T> *b_value = new BlackboardValue<T>(value);
+    std::unique_lock<std::shared_mutex> lk(this->storage->mutex);
 
     // Apply remapping if exists
-    std::string key = this->remap(name);
+    const std::string &key = this->remap(name);
+    this->write_value(key, std::move(value));
+    this->notify_change(key, lk);
+  }
 
-    // If the type is changing, remove the old entry first
-    if (this->type_registry.find(key) != this->type_registry.end()) {
-      this->values.erase(key);
-      this->type_registry.erase(key);
-    }
+  /**
+   * @brief Set a value in the blackboard through a key handle.
+   * @tparam T The type of the value to store.
+   * @param key The key handle to associate with the value.
+   * @param value The value to store.
+   * @throws std::invalid_argument if the key belongs to another blackboard.
+   */
+  template <class T> void set(const BlackboardKey<T> &key, T value) {
 
-    // Insert or update the value
-    if (!this->contains(key)) {
-      this->values.insert({key, b_value});
-      this->type_registry.insert({key, b_value->get_type()});
+    YASMIN_LOG_DEBUG("Setting '%s' in the blackboard",
+                     key.get_name().c_str());
 
-    } else {
-      b_value = (BlackboardValue<T> *)this->values.at(key);
-      b_value->set(value);
-      this->type_registry[key] = b_value->get_type();
-    }
+    this->check_key(key);
+    std::unique_lock<std::shared_mutex> lk(this->storage->mutex);
+    this->write_value(key, std::move(value));
+    this->notify_change(key.get_name(), lk);
   }
 
   /**
@@ -107,22 +672,234 @@ public:
    * @tparam T The type of the value to retrieve.
    * @param name The key associated with the value.
    * @return The value associated with the specified key.
-   * @throws std::runtime_error if the key does not exist.
+   * @throws std::runtime_error if the key does not exist or its value is of
+   * another type.
    */
   template <class T> T get(const std::string &key) {
 
     YASMIN_LOG_DEBUG("Getting '%s' from the blackboard", key.c_str());
 
-    std::lock_guard<std::recursive_mutex> lk(this->mutex);
+    std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+    return this->read_value<T>(key, this->remap(key));
+  }
+
+  /**
+   * @brief Retrieve a value from the blackboard through a key handle.
+   * @tparam T The type of the value to retrieve.
+   * @param key The key handle associated with the value.
+   * @return The value associated with the specified key.
+   * @throws std::runtime_error if the key does not exist or its value is of
+   * another type.
+   * @throws std::invalid_argument if the key belongs to another blackboard.
+   */
+  template <class T> T get(const BlackboardKey<T> &key) {
+
+    YASMIN_LOG_DEBUG("Getting '%s' from the blackboard",
+                     key.get_name().c_str());
 
-    if (!this->contains(key)) {
-      throw std::runtime_error("Element '" + key +
-                               "' does not exist in the blackboard");
+    this->check_key(key);
+    std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+    return this->read_value(key);
+  }
+
+  /**
+   * @brief Set several values of the same type under one lock.
+   *
+   * The other threads see all the values or none of them.
+   *
+   * @tparam T The type of the values to store.
+   * @param values The values of each key.
+   */
+  template <class T>
+  void set_many(const std::map<std::string, T> &values) {
+
+    YASMIN_LOG_DEBUG("Setting %zu keys in the blackboard", values.size());
+
+    std::unique_lock<std::shared_mutex> lk(this->storage->mutex);
+
+    // The changed keys are only kept if there are watchers, which cannot
+    // change while the blackboard is locked
+    const bool notify = this->storage->num_watchers.load() != 0;
+    std::vector<std::string> keys;
+
+    for (const auto &[name, value] : values) {
+      const std::string &key = this->remap(name);
+      this->write_value(key, value);
+      if (notify) {
+        keys.push_back(key);
+      }
+    }
+
+    if (notify) {
+      this->notify_changes(keys, lk);
+    }
+  }
+
+  /**
+   * @brief Retrieve several values of the same type under one lock.
+   * @tparam T The type of the values to retrieve.
+   * @param keys The keys associated with the values.
+   * @return The values, in the order of the keys.
+   * @throws std::runtime_error if a key does not exist or its value is of
+   * another type.
+   */
+  template <class T>
+  std::vector<T> get_many(const std::vector<std::string> &keys) {
+
+    YASMIN_LOG_DEBUG("Getting %zu keys from the blackboard", keys.size());
+
+    std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+    std::vector<T> values;
+    values.reserve(keys.size());
+
+    for (const std::string &key : keys) {
+      values.push_back(this->read_value<T>(key, this->remap(key)));
+    }
+
+    return values;
+  }
+
+  /**
+   * @brief Retrieve the values of several key handles under one lock.
+   *
+   * The values can be of different types, like a pose with its covariance
+   * and timestamp.
+   *
+   * @tparam Ts The types of the values to retrieve.
+   * @param keys The key handles associated with the values.
+   * @return The values, in the order of the keys.
+   * @throws std::runtime_error if a key does not exist or its value is of
+   * another type.
+   * @throws std::invalid_argument if a key belongs to another blackboard.
+   */
+  template <class... Ts>
+  std::tuple<Ts...> get_many(const BlackboardKey<Ts> &...keys) {
+    (this->check_key(keys), ...);
+    std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+
+    // Braced initialization reads the keys in order
+    return std::tuple<Ts...>{this->read_value(keys)...};
+  }
+
+  /**
+   * @brief Call a function with a value of any type while the blackboard is
+   * locked.
+   *
+   * The function must not access the blackboard, which is locked.
+   *
+   * @param key The key associated with the value.
+   * @param function The function, which receives the value as a
+   * BlackboardValueInterface.
+   * @return The result of the function.
+   * @throws std::runtime_error if the key does not exist.
+   */
+  template <class F> auto visit(const std::string &key, F &&function) {
+    std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+    return this->visit_value(key, this->remap(key),
+                             std::forward<F>(function));
+  }
+
+  /**
+   * @brief Retrieve a snapshot of a value from the blackboard without
+   * copying it.
+   *
+   * The snapshot keeps the value alive and unchanged after the key is
+   * overwritten or removed. While a snapshot exists, the next write to the
+   * key allocates a new value instead of writing in place. Shared values
+   * are copied out of the shared memory segment, since other processes can
+   * overwrite them.
+   *
+   * @tparam T The type of the value to retrieve.
+   * @param key The key associated with the value.
+   * @return A shared pointer to the value.
+   * @throws std::runtime_error if the key does not exist or its value is of
+   * another type.
+   */
+  template <class T>
+  std::shared_ptr<const T> get_shared(const std::string &key) {
+
+    YASMIN_LOG_DEBUG("Getting '%s' from the blackboard", key.c_str());
+
+    std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+    const std::string &name = this->remap(key);
+
+    if (this->find_shared(name) != nullptr) {
+      return std::make_shared<const T>(
+          this->storage->segment->load<T>(name));
+    }
+
+    return this->read_entry(
+        name, this->find_entry(name), [&key](const BlackboardEntry *entry) {
+          return get_value<T>(key, entry)->get_shared();
+        });
+  }
+
+  /**
+   * @brief Retrieve a snapshot of a value through a key handle without
+   * copying it.
+   * @tparam T The type of the value to retrieve.
+   * @param key The key handle associated with the value.
+   * @return A shared pointer to the value.
+   * @throws std::runtime_error if the key does not exist or its value is of
+   * another type.
+   * @throws std::invalid_argument if the key belongs to another blackboard.
+   */
+  template <class T>
+  std::shared_ptr<const T> get_shared(const BlackboardKey<T> &key) {
+
+    YASMIN_LOG_DEBUG("Getting '%s' from the blackboard",
+                     key.get_name().c_str());
+
+    this->check_key(key);
+    std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+
+    if (key.shared) {
+      return std::make_shared<const T>(
+          this->storage->segment->load<T>(key.get_name()));
     }
 
-    BlackboardValue<T> *b_value =
-        (BlackboardValue<T> *)this->values.at(this->remap(key));
-    return b_value->get();
+    return this->read_entry(
+        key.get_name(), this->find_key_entry(key),
+        [&key](const BlackboardEntry *entry) {
+          return get_value<T>(key.get_name(), entry)->get_shared();
+        });
+  }
+
+  /**
+   * @brief Resolve a key into a handle.
+   *
+   * The remappings active when the handle is created are applied. The key
+   * does not need to have a value yet.
+   *
+   * @tparam T The type of the value.
+   * @param name The key to resolve.
+   * @return The key handle.
+   */
+  template <class T> BlackboardKey<T> get_key(const std::string &name) {
+    std::lock_guard<std::shared_mutex> lk(this->storage->mutex);
+    const std::string &key = this->remap(name);
+    return BlackboardKey<T>(this->storage, key,
+                            &this->storage->entries[key],
+                            this->find_shared(key) != nullptr);
+  }
+
+  /**
+   * @brief Check if a key handle has a value in the blackboard.
+   * @param key The key handle to check.
+   * @return True if the key exists, false otherwise.
+   * @throws std::invalid_argument if the key belongs to another blackboard.
+   */
+  template <class T> bool contains(const BlackboardKey<T> &key) {
+    this->check_key(key);
+    std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+
+    if (key.shared) {
+      return this->storage->segment->contains(key.get_name());
+    }
+
+    return this->read_entry(
+        key.get_name(), this->find_key_entry(key),
+        [](const BlackboardEntry *entry) { return entry != nullptr; });
   }
 
   /**
@@ -152,14 +929,194 @@ public:
    */
   std::string get_type(const std::string &key);
 
+  /**
+   * @brief Get the type of a value stored in the blackboard.
+   *
+   * Unlike get_type(), the name of the type is not built.
+   *
+   * @param key The key associated with the value.
+   * @return The type index of the value.
+   * @throws std::runtime_error if the key does not exist.
+   */
+  std::type_index get_type_index(const std::string &key);
+
   /**
    * @brief Convert the contents of the blackboard to a string.
    * @return A string representation of the blackboard.
    */
   std::string to_string();
 
+  /**
+   * @brief Get the version of a key.
+   *
+   * The version increases each time the key is set or removed, so it can be
+   * passed to wait_for_change() without missing the changes made in between.
+   * In a fork, it also counts the changes of the key in the base.
+   *
+   * @param key The key.
+   * @return The version of the key, 0 if it has not changed.
+   */
+  std::uint64_t get_version(const std::string &key);
+
+  /**
+   * @brief Wait until a key changes or a deadline passes.
+   *
+   * In a fork, the changes of the key in the base also end the wait.
+   *
+   * @param key The key.
+   * @param version The version of the key already seen, from get_version().
+   * @param deadline The time to stop waiting.
+   * @return True if the version of the key is no longer the given one, false
+   * if the deadline passed.
+   */
+  bool wait_for_change(const std::string &key, std::uint64_t version,
+                       std::chrono::steady_clock::time_point deadline);
+
+  /**
+   * @brief Wait until a key changes or a timeout passes.
+   * @param key The key.
+   * @param version The version of the key already seen, from get_version().
+   * @param timeout The maximum time to wait.
+   * @return True if the version of the key is no longer the given one, false
+   * if the timeout passed.
+   */
+  bool wait_for_change(const std::string &key, std::uint64_t version,
+                       std::chrono::nanoseconds timeout);
+
+  /**
+   * @brief Add a callback called each time a key is set or removed.
+   *
+   * The callback runs in the thread that changed the key, after the
+   * blackboard is unlocked. Changes made in a fork are notified when the fork
+   * is merged.
+   *
+   * @param key The key to watch.
+   * @param callback The callback, which receives the key.
+   * @return The identifier of the watch.
+   */
+  std::size_t add_watch(const std::string &key,
+                        std::function<void(const std::string &)> callback);
+
+  /**
+   * @brief Remove a callback added with add_watch().
+   * @param id The identifier of the watch.
+   * @return True if the watch was removed, false if it did not exist.
+   */
+  bool remove_watch(std::size_t id);
+
+  /**
+   * @brief Get the estimated memory held by the values of the blackboard.
+   *
+   * In a fork, only the values set in the fork are counted.
+   *
+   * @return The number of bytes.
+   */
+  std::size_t get_memory_usage();
+
+  /**
+   * @brief Get the estimated memory held by the value of a key.
+   * @param key The key.
+   * @return The number of bytes, 0 if the key has no value.
+   */
+  std::size_t get_memory_usage(const std::string &key);
+
+  /**
+   * @brief Set the maximum memory held by the values of the blackboard.
+   *
+   * When a value is set and the values hold more bytes than the budget, the
+   * stale values are removed and then the least recently used ones are
+   * evicted, as if they were removed. The value just set is never evicted.
+   * Finding the least recently used value takes a pass over the keys, so the
+   * budget is meant to be exceeded rarely.
+   *
+   * @param budget The number of bytes, 0 for no limit.
+   */
+  void set_memory_budget(std::size_t budget);
+
+  /**
+   * @brief Get the maximum memory held by the values of the blackboard.
+   * @return The number of bytes, 0 if there is no limit.
+   */
+  std::size_t get_memory_budget();
+
+  /**
+   * @brief Set the time to live of the values of a key.
+   *
+   * Each value set to the key becomes stale after the time to live, and the
+   * current value expires the time to live from now. Stale values are seen as
+   * missing.
+   *
+   * @param key The key.
+   * @param ttl The time to live, 0 for values that do not expire.
+   * @throws std::invalid_argument if the key is shared with other processes.
+   */
+  void set_ttl(const std::string &key, std::chrono::nanoseconds ttl);
+
+  /**
+   * @brief Check if the value of a key is stale.
+   * @param key The key.
+   * @return True if the key has a value whose time to live has passed, false
+   * if its value is fresh or it has no value.
+   */
+  bool is_stale(const std::string &key);
+
+  /**
+   * @brief Remove the stale values, freeing their memory.
+   *
+   * The watches of the keys are called as if they were removed.
+   *
+   * @return The number of values removed.
+   */
+  std::size_t purge_stale();
+
+  /**
+   * @brief Get the shared memory segment of the blackboard.
+   * @return The segment, or nullptr if the blackboard has none.
+   */
+  std::shared_ptr<SharedMemorySegment> get_segment() const {
+    return this->storage->segment;
+  }
+
+  /**
+   * @brief Create a copy-on-write fork of the blackboard.
+   *
+   * The fork has its own storage and lock and keeps the remappings of this
+   * blackboard. It only stores the keys set or removed in it and reads the
+   * other ones from this blackboard, so forking does not copy anything and
+   * the keys not changed in the fork show the current values of this one.
+   * Shared keys are not forked: they are written directly to the segment.
+   *
+   * @return The fork.
+   */
+  std::shared_ptr<Blackboard> fork();
+
+  /**
+   * @brief Get the keys set or removed in a fork since it was created.
+   * @return The remapped keys, sorted.
+   */
+  std::vector<std::string> get_changes();
+
+  /**
+   * @brief Merge the changes of a fork into this blackboard.
+   *
+   * The values of the keys are shared with the fork and the keys removed in
+   * the fork are removed here. The key handles of this blackboard remain
+   * valid.
+   *
+   * @param fork A fork of this blackboard or of a view of it.
+   * @param keys The keys to merge, as returned by get_changes().
+   * @throws std::invalid_argument if the blackboard was not forked from this
+   * one.
+   */
+  void merge(Blackboard &fork, const std::vector<std::string> &keys);
+
   /**
    * @brief Set the remappings of the blackboard.
+   *
+   * In a view, the remappings are applied before the ones of its parent.
+   * State machines give each state a BlackboardView instead of changing the
+   * remappings of the shared blackboard.
+   *
    * @param remappings The remappings to set.
    */
   void set_remappings(const std::map<std::string, std::string> &remappings);
@@ -171,6 +1128,28 @@ public:
   const std::map<std::string, std::string> &get_remappings();
 };
 
+/**
+ * @class BlackboardView
+ * @brief A blackboard that shares the storage of another one with its own
+ * remappings.
+ *
+ * The remappings are resolved against the ones of the parent when the view is
+ * created, so each access takes a single hash lookup and no shared state is
+ * modified. Views are cheap to create and can be nested.
+ */
+class BlackboardView : public Blackboard {
+public:
+  /**
+   * @brief Constructs a BlackboardView.
+   * @param parent The blackboard whose storage is shared.
+   * @param remappings The remappings of the view, applied before the ones of
+   * the parent.
+   */
+  BlackboardView(std::shared_ptr<Blackboard> parent,
+                 const std::map<std::string, std::string> &remappings)
+      : Blackboard(parent, remappings) {}
+};
+
 } // namespace blackboard
 } // namespace yasmin
 
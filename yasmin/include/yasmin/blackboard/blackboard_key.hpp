@@ -0,0 +1,147 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef YASMIN__BLACKBOARD__BLACKBOARD_KEY_HPP
+#define YASMIN__BLACKBOARD__BLACKBOARD_KEY_HPP
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "yasmin/blackboard/blackboard_storage.hpp"
+
+namespace yasmin {
+namespace blackboard {
+
+class Blackboard;
+class BlackboardTransaction;
+
+/**
+ * @class BlackboardKey
+ * @brief Typed handle of a blackboard key, resolved once.
+ *
+ * A key handle is obtained with Blackboard::get_key(). It applies the
+ * remappings active when it is created and points directly to the storage
+ * slot of the key, so accessing the value through it takes no string lookup.
+ * The value is checked to be of type T on each access. A handle can be used
+ * with the blackboard that created it, with the views that share its
+ * storage and with their forks, where it is looked up by name. The handle
+ * keeps the storage alive, and the slot of the key is not erased while a
+ * handle points to it.
+ *
+ * @tparam T The type of the value.
+ */
+template <class T> class BlackboardKey {
+
+  friend class Blackboard;
+  friend class BlackboardTransaction;
+
+private:
+  /// The storage the key belongs to.
+  std::shared_ptr<const BlackboardStorage> storage;
+  /// The resolved name of the key.
+  std::string name;
+  /// The storage slot of the key.
+  BlackboardEntry *entry;
+  /// Flag to indicate if the value is in the shared memory segment of the
+  /// storage instead of in the entry.
+  bool shared;
+
+  /**
+   * @brief Constructs a resolved BlackboardKey.
+   * @param storage The storage the key belongs to.
+   * @param name The resolved name of the key.
+   * @param entry The storage slot of the key.
+   * @param shared Flag to indicate if the key is in the shared memory
+   * segment of the storage.
+   */
+  BlackboardKey(std::shared_ptr<const BlackboardStorage> storage,
+                const std::string &name, BlackboardEntry *entry, bool shared)
+      : storage(std::move(storage)), name(name), entry(entry),
+        shared(shared) {
+    this->acquire();
+  }
+
+  /** @brief Internal method that counts the handle in its entry. */
+  void acquire() {
+    if (this->entry != nullptr) {
+      this->entry->num_handles.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief Internal method that stops counting the handle in its entry.
+   *
+   * The release pairs with the acquire of the blackboard before erasing the
+   * entry.
+   */
+  void release() {
+    if (this->entry != nullptr) {
+      this->entry->num_handles.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+public:
+  /** @brief Constructs an unresolved BlackboardKey. */
+  BlackboardKey() : entry(nullptr), shared(false) {}
+
+  /**
+   * @brief Copy constructor for BlackboardKey.
+   * @param other The key to copy.
+   */
+  BlackboardKey(const BlackboardKey &other)
+      : storage(other.storage), name(other.name), entry(other.entry),
+        shared(other.shared) {
+    this->acquire();
+  }
+
+  /**
+   * @brief Copy assignment operator for BlackboardKey.
+   * @param other The key to copy.
+   * @return A reference to this key.
+   */
+  BlackboardKey &operator=(const BlackboardKey &other) {
+    if (this != &other) {
+      // The other key may point to the same entry
+      BlackboardKey copy(other);
+      std::swap(this->storage, copy.storage);
+      std::swap(this->name, copy.name);
+      std::swap(this->entry, copy.entry);
+      std::swap(this->shared, copy.shared);
+    }
+    return *this;
+  }
+
+  /** @brief Destroys the BlackboardKey. */
+  ~BlackboardKey() { this->release(); }
+
+  /**
+   * @brief Gets the resolved name of the key.
+   * @return The name of the key after applying the remappings.
+   */
+  const std::string &get_name() const { return this->name; }
+
+  /**
+   * @brief Checks if the key has been resolved.
+   * @return True if the key belongs to a blackboard, otherwise false.
+   */
+  bool is_valid() const { return this->entry != nullptr; }
+};
+
+} // namespace blackboard
+} // namespace yasmin
+
+#endif // YASMIN__BLACKBOARD__BLACKBOARD_KEY_HPP
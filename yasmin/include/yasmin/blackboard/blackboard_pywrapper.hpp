@@ -16,19 +16,28 @@
 #ifndef YASMIN__BLACKBOARD__BLACKBOARD_PYWRAPPER_HPP
 #define YASMIN__BLACKBOARD__BLACKBOARD_PYWRAPPER_HPP
 
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <list>
 #include <map>
+#include <memory>
 #include <pybind11/cast.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <string>
 #include <tuple>
 #include <type_traits>
+#include <typeindex>
 #include <typeinfo>
 #include <vector>
 
 #include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/blackboard/blackboard_snapshot.hpp"
+#include "yasmin/blackboard/blackboard_transaction.hpp"
 #include "yasmin/blackboard/blackboard_value.hpp"
+#include "yasmin/blackboard/py_converter_registry.hpp"
 
 namespace py = pybind11;
 
@@ -52,52 +61,124 @@ private:
   /// @brief Underlying C++ Blackboard instance
   std::shared_ptr<Blackboard> blackboard;
 
-public:
-  BlackboardPyWrapper() : blackboard(std::make_shared<Blackboard>()) {}
-
   /**
-   * @brief Construct from an existing C++ Blackboard (move constructor)
+   * @brief Set a one-dimensional NumPy array as a vector of its elements.
+   * @tparam T The type of the elements.
+   * @tparam B The Blackboard or BlackboardTransaction to write.
+   * @param target The Blackboard or BlackboardTransaction to write.
+   * @param key The key to associate with the value.
+   * @param array The array, which may not be contiguous.
    */
-  BlackboardPyWrapper(Blackboard &&other)
-      : blackboard(std::make_shared<Blackboard>(std::move(other))) {}
+  template <class T, class B>
+  static void set_array(B &target, const std::string &key,
+                        const py::array &array) {
+    auto contiguous = py::array_t<T, py::array::c_style>::ensure(array);
+    std::vector<T> values(contiguous.size());
+    if (!values.empty()) {
+      std::memcpy(values.data(), contiguous.data(), values.size() * sizeof(T));
+    }
+    target.template set<std::vector<T>>(key, std::move(values));
+  }
 
   /**
-   * @brief Construct by wrapping a shared_ptr to a C++ Blackboard
+   * @brief Set a NumPy array as a vector if its elements are of a type with
+   * a zero-copy converter.
+   * @tparam B The Blackboard or BlackboardTransaction to write.
+   * @param target The Blackboard or BlackboardTransaction to write.
+   * @param key The key to associate with the value.
+   * @param value The Python object, which may not be an array.
+   * @return True if the value was set, otherwise false.
    */
-  explicit BlackboardPyWrapper(std::shared_ptr<Blackboard> bb_ptr)
-      : blackboard(bb_ptr) {}
+  template <class B>
+  static bool set_numpy(B &target, const std::string &key,
+                        const py::object &value) {
+    // Only objects with a dtype are checked, so NumPy is not imported for
+    // the other ones
+    if (!py::hasattr(value, "dtype") || !py::isinstance<py::array>(value)) {
+      return false;
+    }
+
+    py::array array = py::reinterpret_borrow<py::array>(value);
+    if (array.ndim() != 1) {
+      return false;
+    }
+
+    if (py::isinstance<py::array_t<double>>(array)) {
+      set_array<double>(target, key, array);
+    } else if (py::isinstance<py::array_t<float>>(array)) {
+      set_array<float>(target, key, array);
+    } else if (py::isinstance<py::array_t<std::uint8_t>>(array)) {
+      set_array<std::uint8_t>(target, key, array);
+    } else if (py::isinstance<py::array_t<std::int64_t>>(array)) {
+      set_array<std::int64_t>(target, key, array);
+    } else {
+      return false;
+    }
+
+    return true;
+  }
 
   /**
-   * @brief Set a Python object in the blackboard.
+   * @brief Set a Python object as the C++ type that matches it.
+   * @tparam B The Blackboard or BlackboardTransaction to write.
+   * @param target The Blackboard or BlackboardTransaction to write.
    * @param key The key to associate with the value.
    * @param value The Python object to store.
    */
-  void set(const std::string &key, py::object value) {
+  template <class B>
+  static void set_object(B &target, const std::string &key,
+                         py::object value) {
     if (py::isinstance<py::bool_>(value)) {
-      this->blackboard->set<bool>(key, value.cast<bool>());
+      target.template set<bool>(key, value.cast<bool>());
     } else if (py::isinstance<py::int_>(value)) {
       try {
-        this->blackboard->set<int>(key, value.cast<int>());
+        target.template set<int>(key, value.cast<int>());
       } catch (...) {
-        this->blackboard->set<long>(key, value.cast<long>());
+        target.template set<long>(key, value.cast<long>());
       }
     } else if (py::isinstance<py::float_>(value)) {
-      this->blackboard->set<double>(key, value.cast<double>());
+      target.template set<double>(key, value.cast<double>());
     } else if (py::isinstance<py::str>(value)) {
-      this->blackboard->set<std::string>(key, value.cast<std::string>());
+      target.template set<std::string>(key, value.cast<std::string>());
+    } else if (set_numpy(target, key, value)) {
+      return;
     } else if (py::isinstance<py::list>(value)) {
-      this->blackboard->set<py::object>(key, value);
+      target.template set<py::object>(key, value);
     } else if (py::isinstance<py::dict>(value)) {
-      this->blackboard->set<py::object>(key, value);
+      target.template set<py::object>(key, value);
     } else if (py::isinstance<py::tuple>(value)) {
-      this->blackboard->set<py::object>(key, value);
+      target.template set<py::object>(key, value);
     } else if (py::isinstance<py::set>(value)) {
-      this->blackboard->set<py::object>(key, value);
+      target.template set<py::object>(key, value);
     } else {
-      this->blackboard->set<py::object>(key, value);
+      target.template set<py::object>(key, value);
     }
   }
 
+public:
+  BlackboardPyWrapper() : blackboard(std::make_shared<Blackboard>()) {}
+
+  /**
+   * @brief Construct from an existing C++ Blackboard (move constructor)
+   */
+  BlackboardPyWrapper(Blackboard &&other)
+      : blackboard(std::make_shared<Blackboard>(std::move(other))) {}
+
+  /**
+   * @brief Construct by wrapping a shared_ptr to a C++ Blackboard
+   */
+  explicit BlackboardPyWrapper(std::shared_ptr<Blackboard> bb_ptr)
+      : blackboard(bb_ptr) {}
+
+  /**
+   * @brief Set a Python object in the blackboard.
+   * @param key The key to associate with the value.
+   * @param value The Python object to store.
+   */
+  void set(const std::string &key, py::object value) {
+    set_object(*this->blackboard, key, value);
+  }
+
   /**
    * @brief Get a Python object from the blackboard.
    * @param key The key associated with the value.
@@ -105,78 +186,45 @@ public:
    * @throws std::runtime_error if the key does not exist.
    */
   py::object get(const std::string &key) {
-    // Get the type of the stored value
-    std::string type = this->blackboard->get_type(key);
-
-    // Check if it's a pybind11::object (Python object - includes all Python
-    // types)
-    if (type.find("pybind11::object") != std::string::npos ||
-        type.find("pybind11::int_") != std::string::npos ||
-        type.find("pybind11::float_") != std::string::npos ||
-        type.find("pybind11::str") != std::string::npos ||
-        type.find("pybind11::bool_") != std::string::npos ||
-        type.find("pybind11::list") != std::string::npos ||
-        type.find("pybind11::dict") != std::string::npos ||
-        type.find("pybind11::set") != std::string::npos ||
-        type.find("pybind11::tuple") != std::string::npos ||
-        type.find("pybind11::bytes") != std::string::npos ||
-        type.find("pybind11::none") != std::string::npos) {
-      return this->blackboard->get<py::object>(key);
-    }
-    // Check if it's a std::string (C++ string) - convert to Python str
-    else if (type.find("std::string") != std::string::npos ||
-             type.find("std::__cxx11::basic_string") != std::string::npos) {
-      std::string cpp_value = this->blackboard->get<std::string>(key);
-      return py::cast(cpp_value);
-    }
-    // Check if it's a std::vector (C++ vector) - convert to Python list
-    else if (type.find("std::vector") != std::string::npos) {
-      return this->blackboard->get<py::object>(key);
-    }
-    // Check if it's a std::map (C++ map) - convert to Python dict
-    else if (type.find("std::map") != std::string::npos ||
-             type.find("std::unordered_map") != std::string::npos) {
-      return this->blackboard->get<py::object>(key);
-    }
-    // Check if it's a std::set (C++ set) - convert to Python set
-    else if (type.find("std::set") != std::string::npos ||
-             type.find("std::unordered_set") != std::string::npos) {
-      return this->blackboard->get<py::object>(key);
-    }
-    // Check if it's a std::list (C++ list) - convert to Python list
-    else if (type.find("std::list") != std::string::npos) {
-      return this->blackboard->get<py::object>(key);
-    }
-    // Check if it's a std::tuple (C++ tuple) - convert to Python tuple
-    else if (type.find("std::tuple") != std::string::npos) {
-      return this->blackboard->get<py::object>(key);
-    }
-    // Check if it's an int (C++ int) - convert to Python int
-    else if (type.find("int") != std::string::npos) {
-      int cpp_value = this->blackboard->get<int>(key);
-      return py::cast(cpp_value);
-    }
-    // Check if it's a long (C++ long) - convert to Python int
-    else if (type.find("long") != std::string::npos) {
-      long cpp_value = this->blackboard->get<long>(key);
-      return py::cast(cpp_value);
-    }
-    // Check if it's a float or double (C++ float/double) - convert to Python
-    // float
-    else if (type.find("float") != std::string::npos ||
-             type.find("double") != std::string::npos) {
-      double cpp_value = this->blackboard->get<double>(key);
-      return py::cast(cpp_value);
-    }
-    // Check if it's a bool (C++ bool) - convert to Python bool
-    else if (type.find("bool") != std::string::npos) {
-      bool cpp_value = this->blackboard->get<bool>(key);
-      return py::cast(cpp_value);
+    // Convert the value with the converter registered for its type
+    const PyConverterRegistry &registry = PyConverterRegistry::get_instance();
+    return this->blackboard->visit(
+        key, [&registry](const BlackboardValueInterface &value) {
+          return registry.convert(value);
+        });
+  }
+
+  /**
+   * @brief Set several Python objects in the blackboard at once.
+   * @param values The Python objects of each key.
+   */
+  void set_many(const py::dict &values) {
+    BlackboardTransaction transaction(*this->blackboard);
+    for (const auto &[key, value] : values) {
+      set_object(transaction, key.cast<std::string>(),
+                 py::reinterpret_borrow<py::object>(value));
     }
-    // Default: try to get as py::object
-    else {
-      return this->blackboard->get<py::object>(key);
+  }
+
+  /**
+   * @brief Get several Python objects from the blackboard at once.
+   * @param keys The keys associated with the values.
+   * @return The Python objects, in the order of the keys.
+   * @throws std::runtime_error if a key does not exist.
+   */
+  py::list get_many(const std::vector<std::string> &keys) {
+    const PyConverterRegistry &registry = PyConverterRegistry::get_instance();
+    py::list values;
+
+    BlackboardTransaction transaction(*this->blackboard);
+    for (const std::string &key : keys) {
+      values.append(transaction.visit(
+          key, [&registry](const BlackboardValueInterface &value) {
+            return registry.convert(value);
+          }));
     }
+
+    return values;
   }
 
   /**
@@ -222,6 +270,149 @@ public:
     return this->blackboard->get_remappings();
   }
 
+  /**
+   * @brief Get the version of a key.
+   * @param key The key.
+   * @return The version of the key, 0 if it has not changed.
+   */
+  std::uint64_t get_version(const std::string &key) {
+    return this->blackboard->get_version(key);
+  }
+
+  /**
+   * @brief Wait until a key changes or a timeout passes.
+   *
+   * The GIL is released while waiting, so other Python threads can change
+   * the key.
+   *
+   * @param key The key.
+   * @param version The version of the key already seen.
+   * @param timeout The maximum time to wait in seconds.
+   * @return True if the key changed, false if the timeout passed.
+   */
+  bool wait_for_change(const std::string &key, std::uint64_t version,
+                       double timeout) {
+    py::gil_scoped_release release;
+    return this->blackboard->wait_for_change(
+        key, version,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::duration<double>(timeout)));
+  }
+
+  /**
+   * @brief Add a Python callback called each time a key is set or removed.
+   * @param key The key to watch.
+   * @param callback The callback, which receives the key.
+   * @return The identifier of the watch.
+   */
+  std::size_t add_watch(const std::string &key, py::function callback) {
+    // The watches are copied without the GIL, so the function is shared and
+    // only released with the GIL held
+    std::shared_ptr<py::function> function(
+        new py::function(std::move(callback)), [](py::function *function) {
+          py::gil_scoped_acquire acquire;
+          delete function;
+        });
+
+    return this->blackboard->add_watch(
+        key, [function](const std::string &name) {
+          py::gil_scoped_acquire acquire;
+          (*function)(name);
+        });
+  }
+
+  /**
+   * @brief Remove a callback added with add_watch().
+   * @param id The identifier of the watch.
+   * @return True if the watch was removed, false if it did not exist.
+   */
+  bool remove_watch(std::size_t id) {
+    return this->blackboard->remove_watch(id);
+  }
+
+  /**
+   * @brief Get the estimated memory held by the values of the blackboard.
+   * @return The number of bytes.
+   */
+  std::size_t get_memory_usage() {
+    return this->blackboard->get_memory_usage();
+  }
+
+  /**
+   * @brief Get the estimated memory held by the value of a key.
+   *
+   * Python objects are counted as the size of a reference, not of the object.
+   *
+   * @param key The key.
+   * @return The number of bytes, 0 if the key has no value.
+   */
+  std::size_t get_key_memory_usage(const std::string &key) {
+    return this->blackboard->get_memory_usage(key);
+  }
+
+  /**
+   * @brief Set the maximum memory held by the values of the blackboard.
+   * @param budget The number of bytes, 0 for no limit.
+   */
+  void set_memory_budget(std::size_t budget) {
+    this->blackboard->set_memory_budget(budget);
+  }
+
+  /**
+   * @brief Get the maximum memory held by the values of the blackboard.
+   * @return The number of bytes, 0 if there is no limit.
+   */
+  std::size_t get_memory_budget() {
+    return this->blackboard->get_memory_budget();
+  }
+
+  /**
+   * @brief Set the time to live of the values of a key.
+   * @param key The key.
+   * @param ttl The time to live in seconds, 0 for values that do not expire.
+   */
+  void set_ttl(const std::string &key, double ttl) {
+    this->blackboard->set_ttl(
+        key, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::duration<double>(ttl)));
+  }
+
+  /**
+   * @brief Check if the value of a key is stale.
+   * @param key The key.
+   * @return True if the time to live of the value has passed.
+   */
+  bool is_stale(const std::string &key) {
+    return this->blackboard->is_stale(key);
+  }
+
+  /**
+   * @brief Remove the stale values.
+   * @return The number of values removed.
+   */
+  std::size_t purge_stale() { return this->blackboard->purge_stale(); }
+
+  /**
+   * @brief Write a full snapshot of the blackboard.
+   *
+   * Python objects other than numbers and strings have no serializer, so
+   * they are not stored.
+   *
+   * @param path The path of the snapshot file.
+   */
+  void save_snapshot(const std::string &path) {
+    BlackboardSnapshot::save(*this->blackboard, path);
+  }
+
+  /**
+   * @brief Restore the keys of a snapshot into the blackboard.
+   * @param path The path of the snapshot file.
+   * @return The number of keys restored.
+   */
+  std::size_t restore_snapshot(const std::string &path) {
+    return BlackboardSnapshot::restore(*this->blackboard, path);
+  }
+
   /**
    * @brief Get a shared pointer to the underlying C++ Blackboard
    * @return Shared pointer to the C++ Blackboard
@@ -0,0 +1,189 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef YASMIN__BLACKBOARD__BLACKBOARD_SNAPSHOT_HPP
+#define YASMIN__BLACKBOARD__BLACKBOARD_SNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/blackboard/blackboard_value_interface.hpp"
+
+namespace yasmin {
+namespace blackboard {
+
+struct BlackboardSerializer;
+
+/**
+ * @struct BlackboardSnapshotHeader
+ * @brief Header at the start of a snapshot file.
+ */
+struct BlackboardSnapshotHeader {
+  /// Bytes that identify the file as a snapshot
+  char magic[8];
+  /// Version of the format of the file
+  std::uint32_t format_version;
+  /// Known value to detect files written with another byte order
+  std::uint32_t byte_order;
+};
+
+/**
+ * @struct BlackboardSnapshotRecord
+ * @brief Header of a record of a snapshot file.
+ *
+ * It is followed by the key, the name of the type, padding up to the
+ * alignment of the records, the data of the value and padding again.
+ */
+struct BlackboardSnapshotRecord {
+  /// Size of the key
+  std::uint32_t key_size;
+  /// Size of the name of the type, 0 if the key was removed
+  std::uint32_t type_size;
+  /// Size of the data of the value
+  std::uint64_t data_size;
+};
+
+/**
+ * @class BlackboardSnapshot
+ * @brief Writer of snapshots of a blackboard, to restore it after a
+ * restart.
+ *
+ * A snapshot is a binary file made of records. Each record holds the key,
+ * the name of the serializer of its type and the bytes of the value, or
+ * marks the key as removed. The first write stores all the keys and the
+ * next ones only append the keys that changed, using their versions. When
+ * most of the file is made of old records, it is rewritten with the current
+ * ones. Full snapshots are written to a temporary file that replaces the
+ * previous one, so a crash never leaves a broken snapshot.
+ *
+ * Values are serialized with the SerializerRegistry. Keys whose type has no
+ * serializer are skipped with a warning. The blackboard is locked while the
+ * values are serialized, but not while the file is written.
+ *
+ * Snapshots are restored by mapping the file into memory, so the records
+ * are read in place without copying the file.
+ */
+class BlackboardSnapshot {
+public:
+  /// Bytes that identify the file as a snapshot
+  static constexpr char MAGIC[8] = {'Y', 'A', 'S', 'M', 'I', 'N', 'B', 'B'};
+  /// Version of the format of the file
+  static constexpr std::uint32_t FORMAT_VERSION = 1;
+  /// Known value to detect files written with another byte order
+  static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+  /// Alignment of the records and of the data of the values
+  static constexpr std::size_t ALIGNMENT = 8;
+  /// The file is rewritten when it is this many times larger than the data
+  /// of the current records
+  static constexpr std::size_t COMPACT_RATIO = 4;
+
+  /**
+   * @brief Constructs a BlackboardSnapshot.
+   *
+   * Nothing is written until write() is called.
+   *
+   * @param blackboard The blackboard, which must outlive the snapshot. Its
+   * keys are stored after applying its remappings.
+   * @param path The path of the snapshot file.
+   * @param sync Whether each write waits until the data is on disk.
+   */
+  BlackboardSnapshot(Blackboard &blackboard, const std::string &path,
+                     bool sync = false);
+
+  /** @brief Destroys the BlackboardSnapshot, closing the file. */
+  ~BlackboardSnapshot();
+
+  BlackboardSnapshot(const BlackboardSnapshot &) = delete;
+  BlackboardSnapshot &operator=(const BlackboardSnapshot &) = delete;
+
+  /**
+   * @brief Write the keys that changed since the previous write.
+   * @return The number of records written.
+   * @throws std::runtime_error if the file cannot be written.
+   */
+  std::size_t write();
+
+  /**
+   * @brief Write a full snapshot of a blackboard.
+   * @param blackboard The blackboard.
+   * @param path The path of the snapshot file.
+   * @throws std::runtime_error if the file cannot be written.
+   */
+  static void save(Blackboard &blackboard, const std::string &path);
+
+  /**
+   * @brief Restore the keys of a snapshot into a blackboard.
+   *
+   * The keys are set in one transaction, so other threads see the whole
+   * snapshot at once. Keys that are not in the snapshot are kept. A record
+   * cut by a crash at the end of the file is ignored.
+   *
+   * @param blackboard The blackboard.
+   * @param path The path of the snapshot file.
+   * @return The number of keys restored.
+   * @throws std::runtime_error if the file cannot be read or is not a
+   * snapshot.
+   */
+  static std::size_t restore(Blackboard &blackboard, const std::string &path);
+
+private:
+  /// The blackboard to write
+  Blackboard &blackboard;
+  /// The path of the snapshot file
+  std::string path;
+  /// Whether each write waits until the data is on disk
+  bool sync;
+  /// Descriptor of the file to append records, -1 before the first write
+  int fd{-1};
+  /// Size of the file
+  std::size_t file_size{0};
+  /// Version and record size of each key in the file
+  std::map<std::string, std::pair<std::uint64_t, std::size_t>> written_keys;
+  /// Size of the current records of the keys
+  std::size_t live_size{0};
+
+  /**
+   * @brief Append a record to a buffer.
+   * @param data The buffer, which starts at an aligned offset of the file.
+   * @param key The key.
+   * @param type The name of the type, empty if the key was removed.
+   * @param value The value, or nullptr if the key was removed.
+   * @param serializer The serializer of the value.
+   * @return The size of the record.
+   */
+  static std::size_t
+  append_record(std::vector<std::uint8_t> &data, const std::string &key,
+                const std::string &type,
+                const BlackboardValueInterface *value,
+                const BlackboardSerializer *serializer);
+
+  /**
+   * @brief Write a buffer to the end of the file.
+   * @param data The buffer.
+   * @throws std::runtime_error if the file cannot be written.
+   */
+  void write_data(const std::vector<std::uint8_t> &data);
+};
+
+} // namespace blackboard
+} // namespace yasmin
+
+#endif // YASMIN__BLACKBOARD__BLACKBOARD_SNAPSHOT_HPP
@@ -0,0 +1,149 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef YASMIN__BLACKBOARD__BLACKBOARD_STORAGE_HPP
+#define YASMIN__BLACKBOARD__BLACKBOARD_STORAGE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "yasmin/blackboard/blackboard_value_holder.hpp"
+
+namespace yasmin {
+namespace blackboard {
+
+// Forward declaration
+class SharedMemorySegment;
+
+/**
+ * @struct BlackboardEntry
+ * @brief Storage slot of a key in the blackboard.
+ *
+ * The entry of a removed value is erased, unless a key handle points to it,
+ * the key has a time to live or the storage is a fork, where the entry hides
+ * the value of the base.
+ */
+struct BlackboardEntry {
+  /// Time point of the values that never expire.
+  static constexpr std::chrono::steady_clock::time_point NEVER =
+      std::chrono::steady_clock::time_point::max();
+
+  /// The stored value, nullptr if the key has no value.
+  BlackboardValueHolder value;
+  /// Number of times the value was set or removed in this storage, 0 if it
+  /// has not changed. In a fork, an entry without value that has changed
+  /// hides the base value.
+  std::uint64_t version{0};
+  /// Estimated bytes held by the value, 0 if the key has no value.
+  std::size_t size{0};
+  /// Time to live of the values of the key, 0 if they do not expire.
+  std::chrono::nanoseconds ttl{0};
+  /// Time when the value becomes stale.
+  std::chrono::steady_clock::time_point expiration{NEVER};
+  /// Tick of the last access to the value, only updated when the storage
+  /// has a memory budget.
+  mutable std::atomic<std::uint64_t> last_access{0};
+  /// Number of key handles pointing to the entry, which is not erased while
+  /// there are any.
+  mutable std::atomic<std::size_t> num_handles{0};
+
+  /**
+   * @brief Check if the value is stale.
+   * @return True if the value has a time to live that has passed.
+   */
+  bool is_stale() const {
+    return this->expiration != NEVER &&
+           std::chrono::steady_clock::now() >= this->expiration;
+  }
+};
+
+/**
+ * @struct BlackboardWatch
+ * @brief Callback called when the value of a key changes.
+ */
+struct BlackboardWatch {
+  /// Identifier of the watch
+  std::size_t id;
+  /// The key, as given when the watch was added
+  std::string name;
+  /// The callback, which receives the key
+  std::function<void(const std::string &)> callback;
+};
+
+/**
+ * @struct BlackboardStorage
+ * @brief Entries of a blackboard, shared by the blackboard and its views.
+ *
+ * The storage of a fork only holds the entries changed in the fork. The other
+ * keys are read from its base.
+ */
+struct BlackboardStorage {
+  /// Mutex for thread safety, shared by readers.
+  mutable std::shared_mutex mutex;
+  /// Entries of the keys, whose addresses are stable.
+  std::map<std::string, BlackboardEntry> entries;
+  /// Number of entries that have a value, without the ones of the base.
+  std::size_t num_values{0};
+  /// Number of entries with a time to live.
+  std::size_t num_ttls{0};
+  /// Highest version of the erased entries. The versions of the new entries
+  /// start after it, so a key never gets back a version it had.
+  std::uint64_t erased_version{0};
+  /// Estimated bytes held by the values, without the ones of the base.
+  std::size_t memory_usage{0};
+  /// Maximum bytes held by the values before the least recently used ones
+  /// are evicted, 0 if there is no limit.
+  std::size_t memory_budget{0};
+  /// Clock of the accesses to the values, used to find the least recently
+  /// used one.
+  mutable std::atomic<std::uint64_t> access_clock{0};
+  /// Keys evicted since the last notification, only kept if there are
+  /// watchers.
+  std::vector<std::string> evicted_keys;
+  /// Storage this one was forked from, nullptr if it is not a fork.
+  std::shared_ptr<const BlackboardStorage> base;
+  /// Condition variable notified when a value changes.
+  mutable std::condition_variable_any change_cond;
+  /// Number of waiting threads and watches, to skip notifying when there
+  /// are none.
+  mutable std::atomic<std::size_t> num_watchers{0};
+  /// Mutex for the waiting forks.
+  mutable std::mutex forks_mutex;
+  /// Forks with threads waiting for changes, once per thread. They are also
+  /// counted as watchers, since they read the keys of this storage.
+  mutable std::vector<const BlackboardStorage *> waiting_forks;
+  /// Watches of each key, already remapped.
+  std::map<std::string, std::vector<BlackboardWatch>> watches;
+  /// Identifier of the next watch.
+  std::size_t next_watch_id{1};
+  /// Shared memory segment holding the keys shared with other processes,
+  /// nullptr if there is none. Forks share the segment of their base.
+  std::shared_ptr<SharedMemorySegment> segment;
+};
+
+} // namespace blackboard
+} // namespace yasmin
+
+#endif // YASMIN__BLACKBOARD__BLACKBOARD_STORAGE_HPP
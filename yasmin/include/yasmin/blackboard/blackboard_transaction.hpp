@@ -0,0 +1,292 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef YASMIN__BLACKBOARD__BLACKBOARD_TRANSACTION_HPP
+#define YASMIN__BLACKBOARD__BLACKBOARD_TRANSACTION_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/blackboard/blackboard_key.hpp"
+#include "yasmin/logs.hpp"
+
+namespace yasmin {
+namespace blackboard {
+
+/**
+ * @class BlackboardTransaction
+ * @brief Scoped access to a blackboard that groups several reads and writes
+ * under one lock.
+ *
+ * The transaction locks the blackboard when it is created and unlocks it
+ * when it is committed or destroyed, so other threads see all of its writes
+ * at once and never a group of keys half-written. The watches of the
+ * changed keys are called after the commit. Writes are applied as they are
+ * made, so they are kept if an exception leaves the scope.
+ *
+ * The blackboard must not be used directly while the transaction is open in
+ * the same thread, since it is locked. Keys shared with other processes
+ * through a SharedMemorySegment are written as they are set, so other
+ * processes may see part of the group.
+ */
+class BlackboardTransaction {
+private:
+  /// The blackboard of the transaction.
+  Blackboard &blackboard;
+  /// The exclusive lock of the storage of the blackboard.
+  std::unique_lock<std::shared_mutex> lk;
+  /// Flag to indicate if there are watchers to notify, which cannot change
+  /// while the blackboard is locked.
+  bool notify;
+  /// Keys changed by the transaction, already remapped, only kept if there
+  /// are watchers.
+  std::vector<std::string> changed_keys;
+
+  /**
+   * @brief Internal method that records a changed key.
+   * @param key The key, already remapped.
+   */
+  void add_change(const std::string &key) {
+    if (this->notify) {
+      this->changed_keys.push_back(key);
+    }
+  }
+
+  /**
+   * @brief Internal method that checks if the transaction is still open.
+   * @throws std::logic_error if the transaction was committed.
+   */
+  void check_open() const {
+    if (!this->lk.owns_lock()) {
+      throw std::logic_error("The blackboard transaction was committed");
+    }
+  }
+
+public:
+  /**
+   * @brief Constructs a BlackboardTransaction, locking the blackboard.
+   * @param blackboard The blackboard to access.
+   */
+  explicit BlackboardTransaction(Blackboard &blackboard)
+      : blackboard(blackboard), lk(blackboard.storage->mutex),
+        notify(blackboard.storage->num_watchers.load() != 0) {}
+
+  BlackboardTransaction(const BlackboardTransaction &) = delete;
+  BlackboardTransaction &operator=(const BlackboardTransaction &) = delete;
+
+  /** @brief Destroys the BlackboardTransaction, committing it. */
+  ~BlackboardTransaction() {
+    if (this->lk.owns_lock()) {
+      this->commit();
+    }
+  }
+
+  /**
+   * @brief Set a value in the blackboard.
+   * @tparam T The type of the value to store.
+   * @param name The key to associate with the value.
+   * @param value The value to store.
+   * @throws std::logic_error if the transaction was committed.
+   */
+  template <class T> void set(const std::string &name, T value) {
+
+    YASMIN_LOG_DEBUG("Setting '%s' in the blackboard transaction",
+                     name.c_str());
+
+    this->check_open();
+    const std::string &key = this->blackboard.remap(name);
+    this->blackboard.write_value(key, std::move(value));
+    this->add_change(key);
+  }
+
+  /**
+   * @brief Set a value in the blackboard through a key handle.
+   * @tparam T The type of the value to store.
+   * @param key The key handle to associate with the value.
+   * @param value The value to store.
+   * @throws std::invalid_argument if the key belongs to another blackboard.
+   * @throws std::logic_error if the transaction was committed.
+   */
+  template <class T> void set(const BlackboardKey<T> &key, T value) {
+
+    YASMIN_LOG_DEBUG("Setting '%s' in the blackboard transaction",
+                     key.get_name().c_str());
+
+    this->check_open();
+    this->blackboard.check_key(key);
+    this->blackboard.write_value(key, std::move(value));
+    this->add_change(key.get_name());
+  }
+
+  /**
+   * @brief Retrieve a value from the blackboard, including the values set
+   * in the transaction.
+   * @tparam T The type of the value to retrieve.
+   * @param key The key associated with the value.
+   * @return The value associated with the specified key.
+   * @throws std::runtime_error if the key does not exist or its value is of
+   * another type.
+   * @throws std::logic_error if the transaction was committed.
+   */
+  template <class T> T get(const std::string &key) {
+    this->check_open();
+    return this->blackboard.read_value<T>(key, this->blackboard.remap(key));
+  }
+
+  /**
+   * @brief Retrieve a value from the blackboard through a key handle.
+   * @tparam T The type of the value to retrieve.
+   * @param key The key handle associated with the value.
+   * @return The value associated with the specified key.
+   * @throws std::runtime_error if the key does not exist or its value is of
+   * another type.
+   * @throws std::invalid_argument if the key belongs to another blackboard.
+   * @throws std::logic_error if the transaction was committed.
+   */
+  template <class T> T get(const BlackboardKey<T> &key) {
+    this->check_open();
+    this->blackboard.check_key(key);
+    return this->blackboard.read_value(key);
+  }
+
+  /**
+   * @brief Call a function with a value of any type.
+   * @param key The key associated with the value.
+   * @param function The function, which receives the value as a
+   * BlackboardValueInterface.
+   * @return The result of the function.
+   * @throws std::runtime_error if the key does not exist.
+   * @throws std::logic_error if the transaction was committed.
+   */
+  template <class F> auto visit(const std::string &key, F &&function) {
+    this->check_open();
+    return this->blackboard.visit_value(key, this->blackboard.remap(key),
+                                        std::forward<F>(function));
+  }
+
+  /**
+   * @brief Remove a value from the blackboard.
+   * @param key The key associated with the value to remove.
+   * @throws std::runtime_error if the key does not exist.
+   * @throws std::logic_error if the transaction was committed.
+   */
+  void remove(const std::string &key) {
+
+    YASMIN_LOG_DEBUG("Removing '%s' in the blackboard transaction",
+                     key.c_str());
+
+    this->check_open();
+    const std::string &name = this->blackboard.remap(key);
+    this->blackboard.remove_value(key, name);
+    this->add_change(name);
+  }
+
+  /**
+   * @brief Check if a key exists in the blackboard.
+   * @param key The key to check.
+   * @return True if the key exists, false otherwise.
+   * @throws std::logic_error if the transaction was committed.
+   */
+  bool contains(const std::string &key) {
+    this->check_open();
+    const std::string &name = this->blackboard.remap(key);
+
+    if (this->blackboard.find_shared(name) != nullptr) {
+      return this->blackboard.storage->segment->contains(name);
+    }
+
+    return this->blackboard.read_entry(
+        name, this->blackboard.find_entry(name),
+        [](const BlackboardEntry *entry) { return entry != nullptr; });
+  }
+
+  /**
+   * @brief Get the keys with a value in the blackboard.
+   *
+   * The keys are the ones of the storage, after applying the remappings, so
+   * they are meant to be used with a blackboard without remappings.
+   *
+   * @return The keys, sorted.
+   * @throws std::logic_error if the transaction was committed.
+   */
+  std::vector<std::string> get_keys() {
+    this->check_open();
+
+    std::map<std::string, const BlackboardEntry *> entries;
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    Blackboard::collect_entries(*this->blackboard.storage, entries, locks);
+
+    std::vector<std::string> keys;
+    keys.reserve(entries.size());
+    for (const auto &[key, entry] : entries) {
+      keys.push_back(key);
+    }
+
+    if (this->blackboard.storage->segment != nullptr) {
+      for (const std::string &key :
+           this->blackboard.storage->segment->get_keys()) {
+        keys.insert(std::lower_bound(keys.begin(), keys.end(), key), key);
+      }
+    }
+
+    return keys;
+  }
+
+  /**
+   * @brief Get the version of a key.
+   * @param key The key.
+   * @return The version of the key, 0 if it has not changed.
+   * @throws std::logic_error if the transaction was committed.
+   */
+  std::uint64_t get_version(const std::string &key) {
+    this->check_open();
+    return this->blackboard.read_version(this->blackboard.remap(key));
+  }
+
+  /**
+   * @brief Publish the changes, unlocking the blackboard and calling the
+   * watches of the changed keys.
+   * @throws std::logic_error if the transaction was committed.
+   */
+  void commit() {
+    this->check_open();
+
+    if (!this->notify || this->changed_keys.empty()) {
+      this->lk.unlock();
+      return;
+    }
+
+    // Each watch is called once, even if its key changed several times
+    std::sort(this->changed_keys.begin(), this->changed_keys.end());
+    this->changed_keys.erase(
+        std::unique(this->changed_keys.begin(), this->changed_keys.end()),
+        this->changed_keys.end());
+    this->blackboard.notify_changes(this->changed_keys, this->lk);
+  }
+};
+
+} // namespace blackboard
+} // namespace yasmin
+
+#endif // YASMIN__BLACKBOARD__BLACKBOARD_TRANSACTION_HPP
@@ -16,14 +16,19 @@
 #ifndef YASMIN__BLACKBOARD__BLACKBOARD_VALUE_HPP
 #define YASMIN__BLACKBOARD__BLACKBOARD_VALUE_HPP
 
+#include <atomic>
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <type_traits>
+#include <typeindex>
 #include <typeinfo>
+#include <utility>
 
-#ifdef __GNUG__     // If using GCC/G++
-#include <cxxabi.h> // For abi::__cxa_demangle
-#endif
-
+#include "yasmin/blackboard/blackboard_value_holder.hpp"
 #include "yasmin/blackboard/blackboard_value_interface.hpp"
+#include "yasmin/blackboard/blackboard_value_size.hpp"
+#include "yasmin/blackboard/type_registry.hpp"
 
 namespace yasmin {
 namespace blackboard {
@@ -36,55 +41,173 @@ namespace blackboard {
  * any type T. It provides methods to get and set the value, as well as
  * to retrieve the type information of the value in a human-readable format.
  *
+ * Small trivially copyable values, like flags and counters, are stored
+ * inline. Other values are kept in a shared buffer so readers can take
+ * snapshots of them without copying. A new value is written in place unless a
+ * snapshot still refers to the buffer, in which case a new buffer is
+ * allocated.
+ *
+ * Strings are kept in a buffer even when they are short. A std::string
+ * object does not fit in a BlackboardValueHolder, and storing the characters
+ * inline would break get_ref(), which returns a std::string. A short string
+ * takes one allocation when the key is first set and is then overwritten in
+ * place, reusing its buffer.
+ *
  * @tparam T The type of the value to be stored.
  */
 template <class T> class BlackboardValue : public BlackboardValueInterface {
+public:
+  /// Flag to indicate if the value is stored inline instead of in a buffer
+  static constexpr bool IS_INLINE =
+      std::is_trivially_copyable<T>::value && sizeof(T) <= 16 &&
+      alignof(T) <= BlackboardValueHolder::BUFFER_ALIGNMENT;
+
 private:
-  T value; ///< The stored value of type T.
+  /// Storage of the value, inline or in a shared buffer
+  typedef typename std::conditional<IS_INLINE, T, std::shared_ptr<T>>::type
+      Storage;
+
+  Storage value; ///< The stored value of type T.
+
+  /**
+   * @brief Creates the storage of a value.
+   * @param value The value to store.
+   * @return The storage.
+   */
+  static Storage create_storage(T &&value) {
+    if constexpr (IS_INLINE) {
+      return value;
+    } else {
+      return std::make_shared<T>(std::move(value));
+    }
+  }
+
+  /**
+   * @brief Checks if a snapshot refers to the stored value.
+   *
+   * Snapshots are only created while the blackboard is locked, so when no
+   * other owner is seen, none can appear until the value is written. The
+   * count is read without ordering, so an acquire fence makes the reads of
+   * the last released snapshot happen before the value is written. It pairs
+   * with the release of the decrement done when a shared pointer is
+   * destroyed.
+   *
+   * @return True if the value can be written in place, otherwise false.
+   */
+  bool is_unique() const {
+    if constexpr (IS_INLINE) {
+      return true;
+    } else {
+      if (this->value.use_count() != 1) {
+        return false;
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return true;
+    }
+  }
 
 public:
   /**
    * @brief Constructs a BlackboardValue with the specified value.
    * @param value The initial value to store.
    */
-  BlackboardValue(T value) : value(value) {}
+  BlackboardValue(T value) : value(create_storage(std::move(value))) {}
 
   /**
    * @brief Retrieve the stored value.
    * @return The stored value of type T.
    */
-  T get() { return this->value; }
+  T get() {
+    if constexpr (IS_INLINE) {
+      return this->value;
+    } else {
+      return *this->value;
+    }
+  }
+
+  /**
+   * @brief Access the stored value without copying it.
+   *
+   * The reference is only valid while the blackboard holding the value is
+   * locked, as done by Blackboard::visit().
+   *
+   * @return A reference to the stored value.
+   */
+  const T &get_ref() const {
+    if constexpr (IS_INLINE) {
+      return this->value;
+    } else {
+      return *this->value;
+    }
+  }
+
+  /**
+   * @brief Retrieve a snapshot of the stored value without copying it.
+   *
+   * Values stored inline are small, so they are copied into the snapshot.
+   *
+   * @return A shared pointer to the stored value, which is not modified by
+   * later writes.
+   */
+  std::shared_ptr<const T> get_shared() const {
+    if constexpr (IS_INLINE) {
+      return std::make_shared<const T>(this->value);
+    } else {
+      return this->value;
+    }
+  }
 
   /**
    * @brief Set a new value.
    * @param value The new value to store.
    */
-  void set(T value) { this->value = value; }
+  void set(const T &value) {
+    if constexpr (IS_INLINE) {
+      this->value = value;
+    } else if (this->is_unique()) {
+      *this->value = value;
+    } else {
+      this->value = std::make_shared<T>(value);
+    }
+  }
 
   /**
-   * @brief Get the type of the stored value as a string.
-   * @return A string representation of the type of the stored value.
-   *
-   * This method uses RTTI to get the mangled name of the type
-   * and demangles it for readability (if using GCC).
+   * @brief Set a new value, moving it into the stored one.
+   * @param value The new value to store.
    */
-  std::string get_type() {
-    std::string name = typeid(T).name(); // Get the mangled name of the type
-
-#ifdef __GNUG__ // If using GCC/G++
-    int status;
-    // Demangle the name using GCC's demangling function
-    char *demangled =
-        abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
-    if (status == 0) {
-      name = demangled;
+  void set(T &&value) {
+    if constexpr (IS_INLINE) {
+      this->value = value;
+    } else if (this->is_unique()) {
+      *this->value = std::move(value);
+    } else {
+      this->value = std::make_shared<T>(std::move(value));
     }
-    free(demangled);
-#endif
+  }
+
+  /**
+   * @brief Get the type of the stored value.
+   * @return The type index of T.
+   */
+  std::type_index get_type_index() const override { return typeid(T); }
 
-    return name; // Return the demangled type name
+  /**
+   * @brief Estimate the memory held by the stored value.
+   * @return The number of bytes, as given by BlackboardValueSize<T>.
+   */
+  std::size_t get_size() const override {
+    return BlackboardValueSize<T>::get(this->get_ref());
   }
 
+  /**
+   * @brief Get the type of the stored value as a string.
+   * @return A string representation of the type of the stored value.
+   *
+   * The name is demangled by the TypeRegistry the first time it is requested
+   * (if using GCC).
+   */
+  std::string get_type() { return TypeRegistry::get_name(typeid(T)); }
+
   /**
    * @brief Convert the stored value's type information to a string.
    * @return A string representation of the type of the stored value.
@@ -93,6 +216,31 @@ public:
    * BlackboardValueInterface to provide the type of the value.
    */
   std::string to_string() { return this->get_type(); }
+
+  /**
+   * @brief Create a copy of the value.
+   * @param holder The holder where the copy is stored.
+   */
+  void clone(BlackboardValueHolder &holder) const override {
+    if constexpr (IS_INLINE) {
+      holder.emplace<BlackboardValue<T>>(this->value);
+    } else {
+      holder.emplace<BlackboardValue<T>>(*this->value);
+    }
+  }
+
+  /**
+   * @brief Create a value that shares the stored data.
+   *
+   * Both values see the buffer as shared, so the next write to either of them
+   * allocates a new buffer instead of writing in place. Values stored inline
+   * are copied.
+   *
+   * @param holder The holder where the new value is stored.
+   */
+  void share(BlackboardValueHolder &holder) const override {
+    holder.emplace<BlackboardValue<T>>(*this);
+  }
 };
 
 } // namespace blackboard
@@ -0,0 +1,117 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef YASMIN__BLACKBOARD__BLACKBOARD_VALUE_HOLDER_HPP
+#define YASMIN__BLACKBOARD__BLACKBOARD_VALUE_HOLDER_HPP
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "yasmin/blackboard/blackboard_value_interface.hpp"
+
+namespace yasmin {
+namespace blackboard {
+
+/**
+ * @class BlackboardValueHolder
+ * @brief Owner of a blackboard value that stores it inside itself.
+ *
+ * The value object is constructed in a buffer of the holder instead of being
+ * allocated, so storing a value in an entry takes no allocation. Values keep
+ * their data inline when it is small, so only large data is allocated.
+ */
+class BlackboardValueHolder {
+public:
+  /// Size of the buffer, which fits a value object with a pointer to its
+  /// virtual table and 16 bytes of data
+  static constexpr std::size_t BUFFER_SIZE = 24;
+  /// Alignment of the buffer
+  static constexpr std::size_t BUFFER_ALIGNMENT = alignof(void *);
+
+  /** @brief Constructs an empty BlackboardValueHolder. */
+  BlackboardValueHolder() = default;
+
+  /** @brief Destroys the BlackboardValueHolder and its value. */
+  ~BlackboardValueHolder() { this->reset(); }
+
+  BlackboardValueHolder(const BlackboardValueHolder &) = delete;
+  BlackboardValueHolder &operator=(const BlackboardValueHolder &) = delete;
+
+  /**
+   * @brief Replaces the value with a new one built in the buffer.
+   * @tparam V The type of the value object.
+   * @param args The arguments of the constructor of the value object.
+   * @return A pointer to the new value object.
+   */
+  template <class V, class... Args> V *emplace(Args &&...args) {
+    static_assert(sizeof(V) <= BUFFER_SIZE && alignof(V) <= BUFFER_ALIGNMENT,
+                  "The value object does not fit in the holder");
+
+    this->reset();
+    V *value = new (&this->buffer) V(std::forward<Args>(args)...);
+    this->value = value;
+    return value;
+  }
+
+  /** @brief Destroys the value, leaving the holder empty. */
+  void reset() {
+    if (this->value != nullptr) {
+      this->value->~BlackboardValueInterface();
+      this->value = nullptr;
+    }
+  }
+
+  /**
+   * @brief Gets the value.
+   * @return A pointer to the value, or nullptr if the holder is empty.
+   */
+  BlackboardValueInterface *get() const { return this->value; }
+
+  /**
+   * @brief Accesses the value.
+   * @return A pointer to the value.
+   */
+  BlackboardValueInterface *operator->() const { return this->value; }
+
+  /**
+   * @brief Accesses the value.
+   * @return A reference to the value.
+   */
+  BlackboardValueInterface &operator*() const { return *this->value; }
+
+  /**
+   * @brief Checks if the holder is empty.
+   * @return True if the holder has no value.
+   */
+  bool operator==(std::nullptr_t) const { return this->value == nullptr; }
+
+  /**
+   * @brief Checks if the holder has a value.
+   * @return True if the holder has a value.
+   */
+  bool operator!=(std::nullptr_t) const { return this->value != nullptr; }
+
+private:
+  /// Buffer where the value object is built
+  alignas(BUFFER_ALIGNMENT) unsigned char buffer[BUFFER_SIZE];
+  /// The value object in the buffer, nullptr if the holder is empty
+  BlackboardValueInterface *value{nullptr};
+};
+
+} // namespace blackboard
+} // namespace yasmin
+
+#endif // YASMIN__BLACKBOARD__BLACKBOARD_VALUE_HOLDER_HPP
@@ -16,11 +16,16 @@
 #ifndef YASMIN__BLACKBOARD__BLACKBOARD_VALUE_INTERFACE_HPP
 #define YASMIN__BLACKBOARD__BLACKBOARD_VALUE_INTERFACE_HPP
 
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <typeindex>
 
 namespace yasmin {
 namespace blackboard {
 
+class BlackboardValueHolder;
+
 /**
  * @class BlackboardValueInterface
  * @brief Interface for blackboard value types.
@@ -42,6 +47,34 @@ public:
    * an appropriate string representation of the value they encapsulate.
    */
   virtual std::string to_string() { return ""; };
+
+  /**
+   * @brief Get the type of the value.
+   * @return The type index of the value, which can be compared without
+   * building its name.
+   */
+  virtual std::type_index get_type_index() const = 0;
+
+  /**
+   * @brief Estimate the memory held by the value.
+   * @return The number of bytes, as given by BlackboardValueSize.
+   */
+  virtual std::size_t get_size() const = 0;
+
+  /**
+   * @brief Create a copy of the value.
+   * @param holder The holder where the copy is stored.
+   */
+  virtual void clone(BlackboardValueHolder &holder) const = 0;
+
+  /**
+   * @brief Create a value that shares the stored data.
+   *
+   * The data is copied by the first of both values that is written.
+   *
+   * @param holder The holder where the new value is stored.
+   */
+  virtual void share(BlackboardValueHolder &holder) const = 0;
 };
 
 } // namespace blackboard
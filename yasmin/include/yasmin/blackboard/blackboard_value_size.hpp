@@ -0,0 +1,110 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef YASMIN__BLACKBOARD__BLACKBOARD_VALUE_SIZE_HPP
+#define YASMIN__BLACKBOARD__BLACKBOARD_VALUE_SIZE_HPP
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace yasmin {
+namespace blackboard {
+
+/**
+ * @struct BlackboardValueSize
+ * @brief Estimate of the memory held by a value stored in a blackboard.
+ *
+ * By default, a value holds sizeof(T) bytes. Types that own heap memory,
+ * like messages with dynamic fields, can specialize this struct before their
+ * values are stored, so the blackboard accounts for their real size.
+ *
+ * @tparam T The type of the value.
+ */
+template <class T> struct BlackboardValueSize {
+  /**
+   * @brief Estimate the size of a value.
+   * @param value The value.
+   * @return The number of bytes held by the value.
+   */
+  static std::size_t get(const T &value) {
+    (void)value;
+    return sizeof(T);
+  }
+};
+
+/**
+ * @struct BlackboardValueSize<std::string>
+ * @brief Size of a string, including its buffer.
+ */
+template <> struct BlackboardValueSize<std::string> {
+  /**
+   * @brief Estimate the size of a string.
+   * @param value The string.
+   * @return The number of bytes held by the string.
+   */
+  static std::size_t get(const std::string &value) {
+    return sizeof(std::string) + value.capacity();
+  }
+};
+
+/**
+ * @struct BlackboardValueSize<std::vector<T>>
+ * @brief Size of a vector, including its buffer and the memory held by its
+ * elements.
+ */
+template <class T, class Allocator>
+struct BlackboardValueSize<std::vector<T, Allocator>> {
+  /**
+   * @brief Estimate the size of a vector.
+   * @param value The vector.
+   * @return The number of bytes held by the vector.
+   */
+  static std::size_t get(const std::vector<T, Allocator> &value) {
+    std::size_t size =
+        sizeof(std::vector<T, Allocator>) + value.capacity() * sizeof(T);
+
+    // Only the elements that own memory are visited
+    if constexpr (!std::is_trivially_copyable<T>::value) {
+      for (const T &element : value) {
+        size += BlackboardValueSize<T>::get(element) - sizeof(T);
+      }
+    }
+
+    return size;
+  }
+};
+
+/**
+ * @struct BlackboardValueSize<std::vector<bool>>
+ * @brief Size of a vector of bits.
+ */
+template <class Allocator>
+struct BlackboardValueSize<std::vector<bool, Allocator>> {
+  /**
+   * @brief Estimate the size of a vector of bits.
+   * @param value The vector.
+   * @return The number of bytes held by the vector.
+   */
+  static std::size_t get(const std::vector<bool, Allocator> &value) {
+    return sizeof(std::vector<bool, Allocator>) + (value.capacity() + 7) / 8;
+  }
+};
+
+} // namespace blackboard
+} // namespace yasmin
+
+#endif // YASMIN__BLACKBOARD__BLACKBOARD_VALUE_SIZE_HPP
@@ -0,0 +1,197 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef YASMIN__BLACKBOARD__PY_CONVERTER_REGISTRY_HPP
+#define YASMIN__BLACKBOARD__PY_CONVERTER_REGISTRY_HPP
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/blackboard/blackboard_value.hpp"
+#include "yasmin/blackboard/blackboard_value_interface.hpp"
+
+namespace py = pybind11;
+
+namespace yasmin {
+namespace blackboard {
+
+/**
+ * @class PyConverterRegistry
+ * @brief Functions that convert the values of a blackboard to Python
+ * objects, indexed by the type of the value.
+ *
+ * The registry comes with converters for the basic C++ types and for Python
+ * objects. Vectors of numbers used for bulk data, like laser scans and
+ * occupancy grids, are converted to read-only NumPy arrays that share the
+ * buffer of the value. Other types, like messages, can be added with
+ * register_type(), register_array() or register_converter(). The registry is
+ * owned by the yasmin.blackboard module and shared with other modules through
+ * a capsule, so converters registered from any module are used by all
+ * blackboards. It must be used with the GIL held.
+ */
+class PyConverterRegistry {
+public:
+  /// Function that converts a value of a blackboard to a Python object
+  typedef std::function<py::object(const BlackboardValueInterface &)>
+      Converter;
+
+  /// Name of the capsule attribute of the yasmin.blackboard module
+  static constexpr const char *CAPSULE_NAME = "_converter_registry";
+
+  /**
+   * @brief Constructs a PyConverterRegistry with the default converters.
+   */
+  PyConverterRegistry() {
+    this->register_converter<py::object>(
+        [](const py::object &value) { return value; });
+    this->register_type<bool>();
+    this->register_type<int>();
+    this->register_type<long>();
+    this->register_type<float>();
+    this->register_type<double>();
+    this->register_type<std::string>();
+    this->register_type<std::vector<bool>>();
+    this->register_type<std::vector<int>>();
+    this->register_type<std::vector<long>>();
+    this->register_type<std::vector<double>>();
+    this->register_type<std::vector<std::string>>();
+    this->register_type<std::map<std::string, std::string>>();
+
+    // Registered after the lists, since std::int64_t may be long
+    this->register_array<double>();
+    this->register_array<float>();
+    this->register_array<std::uint8_t>();
+    this->register_array<std::int64_t>();
+  }
+
+  PyConverterRegistry(const PyConverterRegistry &) = delete;
+  PyConverterRegistry &operator=(const PyConverterRegistry &) = delete;
+
+  /**
+   * @brief Register a function that converts values of a type.
+   * @tparam T The type of the values.
+   * @param converter The function, which receives the value.
+   */
+  template <class T>
+  void register_converter(std::function<py::object(const T &)> converter) {
+    this->converters[typeid(T)] =
+        [converter](const BlackboardValueInterface &value) {
+          return converter(
+              static_cast<const BlackboardValue<T> &>(value).get_ref());
+        };
+  }
+
+  /**
+   * @brief Register a type that pybind11 can cast to Python.
+   * @tparam T The type of the values.
+   */
+  template <class T> void register_type() {
+    this->register_converter<T>(
+        [](const T &value) { return py::cast(value); });
+  }
+
+  /**
+   * @brief Register a vector type that is converted to a NumPy array without
+   * copying it.
+   *
+   * The array is read-only and keeps a snapshot of the value alive, so it
+   * does not change when the key is overwritten.
+   *
+   * @tparam T The type of the elements of the vectors.
+   */
+  template <class T> void register_array() {
+    this->converters[typeid(std::vector<T>)] =
+        [](const BlackboardValueInterface &value) -> py::object {
+      auto *data = new std::shared_ptr<const std::vector<T>>(
+          static_cast<const BlackboardValue<std::vector<T>> &>(value)
+              .get_shared());
+      py::capsule base(data, [](void *data) {
+        delete static_cast<std::shared_ptr<const std::vector<T>> *>(data);
+      });
+
+      py::array_t<T> array(static_cast<py::ssize_t>((*data)->size()),
+                           (*data)->data(), base);
+      array.attr("flags").attr("writeable") = false;
+      return std::move(array);
+    };
+  }
+
+  /**
+   * @brief Convert a value with the converter of its type.
+   * @param value The value.
+   * @return The Python object.
+   * @throws std::runtime_error if the type of the value has no converter.
+   */
+  py::object convert(const BlackboardValueInterface &value) const {
+    const Converter *converter = this->find(value.get_type_index());
+    if (converter == nullptr) {
+      throw std::runtime_error(
+          "Values of type '" + TypeRegistry::get_name(value.get_type_index()) +
+          "' cannot be converted to Python");
+    }
+    return (*converter)(value);
+  }
+
+  /**
+   * @brief Find the converter of a type.
+   * @param type The type of the value.
+   * @return A pointer to the converter, or nullptr if the type has none.
+   */
+  const Converter *find(const std::type_index &type) const {
+    auto it = this->converters.find(type);
+    if (it == this->converters.end()) {
+      return nullptr;
+    }
+    return &it->second;
+  }
+
+  /**
+   * @brief Get the registry shared by all the modules.
+   *
+   * The registry is looked up in the yasmin.blackboard module the first time.
+   *
+   * @return A reference to the shared registry.
+   */
+  static PyConverterRegistry &get_instance() {
+    static PyConverterRegistry *instance = nullptr;
+
+    if (instance == nullptr) {
+      py::module_ module = py::module_::import("yasmin.blackboard");
+      instance = module.attr(CAPSULE_NAME).cast<py::capsule>();
+    }
+
+    return *instance;
+  }
+
+private:
+  /// Converters of each type
+  std::unordered_map<std::type_index, Converter> converters;
+};
+
+} // namespace blackboard
+} // namespace yasmin
+
+#endif // YASMIN__BLACKBOARD__PY_CONVERTER_REGISTRY_HPP
@@ -0,0 +1,216 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef YASMIN__BLACKBOARD__SERIALIZER_REGISTRY_HPP
+#define YASMIN__BLACKBOARD__SERIALIZER_REGISTRY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+#include <vector>
+
+#include "yasmin/blackboard/blackboard_transaction.hpp"
+#include "yasmin/blackboard/blackboard_value.hpp"
+#include "yasmin/blackboard/blackboard_value_interface.hpp"
+
+namespace yasmin {
+namespace blackboard {
+
+/**
+ * @struct BlackboardSerializer
+ * @brief Functions that convert the values of a type to bytes and back.
+ */
+struct BlackboardSerializer {
+  /// Name of the type in snapshots, which must not change between builds
+  std::string name;
+  /// Function that appends the bytes of a value to a buffer
+  std::function<void(const BlackboardValueInterface &,
+                     std::vector<std::uint8_t> &)>
+      serialize;
+  /// Function that sets a key from the bytes of its value
+  std::function<void(BlackboardTransaction &, const std::string &,
+                     const std::uint8_t *, std::size_t)>
+      deserialize;
+};
+
+/**
+ * @class SerializerRegistry
+ * @brief Serializers of the types stored in blackboards, used by snapshots.
+ *
+ * The registry comes with serializers for the basic scalars, strings and
+ * vectors. Other types, like messages, are added with register_serializer().
+ * Types are looked up by their std::type_index when saving and by the name
+ * of their serializer when restoring.
+ */
+class SerializerRegistry {
+public:
+  /**
+   * @brief Register the serializer of a type.
+   * @param type The type of the values.
+   * @param serializer The serializer, which replaces the previous one.
+   */
+  static void register_serializer(const std::type_index &type,
+                                  BlackboardSerializer serializer);
+
+  /**
+   * @brief Register the serializer of a type from typed functions.
+   * @tparam T The type of the values.
+   * @param name The name of the type in snapshots.
+   * @param serialize The function that appends the bytes of a value.
+   * @param deserialize The function that builds a value from its bytes.
+   */
+  template <class T>
+  static void register_serializer(
+      const std::string &name,
+      std::function<void(const T &, std::vector<std::uint8_t> &)> serialize,
+      std::function<T(const std::uint8_t *, std::size_t)> deserialize) {
+    register_serializer(typeid(T),
+                        make_serializer<T>(name, serialize, deserialize));
+  }
+
+  /**
+   * @brief Find the serializer of a type.
+   * @param type The type of the values.
+   * @return The serializer, or nullptr if the type has none.
+   */
+  static std::shared_ptr<const BlackboardSerializer>
+  find(const std::type_index &type);
+
+  /**
+   * @brief Find a serializer by its name.
+   * @param name The name of the type in snapshots.
+   * @return The serializer, or nullptr if there is none with the name.
+   */
+  static std::shared_ptr<const BlackboardSerializer>
+  find(const std::string &name);
+
+  /**
+   * @brief Build a serializer from typed functions.
+   * @tparam T The type of the values.
+   * @param name The name of the type in snapshots.
+   * @param serialize The function that appends the bytes of a value.
+   * @param deserialize The function that builds a value from its bytes.
+   * @return The serializer.
+   */
+  template <class T>
+  static BlackboardSerializer make_serializer(
+      const std::string &name,
+      std::function<void(const T &, std::vector<std::uint8_t> &)> serialize,
+      std::function<T(const std::uint8_t *, std::size_t)> deserialize) {
+    return BlackboardSerializer{
+        name,
+        [serialize](const BlackboardValueInterface &value,
+                    std::vector<std::uint8_t> &data) {
+          serialize(static_cast<const BlackboardValue<T> &>(value).get_ref(),
+                    data);
+        },
+        [deserialize](BlackboardTransaction &transaction,
+                      const std::string &key, const std::uint8_t *data,
+                      std::size_t size) {
+          transaction.set<T>(key, deserialize(data, size));
+        }};
+  }
+
+  /**
+   * @brief Build a serializer that copies the bytes of a trivially copyable
+   * type.
+   * @tparam T The type of the values.
+   * @param name The name of the type in snapshots.
+   * @return The serializer.
+   */
+  template <class T>
+  static BlackboardSerializer make_trivial_serializer(const std::string &name) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "The type must be trivially copyable");
+
+    return make_serializer<T>(
+        name,
+        [](const T &value, std::vector<std::uint8_t> &data) {
+          append(data, &value, sizeof(T));
+        },
+        [name](const std::uint8_t *data, std::size_t size) {
+          check_size(name, size, sizeof(T));
+          T value;
+          std::memcpy(&value, data, sizeof(T));
+          return value;
+        });
+  }
+
+  /**
+   * @brief Build a serializer that copies the elements of a vector of a
+   * trivially copyable type.
+   * @tparam T The type of the elements.
+   * @param name The name of the type in snapshots.
+   * @return The serializer.
+   */
+  template <class T>
+  static BlackboardSerializer
+  make_vector_serializer(const std::string &name) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "The elements must be trivially copyable");
+
+    return make_serializer<std::vector<T>>(
+        name,
+        [](const std::vector<T> &value, std::vector<std::uint8_t> &data) {
+          append(data, value.data(), value.size() * sizeof(T));
+        },
+        [name](const std::uint8_t *data, std::size_t size) {
+          check_size(name, size % sizeof(T), 0);
+          std::vector<T> value(size / sizeof(T));
+          if (size != 0) {
+            std::memcpy(value.data(), data, size);
+          }
+          return value;
+        });
+  }
+
+  /**
+   * @brief Append bytes to a buffer.
+   * @param data The buffer.
+   * @param bytes The bytes to append.
+   * @param size The number of bytes.
+   */
+  static void append(std::vector<std::uint8_t> &data, const void *bytes,
+                     std::size_t size) {
+    const std::uint8_t *begin = static_cast<const std::uint8_t *>(bytes);
+    data.insert(data.end(), begin, begin + size);
+  }
+
+  /**
+   * @brief Check the size of serialized data.
+   * @param name The name of the type, used in the error message.
+   * @param size The size of the data.
+   * @param expected_size The expected size.
+   * @throws std::runtime_error if the sizes are different.
+   */
+  static void check_size(const std::string &name, std::size_t size,
+                         std::size_t expected_size) {
+    if (size != expected_size) {
+      throw std::runtime_error("Invalid size of serialized '" + name + "'");
+    }
+  }
+};
+
+} // namespace blackboard
+} // namespace yasmin
+
+#endif // YASMIN__BLACKBOARD__SERIALIZER_REGISTRY_HPP
@@ -0,0 +1,353 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef YASMIN__BLACKBOARD__SHARED_MEMORY_SEGMENT_HPP
+#define YASMIN__BLACKBOARD__SHARED_MEMORY_SEGMENT_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include "yasmin/blackboard/blackboard_value.hpp"
+#include "yasmin/blackboard/blackboard_value_holder.hpp"
+#include "yasmin/blackboard/type_registry.hpp"
+
+namespace yasmin {
+namespace blackboard {
+
+class SharedMemorySegment;
+
+/**
+ * @struct SharedMemoryField
+ * @brief Key of a shared memory segment and the type of its value.
+ */
+struct SharedMemoryField {
+  /// The key
+  std::string name;
+  /// The type of the value
+  std::type_index type;
+  /// Size of the value in bytes
+  std::size_t size;
+  /// Function that reads the value into a holder, for the accesses that do
+  /// not know the type, like Blackboard::visit()
+  std::function<void(const SharedMemorySegment &, const std::string &,
+                     BlackboardValueHolder &)>
+      load;
+};
+
+/**
+ * @class SharedMemoryLayout
+ * @brief Keys stored in a shared memory segment and their types.
+ *
+ * All the processes that open a segment must use the same layout.
+ */
+class SharedMemoryLayout {
+private:
+  /// The fields, in the order they were added
+  std::vector<SharedMemoryField> fields;
+
+public:
+  /**
+   * @brief Add a key to the layout.
+   * @tparam T The type of the value, which is copied byte by byte between
+   * processes.
+   * @param name The key.
+   * @return The layout, to chain the calls.
+   */
+  template <class T> SharedMemoryLayout &add(const std::string &name);
+
+  /**
+   * @brief Get the fields of the layout.
+   * @return The fields, in the order they were added.
+   */
+  const std::vector<SharedMemoryField> &get_fields() const {
+    return this->fields;
+  }
+};
+
+/**
+ * @struct SharedMemorySlot
+ * @brief Header of the value of a key in a shared memory segment.
+ *
+ * It is followed by the data of the value, stored as 64-bit words.
+ */
+struct SharedMemorySlot {
+  /// Sequence of the seqlock of the value, odd while it is written
+  std::atomic<std::uint64_t> sequence;
+  /// Process writing the value, 0 if none
+  std::atomic<std::int32_t> writer;
+  /// Flag to indicate if the key has a value
+  std::atomic<std::uint32_t> present;
+  /// Number of writes, waited on by the processes blocked in
+  /// SharedMemorySegment::wait_for_change()
+  std::atomic<std::uint32_t> changes;
+  /// Number of threads blocked waiting for the value to change
+  std::atomic<std::uint32_t> waiters;
+};
+
+/**
+ * @class SharedMemorySegment
+ * @brief Named POSIX shared memory segment that holds blackboard values.
+ *
+ * The segment is created by the first process that opens it and the other
+ * ones map the same memory, so values written by one process are read by
+ * the others without messages or serialization. Each key has a fixed slot
+ * whose type is given by the layout, so only trivially copyable types are
+ * supported.
+ *
+ * Each slot is protected by a seqlock: readers never block and retry if a
+ * writer changed the value while they copied it, and writers exclude each
+ * other with an atomic compare-and-swap. If a process dies while writing a
+ * value, the next access of another process detects it and drops the
+ * half-written value.
+ *
+ * A segment is used by attaching it to a Blackboard, so states access the
+ * shared keys with the usual API.
+ */
+class SharedMemorySegment {
+public:
+  /// Bytes that identify the memory as a segment
+  static constexpr char MAGIC[8] = {'Y', 'A', 'S', 'M', 'I', 'N', 'S', 'M'};
+  /// Version of the layout of the memory
+  static constexpr std::uint32_t FORMAT_VERSION = 1;
+  /// Maximum size of the keys and the names of the types
+  static constexpr std::size_t MAX_NAME_SIZE = 63;
+
+  /**
+   * @brief Check if a type can be stored in a segment.
+   * @tparam T The type.
+   * @return True if the values of the type can be copied byte by byte.
+   */
+  template <class T> static constexpr bool is_shareable() {
+    return std::is_trivially_copyable<T>::value &&
+           std::is_default_constructible<T>::value;
+  }
+
+  /**
+   * @brief Constructs a SharedMemorySegment, creating the segment or opening
+   * an existing one.
+   * @param name The name of the segment.
+   * @param layout The keys of the segment, which must match the ones of the
+   * processes that already opened it.
+   * @throws std::runtime_error if the segment cannot be opened or has
+   * another layout.
+   * @throws std::invalid_argument if the layout is invalid.
+   */
+  SharedMemorySegment(const std::string &name,
+                      const SharedMemoryLayout &layout);
+
+  /** @brief Destroys the SharedMemorySegment, unmapping it. */
+  ~SharedMemorySegment();
+
+  SharedMemorySegment(const SharedMemorySegment &) = delete;
+  SharedMemorySegment &operator=(const SharedMemorySegment &) = delete;
+
+  /**
+   * @brief Remove a segment, which is freed when the processes close it.
+   * @param name The name of the segment.
+   * @return True if the segment was removed, false if it did not exist.
+   */
+  static bool unlink(const std::string &name);
+
+  /**
+   * @brief Get the name of the segment.
+   * @return The name, starting with a slash.
+   */
+  const std::string &get_name() const { return this->name; }
+
+  /**
+   * @brief Find the field of a key.
+   * @param key The key.
+   * @return The field, or nullptr if the key is not in the segment.
+   */
+  const SharedMemoryField *find(const std::string &key) const {
+    auto it = this->slots.find(key);
+    return it != this->slots.end() ? &it->second.field : nullptr;
+  }
+
+  /**
+   * @brief Write a value.
+   * @tparam T The type of the value.
+   * @param key The key.
+   * @param value The value.
+   * @throws std::runtime_error if the key is of another type.
+   */
+  template <class T> void store(const std::string &key, const T &value) {
+    const Slot &slot = this->get_slot(key, typeid(T));
+
+    if constexpr (is_shareable<T>()) {
+      std::uint64_t words[num_words(sizeof(T))] = {};
+      std::memcpy(words, &value, sizeof(T));
+      this->write(slot, words, true);
+    }
+  }
+
+  /**
+   * @brief Read a value.
+   * @tparam T The type of the value.
+   * @param key The key.
+   * @return The value.
+   * @throws std::runtime_error if the key has no value or it is of another
+   * type.
+   */
+  template <class T> T load(const std::string &key) const {
+    const Slot &slot = this->get_slot(key, typeid(T));
+
+    // The layout only holds types that can be shared, so get_slot() throws
+    // for the other ones
+    if constexpr (is_shareable<T>()) {
+      std::uint64_t words[num_words(sizeof(T))];
+      if (!this->read(slot, words)) {
+        throw std::runtime_error("Element '" + key +
+                                 "' does not exist in the blackboard");
+      }
+
+      T value;
+      std::memcpy(&value, words, sizeof(T));
+      return value;
+
+    } else {
+      throw std::logic_error("Element '" + key + "' cannot be shared");
+    }
+  }
+
+  /**
+   * @brief Remove the value of a key.
+   * @param key The key.
+   * @return True if the key had a value, otherwise false.
+   */
+  bool remove(const std::string &key);
+
+  /**
+   * @brief Check if a key has a value.
+   * @param key The key.
+   * @return True if the key has a value, otherwise false.
+   */
+  bool contains(const std::string &key) const;
+
+  /**
+   * @brief Get the version of a key, shared by all the processes.
+   * @param key The key.
+   * @return The number of times the key was set or removed.
+   */
+  std::uint64_t get_version(const std::string &key) const;
+
+  /**
+   * @brief Wait until a key changes in any process or a deadline passes.
+   * @param key The key.
+   * @param version The version of the key already seen, from get_version().
+   * @param deadline The time to stop waiting.
+   * @return True if the version of the key is no longer the given one, false
+   * if the deadline passed or the key is not in the segment.
+   */
+  bool wait_for_change(const std::string &key, std::uint64_t version,
+                       std::chrono::steady_clock::time_point deadline) const;
+
+  /**
+   * @brief Get the keys that have a value.
+   * @return The keys, in the order of the layout.
+   */
+  std::vector<std::string> get_keys() const;
+
+private:
+  /**
+   * @struct Slot
+   * @brief Field of a key and the address of its slot in the segment.
+   */
+  struct Slot {
+    /// The field of the layout
+    SharedMemoryField field;
+    /// The slot in the segment
+    SharedMemorySlot *slot;
+  };
+
+  /// The name of the segment
+  std::string name;
+  /// The mapped memory
+  void *memory{nullptr};
+  /// Size of the mapped memory
+  std::size_t size{0};
+  /// This process, which owns the slots while it writes them
+  std::int32_t pid;
+  /// Slots of the keys, in the order of the layout
+  std::vector<std::string> keys;
+  /// Slots of each key
+  std::unordered_map<std::string, Slot> slots;
+
+  /**
+   * @brief Get the number of words that hold a value.
+   * @param size The size of the value in bytes.
+   * @return The number of 64-bit words.
+   */
+  static constexpr std::size_t num_words(std::size_t size) {
+    return size == 0 ? 1 : (size + sizeof(std::uint64_t) - 1) /
+                               sizeof(std::uint64_t);
+  }
+
+  /**
+   * @brief Get the slot of a key, checking its type.
+   * @param key The key.
+   * @param type The type of the value to access.
+   * @return The slot.
+   * @throws std::runtime_error if the key is of another type.
+   */
+  const Slot &get_slot(const std::string &key, std::type_index type) const;
+
+  /**
+   * @brief Copy the words of a value out of its slot.
+   * @param slot The slot.
+   * @param words The buffer for the words.
+   * @return True if the key has a value, otherwise false.
+   */
+  bool read(const Slot &slot, std::uint64_t *words) const;
+
+  /**
+   * @brief Copy the words of a value into its slot.
+   * @param slot The slot.
+   * @param words The words, or nullptr to keep the current ones.
+   * @param present Flag to indicate if the key has a value.
+   * @return True if the key had a value before, otherwise false.
+   */
+  bool write(const Slot &slot, const std::uint64_t *words, bool present);
+};
+
+template <class T>
+SharedMemoryLayout &SharedMemoryLayout::add(const std::string &name) {
+  static_assert(SharedMemorySegment::is_shareable<T>(),
+                "Only trivially copyable types can be shared");
+
+  this->fields.push_back(
+      {name, typeid(T), sizeof(T),
+       [](const SharedMemorySegment &segment, const std::string &key,
+          BlackboardValueHolder &holder) {
+         holder.emplace<BlackboardValue<T>>(segment.load<T>(key));
+       }});
+  return *this;
+}
+
+} // namespace blackboard
+} // namespace yasmin
+
+#endif // YASMIN__BLACKBOARD__SHARED_MEMORY_SEGMENT_HPP
@@ -0,0 +1,47 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef YASMIN__BLACKBOARD__TYPE_REGISTRY_HPP
+#define YASMIN__BLACKBOARD__TYPE_REGISTRY_HPP
+
+#include <string>
+#include <typeindex>
+
+namespace yasmin {
+namespace blackboard {
+
+/**
+ * @class TypeRegistry
+ * @brief Readable names of the types stored in blackboards.
+ *
+ * Types are identified by their std::type_index. The name of a type is only
+ * demangled the first time it is requested and then cached, so it costs
+ * nothing to store values and names are only built for display.
+ */
+class TypeRegistry {
+public:
+  /**
+   * @brief Get the readable name of a type.
+   * @param type The type.
+   * @return The demangled name of the type, which stays valid for the
+   * lifetime of the process.
+   */
+  static const std::string &get_name(const std::type_index &type);
+};
+
+} // namespace blackboard
+} // namespace yasmin
+
+#endif // YASMIN__BLACKBOARD__TYPE_REGISTRY_HPP
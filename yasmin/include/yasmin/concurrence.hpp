@@ -18,6 +18,9 @@
 #define YASMIN__CONCURRENCE_HPP
 
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -32,7 +35,9 @@
 #endif
 
 #include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/outcome.hpp"
 #include "yasmin/state.hpp"
+#include "yasmin/thread_pool.hpp"
 
 namespace yasmin {
 
@@ -44,6 +49,34 @@ namespace yasmin {
  * for the termination of each, and then returns a single output
  * according to a provided rule map, or a default outcome if no rule is
  * satisfied.
+ *
+ * The states run on the idle workers of the shared ThreadPool and the calling
+ * thread runs the last one. When no worker is idle, the pool grows up to its
+ * maximum size, so all the states run at the same time and they can wait for
+ * each other. Once the pool is at its maximum size, the states that find no
+ * worker are queued and the calling thread runs the ones that no worker has
+ * taken after its own, so nested concurrences never start unbounded threads.
+ * States that wait for each other need a maximum size large enough to run
+ * them all at once (see ThreadPool::set_default_max_size()).
+ *
+ * A JoinPolicy other than ALL_COMPLETED stops waiting as soon as the result
+ * is fixed: the runs of the states that are still running are canceled with
+ * State::cancel_run(), the ones that have not started are skipped, and the
+ * outcome map is evaluated with the intermediate outcomes received until
+ * then. Canceled states are still awaited, so they should check
+ * is_canceled() to finish early.
+ *
+ * A ConflictPolicy other than SHARED gives each state a copy-on-write fork of
+ * the blackboard. The forks are merged in the order of the states after the
+ * join, so the result does not depend on the order in which the states run.
+ * The changes of the states that threw, were canceled by the join policy or
+ * did not run are discarded.
+ *
+ * The data of each execution, including the tasks of the states, is reused by
+ * later executions. With the SHARED policy, an execution does not allocate
+ * once the concurrence has run as many times at the same time as it will,
+ * unless the pool is busy and has to grow. The other policies
+ * allocate a fork of the blackboard for each state.
  */
 class Concurrence : public State {
 
@@ -51,6 +84,29 @@ public:
   typedef std::map<std::string, std::string> StateOutcomeMap;
   typedef std::map<std::string, StateOutcomeMap> OutcomeMap;
 
+  /**
+   * @enum JoinPolicy
+   * @brief Condition to stop waiting for the concurrent states.
+   */
+  enum class JoinPolicy {
+    ALL_COMPLETED,   ///< Wait for all the states to finish
+    FIRST_COMPLETED, ///< Finish when the first state finishes
+    QUORUM,          ///< Finish when a number of states have finished
+    FAIL_FAST        ///< Finish when a state returns the fail-fast outcome
+  };
+
+  /**
+   * @enum ConflictPolicy
+   * @brief How the changes of the concurrent states to the blackboard are
+   * combined.
+   */
+  enum class ConflictPolicy {
+    SHARED,     ///< Write to the shared blackboard while running
+    LAST_WINS,  ///< Merge forks, the last state that changed a key wins
+    FIRST_WINS, ///< Merge forks, the first state that changed a key wins
+    FAIL        ///< Merge forks, throw if several states changed a key
+  };
+
 protected:
   /// The states to run concurrently (name -> state)
   const std::map<std::string, std::shared_ptr<State>> states;
@@ -62,15 +118,198 @@ protected:
   /// overall output
   OutcomeMap outcome_map;
 
-  /// Stores the intermediate outcomes of the concurrent states
-  std::map<std::string, std::shared_ptr<std::string>> intermediate_outcome_map;
-
   /// The set of possible outcomes
   std::set<std::string> possible_outcomes;
 
+  /// Condition to stop waiting for the concurrent states
+  const JoinPolicy join_policy;
+
+  /// Number of finished states required by the QUORUM policy
+  const std::size_t quorum;
+
+  /// Intermediate outcome that finishes the FAIL_FAST policy
+  const std::string fail_fast_outcome;
+
+  /// How the changes of the states to the blackboard are combined
+  const ConflictPolicy conflict_policy;
+
 private:
-  /// Mutex for intermediate outcome map
-  std::mutex intermediate_outcome_mutex;
+  /// Value of a slot that has not received an intermediate outcome
+  static constexpr int NO_OUTCOME = -1;
+
+  /**
+   * @struct Branch
+   * @brief A concurrent state.
+   */
+  struct Branch {
+    /// Name of the state
+    std::string name;
+    /// The state to run
+    std::shared_ptr<State> state;
+  };
+
+  /**
+   * @struct BranchRun
+   * @brief The run of a concurrent state in an execution and the slot for its
+   * intermediate outcome.
+   *
+   * The slots are written only by the thread running the state, so storing an
+   * outcome takes no lock.
+   */
+  struct BranchRun {
+    /// Blackboard of the state
+    std::shared_ptr<blackboard::Blackboard> blackboard;
+    /// Index of the intermediate outcome in the outcomes of the state
+    int outcome{NO_OUTCOME};
+    /// Position in which the state finished, SIZE_MAX if it did not run
+    std::size_t order{SIZE_MAX};
+    /// Exception thrown by the state, if any
+    std::exception_ptr exception;
+    /// Flag to indicate if the state is running
+    std::atomic_bool running{false};
+    /// Run of the state, canceled without canceling other executions
+    StateRun run;
+  };
+
+  struct Execution;
+
+  /**
+   * @class BranchTask
+   * @brief Task that runs a branch of an execution in the thread pool.
+   *
+   * The tasks are allocated with their execution and submitted again by each
+   * run that reuses it. A task run by the joining thread can stay in a queue
+   * of the pool after its execution, so the queue shares its ownership and a
+   * worker that takes it later finds it already claimed.
+   */
+  class BranchTask : public ThreadPool::Task {
+  public:
+    /// The concurrence running the branch
+    Concurrence *concurrence{nullptr};
+    /// The execution of the branch
+    Execution *execution{nullptr};
+    /// Index of the branch
+    std::size_t index{0};
+    /// Flag to indicate if the task waits for a busy worker
+    bool queued{false};
+
+  protected:
+    /// @brief Runs the branch
+    void run() override {
+      this->concurrence->run_branch(*this->execution, this->index);
+    }
+  };
+
+  /**
+   * @struct Execution
+   * @brief The data of one execution of the concurrence.
+   *
+   * Each run of the concurrence has its own execution, so several state
+   * machine instances can run the same concurrence at the same time.
+   * Executions, with their slots and tasks, are reused by later runs.
+   */
+  struct Execution {
+    /**
+     * @brief Constructs an execution for the branches of a concurrence.
+     * @param concurrence The concurrence.
+     */
+    explicit Execution(Concurrence *concurrence)
+        : branches(concurrence->branches.size()),
+          tasks(concurrence->branches.size()) {
+      for (std::size_t i = 0; i < this->tasks.size(); ++i) {
+        this->tasks[i] = std::make_shared<BranchTask>();
+        this->tasks[i]->concurrence = concurrence;
+        this->tasks[i]->execution = this;
+        this->tasks[i]->index = i;
+      }
+    }
+
+    /// Run of the concurrence, nullptr if execute() was called directly
+    const StateRun *run{nullptr};
+    /// Runs of the branches, in the same order as the branches
+    std::vector<BranchRun> branches;
+    /// Tasks of the branches
+    std::vector<std::shared_ptr<BranchTask>> tasks;
+    /// Number of branches that have not finished
+    std::atomic<std::size_t> running_branches{0};
+    /// Number of branches that have finished
+    std::atomic<std::size_t> finished_branches{0};
+    /// Flag to indicate if the join policy has been fulfilled
+    std::atomic_bool joined{false};
+    /// Position of the branch that fulfilled the join policy
+    std::atomic<std::size_t> join_order{SIZE_MAX};
+    /// Mutex to wait for the branches
+    std::mutex join_mutex;
+    /// Condition variable to wait for the branches
+    std::condition_variable join_cond;
+  };
+
+  /**
+   * @struct CompiledRequirement
+   * @brief A requirement of the outcome map as branch and outcome indices.
+   */
+  struct CompiledRequirement {
+    /// Index of the branch
+    std::size_t branch;
+    /// Index of the expected outcome in the outcomes of the state
+    int outcome;
+  };
+
+  /**
+   * @struct CompiledOutcome
+   * @brief An outcome of the outcome map with its compiled requirements.
+   */
+  struct CompiledOutcome {
+    /// The outcome of the concurrence
+    std::string outcome;
+    /// Requirements to produce the outcome
+    std::vector<CompiledRequirement> requirements;
+  };
+
+  /// Concurrent states, in the same order as the states map
+  std::vector<Branch> branches;
+  /// Outcome map compiled into branch and outcome indices
+  std::vector<CompiledOutcome> compiled_outcome_map;
+  /// Interned intermediate outcome that finishes the FAIL_FAST policy
+  Outcome compiled_fail_fast_outcome;
+
+  /// Executions that are running
+  std::vector<std::unique_ptr<Execution>> executions;
+  /// Executions that have finished, reused by the next runs
+  std::vector<std::unique_ptr<Execution>> free_executions;
+  /// Mutex for the executions
+  std::mutex executions_mutex;
+
+  /// @brief Gets an execution for the run of the calling thread
+  /// @param blackboard The blackboard of the run
+  /// @return The execution, with its slots cleared
+  Execution &
+  acquire_execution(std::shared_ptr<blackboard::Blackboard> blackboard);
+
+  /// @brief Releases an execution after its run finishes
+  /// @param execution The execution to release
+  void release_execution(Execution &execution);
+
+  /// @brief Builds the outcome of an execution after its branches finish
+  /// @param blackboard The blackboard the branches were forked from
+  /// @param execution The finished execution
+  /// @return The outcome of the concurrence
+  /// @throws std::runtime_error If a required intermediate outcome is missing
+  std::string join(std::shared_ptr<blackboard::Blackboard> blackboard,
+                   const Execution &execution);
+
+  /// @brief Runs a branch and fulfills the join policy if needed
+  /// @param execution The execution running the branch
+  /// @param index Index of the branch
+  void run_branch(Execution &execution, std::size_t index);
+
+  /// @brief Merges the forks of the branches that finished before the join
+  /// @param blackboard The blackboard the branches were forked from
+  /// @param execution The execution with the forks of the branches
+  /// @param last_order Position of the last branch whose changes are kept
+  /// @throws std::runtime_error If the FAIL policy finds a conflict
+  void merge_branches(std::shared_ptr<blackboard::Blackboard> blackboard,
+                      const Execution &execution, std::size_t last_order);
 
   /// @brief Helper function to generate a set of possible outcomes from an
   /// outcome map
@@ -81,6 +320,13 @@ private:
   generate_possible_outcomes(const OutcomeMap &outcome_map,
                              const std::string &default_outcome);
 
+  /// @brief Checks if the join policy is fulfilled after a state finishes
+  /// @param finished_states Number of states finished so far
+  /// @param outcome Intermediate outcome of the last finished state
+  /// @return True if the remaining states can be canceled
+  bool is_join_reached(std::size_t finished_states,
+                       const Outcome &outcome) const;
+
 public:
   /**
    * @brief Constructs a State with a set of possible outcomes.
@@ -89,10 +335,22 @@ public:
    * rules are satisfied.
    * @param outcome_map A map of outcome names to requirements for achieving
    * that outcome.
+   * @param join_policy Condition to stop waiting for the states.
+   * @param quorum Number of finished states required by the QUORUM policy.
+   * @param fail_fast_outcome Intermediate outcome that finishes the FAIL_FAST
+   * policy.
+   * @param conflict_policy How the changes of the states to the blackboard
+   * are combined.
+   * @throws std::invalid_argument If the states, the outcome map or the join
+   * policy parameters are not valid.
    */
   Concurrence(const std::map<std::string, std::shared_ptr<State>> &states,
               const std::string &default_outcome,
-              const OutcomeMap &outcome_map);
+              const OutcomeMap &outcome_map,
+              JoinPolicy join_policy = JoinPolicy::ALL_COMPLETED,
+              std::size_t quorum = 0,
+              const std::string &fail_fast_outcome = "",
+              ConflictPolicy conflict_policy = ConflictPolicy::SHARED);
 
   /**
    * @brief Executes the state's specific logic.
@@ -109,7 +367,8 @@ public:
   /**
    * @brief Cancels the current state execution.
    *
-   * This method sets the canceled flag to true and logs the action.
+   * This method cancels the states of the execution being canceled, or of
+   * every execution if no run is targeted, and logs the action.
    */
   void cancel_state() override;
 
@@ -131,6 +390,30 @@ public:
    */
   const std::string &get_default_outcome() const;
 
+  /**
+   * @brief Returns the join policy for this concurrence state.
+   * @return The join policy.
+   */
+  JoinPolicy get_join_policy() const;
+
+  /**
+   * @brief Returns the number of finished states required by QUORUM.
+   * @return The quorum.
+   */
+  std::size_t get_quorum() const;
+
+  /**
+   * @brief Returns the intermediate outcome that finishes FAIL_FAST.
+   * @return The fail-fast outcome.
+   */
+  const std::string &get_fail_fast_outcome() const;
+
+  /**
+   * @brief Returns the conflict policy for this concurrence state.
+   * @return The conflict policy.
+   */
+  ConflictPolicy get_conflict_policy() const;
+
   /**
    * @brief Converts the state to a string representation.
    * @return A string representation of the state.
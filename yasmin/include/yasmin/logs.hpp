@@ -16,9 +16,34 @@
 #ifndef YASMIN__LOGS_HPP
 #define YASMIN__LOGS_HPP
 
+#include <atomic>
+#include <chrono>
 #include <cstdarg>
+#include <cstddef>
 #include <cstring>
 #include <string>
+#include <tuple>
+#include <type_traits>
+
+/**
+ * @brief Most verbose log level compiled into the logging macros.
+ *
+ * Messages less severe than this level (0 -> ERROR, 1 -> WARN, 2 -> INFO, 3
+ * -> DEBUG) are removed at compile time, along with the evaluation of their
+ * arguments, so set_log_level() cannot enable them. It is set with the
+ * YASMIN_MIN_LOG_LEVEL CMake option.
+ */
+#ifndef YASMIN_MIN_LOG_LEVEL
+#define YASMIN_MIN_LOG_LEVEL 3
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+/// Check the arguments of a function against its printf-like format string
+#define YASMIN_PRINTF_FORMAT(format_index, first_arg_index)                    \
+  __attribute__((format(printf, format_index, first_arg_index)))
+#else
+#define YASMIN_PRINTF_FORMAT(format_index, first_arg_index)
+#endif
 
 namespace yasmin {
 
@@ -49,9 +74,18 @@ enum LogLevel {
  *
  * This global variable holds the current log level, which determines the
  * verbosity of the logs. Logs at or above this level will be displayed. The
- * default level is set to INFO.
+ * default level is set to INFO. It is read with relaxed ordering, since it
+ * only filters messages.
+ */
+extern std::atomic<LogLevel> log_level;
+
+/**
+ * @brief Gets the current log level.
+ * @return The log level.
  */
-extern LogLevel log_level;
+inline LogLevel get_log_level() {
+  return log_level.load(std::memory_order_relaxed);
+}
 
 /**
  * @brief Default logging function.
@@ -105,12 +139,354 @@ typedef void (*LogFunction)(LogLevel level, const char *file,
 
 extern LogFunction log_message; ///< Pointer to the logging function
 
+/**
+ * @brief Format a message like printf into a string.
+ *
+ * The capacity of the string is reused, so formatting into the same string
+ * does not allocate once it is large enough.
+ *
+ * @param message The string where the message is written.
+ * @param text The format string for the message.
+ * @param ... Additional arguments for the format string.
+ */
+void format_message(std::string &message, const char *text, ...);
+
+/**
+ * @brief Check the arguments of a message against its format string at
+ * compile time.
+ *
+ * The logging macros only use it in unevaluated expressions, so it is never
+ * called.
+ *
+ * @param text The format string for the message.
+ * @param ... Additional arguments for the format string.
+ */
+YASMIN_PRINTF_FORMAT(1, 2)
+inline void check_log_format(const char *text, ...) { (void)text; }
+
+/**
+ * @struct LogSite
+ * @brief Place of the code where a message is logged.
+ *
+ * The logging macros build a static LogSite for each call, so asynchronous
+ * records only store a pointer to it.
+ */
+struct LogSite {
+  /// The source file where the log function is called
+  const char *file;
+  /// The function where the log function is called
+  const char *function;
+  /// The line number in the source file
+  int line;
+};
+
+/**
+ * @enum LogOverflowPolicy
+ * @brief What to do when a thread logs a message and its asynchronous log
+ * buffer is full.
+ */
+enum class LogOverflowPolicy {
+  /// Drop the message. The number of dropped messages is logged later.
+  DROP,
+  /// Wait until the background thread frees space in the buffer.
+  BLOCK
+};
+
+/**
+ * @struct AsyncLogOptions
+ * @brief Options of the asynchronous logging mode.
+ */
+struct AsyncLogOptions {
+  /// Number of records of the buffer of each thread, rounded up to a power
+  /// of two
+  std::size_t capacity = 1024;
+  /// What to do when the buffer of a thread is full
+  LogOverflowPolicy overflow_policy = LogOverflowPolicy::DROP;
+  /// Maximum time the background thread waits before writing new messages
+  std::chrono::milliseconds flush_interval{10};
+};
+
+/// Size of the arguments stored in an asynchronous log record
+constexpr std::size_t LOG_RECORD_DATA_SIZE = 224;
+
+/**
+ * @brief Type of the functions that format the arguments of a record.
+ * @param text The format string.
+ * @param data The encoded arguments.
+ * @param message The string where the message is written.
+ */
+typedef void (*LogRecordFormatter)(const char *text,
+                                   const unsigned char *data,
+                                   std::string &message);
+
+/**
+ * @struct LogRecord
+ * @brief Message logged in asynchronous mode, formatted by the background
+ * thread.
+ */
+struct LogRecord {
+  /// The log level of the message
+  LogLevel level;
+  /// The place where the message was logged, nullptr if its line, file and
+  /// function are copied at the start of the data, followed by the text
+  const LogSite *site;
+  /// The format string, nullptr if it is copied at the start of the data
+  const char *text;
+  /// The function that formats the arguments
+  LogRecordFormatter formatter;
+  /// The arguments, copied by value with their strings
+  alignas(8) unsigned char data[LOG_RECORD_DATA_SIZE];
+};
+
+/**
+ * @brief Flag to indicate if messages are logged asynchronously.
+ */
+extern std::atomic<bool> async_logs_enabled;
+
+/**
+ * @brief Log messages asynchronously.
+ *
+ * Each logging thread copies its messages, unformatted, into a lock-free
+ * buffer of its own and a background thread formats them and calls the
+ * logging function. Messages of a thread keep their order, but messages of
+ * different threads may be interleaved. The format string of the messages
+ * with arguments must outlive the call, as string literals do.
+ *
+ * The logging function must not be changed while messages are logged
+ * asynchronously. Pending messages are written when the asynchronous mode is
+ * disabled and when the program exits.
+ *
+ * @param options The options of the asynchronous mode.
+ */
+void enable_async_logs(const AsyncLogOptions &options = AsyncLogOptions());
+
+/**
+ * @brief Write the pending messages and log synchronously again.
+ */
+void disable_async_logs();
+
+/**
+ * @brief Wait until the messages logged so far are written.
+ *
+ * It returns at once if the asynchronous mode is disabled.
+ */
+void flush_logs();
+
+/**
+ * @brief Reserve a record in the asynchronous log buffer of this thread.
+ * @return The record, or nullptr if the buffer is full and the message is
+ * dropped or if the asynchronous mode is disabled.
+ */
+LogRecord *reserve_log_record();
+
+/**
+ * @brief Publish the record reserved in the buffer of this thread to the
+ * background thread.
+ *
+ * If the buffer was closed by disable_async_logs() meanwhile, the record is
+ * written synchronously.
+ */
+void commit_log_record();
+
+/**
+ * @struct LogArg
+ * @brief Encoding of an argument of a message in a log record.
+ *
+ * Arguments are copied by value. Only trivially copyable types, as accepted
+ * by printf, can be logged.
+ *
+ * @tparam T The type of the argument.
+ */
+template <class T> struct LogArg {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Only trivially copyable values can be logged");
+
+  /**
+   * @brief Copy an argument into the data of a record.
+   * @param data The data of the record.
+   * @param offset The offset where the argument is copied, which is advanced.
+   * @param value The argument.
+   * @return True if the argument fits in the record, otherwise false.
+   */
+  static bool encode(unsigned char *data, std::size_t &offset,
+                     const T &value) {
+    offset = (offset + alignof(T) - 1) & ~(alignof(T) - 1);
+    if (offset + sizeof(T) > LOG_RECORD_DATA_SIZE) {
+      return false;
+    }
+
+    std::memcpy(data + offset, &value, sizeof(T));
+    offset += sizeof(T);
+    return true;
+  }
+
+  /**
+   * @brief Read an argument from the data of a record.
+   * @param data The data of the record.
+   * @param offset The offset of the argument, which is advanced.
+   * @return The argument.
+   */
+  static T decode(const unsigned char *data, std::size_t &offset) {
+    offset = (offset + alignof(T) - 1) & ~(alignof(T) - 1);
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    offset += sizeof(T);
+    return value;
+  }
+};
+
+/**
+ * @struct LogArg<const char *>
+ * @brief Strings are copied into the record, since they may not outlive the
+ * call. A message whose strings do not fit is logged synchronously.
+ */
+template <> struct LogArg<const char *> {
+  /**
+   * @brief Copy a string into the data of a record.
+   * @param data The data of the record.
+   * @param offset The offset where the string is copied, which is advanced.
+   * @param value The string.
+   * @return True if the whole string fits in the record, otherwise false.
+   */
+  static bool encode(unsigned char *data, std::size_t &offset,
+                     const char *value) {
+    if (value == nullptr) {
+      value = "(null)";
+    }
+
+    std::size_t size = std::strlen(value);
+    if (offset >= LOG_RECORD_DATA_SIZE ||
+        size > LOG_RECORD_DATA_SIZE - offset - 1) {
+      return false;
+    }
+
+    std::memcpy(data + offset, value, size);
+    data[offset + size] = '\0';
+    offset += size + 1;
+    return true;
+  }
+
+  /**
+   * @brief Read a string from the data of a record.
+   * @param data The data of the record.
+   * @param offset The offset of the string, which is advanced.
+   * @return The string, which points into the record.
+   */
+  static const char *decode(const unsigned char *data, std::size_t &offset) {
+    const char *value = reinterpret_cast<const char *>(data + offset);
+    offset += std::strlen(value) + 1;
+    return value;
+  }
+};
+
+/**
+ * @struct LogArg<char *>
+ * @brief Strings are copied into the record. They are decoded as const
+ * char *, since they point into the record.
+ */
+template <> struct LogArg<char *> : LogArg<const char *> {};
+
+/**
+ * @brief Format the arguments of a record.
+ * @tparam Args The types of the arguments.
+ * @param text The format string.
+ * @param data The encoded arguments.
+ * @param message The string where the message is written.
+ */
+template <class... Args>
+void format_log_record(const char *text, const unsigned char *data,
+                       std::string &message) {
+  std::size_t offset = 0;
+  (void)data;
+  (void)offset;
+
+  // Braced initialization decodes the arguments in order. The types are the
+  // decoded ones, so char * arguments are read back as const char *.
+  std::tuple<decltype(LogArg<Args>::decode(data, offset))...> args{
+      LogArg<Args>::decode(data, offset)...};
+  std::apply(
+      [&message, text](const auto &...values) {
+        format_message(message, text, values...);
+      },
+      args);
+}
+
+/**
+ * @brief Copy a message into the asynchronous log buffer of this thread.
+ * @tparam Args The types of the arguments.
+ * @param level The log level of the message.
+ * @param site The place where the message is logged.
+ * @param text The format string for the message.
+ * @param args The arguments for the format string.
+ * @return True if the message was buffered or dropped, false if it must be
+ * logged synchronously because its text or arguments do not fit in a record
+ * or the asynchronous mode was disabled.
+ */
+template <class... Args>
+bool push_log_record(LogLevel level, const LogSite &site, const char *text,
+                     const Args &...args) {
+  LogRecord *record = reserve_log_record();
+  if (record == nullptr) {
+    // The message was dropped, unless the asynchronous mode was disabled
+    return async_logs_enabled.load(std::memory_order_relaxed);
+  }
+
+  record->level = level;
+  record->site = &site;
+  record->formatter = &format_log_record<Args...>;
+  std::size_t offset = 0;
+
+  if constexpr (sizeof...(Args) == 0) {
+    // Messages without arguments are often built at runtime
+    record->text = nullptr;
+    if (!LogArg<const char *>::encode(record->data, offset, text)) {
+      return false;
+    }
+
+  } else {
+    record->text = text;
+    if (!(LogArg<Args>::encode(record->data, offset, args) && ...)) {
+      return false;
+    }
+  }
+
+  commit_log_record();
+  return true;
+}
+
 /**
  * @brief Variadic template function to log messages at different levels.
  *
  * This function wraps log_message and allows logging messages with different
  * log levels while reducing redundant code. It provides a consistent logging
- * format across all levels.
+ * format across all levels. In asynchronous mode, the message is copied to
+ * the buffer of the thread and formatted by the background thread.
+ *
+ * @tparam LEVEL The log level LogLevel (e.g., 0 -> "ERROR", 1 -> "WARN", 2 ->
+ * "INFO", 3 -> "DEBUG").
+ * @param site The place where the message is logged, which must outlive the
+ * call.
+ * @param text The format string for the log message.
+ * @param args Additional arguments for the format string.
+ */
+template <yasmin::LogLevel LEVEL, class... Args>
+void log_helper(const LogSite &site, const char *text, Args... args) {
+  if (async_logs_enabled.load(std::memory_order_relaxed) &&
+      push_log_record(LEVEL, site, text, args...)) {
+    return;
+  }
+
+  std::string buffer;
+  format_message(buffer, text, args...);
+  yasmin::log_message(LEVEL, site.file, site.function, site.line,
+                      buffer.c_str());
+}
+
+/**
+ * @brief Variadic template function to log messages at different levels.
+ *
+ * The message is always logged synchronously, since the place where it is
+ * logged is not kept.
  *
  * @tparam LEVEL The log level LogLevel (e.g., 0 -> "ERROR", 1 -> "WARN", 2 ->
  * "INFO", 3 -> "DEBUG").
@@ -118,64 +494,75 @@ extern LogFunction log_message; ///< Pointer to the logging function
  * @param function The function where the log function is called.
  * @param line The line number in the source file.
  * @param text The format string for the log message.
- * @param ... Additional arguments for the format string.
+ * @param args Additional arguments for the format string.
  */
-template <yasmin::LogLevel LEVEL>
+template <yasmin::LogLevel LEVEL, class... Args>
 void log_helper(const char *file, const char *function, int line,
-                const char *text, ...) {
-  va_list args;
-  va_start(args, text);
-
-  // Calculate the required buffer size
-  int size = vsnprintf(nullptr, 0, text, args) + 1;
-  va_end(args);
-
-  std::string buffer(size, '\0');
-  va_start(args, text);
-  vsnprintf(&buffer[0], buffer.size(), text, args);
-
-  va_end(args);
-
+                const char *text, Args... args) {
+  std::string buffer;
+  format_message(buffer, text, args...);
   yasmin::log_message(LEVEL, file, function, line, buffer.c_str());
 }
 
+/**
+ * @brief Log a formatted message whose place is not kept by the caller.
+ *
+ * In asynchronous mode, the file, function and text are copied into the
+ * buffer of the thread, so the messages of other languages, like Python, keep
+ * their order with the ones of the C++ code. A message that does not fit in
+ * a record is logged synchronously.
+ *
+ * @param level The log level of the message.
+ * @param file The source file where the message is logged.
+ * @param function The function where the message is logged.
+ * @param line The line number in the source file.
+ * @param text The message.
+ */
+void log_text(LogLevel level, const char *file, const char *function,
+              int line, const char *text);
+
 /**
  * @brief Extracts the filename from a given file path.
  *
  * This function takes a full path to a file and returns just the file name.
+ * It can be evaluated at compile time.
  *
  * @param path The full path to the file.
  * @return A pointer to the extracted filename.
  */
-inline const char *extract_filename(const char *path) {
-  const char *filename = std::strrchr(path, '/');
-  if (!filename) {
-    filename = std::strrchr(path, '\\'); // handle Windows-style paths
+constexpr const char *extract_filename(const char *path) {
+  const char *filename = path;
+  for (const char *c = path; *c != '\0'; ++c) {
+    if (*c == '/' || *c == '\\') { // handle Windows-style paths
+      filename = c + 1;
+    }
   }
-  return filename ? filename + 1 : path;
+  return filename;
 }
 
-// Macros for logging with automatic file and function information
+// Macros for logging with automatic file and function information. The
+// format string is checked at compile time and the levels above
+// YASMIN_MIN_LOG_LEVEL are compiled out.
+#define YASMIN_LOG(level, text, ...)                                           \
+  do {                                                                         \
+    (void)sizeof(::yasmin::check_log_format(text, ##__VA_ARGS__), 0);          \
+    if constexpr (level <= YASMIN_MIN_LOG_LEVEL) {                             \
+      if (::yasmin::get_log_level() >= level) {                                \
+        static const ::yasmin::LogSite yasmin_log_site{                        \
+            ::yasmin::extract_filename(__FILE__), __FUNCTION__, __LINE__};     \
+        ::yasmin::log_helper<level>(yasmin_log_site, text, ##__VA_ARGS__);     \
+      }                                                                        \
+    }                                                                          \
+  } while (0)
+
 #define YASMIN_LOG_ERROR(text, ...)                                            \
-  if (yasmin::log_level >= yasmin::ERROR)                                      \
-  yasmin::log_helper<yasmin::ERROR>(::yasmin::extract_filename(__FILE__),      \
-                                    __FUNCTION__, __LINE__, text,              \
-                                    ##__VA_ARGS__)
+  YASMIN_LOG(yasmin::ERROR, text, ##__VA_ARGS__)
 #define YASMIN_LOG_WARN(text, ...)                                             \
-  if (yasmin::log_level >= yasmin::WARN)                                       \
-  yasmin::log_helper<yasmin::WARN>(::yasmin::extract_filename(__FILE__),       \
-                                   __FUNCTION__, __LINE__, text,               \
-                                   ##__VA_ARGS__)
+  YASMIN_LOG(yasmin::WARN, text, ##__VA_ARGS__)
 #define YASMIN_LOG_INFO(text, ...)                                             \
-  if (yasmin::log_level >= yasmin::INFO)                                       \
-  yasmin::log_helper<yasmin::INFO>(::yasmin::extract_filename(__FILE__),       \
-                                   __FUNCTION__, __LINE__, text,               \
-                                   ##__VA_ARGS__)
+  YASMIN_LOG(yasmin::INFO, text, ##__VA_ARGS__)
 #define YASMIN_LOG_DEBUG(text, ...)                                            \
-  if (yasmin::log_level >= yasmin::DEBUG)                                      \
-  yasmin::log_helper<yasmin::DEBUG>(::yasmin::extract_filename(__FILE__),      \
-                                    __FUNCTION__, __LINE__, text,              \
-                                    ##__VA_ARGS__)
+  YASMIN_LOG(yasmin::DEBUG, text, ##__VA_ARGS__)
 
 /**
  * @brief Sets custom logging functions for different log levels.
@@ -0,0 +1,242 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef YASMIN__OUTCOME_HPP
+#define YASMIN__OUTCOME_HPP
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace yasmin {
+
+/**
+ * @class Outcome
+ * @brief Interned handle of an outcome name.
+ *
+ * Outcomes are registered once in a global thread-safe symbol table, so two
+ * outcomes with the same name share the same handle and can be compared as
+ * pointers. An Outcome can be built from string literals and strings, and it
+ * converts back to a std::string reference.
+ */
+class Outcome {
+private:
+  /// Pointer to the interned name of the outcome.
+  const std::string *name;
+
+  /**
+   * @brief Constructs an Outcome from an interned name.
+   * @param name Pointer to the interned name.
+   */
+  explicit Outcome(const std::string *name) : name(name) {}
+
+  /**
+   * @brief Registers a name in the symbol table.
+   * @param name The name to register.
+   * @return A pointer to the interned name.
+   */
+  static const std::string *intern(const std::string &name);
+
+  /**
+   * @brief Gets the interned empty name, registered only once.
+   * @return A pointer to the interned empty name.
+   */
+  static const std::string *empty_name();
+
+public:
+  /** @brief Constructs the empty outcome. */
+  Outcome();
+
+  /**
+   * @brief Constructs an Outcome, registering its name if needed.
+   * @param name The name of the outcome.
+   */
+  Outcome(const char *name);
+
+  /**
+   * @brief Constructs an Outcome, registering its name if needed.
+   * @param name The name of the outcome.
+   */
+  Outcome(const std::string &name);
+
+  /**
+   * @brief Looks up an outcome without registering its name.
+   * @param name The name of the outcome.
+   * @return The outcome if the name is already registered, otherwise nullopt.
+   */
+  static std::optional<Outcome> find(const std::string &name);
+
+  /**
+   * @brief Gets the name of the outcome.
+   * @return A constant reference to the interned name.
+   */
+  const std::string &str() const { return *this->name; }
+
+  /**
+   * @brief Gets the name of the outcome as a C string.
+   * @return A pointer to the interned name.
+   */
+  const char *c_str() const { return this->name->c_str(); }
+
+  /**
+   * @brief Converts the outcome to its name.
+   * @return A constant reference to the interned name.
+   */
+  operator const std::string &() const { return *this->name; }
+
+  /// Compares two outcomes by identity.
+  friend bool operator==(const Outcome &lhs, const Outcome &rhs) {
+    return lhs.name == rhs.name;
+  }
+  /// Compares two outcomes by identity.
+  friend bool operator!=(const Outcome &lhs, const Outcome &rhs) {
+    return lhs.name != rhs.name;
+  }
+  /// Compares an outcome with a name.
+  friend bool operator==(const Outcome &lhs, const std::string &rhs) {
+    return *lhs.name == rhs;
+  }
+  /// Compares an outcome with a name.
+  friend bool operator==(const std::string &lhs, const Outcome &rhs) {
+    return lhs == *rhs.name;
+  }
+  /// Compares an outcome with a name.
+  friend bool operator==(const Outcome &lhs, const char *rhs) {
+    return *lhs.name == rhs;
+  }
+  /// Compares an outcome with a name.
+  friend bool operator==(const char *lhs, const Outcome &rhs) {
+    return lhs == *rhs.name;
+  }
+  /// Compares an outcome with a name.
+  friend bool operator!=(const Outcome &lhs, const std::string &rhs) {
+    return !(lhs == rhs);
+  }
+  /// Compares an outcome with a name.
+  friend bool operator!=(const Outcome &lhs, const char *rhs) {
+    return !(lhs == rhs);
+  }
+  /// Orders outcomes by name.
+  friend bool operator<(const Outcome &lhs, const Outcome &rhs) {
+    return lhs.name != rhs.name && *lhs.name < *rhs.name;
+  }
+  /// Writes the name of the outcome.
+  friend std::ostream &operator<<(std::ostream &os, const Outcome &outcome) {
+    return os << *outcome.name;
+  }
+
+  friend struct std::hash<Outcome>;
+};
+
+/**
+ * @class OutcomeSet
+ * @brief Immutable set of outcomes shared between states.
+ *
+ * Outcome sets are interned as well, so all the states with the same outcomes
+ * share a single instance. Membership checks compare outcome handles instead
+ * of strings.
+ */
+class OutcomeSet {
+private:
+  /// Names of the outcomes.
+  const std::set<std::string> names;
+  /// Outcome handles, in the same order as the names.
+  std::vector<Outcome> outcomes;
+
+public:
+  /**
+   * @brief Constructs an OutcomeSet. Use intern() to share instances.
+   * @param names Names of the outcomes.
+   */
+  explicit OutcomeSet(const std::set<std::string> &names);
+
+  /**
+   * @brief Gets the shared instance for a set of outcome names.
+   * @param names Names of the outcomes.
+   * @return A shared pointer to the immutable outcome set.
+   */
+  static std::shared_ptr<const OutcomeSet>
+  intern(const std::set<std::string> &names);
+
+  /**
+   * @brief Gets the names of the outcomes.
+   * @return A constant reference to the set of names.
+   */
+  const std::set<std::string> &get_names() const { return this->names; }
+
+  /**
+   * @brief Gets the outcome handles, sorted by name.
+   * @return A constant reference to the vector of outcomes.
+   */
+  const std::vector<Outcome> &get_outcomes() const { return this->outcomes; }
+
+  /**
+   * @brief Gets the position of an outcome in the set.
+   * @param outcome The outcome to look for.
+   * @return The index of the outcome, or -1 if it is not in the set.
+   */
+  int index_of(const Outcome &outcome) const {
+    for (std::size_t i = 0; i < this->outcomes.size(); ++i) {
+      if (this->outcomes[i] == outcome) {
+        return (int)i;
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * @brief Looks up an outcome of the set by name without using the global
+   * symbol table.
+   * @param name The name of the outcome.
+   * @return The outcome if it is in the set, otherwise nullopt.
+   */
+  std::optional<Outcome> find(const std::string &name) const {
+    for (const Outcome &outcome : this->outcomes) {
+      if (outcome == name) {
+        return outcome;
+      }
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * @brief Checks if an outcome is in the set.
+   * @param outcome The outcome to look for.
+   * @return True if the outcome is in the set, otherwise false.
+   */
+  bool contains(const Outcome &outcome) const {
+    return this->index_of(outcome) >= 0;
+  }
+};
+
+} // namespace yasmin
+
+namespace std {
+
+/// Hash of an outcome, based on its identity.
+template <> struct hash<yasmin::Outcome> {
+  std::size_t operator()(const yasmin::Outcome &outcome) const noexcept {
+    return std::hash<const std::string *>()(outcome.name);
+  }
+};
+
+} // namespace std
+
+#endif // YASMIN__OUTCOME_HPP
@@ -129,7 +129,8 @@ template <typename ClassType, typename StateType>
 inline void add_call_operator(ClassType &cls) {
   cls.def(
       "__call__",
-      [](StateType &self, py::object blackboard_obj = py::none()) {
+      [](StateType &self,
+         py::object blackboard_obj = py::none()) -> std::string {
         auto blackboard = convert_blackboard_from_python(blackboard_obj);
         // Release GIL to allow C++ threads (important for Concurrence) to run
         py::gil_scoped_release release;
@@ -17,6 +17,7 @@
 #define YASMIN__STATE_HPP
 
 #include <atomic>
+#include <cstddef>
 #include <memory>
 #include <set>
 #include <string>
@@ -28,6 +29,7 @@
 
 #include "yasmin/blackboard/blackboard.hpp"
 #include "yasmin/logs.hpp"
+#include "yasmin/outcome.hpp"
 
 namespace yasmin {
 
@@ -42,6 +44,28 @@ enum class StateStatus {
   COMPLETED ///< State execution has completed successfully
 };
 
+class State;
+
+/**
+ * @struct StateRun
+ * @brief Status of a single execution of a state.
+ *
+ * A state can be run by several executions at the same time, for example when
+ * StateMachineInstance objects share a state machine. Each execution passes
+ * its own StateRun, so canceling one execution does not cancel the others. A
+ * run canceled before it starts makes the state start canceled.
+ */
+struct StateRun {
+  /// Status of this execution
+  std::atomic<StateStatus> status{StateStatus::IDLE};
+  /// Untargeted cancels of the state counted when the execution started
+  std::size_t cancel_epoch{0};
+  /// The state being run, used to find the run of a state in its thread
+  const State *state{nullptr};
+  /// Run of the enclosing state in the same thread, if any
+  StateRun *previous{nullptr};
+};
+
 /**
  * @class State
  * @brief Represents a state in a state machine.
@@ -53,12 +77,39 @@ enum class StateStatus {
 class State {
 
 protected:
-  /// The possible outcomes of this state.
-  std::set<std::string> outcomes;
+  /// The possible outcomes of this state, shared with other states.
+  std::shared_ptr<const OutcomeSet> outcomes;
+
+  /**
+   * @brief Adds outcomes to the possible outcomes of this state.
+   * @param outcomes The outcomes to add.
+   *
+   * Intended to be called by the constructors of derived classes.
+   */
+  void add_outcomes(const std::set<std::string> &outcomes);
+
+  /**
+   * @brief Gets the run of this state executed by the calling thread.
+   * @return A pointer to the run, or nullptr if the calling thread is not
+   * running this state.
+   */
+  StateRun *get_current_run() const;
+
+  /**
+   * @brief Gets the run that cancel_run() is canceling.
+   * @return A pointer to the run, or nullptr if cancel_state() was called to
+   * cancel every execution of this state.
+   *
+   * Intended to be called by the overrides of cancel_state() that keep data
+   * per execution.
+   */
+  StateRun *get_canceled_run() const;
 
 private:
-  /// Current status of the state
+  /// Status of the last execution of the state
   std::atomic<StateStatus> status{StateStatus::IDLE};
+  /// Number of cancels that target every execution of the state
+  std::atomic<std::size_t> cancel_epoch{0};
 
 public:
   /**
@@ -70,6 +121,9 @@ public:
   /**
    * @brief Gets the current status of the state.
    * @return The current StateStatus.
+   *
+   * Called from a thread running the state, it gives the status of that
+   * execution. Otherwise, it gives the status of the last execution.
    */
   StateStatus get_status() const;
 
@@ -101,14 +155,25 @@ public:
    * @brief Executes the state and returns the outcome.
    * @param blackboard A shared pointer to the Blackboard to use during
    * execution.
-   * @return A string representing the outcome of the execution.
+   * @return The interned outcome of the execution.
    *
    * This function stores the state as running, invokes the execute method,
    * and checks if the returned outcome is valid. If the outcome is not
    * valid, a std::logic_error is thrown.
    * @throws std::logic_error If the outcome is not in the set of outcomes.
    */
-  std::string operator()(std::shared_ptr<blackboard::Blackboard> blackboard);
+  Outcome operator()(std::shared_ptr<blackboard::Blackboard> blackboard);
+
+  /**
+   * @brief Executes the state as part of a given run and returns the outcome.
+   * @param blackboard A shared pointer to the Blackboard to use during
+   * execution.
+   * @param run The run of this execution, canceled through cancel_run().
+   * @return The interned outcome of the execution.
+   * @throws std::logic_error If the outcome is not in the set of outcomes.
+   */
+  Outcome operator()(std::shared_ptr<blackboard::Blackboard> blackboard,
+                     StateRun &run);
 
   /**
    * @brief Executes the state's specific logic.
@@ -128,12 +193,20 @@ public:
   /**
    * @brief Cancels the current state execution.
    *
-   * This method sets the status to CANCELED and logs the action.
+   * This method sets the status to CANCELED and logs the action. Called
+   * through cancel_run(), it only cancels that run. Otherwise, it cancels
+   * every execution of the state.
    */
-  virtual void cancel_state() {
-    YASMIN_LOG_INFO("Canceling state '%s'", this->to_string().c_str());
-    this->status.store(StateStatus::CANCELED);
-  }
+  virtual void cancel_state();
+
+  /**
+   * @brief Cancels a single execution of the state.
+   * @param run The run to cancel.
+   *
+   * This method calls cancel_state(), which can get the run with
+   * get_canceled_run().
+   */
+  void cancel_run(StateRun &run);
 
   /**
    * @brief Gets the set of possible outcomes for this state.
@@ -141,6 +214,12 @@ public:
    */
   std::set<std::string> const &get_outcomes();
 
+  /**
+   * @brief Gets the interned set of possible outcomes for this state.
+   * @return A constant reference to the outcome set.
+   */
+  const OutcomeSet &get_outcome_set() const { return *this->outcomes; }
+
   /**
    * @brief Converts the state to a string representation.
    * @return A string representation of the state.
@@ -24,10 +24,13 @@
 #include <mutex>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/outcome.hpp"
 #include "yasmin/state.hpp"
+#include "yasmin/state_machine_instance.hpp"
 
 namespace yasmin {
 
@@ -42,6 +45,9 @@ namespace yasmin {
  */
 class StateMachine : public State {
 
+  friend class StateMachineInstance;
+  friend struct CompiledStateMachine;
+
   /// Alias for a callback function executed before running the state machine.
   using StartCallbackType = std::function<void(
       std::shared_ptr<yasmin::blackboard::Blackboard>, const std::string &,
@@ -225,6 +231,22 @@ public:
   std::string
   execute(std::shared_ptr<blackboard::Blackboard> blackboard) override;
 
+  /**
+   * @brief Executes the state machine from a given state instead of the
+   * start state.
+   *
+   * Used with a BlackboardSnapshot to resume a mission after a restart,
+   * skipping the states that already ran. Nested state machines start from
+   * their start state.
+   *
+   * @param blackboard A shared pointer to the blackboard used during execution.
+   * @param state_name The name of the state to resume from.
+   * @return The outcome of the state machine execution.
+   * @throws std::invalid_argument If the state is not in the state machine.
+   */
+  std::string resume(std::shared_ptr<blackboard::Blackboard> blackboard,
+                     const std::string &state_name);
+
   /**
    * @brief Executes the state machine using a default blackboard.
    *
@@ -260,19 +282,61 @@ private:
   std::map<std::string, std::shared_ptr<State>> states;
   /// Map of transitions
   std::map<std::string, std::map<std::string, std::string>> transitions;
-  /// A dictionary of remappings to set in the blackboard in each transition
+  /// A dictionary of remappings of the blackboard view of each state
   std::map<std::string, std::map<std::string, std::string>> remappings;
   /// Name of the start state
   std::string start_state;
-  /// Name of the current state
-  std::string current_state;
-  /// Mutex for current state access
-  std::unique_ptr<std::mutex> current_state_mutex;
-  /// Condition variable for current state changes
-  std::condition_variable current_state_cond;
+  /// Executions started by execute() and the runs they belong to, used by
+  /// get_current_state() and cancel_state()
+  std::vector<std::pair<const StateRun *, StateMachineInstance *>>
+      active_instances;
+  /// Mutex for active instance access
+  std::unique_ptr<std::mutex> active_instance_mutex;
+  /// Condition variable for active instance changes
+  std::condition_variable active_instance_cond;
 
   /// Flag to indicate if the state machine has been validated
   std::atomic_bool validated{false};
+  /// Mutex to validate the state machine from several instances
+  std::unique_ptr<std::mutex> validate_mutex;
+
+  /**
+   * @struct CompiledTransition
+   * @brief Next hop of a state outcome resolved at validation time.
+   */
+  struct CompiledTransition {
+    /// Outcome returned by the state
+    Outcome outcome;
+    /// Translated outcome, either a state name or a state machine outcome
+    Outcome target;
+    /// Index of the next state, or one of the negative next hop values
+    int next_state;
+  };
+
+  /// Next hop value for outcomes that end the state machine
+  static constexpr int END_OF_MACHINE = -1;
+  /// Next hop value for outcomes that are neither states nor outcomes
+  static constexpr int INVALID_TARGET = -2;
+
+  /**
+   * @struct CompiledState
+   * @brief Dense representation of a state and its transitions.
+   */
+  struct CompiledState {
+    /// Name of the state
+    std::string name;
+    /// The state to execute
+    std::shared_ptr<State> state;
+    /// The state as a state machine, nullptr if it is not one
+    StateMachine *state_machine;
+    /// Remappings of the state
+    std::map<std::string, std::string> remappings;
+    /// One transition for each outcome of the state
+    std::vector<CompiledTransition> transitions;
+  };
+
+  /// Compiled table published by validate(), never modified once published
+  std::shared_ptr<const CompiledStateMachine> compiled;
 
   /// Start callbacks executed before the state machine
   std::vector<std::pair<StartCallbackType, std::vector<std::string>>> start_cbs;
@@ -283,11 +347,76 @@ private:
   std::vector<std::pair<EndCallbackType, std::vector<std::string>>> end_cbs;
 
   /**
-   * @brief Sets the current state name.
+   * @brief Registers an execution for get_current_state() and cancel_state().
    *
-   * @param state_name The name of the state to set as the current state.
+   * The execution belongs to the run of the state machine in the calling
+   * thread, if any, and it is canceled if that run already is.
+   *
+   * @param instance The running instance.
    */
-  void set_current_state(const std::string &state_name);
+  void add_active_instance(StateMachineInstance *instance);
+
+  /**
+   * @brief Unregisters an execution when it ends.
+   *
+   * @param instance The instance that was running.
+   */
+  void remove_active_instance(StateMachineInstance *instance);
+
+  /**
+   * @brief Runs the compiled state machine within an execution instance.
+   *
+   * The state machine is only read, so several instances can run it at the
+   * same time.
+   *
+   * @param instance The execution instance holding the current state.
+   * @return The outcome of the state machine execution.
+   * @throws std::runtime_error If the execution is canceled.
+   */
+  Outcome run(StateMachineInstance &instance);
+
+  /**
+   * @brief Gets the index of a state in the compiled table.
+   *
+   * @param state_name The name of the state.
+   * @return The index of the state.
+   * @throws std::invalid_argument If the state is not in the state machine.
+   */
+  int get_state_id(const std::string &state_name) const;
+
+  /**
+   * @brief Gets the compiled table published by the last validation.
+   *
+   * Instances keep the table for the length of their run, so validating the
+   * state machine again while they run does not change the table they use.
+   *
+   * @return The compiled table, nullptr if the state machine was never
+   * validated.
+   */
+  std::shared_ptr<const CompiledStateMachine> get_compiled() const;
+
+  /**
+   * @brief Builds the compiled table of states and transitions.
+   *
+   * Resolves every state outcome to the index of the next state or to an
+   * outcome of the state machine, so execute() does not need to look up
+   * strings in the maps of states and transitions. A new table is published,
+   * so the running instances keep the previous one.
+   *
+   * The validation mutex must be held.
+   */
+  void compile();
+};
+
+/**
+ * @struct CompiledStateMachine
+ * @brief Immutable transition table of a StateMachine, built by validate().
+ */
+struct CompiledStateMachine {
+  /// States indexed by their id
+  std::vector<StateMachine::CompiledState> states;
+  /// Index of the start state
+  int start_state{-1};
 };
 
 } // namespace yasmin
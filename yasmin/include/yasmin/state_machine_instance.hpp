@@ -0,0 +1,268 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef YASMIN__STATE_MACHINE_INSTANCE_HPP
+#define YASMIN__STATE_MACHINE_INSTANCE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/state.hpp"
+#include "yasmin/state_metrics.hpp"
+
+namespace yasmin {
+
+class StateMachine;
+struct CompiledStateMachine;
+
+/**
+ * @class StateMachineInstance
+ * @brief A single execution of a StateMachine.
+ *
+ * The instance holds everything that changes while a state machine runs: the
+ * current state, the execution status and the blackboard. The StateMachine
+ * acts as an immutable, validated definition that can be shared by many
+ * instances running at the same time in different threads. Nested state
+ * machines are executed through nested instances, so they can be shared too.
+ *
+ * Leaf states are still shared objects. Each instance runs them with its own
+ * StateRun, so canceling an instance only cancels its own execution of the
+ * current state. States that keep other per-execution data in their members,
+ * or that override cancel_state() without using get_canceled_run(), must not
+ * be shared by instances running at the same time.
+ */
+class StateMachineInstance {
+
+  friend class StateMachine;
+
+public:
+  /**
+   * @brief Construct a new StateMachineInstance object.
+   *
+   * The state machine is validated on construction. Each run keeps the
+   * compiled table it started with, so validating the state machine again
+   * does not change the running instances.
+   *
+   * @param state_machine The state machine to execute.
+   * @param blackboard The blackboard of this execution. A new one is created
+   * if it is nullptr.
+   * @throws std::runtime_error If the state machine is misconfigured.
+   */
+  StateMachineInstance(
+      std::shared_ptr<StateMachine> state_machine,
+      std::shared_ptr<blackboard::Blackboard> blackboard = nullptr);
+
+  /**
+   * @brief Executes the state machine.
+   *
+   * @return The outcome of the state machine execution.
+   * @throws std::runtime_error If the execution is canceled.
+   */
+  std::string execute();
+
+  /**
+   * @brief Executes the state machine from a given state instead of the
+   * start state.
+   *
+   * @param state_name The name of the state to resume from.
+   * @return The outcome of the state machine execution.
+   * @throws std::invalid_argument If the state is not in the state machine.
+   */
+  std::string resume(const std::string &state_name);
+
+  /**
+   * @brief Executes the state machine.
+   *
+   * @return The outcome of the state machine execution.
+   */
+  std::string operator()();
+
+  /**
+   * @brief Cancels the execution, canceling the current state.
+   */
+  void cancel();
+
+  /**
+   * @brief Retrieves the current state name.
+   *
+   * @return The name of the current state, empty if it is not running.
+   */
+  std::string get_current_state();
+
+  /**
+   * @brief Gets the current status of the execution.
+   * @return The current StateStatus.
+   */
+  StateStatus get_status() const { return this->status.load(); }
+
+  /**
+   * @brief Checks if the execution is idle.
+   * @return True if the execution is idle, otherwise false.
+   */
+  bool is_idle() const { return this->status.load() == StateStatus::IDLE; }
+
+  /**
+   * @brief Checks if the execution is running.
+   * @return True if the execution is running, otherwise false.
+   */
+  bool is_running() const {
+    return this->status.load() == StateStatus::RUNNING;
+  }
+
+  /**
+   * @brief Checks if the execution has been canceled.
+   * @return True if the execution is canceled, otherwise false.
+   */
+  bool is_canceled() const {
+    return this->status.load() == StateStatus::CANCELED;
+  }
+
+  /**
+   * @brief Checks if the execution has completed.
+   * @return True if the execution is completed, otherwise false.
+   */
+  bool is_completed() const {
+    return this->status.load() == StateStatus::COMPLETED;
+  }
+
+  /**
+   * @brief Gets the blackboard of this execution.
+   * @return A shared pointer to the blackboard.
+   */
+  std::shared_ptr<blackboard::Blackboard> get_blackboard() const {
+    return this->blackboard;
+  }
+
+  /**
+   * @brief Gets the state machine executed by this instance.
+   * @return A reference to the state machine.
+   */
+  StateMachine &get_state_machine() const { return *this->state_machine; }
+
+private:
+  /// Keeps the state machine alive when the instance owns a reference
+  std::shared_ptr<StateMachine> state_machine_ptr;
+  /// The state machine executed by this instance
+  StateMachine *state_machine;
+  /// Blackboard of this execution
+  std::shared_ptr<blackboard::Blackboard> blackboard;
+  /// Whether nested state machines run in nested instances
+  bool nested_instances;
+  /// Compiled table of the state machine, kept for the length of each run
+  std::shared_ptr<const CompiledStateMachine> graph;
+
+  /// Status of this execution
+  std::atomic<StateStatus> status{StateStatus::IDLE};
+  /// Index of the current state in the compiled table, -1 if none
+  int current_state{-1};
+  /// Run of the current state, canceled by cancel()
+  StateRun state_run;
+  /// Index of the state to run first, -1 to run the start state
+  int resume_state{-1};
+  /// Instance of the nested state machine being executed, if any
+  std::unique_ptr<StateMachineInstance> child;
+  /// Blackboard of each state, created the first time the state runs and
+  /// kept until the compiled table changes
+  std::vector<std::shared_ptr<blackboard::Blackboard>> state_blackboards;
+  /// Fully qualified path of the state machine, used to key its metrics
+  std::string path;
+  /// Whether the state machine runs as a state of another one
+  bool nested{false};
+  /// Metrics of each state, resolved the first time the state runs
+  std::vector<StateMetrics *> state_metrics;
+  /// Mutex for the current state and the nested instance
+  std::mutex mutex;
+  /// Condition variable for current state and status changes
+  std::condition_variable cond;
+
+  /**
+   * @brief Construct a new StateMachineInstance object without validating.
+   *
+   * @param state_machine The state machine to execute.
+   * @param blackboard The blackboard of this execution.
+   * @param nested_instances Whether nested state machines run in nested
+   * instances or through their own operator().
+   */
+  StateMachineInstance(StateMachine *state_machine,
+                       std::shared_ptr<blackboard::Blackboard> blackboard,
+                       bool nested_instances);
+
+  /**
+   * @brief Sets the current state by its index in the compiled table.
+   *
+   * The run of the state is reset for the new state.
+   *
+   * @param state_id The index of the state, -1 to clear the current state.
+   */
+  void set_current_state(int state_id);
+
+  /**
+   * @brief Sets the status of the execution.
+   *
+   * @param status The new status.
+   */
+  void set_status(StateStatus status);
+
+  /**
+   * @brief Runs the state machine and updates the status of the execution.
+   *
+   * The status must be set to RUNNING before calling this method.
+   *
+   * @return The outcome of the state machine execution.
+   */
+  Outcome run();
+
+  /**
+   * @brief Gets the blackboard of a state.
+   *
+   * States without remappings use the blackboard of the execution. The other
+   * ones get a BlackboardView with their remappings, created once per
+   * execution.
+   *
+   * @param state_id The index of the state in the compiled table.
+   * @return The blackboard to pass to the state.
+   */
+  std::shared_ptr<blackboard::Blackboard> get_state_blackboard(int state_id);
+
+  /**
+   * @brief Gets the metrics of a state.
+   *
+   * The metrics are looked up in the StateMetricsRegistry by the path of the
+   * state once per execution.
+   *
+   * @param state_id The index of the state in the compiled table.
+   * @return A reference to the metrics of the state.
+   */
+  StateMetrics &get_state_metrics(int state_id);
+
+  /**
+   * @brief Executes a nested state machine in a nested instance.
+   *
+   * @param state_machine The nested state machine.
+   * @param blackboard The blackboard of the nested state machine.
+   * @return The outcome of the nested state machine.
+   */
+  Outcome execute_child(StateMachine *state_machine,
+                        std::shared_ptr<blackboard::Blackboard> blackboard);
+};
+
+} // namespace yasmin
+
+#endif // YASMIN__STATE_MACHINE_INSTANCE_HPP
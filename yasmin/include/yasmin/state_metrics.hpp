@@ -0,0 +1,291 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef YASMIN__STATE_METRICS_HPP
+#define YASMIN__STATE_METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "yasmin/outcome.hpp"
+
+namespace yasmin {
+
+/**
+ * @class LatencyHistogram
+ * @brief Lock-free histogram of durations in nanoseconds.
+ *
+ * Buckets are log-linear, as in HDR histograms: each power of two is split
+ * into SUB_BUCKETS buckets, so values are kept with a relative error below
+ * 1 / SUB_BUCKETS. Recording a value only increments atomic counters, so many
+ * threads can record at the same time.
+ */
+class LatencyHistogram {
+
+public:
+  /// Number of bits of the sub-buckets of each power of two
+  static constexpr int SUB_BUCKET_BITS = 5;
+  /// Number of sub-buckets of each power of two
+  static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  /// Number of bits of the largest value, about 4.9 hours in nanoseconds
+  static constexpr int MAX_VALUE_BITS = 44;
+  /// Largest value kept, greater values are clamped to it
+  static constexpr std::uint64_t MAX_VALUE =
+      (std::uint64_t(1) << MAX_VALUE_BITS) - 1;
+  /// Number of buckets
+  static constexpr int NUM_BUCKETS =
+      SUB_BUCKETS * (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1);
+
+  /**
+   * @brief Records a value.
+   * @param value The value in nanoseconds.
+   */
+  void record(std::uint64_t value);
+
+  /**
+   * @brief Records a duration.
+   * @param duration The duration.
+   */
+  void record(std::chrono::nanoseconds duration) {
+    this->record(duration.count() > 0 ? std::uint64_t(duration.count()) : 0);
+  }
+
+  /**
+   * @brief Gets the number of recorded values.
+   * @return The number of values.
+   */
+  std::uint64_t get_count() const {
+    return this->count.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Gets the sum of the recorded values.
+   * @return The sum in nanoseconds.
+   */
+  std::uint64_t get_sum() const {
+    return this->sum.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Gets the smallest recorded value.
+   * @return The value in nanoseconds, 0 if there are no values.
+   */
+  std::uint64_t get_min() const;
+
+  /**
+   * @brief Gets the largest recorded value.
+   * @return The value in nanoseconds, 0 if there are no values.
+   */
+  std::uint64_t get_max() const {
+    return this->max.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Gets the mean of the recorded values.
+   * @return The mean in nanoseconds, 0 if there are no values.
+   */
+  double get_mean() const;
+
+  /**
+   * @brief Gets the value below which a fraction of the recorded values
+   * fall.
+   * @param quantile The fraction, between 0 and 1 (e.g., 0.99 for p99).
+   * @return The largest value of the bucket of the quantile, in nanoseconds,
+   * or 0 if there are no values.
+   * @throws std::invalid_argument If the quantile is not between 0 and 1.
+   */
+  std::uint64_t get_quantile(double quantile) const;
+
+  /**
+   * @brief Removes all recorded values.
+   *
+   * Values recorded at the same time by other threads may be partially
+   * kept.
+   */
+  void reset();
+
+  /**
+   * @brief Gets the bucket of a value.
+   * @param value The value.
+   * @return The index of the bucket.
+   */
+  static int get_bucket(std::uint64_t value);
+
+  /**
+   * @brief Gets the largest value of a bucket.
+   * @param bucket The index of the bucket.
+   * @return The largest value kept in the bucket.
+   */
+  static std::uint64_t get_bucket_upper_bound(int bucket);
+
+private:
+  /// Number of values of each bucket
+  std::array<std::atomic<std::uint64_t>, NUM_BUCKETS> buckets{};
+  /// Number of values
+  std::atomic<std::uint64_t> count{0};
+  /// Sum of the values
+  std::atomic<std::uint64_t> sum{0};
+  /// Smallest value
+  std::atomic<std::uint64_t> min{UINT64_MAX};
+  /// Largest value
+  std::atomic<std::uint64_t> max{0};
+};
+
+/**
+ * @class StateMetrics
+ * @brief Latency histogram and outcome counters of a state.
+ */
+class StateMetrics {
+
+public:
+  /**
+   * @brief Constructs the metrics of a state.
+   * @param path The fully qualified path of the state.
+   * @param outcomes The outcomes of the state, which get lock-free counters.
+   */
+  StateMetrics(const std::string &path,
+               std::shared_ptr<const OutcomeSet> outcomes);
+
+  /**
+   * @brief Records an execution of the state.
+   * @param duration The time from the entry to the exit of the state.
+   * @param outcome The outcome returned by the state.
+   */
+  void record(std::chrono::nanoseconds duration, const Outcome &outcome);
+
+  /**
+   * @brief Gets the fully qualified path of the state.
+   * @return The path.
+   */
+  const std::string &get_path() const { return this->path; }
+
+  /**
+   * @brief Gets the histogram of the durations of the state.
+   * @return A constant reference to the histogram.
+   */
+  const LatencyHistogram &get_latency() const { return this->latency; }
+
+  /**
+   * @brief Gets how many times each outcome was returned.
+   * @return A map from outcome names to counts, without the outcomes never
+   * returned.
+   */
+  std::map<std::string, std::uint64_t> get_outcome_counts() const;
+
+  /**
+   * @brief Removes all recorded executions.
+   */
+  void reset();
+
+private:
+  /// Fully qualified path of the state
+  std::string path;
+  /// Histogram of the durations
+  LatencyHistogram latency;
+  /// Outcomes with lock-free counters
+  std::shared_ptr<const OutcomeSet> outcomes;
+  /// Counters of the outcomes, in the order of the outcome set
+  std::unique_ptr<std::atomic<std::uint64_t>[]> outcome_counts;
+  /// Counters of outcomes added to the state after the metrics were created
+  std::map<std::string, std::uint64_t> other_outcome_counts;
+  /// Mutex for the counters of other outcomes
+  mutable std::mutex other_outcome_counts_mutex;
+};
+
+/**
+ * @class StateMetricsRegistry
+ * @brief Opt-in registry of the metrics of the states run by state machines.
+ *
+ * When it is enabled, state machines time each state they execute and count
+ * its outcomes. Metrics are keyed by the fully qualified path of the state:
+ * the names of the nested state machines and the state joined with '/',
+ * starting with the name of the root state machine if it has one. The
+ * executions of a root state machine with a name are recorded under its
+ * name. States run by a Concurrence are recorded as part of it.
+ */
+class StateMetricsRegistry {
+
+public:
+  /**
+   * @brief Enables or disables recording metrics.
+   * @param enabled True to record metrics.
+   */
+  static void set_enabled(bool enabled) {
+    StateMetricsRegistry::enabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Checks if metrics are recorded.
+   * @return True if metrics are recorded, otherwise false.
+   */
+  static bool is_enabled() {
+    return StateMetricsRegistry::enabled.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Gets the metrics of a state, creating them if needed.
+   *
+   * The metrics are never destroyed, so the reference can be kept.
+   *
+   * @param path The fully qualified path of the state.
+   * @param outcomes The outcomes of the state.
+   * @return A reference to the metrics.
+   */
+  static StateMetrics &get_metrics(const std::string &path,
+                                   std::shared_ptr<const OutcomeSet> outcomes);
+
+  /**
+   * @brief Finds the metrics of a state.
+   * @param path The fully qualified path of the state.
+   * @return A pointer to the metrics, nullptr if the state has not run.
+   */
+  static const StateMetrics *find_metrics(const std::string &path);
+
+  /**
+   * @brief Gets the paths of the states with metrics.
+   * @return The sorted paths.
+   */
+  static std::vector<std::string> get_paths();
+
+  /**
+   * @brief Removes the recorded executions of all states.
+   */
+  static void reset();
+
+  /**
+   * @brief Exports the metrics in the OpenMetrics text format.
+   *
+   * Durations are exported as a summary in seconds with the quantiles 0.5,
+   * 0.9, 0.99 and 0.999, and outcomes as a counter, both labeled by state.
+   *
+   * @return The metrics exposition, ending with "# EOF".
+   */
+  static std::string to_openmetrics();
+
+private:
+  /// Flag to indicate if metrics are recorded
+  static inline std::atomic<bool> enabled{false};
+};
+
+} // namespace yasmin
+
+#endif // YASMIN__STATE_METRICS_HPP
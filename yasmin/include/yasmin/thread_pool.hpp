@@ -0,0 +1,286 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef YASMIN__THREAD_POOL_HPP
+#define YASMIN__THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yasmin {
+
+/**
+ * @class ThreadPool
+ * @brief Bounded work-stealing pool of worker threads.
+ *
+ * Each worker owns a queue of tasks. Tasks submitted from a worker go to its
+ * own queue and idle workers steal tasks from the queues of the others. A
+ * thread waiting for its tasks can run the ones that have not started yet
+ * with Task::try_run(), so nested waits do not exhaust the pool.
+ *
+ * try_submit() only queues a task when an idle worker is free to take it.
+ * try_start() also adds a worker when all of them are busy, up to the maximum
+ * size of the pool, so tasks that must run at the same time do not wait for
+ * a busy pool while the number of threads stays bounded.
+ */
+class ThreadPool {
+
+public:
+  /// Maximum number of worker threads of a pool
+  static constexpr std::size_t MAX_SIZE = 256;
+
+  /**
+   * @class Task
+   * @brief A function submitted to the pool that runs exactly once.
+   *
+   * Derived classes can override run() instead of wrapping a function, so a
+   * task can be allocated once and submitted again after it runs.
+   */
+  class Task {
+  private:
+    /// The function to run, empty if run() is overridden
+    std::function<void()> function;
+    /// Flag to indicate if a thread has already taken the task
+    std::atomic_bool claimed{false};
+
+  protected:
+    /**
+     * @brief Constructs a Task whose work is done by an override of run().
+     */
+    Task() = default;
+
+    /**
+     * @brief Does the work of the task. By default, it calls the function.
+     */
+    virtual void run() { this->function(); }
+
+  public:
+    /**
+     * @brief Constructs a Task.
+     * @param function The function to run.
+     */
+    explicit Task(std::function<void()> function);
+
+    /**
+     * @brief Destroys the Task.
+     */
+    virtual ~Task() = default;
+
+    /**
+     * @brief Runs the task in the calling thread if no thread took it yet.
+     * @return True if the task was run by this call, otherwise false.
+     */
+    bool try_run();
+
+    /**
+     * @brief Allows the task to run again.
+     *
+     * It must not be called while the task is queued or running.
+     */
+    void reset() { this->claimed.store(false); }
+  };
+
+  /**
+   * @brief Constructs a ThreadPool.
+   * @param size Number of worker threads, 0 to use the default size. It is
+   * limited to MAX_SIZE.
+   * @param max_size Number of worker threads the pool can grow to with
+   * try_start(), 0 to use the default maximum size. It is limited to
+   * MAX_SIZE and is at least size.
+   */
+  explicit ThreadPool(std::size_t size = 0, std::size_t max_size = 0);
+
+  /**
+   * @brief Destroys the ThreadPool, waiting for the queued tasks.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * @brief Submits a function to the pool.
+   * @param function The function to run.
+   * @return The task, which can be run by the caller with Task::try_run().
+   */
+  std::shared_ptr<Task> submit(std::function<void()> function);
+
+  /**
+   * @brief Submits a task to the pool.
+   *
+   * The task waits in a queue if all the workers are busy.
+   *
+   * @param task The task to run.
+   */
+  void submit(std::shared_ptr<Task> task);
+
+  /**
+   * @brief Submits a task to the pool only if an idle worker can take it.
+   *
+   * Each idle worker is counted for one queued task, so the task starts
+   * without waiting for the tasks that are running.
+   *
+   * @param task The task to run.
+   * @return True if the task was queued, false if all the workers are busy.
+   */
+  bool try_submit(std::shared_ptr<Task> task);
+
+  /**
+   * @brief Submits a task owned by the caller only if an idle worker can take
+   * it.
+   *
+   * The task is reset and queued without taking ownership, so submitting it
+   * does not allocate. The caller must keep it alive until it has run and
+   * must not run it with Task::try_run() while it is queued.
+   *
+   * @param task The task to run.
+   * @return True if the task was queued, false if all the workers are busy.
+   */
+  bool try_submit(Task &task);
+
+  /**
+   * @brief Submits a task to the pool only if it can start without waiting.
+   *
+   * The task is queued for an idle worker or, if all the workers are busy
+   * and the pool is below its maximum size, for a new worker.
+   *
+   * @param task The task to run.
+   * @return True if the task was queued, false if the pool is at its maximum
+   * size and all the workers are busy.
+   */
+  bool try_start(std::shared_ptr<Task> task);
+
+  /**
+   * @brief Gets the number of worker threads.
+   * @return The number of worker threads.
+   */
+  std::size_t size() const { return this->num_workers.load(); }
+
+  /**
+   * @brief Gets the number of worker threads the pool can grow to.
+   * @return The maximum number of worker threads.
+   */
+  std::size_t get_max_size() const { return this->max_size; }
+
+  /**
+   * @brief Gets the pool shared by the whole process.
+   *
+   * The pool is created on the first call with the default size.
+   *
+   * @return A reference to the shared pool.
+   */
+  static ThreadPool &get_instance();
+
+  /**
+   * @brief Sets the size of the shared pool.
+   * @param size Number of worker threads, limited to MAX_SIZE.
+   * @throws std::logic_error If the shared pool has already been created.
+   */
+  static void set_default_size(std::size_t size);
+
+  /**
+   * @brief Gets the size used for the shared pool.
+   *
+   * If no size was set, it is the number of hardware threads.
+   *
+   * @return The default number of worker threads.
+   */
+  static std::size_t get_default_size();
+
+  /**
+   * @brief Sets the maximum size of the shared pool.
+   * @param max_size Number of worker threads the pool can grow to, limited
+   * to MAX_SIZE.
+   * @throws std::logic_error If the shared pool has already been created.
+   */
+  static void set_default_max_size(std::size_t max_size);
+
+  /**
+   * @brief Gets the maximum size used for the shared pool.
+   *
+   * If no maximum size was set, it is four times the default size.
+   *
+   * @return The default maximum number of worker threads.
+   */
+  static std::size_t get_default_max_size();
+
+private:
+  /**
+   * @struct WorkerQueue
+   * @brief Queue of tasks owned by a worker.
+   */
+  struct WorkerQueue {
+    /// Tasks of the worker
+    std::deque<std::shared_ptr<Task>> tasks;
+    /// Mutex for the tasks
+    std::mutex mutex;
+  };
+
+  /// Maximum number of worker threads
+  std::size_t max_size;
+  /// Queues of the workers, allocated for the maximum size
+  std::vector<std::unique_ptr<WorkerQueue>> queues;
+  /// Worker threads, guarded by the mutex
+  std::vector<std::thread> threads;
+  /// Number of worker threads started
+  std::atomic<std::size_t> num_workers{0};
+  /// Number of queued tasks that no worker has taken yet
+  std::atomic<std::size_t> pending{0};
+  /// Number of workers waiting for a task, guarded by the mutex
+  std::size_t idle{0};
+  /// Queue used for the next task submitted from outside the pool
+  std::atomic<std::size_t> next_queue{0};
+  /// Flag to stop the workers
+  bool stop{false};
+  /// Mutex to sleep the workers
+  std::mutex mutex;
+  /// Condition variable to wake up the workers
+  std::condition_variable cond;
+
+  /**
+   * @brief Loop run by each worker thread.
+   * @param index Index of the worker.
+   */
+  void worker_loop(std::size_t index);
+
+  /**
+   * @brief Starts a new worker thread. The mutex must be locked.
+   */
+  void start_worker();
+
+  /**
+   * @brief Gets the queue for a task submitted by the calling thread.
+   * @return The index of the queue.
+   */
+  std::size_t get_submit_queue();
+
+  /**
+   * @brief Takes a task from the queue of a worker or steals one.
+   * @param index Index of the worker.
+   * @return The task, or nullptr if all queues are empty.
+   */
+  std::shared_ptr<Task> pop_task(std::size_t index);
+};
+
+} // namespace yasmin
+
+#endif // YASMIN__THREAD_POOL_HPP
@@ -0,0 +1,215 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef YASMIN__TRACE_RECORDER_HPP
+#define YASMIN__TRACE_RECORDER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace yasmin {
+
+/**
+ * @struct TraceOptions
+ * @brief Options of the trace recorder.
+ */
+struct TraceOptions {
+  /// Maximum number of events of the buffer of each thread, allocated in
+  /// small chunks as the thread records them. Later events are dropped.
+  std::size_t events_per_thread = 16384;
+  /// File where the trace is written each time a root state machine ends,
+  /// empty to only write it on demand
+  std::string output_path;
+};
+
+/**
+ * @struct TraceEvent
+ * @brief Event of the timeline, in the Chrome trace event format.
+ */
+struct TraceEvent {
+  /// Maximum length of the texts of an event, longer texts are truncated
+  static constexpr std::size_t TEXT_SIZE = 48;
+
+  /// Time of the event in nanoseconds of the steady clock
+  std::uint64_t timestamp;
+  /// Phase of the event: 'B' (begin), 'E' (end) or 'i' (instant)
+  char phase;
+  /// Nesting depth of the event in its thread
+  std::uint16_t depth;
+  /// Category of the event, a string literal
+  const char *category;
+  /// Name of the argument, a string literal, or nullptr if there is none
+  const char *arg_name;
+  /// Name of the event
+  char name[TEXT_SIZE];
+  /// Value of the argument
+  char arg[TEXT_SIZE];
+};
+
+/**
+ * @class TraceRecorder
+ * @brief Records a timeline of the execution of state machines.
+ *
+ * When it is started, state machines record begin and end events for every
+ * state, callback and Concurrence branch, and an instant event for every
+ * transition. Each thread writes its events to a buffer of its own without
+ * locks, so recording an event costs a clock read and a copy.
+ * The timeline can be exported in the Chrome trace event format, which can
+ * be loaded in chrome://tracing and in the Perfetto UI.
+ */
+class TraceRecorder {
+
+public:
+  /// Category of the events of state machines
+  static constexpr const char *STATE_MACHINE_EVENT = "state_machine";
+  /// Category of the events of states
+  static constexpr const char *STATE_EVENT = "state";
+  /// Category of the events of transitions
+  static constexpr const char *TRANSITION_EVENT = "transition";
+  /// Category of the events of callbacks
+  static constexpr const char *CALLBACK_EVENT = "callback";
+  /// Category of the events of Concurrence branches
+  static constexpr const char *CONCURRENCE_EVENT = "concurrence";
+
+  /**
+   * @brief Starts recording events, removing the recorded ones.
+   * @param options The options of the recorder.
+   */
+  static void start(const TraceOptions &options = TraceOptions());
+
+  /**
+   * @brief Stops recording events. The recorded events are kept.
+   */
+  static void stop();
+
+  /**
+   * @brief Checks if events are recorded.
+   * @return True if events are recorded, otherwise false.
+   */
+  static bool is_enabled() {
+    return TraceRecorder::enabled.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Records an event in the buffer of the current thread.
+   * @param phase The phase of the event: 'B', 'E' or 'i'.
+   * @param category The category of the event, a string literal.
+   * @param name The name of the event.
+   * @param arg_name The name of the argument, a string literal, or nullptr.
+   * @param arg The value of the argument.
+   */
+  static void record(char phase, const char *category, const char *name,
+                     const char *arg_name = nullptr, const char *arg = "");
+
+  /**
+   * @brief Removes the recorded events.
+   */
+  static void clear();
+
+  /**
+   * @brief Gets the number of events dropped because a buffer was full.
+   * @return The number of dropped events.
+   */
+  static std::uint64_t get_dropped_events();
+
+  /**
+   * @brief Exports the recorded events in the Chrome trace event format.
+   * @return The JSON trace.
+   */
+  static std::string to_chrome_json();
+
+  /**
+   * @brief Writes the recorded events in the Chrome trace event format.
+   * @param path The path of the file.
+   * @throws std::runtime_error If the file cannot be written.
+   */
+  static void write_chrome_json(const std::string &path);
+
+  /**
+   * @brief Writes the recorded events to the output file of the options, if
+   * any. Errors are logged.
+   */
+  static void dump();
+
+private:
+  /// Flag to indicate if events are recorded
+  static inline std::atomic<bool> enabled{false};
+};
+
+/**
+ * @class TraceScope
+ * @brief Records a begin event on construction and the matching end event on
+ * destruction, if the recorder is enabled.
+ */
+class TraceScope {
+
+public:
+  /**
+   * @brief Begins a traced scope.
+   * @param category The category of the event, a string literal.
+   * @param name The name of the event.
+   */
+  TraceScope(const char *category, const char *name)
+      : category(TraceRecorder::is_enabled() ? category : nullptr) {
+    if (this->category != nullptr) {
+      TraceRecorder::record('B', category, name);
+    }
+  }
+
+  /**
+   * @brief Begins a traced scope.
+   * @param category The category of the event, a string literal.
+   * @param name The name of the event.
+   */
+  TraceScope(const char *category, const std::string &name)
+      : TraceScope(category, name.c_str()) {}
+
+  /**
+   * @brief Ends the traced scope.
+   */
+  ~TraceScope() {
+    if (this->category != nullptr) {
+      TraceRecorder::record('E', this->category, "", this->arg_name,
+                            this->arg);
+    }
+  }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+  /**
+   * @brief Sets the argument of the end event.
+   * @param arg_name The name of the argument, a string literal.
+   * @param arg The value of the argument, which must outlive the scope.
+   */
+  void set_arg(const char *arg_name, const char *arg) {
+    this->arg_name = arg_name;
+    this->arg = arg;
+  }
+
+private:
+  /// Category of the scope, nullptr if it is not traced
+  const char *category;
+  /// Name of the argument of the end event
+  const char *arg_name = nullptr;
+  /// Value of the argument of the end event
+  const char *arg = "";
+};
+
+} // namespace yasmin
+
+#endif // YASMIN__TRACE_RECORDER_HPP
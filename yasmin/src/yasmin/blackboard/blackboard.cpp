@@ -13,91 +13,731 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iterator>
 #include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
 #include <string>
+#include <typeindex>
+#include <vector>
 
 #include "yasmin/blackboard/blackboard.hpp"
 
 using namespace yasmin::blackboard;
 
-Blackboard::Blackboard() {}
+Blackboard::Blackboard() : storage(std::make_shared<BlackboardStorage>()) {}
 
-Blackboard::Blackboard(const Blackboard &other) {
-  for (const auto &ele : other.values) {
-    this->values.insert({ele.first, ele.second});
-  }
-  this->type_registry = other.type_registry;
+Blackboard::Blackboard(std::shared_ptr<SharedMemorySegment> segment)
+    : storage(std::make_shared<BlackboardStorage>()) {
+  this->storage->segment = segment;
 }
 
-Blackboard::~Blackboard() {
-  // Deallocate memory for each value stored in the blackboard
-  for (const auto &ele : this->values) {
-    delete this->values.at(ele.first);
+Blackboard::Blackboard(const Blackboard &other)
+    : storage(std::make_shared<BlackboardStorage>()) {
+  std::shared_lock<std::shared_mutex> lk(other.storage->mutex);
+  std::map<std::string, const BlackboardEntry *> entries;
+  std::vector<std::shared_lock<std::shared_mutex>> locks;
+  collect_entries(*other.storage, entries, locks);
+
+  for (const auto &[key, entry] : entries) {
+    BlackboardEntry &new_entry = this->storage->entries[key];
+    entry->value->clone(new_entry.value);
+    new_entry.size = entry->size;
+    new_entry.ttl = entry->ttl;
+    new_entry.expiration = entry->expiration;
+
+    this->storage->memory_usage += entry->size;
+    if (entry->ttl.count() != 0) {
+      this->storage->num_ttls++;
+    }
   }
+
+  this->storage->num_values = entries.size();
+
+  // Shared keys stay shared with the other processes
+  this->storage->segment = other.storage->segment;
+}
+
+Blackboard::Blackboard(std::shared_ptr<Blackboard> parent,
+                       const std::map<std::string, std::string> &remappings)
+    : storage(parent->storage), parent(parent), remappings(remappings) {
+  std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+  this->resolve_remappings();
 }
 
+Blackboard::~Blackboard() {}
+
 void Blackboard::remove(const std::string &key) {
   YASMIN_LOG_DEBUG("Removing '%s' from the blackboard", key.c_str());
 
-  std::lock_guard<std::recursive_mutex> lk(this->mutex);
-  auto remapped_key = this->remap(key);
-  delete this->values.at(remapped_key);    // Free memory of the value
-  this->values.erase(remapped_key);        // Remove the entry from the map
-  this->type_registry.erase(remapped_key); // Remove the type info
+  std::unique_lock<std::shared_mutex> lk(this->storage->mutex);
+  const std::string &name = this->remap(key);
+  this->remove_value(key, name);
+  this->notify_change(name, lk);
 }
 
 bool Blackboard::contains(const std::string &key) {
   YASMIN_LOG_DEBUG("Checking if '%s' is in the blackboard", key.c_str());
 
-  std::lock_guard<std::recursive_mutex> lk(this->mutex);
-  auto remapped_key = this->remap(key);
-  return (this->values.find(remapped_key) !=
-          this->values.end()); // Check if key exists
+  std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+  const std::string &name = this->remap(key);
+
+  if (this->find_shared(name) != nullptr) {
+    return this->storage->segment->contains(name);
+  }
+
+  return this->read_entry(name, this->find_entry(name),
+                          [](const BlackboardEntry *entry) {
+                            return entry != nullptr; // Check if key exists
+                          });
 }
 
 int Blackboard::size() {
-  std::lock_guard<std::recursive_mutex> lk(this->mutex);
-  return this->values.size(); // Return the number of key-value pairs
+  std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+
+  std::size_t num_shared = 0;
+  if (this->storage->segment != nullptr) {
+    num_shared = this->storage->segment->get_keys().size();
+  }
+
+  // Stale values are counted when they are found
+  if (this->storage->base == nullptr && this->storage->num_ttls == 0) {
+    // Return the number of key-value pairs
+    return this->storage->num_values + num_shared;
+  }
+
+  std::map<std::string, const BlackboardEntry *> entries;
+  std::vector<std::shared_lock<std::shared_mutex>> locks;
+  collect_entries(*this->storage, entries, locks);
+  return entries.size() + num_shared;
 }
 
 std::string Blackboard::get_type(const std::string &key) {
+  return TypeRegistry::get_name(this->get_type_index(key));
+}
+
+std::type_index Blackboard::get_type_index(const std::string &key) {
   YASMIN_LOG_DEBUG("Getting type of '%s' from the blackboard", key.c_str());
 
-  std::lock_guard<std::recursive_mutex> lk(this->mutex);
-  auto remapped_key = this->remap(key);
+  std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+  const std::string &name = this->remap(key);
 
-  if (!this->contains(key)) {
-    throw std::runtime_error("Element '" + key +
-                             "' does not exist in the blackboard");
+  if (const SharedMemoryField *field = this->find_shared(name)) {
+    if (!this->storage->segment->contains(name)) {
+      throw std::runtime_error("Element '" + key +
+                               "' does not exist in the blackboard");
+    }
+    return field->type;
   }
 
-  return this->type_registry.at(remapped_key);
+  return this->read_entry(
+      name, this->find_entry(name), [&key](const BlackboardEntry *entry) {
+        if (entry == nullptr) {
+          throw std::runtime_error("Element '" + key +
+                                   "' does not exist in the blackboard");
+        }
+        return entry->value->get_type_index();
+      });
 }
 
 std::string Blackboard::to_string() {
-  std::lock_guard<std::recursive_mutex> lk(this->mutex);
+  std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+  std::map<std::string, const BlackboardEntry *> entries;
+  std::vector<std::shared_lock<std::shared_mutex>> locks;
+  collect_entries(*this->storage, entries, locks);
 
   std::string result = "Blackboard\n";
 
   // Iterate through each value and append its string representation
-  for (const auto &ele : this->values) {
-    result += "\t" + ele.first + " (" + ele.second->to_string() + ")\n";
+  for (const auto &[key, entry] : entries) {
+    result += "\t" + key + " (" + entry->value->to_string() + ", " +
+              std::to_string(entry->size) + " bytes)\n";
+  }
+
+  if (this->storage->segment != nullptr) {
+    for (const std::string &key : this->storage->segment->get_keys()) {
+      // The key may be removed by another process meanwhile
+      try {
+        BlackboardValueHolder value;
+        this->find_shared(key)->load(*this->storage->segment, key, value);
+        result += "\t" + key + " (" + value->to_string() + ", " +
+                  std::to_string(value->get_size()) + " bytes)\n";
+      } catch (const std::runtime_error &) {
+      }
+    }
   }
 
   return result; // Return the complete string representation
 }
 
-const std::string &Blackboard::remap(const std::string &key) {
-  if (this->remappings.find(key) != this->remappings.end()) {
-    return this->remappings.at(key);
+std::shared_ptr<Blackboard> Blackboard::fork() {
+  auto fork = std::make_shared<Blackboard>(this->storage->segment);
+  fork->storage->base = this->storage;
+
+  std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+  fork->parent = this->parent;
+  fork->remappings = this->remappings;
+  fork->resolved_remappings = this->resolved_remappings;
+
+  return fork;
+}
+
+std::vector<std::string> Blackboard::get_changes() {
+  std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+
+  std::vector<std::string> keys;
+  for (const auto &[key, entry] : this->storage->entries) {
+    if (entry.version != 0) {
+      keys.push_back(key);
+    }
+  }
+
+  return keys;
+}
+
+void Blackboard::merge(Blackboard &fork, const std::vector<std::string> &keys) {
+  if (fork.storage->base != this->storage) {
+    throw std::invalid_argument(
+        "The blackboard to merge is not a fork of this blackboard");
+  }
+
+  // Forks are always locked before their base
+  std::shared_lock<std::shared_mutex> fork_lk(fork.storage->mutex);
+  std::unique_lock<std::shared_mutex> lk(this->storage->mutex);
+
+  for (const std::string &key : keys) {
+    auto it = fork.storage->entries.find(key);
+    if (it == fork.storage->entries.end()) {
+      continue;
+    }
+
+    const BlackboardEntry &fork_entry = it->second;
+    auto entry_it = this->storage->entries.try_emplace(key).first;
+    BlackboardEntry &entry = entry_it->second;
+
+    if (fork_entry.value != nullptr) {
+      if (entry.value == nullptr) {
+        this->storage->num_values++;
+      }
+      fork_entry.value->share(entry.value);
+
+      this->storage->memory_usage += fork_entry.size - entry.size;
+      entry.size = fork_entry.size;
+
+      // The fork only has a time to live if it was set in the fork
+      if (fork_entry.ttl.count() != 0) {
+        entry.expiration = fork_entry.expiration;
+      } else if (entry.ttl.count() != 0) {
+        entry.expiration = std::chrono::steady_clock::now() + entry.ttl;
+      } else {
+        entry.expiration = BlackboardEntry::NEVER;
+      }
+
+      if (this->storage->memory_budget != 0) {
+        this->touch(entry);
+      }
+      this->bump_version(entry);
+
+    } else {
+      this->clear_value(entry);
+      this->bump_version(entry);
+      this->erase_entry(entry_it);
+    }
+  }
+
+  fork_lk.unlock();
+  this->enforce_budget(nullptr);
+
+  if (this->storage->num_watchers.load() != 0) {
+    this->notify_changes(keys, lk);
+  }
+}
+
+std::size_t Blackboard::get_memory_usage() {
+  std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+  return this->storage->memory_usage;
+}
+
+std::size_t Blackboard::get_memory_usage(const std::string &key) {
+  std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+  const std::string &name = this->remap(key);
+
+  if (const SharedMemoryField *field = this->find_shared(name)) {
+    return this->storage->segment->contains(name) ? field->size : 0;
+  }
+
+  return this->read_entry(name, this->find_entry(name),
+                          [](const BlackboardEntry *entry) -> std::size_t {
+                            return entry != nullptr ? entry->size : 0;
+                          });
+}
+
+void Blackboard::set_memory_budget(std::size_t budget) {
+  std::unique_lock<std::shared_mutex> lk(this->storage->mutex);
+  this->storage->memory_budget = budget;
+  this->enforce_budget(nullptr);
+
+  if (!this->storage->evicted_keys.empty()) {
+    this->notify_changes({}, lk);
+  }
+}
+
+std::size_t Blackboard::get_memory_budget() {
+  std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+  return this->storage->memory_budget;
+}
+
+void Blackboard::set_ttl(const std::string &key,
+                         std::chrono::nanoseconds ttl) {
+  std::lock_guard<std::shared_mutex> lk(this->storage->mutex);
+  const std::string &name = this->remap(key);
+
+  if (this->find_shared(name) != nullptr) {
+    throw std::invalid_argument("Element '" + key +
+                                "' is shared and cannot expire");
+  }
+
+  auto it = this->storage->entries.try_emplace(name).first;
+  BlackboardEntry &entry = it->second;
+
+  if (entry.ttl.count() == 0 && ttl.count() != 0) {
+    this->storage->num_ttls++;
+  } else if (entry.ttl.count() != 0 && ttl.count() == 0) {
+    this->storage->num_ttls--;
+  }
+
+  entry.ttl = ttl;
+  if (entry.value != nullptr) {
+    entry.expiration = ttl.count() != 0
+                           ? std::chrono::steady_clock::now() + ttl
+                           : BlackboardEntry::NEVER;
+  } else {
+    this->erase_entry(it);
+  }
+}
+
+bool Blackboard::is_stale(const std::string &key) {
+  std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+  const std::string &name = this->remap(key);
+
+  if (this->find_shared(name) != nullptr) {
+    return false;
+  }
+
+  // The first storage that changed the key holds its value
+  const BlackboardEntry *entry = this->find_entry(name);
+  if (entry != nullptr && (entry->value != nullptr || entry->version != 0)) {
+    return entry->value != nullptr && entry->is_stale();
+  }
+
+  for (const BlackboardStorage *base = this->storage->base.get();
+       base != nullptr; base = base->base.get()) {
+    std::shared_lock<std::shared_mutex> base_lk(base->mutex);
+    auto it = base->entries.find(name);
+
+    if (it != base->entries.end() &&
+        (it->second.value != nullptr || it->second.version != 0)) {
+      return it->second.value != nullptr && it->second.is_stale();
+    }
+  }
+
+  return false;
+}
+
+std::size_t Blackboard::purge_stale() {
+  std::unique_lock<std::shared_mutex> lk(this->storage->mutex);
+  std::vector<std::string> keys = this->purge_stale_values();
+
+  if (!keys.empty()) {
+    YASMIN_LOG_DEBUG("Purged %zu stale values from the blackboard",
+                     keys.size());
+  }
+
+  if (!keys.empty() && this->storage->num_watchers.load() != 0) {
+    this->notify_changes(keys, lk);
+  }
+
+  return keys.size();
+}
+
+std::uint64_t Blackboard::get_version(const std::string &key) {
+  std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+  return this->read_version(this->remap(key));
+}
+
+bool Blackboard::wait_for_change(
+    const std::string &key, std::uint64_t version,
+    std::chrono::steady_clock::time_point deadline) {
+  YASMIN_LOG_DEBUG("Waiting for '%s' to change in the blackboard",
+                   key.c_str());
+
+  // Registered before locking, since the bases lock the fork to notify it
+  this->add_waiting_fork();
+
+  std::shared_lock<std::shared_mutex> lk(this->storage->mutex);
+
+  // Copied because the lock is released while waiting
+  const std::string name = this->remap(key);
+
+  // Shared keys can change in other processes, which only wake up the
+  // threads waiting on the segment
+  if (this->find_shared(name) != nullptr) {
+    lk.unlock();
+    this->remove_waiting_fork();
+    return this->storage->segment->wait_for_change(name, version, deadline);
+  }
+
+  // Writers check the number of watchers while holding the lock, so they see
+  // this thread before it starts waiting
+  this->storage->num_watchers++;
+  bool changed = this->storage->change_cond.wait_until(
+      lk, deadline, [this, &name, version]() {
+        return this->read_version(name) != version;
+      });
+  this->storage->num_watchers--;
+
+  lk.unlock();
+  this->remove_waiting_fork();
+
+  return changed;
+}
+
+void Blackboard::add_waiting_fork() {
+  for (const BlackboardStorage *base = this->storage->base.get();
+       base != nullptr; base = base->base.get()) {
+    std::lock_guard<std::mutex> forks_lk(base->forks_mutex);
+    base->waiting_forks.push_back(this->storage.get());
+    base->num_watchers++;
+  }
+}
+
+void Blackboard::remove_waiting_fork() {
+  for (const BlackboardStorage *base = this->storage->base.get();
+       base != nullptr; base = base->base.get()) {
+    std::lock_guard<std::mutex> forks_lk(base->forks_mutex);
+    base->waiting_forks.erase(std::find(base->waiting_forks.begin(),
+                                        base->waiting_forks.end(),
+                                        this->storage.get()));
+    base->num_watchers--;
+  }
+}
+
+bool Blackboard::wait_for_change(const std::string &key,
+                                 std::uint64_t version,
+                                 std::chrono::nanoseconds timeout) {
+  return this->wait_for_change(
+      key, version, std::chrono::steady_clock::now() + timeout);
+}
+
+std::size_t
+Blackboard::add_watch(const std::string &key,
+                      std::function<void(const std::string &)> callback) {
+  std::lock_guard<std::shared_mutex> lk(this->storage->mutex);
+  std::size_t id = this->storage->next_watch_id++;
+
+  this->storage->watches[this->remap(key)].push_back({id, key, callback});
+  this->storage->num_watchers++;
+
+  return id;
+}
+
+bool Blackboard::remove_watch(std::size_t id) {
+  std::lock_guard<std::shared_mutex> lk(this->storage->mutex);
+
+  for (auto it = this->storage->watches.begin();
+       it != this->storage->watches.end(); ++it) {
+    std::vector<BlackboardWatch> &watches = it->second;
+
+    for (auto watch = watches.begin(); watch != watches.end(); ++watch) {
+      if (watch->id == id) {
+        watches.erase(watch);
+        if (watches.empty()) {
+          this->storage->watches.erase(it);
+        }
+        this->storage->num_watchers--;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+void Blackboard::remove_value(const std::string &key,
+                              const std::string &name) {
+  if (this->find_shared(name) != nullptr) {
+    if (!this->storage->segment->remove(name)) {
+      throw std::runtime_error("Element '" + key +
+                               "' does not exist in the blackboard");
+    }
+    return;
+  }
+
+  // Stale values can also be removed
+  const BlackboardEntry *own_entry = this->find_entry(name);
+  bool exists =
+      (own_entry != nullptr && own_entry->value != nullptr) ||
+      this->read_entry(
+          name, own_entry,
+          [](const BlackboardEntry *entry) { return entry != nullptr; });
+
+  if (!exists) {
+    throw std::runtime_error("Element '" + key +
+                             "' does not exist in the blackboard");
+  }
+
+  // In a fork, the entry hides the value of the base
+  auto it = this->storage->entries.try_emplace(name).first;
+  this->clear_value(it->second);
+  this->bump_version(it->second);
+  this->erase_entry(it);
+}
+
+bool Blackboard::erase_entry(
+    std::map<std::string, BlackboardEntry>::iterator it) {
+  const BlackboardEntry &entry = it->second;
+
+  // Pairs with the release of the key handles that are destroyed
+  if (this->storage->base != nullptr || entry.value != nullptr ||
+      entry.ttl.count() != 0 ||
+      entry.num_handles.load(std::memory_order_acquire) != 0) {
+    return false;
+  }
+
+  this->storage->erased_version =
+      std::max(this->storage->erased_version, entry.version);
+  this->storage->entries.erase(it);
+  return true;
+}
+
+void Blackboard::account_value(BlackboardEntry &entry) {
+  std::size_t size = entry.value->get_size();
+  this->storage->memory_usage += size - entry.size;
+  entry.size = size;
+
+  entry.expiration = entry.ttl.count() != 0
+                         ? std::chrono::steady_clock::now() + entry.ttl
+                         : BlackboardEntry::NEVER;
+
+  if (this->storage->memory_budget != 0) {
+    this->touch(entry);
+    this->enforce_budget(&entry);
+  }
+}
+
+void Blackboard::clear_value(BlackboardEntry &entry) {
+  if (entry.value != nullptr) {
+    entry.value.reset(); // Free memory of the value
+    this->storage->num_values--;
+    this->storage->memory_usage -= entry.size;
+    entry.size = 0;
+    entry.expiration = BlackboardEntry::NEVER;
+  }
+}
+
+void Blackboard::enforce_budget(const BlackboardEntry *keep) {
+  if (this->storage->memory_budget == 0 ||
+      this->storage->memory_usage <= this->storage->memory_budget) {
+    return;
+  }
+
+  const bool notify = this->storage->num_watchers.load() != 0;
+  std::vector<std::string> keys = this->purge_stale_values();
+
+  while (this->storage->memory_usage > this->storage->memory_budget) {
+    // Find the least recently used value
+    std::map<std::string, BlackboardEntry>::iterator lru =
+        this->storage->entries.end();
+    std::uint64_t lru_access = 0;
+
+    for (auto it = this->storage->entries.begin();
+         it != this->storage->entries.end(); ++it) {
+      std::uint64_t access =
+          it->second.last_access.load(std::memory_order_relaxed);
+
+      if (it->second.value != nullptr && &it->second != keep &&
+          (lru == this->storage->entries.end() || access < lru_access)) {
+        lru = it;
+        lru_access = access;
+      }
+    }
+
+    if (lru == this->storage->entries.end()) {
+      break;
+    }
+
+    YASMIN_LOG_DEBUG("Evicting '%s' from the blackboard to meet its memory "
+                     "budget",
+                     lru->first.c_str());
+
+    this->clear_value(lru->second);
+    this->bump_version(lru->second);
+    keys.push_back(lru->first);
+    this->erase_entry(lru);
+  }
+
+  if (notify) {
+    this->storage->evicted_keys.insert(this->storage->evicted_keys.end(),
+                                       keys.begin(), keys.end());
+  }
+}
+
+std::vector<std::string> Blackboard::purge_stale_values() {
+  std::vector<std::string> keys;
+
+  if (this->storage->num_ttls == 0) {
+    return keys;
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  for (auto it = this->storage->entries.begin();
+       it != this->storage->entries.end();) {
+    auto next = std::next(it);
+    BlackboardEntry &entry = it->second;
+
+    if (entry.value != nullptr && now >= entry.expiration) {
+      this->clear_value(entry);
+      this->bump_version(entry);
+      keys.push_back(it->first);
+      this->erase_entry(it);
+    }
+
+    it = next;
+  }
+
+  return keys;
+}
+
+std::uint64_t Blackboard::read_version(const std::string &key) {
+  if (this->find_shared(key) != nullptr) {
+    return this->storage->segment->get_version(key);
+  }
+
+  const BlackboardEntry *entry = this->find_entry(key);
+  std::uint64_t version = entry != nullptr ? entry->version : 0;
+
+  // In a fork, the versions of the bases are added, so the version of a key
+  // never decreases when the fork changes it for the first time
+  for (const BlackboardStorage *base = this->storage->base.get();
+       base != nullptr; base = base->base.get()) {
+    std::shared_lock<std::shared_mutex> lk(base->mutex);
+    auto it = base->entries.find(key);
+
+    if (it != base->entries.end()) {
+      version += it->second.version;
+    }
+  }
+
+  return version;
+}
+
+void Blackboard::notify_changes(const std::vector<std::string> &keys,
+                                std::unique_lock<std::shared_mutex> &lk) {
+
+  // Copy the watches of the keys, which may be removed by the callbacks
+  std::vector<BlackboardWatch> watches;
+  auto add_watches = [this, &watches](const std::string &key) {
+    auto it = this->storage->watches.find(key);
+    if (it != this->storage->watches.end()) {
+      watches.insert(watches.end(), it->second.begin(), it->second.end());
+    }
+  };
+
+  for (const std::string &key : keys) {
+    add_watches(key);
+  }
+
+  for (const std::string &key : this->storage->evicted_keys) {
+    add_watches(key);
+  }
+  this->storage->evicted_keys.clear();
+
+  lk.unlock();
+  this->storage->change_cond.notify_all();
+
+  // The waiting forks read the keys of this storage. Locking a fork orders
+  // the notification after its threads check the versions.
+  {
+    std::lock_guard<std::mutex> forks_lk(this->storage->forks_mutex);
+    for (const BlackboardStorage *fork : this->storage->waiting_forks) {
+      { std::lock_guard<std::shared_mutex> fork_lk(fork->mutex); }
+      fork->change_cond.notify_all();
+    }
+  }
+
+  for (const BlackboardWatch &watch : watches) {
+    watch.callback(watch.name);
+  }
+}
+
+BlackboardEntry *Blackboard::find_entry(const std::string &key) {
+  auto it = this->storage->entries.find(key);
+
+  if (it == this->storage->entries.end()) {
+    return nullptr;
+  }
+
+  return &it->second;
+}
+
+void Blackboard::collect_entries(
+    const BlackboardStorage &storage,
+    std::map<std::string, const BlackboardEntry *> &entries,
+    std::vector<std::shared_lock<std::shared_mutex>> &locks) {
+
+  // The values of the base are overridden by the ones of the fork
+  if (storage.base != nullptr) {
+    locks.emplace_back(storage.base->mutex);
+    collect_entries(*storage.base, entries, locks);
+  }
+
+  // Stale values hide the values of the base, like removed ones
+  for (const auto &[key, entry] : storage.entries) {
+    if (entry.value != nullptr && !entry.is_stale()) {
+      entries[key] = &entry;
+    } else if (entry.value != nullptr || entry.version != 0) {
+      entries.erase(key);
+    }
+  }
+}
+
+const std::string &Blackboard::remap(const std::string &key) const {
+  if (this->resolved_remappings.empty()) {
+    return key;
+  }
+
+  auto it = this->resolved_remappings.find(key);
+  if (it != this->resolved_remappings.end()) {
+    return it->second;
   }
 
   return key;
 }
 
+void Blackboard::resolve_remappings() {
+  this->resolved_remappings.clear();
+
+  if (this->parent != nullptr) {
+    this->resolved_remappings = this->parent->resolved_remappings;
+  }
+
+  for (const auto &[key, remapped_key] : this->remappings) {
+    this->resolved_remappings[key] =
+        this->parent != nullptr ? this->parent->remap(remapped_key)
+                                : remapped_key;
+  }
+}
+
 void Blackboard::set_remappings(
     const std::map<std::string, std::string> &remappings) {
+  std::lock_guard<std::shared_mutex> lk(this->storage->mutex);
   this->remappings = remappings;
+  this->resolve_remappings();
 }
 
 const std::map<std::string, std::string> &Blackboard::get_remappings() {
@@ -17,12 +17,18 @@
 #include <pybind11/stl.h>
 
 #include "yasmin/blackboard/blackboard_pywrapper.hpp"
+#include "yasmin/blackboard/py_converter_registry.hpp"
 
 namespace py = pybind11;
 
 PYBIND11_MODULE(blackboard, m) {
   m.doc() = "Python bindings for yasmin::blackboard::Blackboard";
 
+  // Registry of converters shared with the other modules
+  static yasmin::blackboard::PyConverterRegistry converter_registry;
+  m.attr(yasmin::blackboard::PyConverterRegistry::CAPSULE_NAME) =
+      py::capsule(&converter_registry);
+
   py::class_<yasmin::blackboard::BlackboardPyWrapper>(m, "Blackboard")
       .def(py::init<>())
       .def("set", &yasmin::blackboard::BlackboardPyWrapper::set,
@@ -46,6 +52,10 @@ PYBIND11_MODULE(blackboard, m) {
              const std::string &name) -> py::object { return self.get(name); },
           "Get a value from the blackboard using attribute access",
           py::arg("name"))
+      .def("set_many", &yasmin::blackboard::BlackboardPyWrapper::set_many,
+           "Set several values in the blackboard at once", py::arg("values"))
+      .def("get_many", &yasmin::blackboard::BlackboardPyWrapper::get_many,
+           "Get several values from the blackboard at once", py::arg("keys"))
       .def("remove", &yasmin::blackboard::BlackboardPyWrapper::remove,
            "Remove a value from the blackboard", py::arg("key"))
       .def("__delitem__", &yasmin::blackboard::BlackboardPyWrapper::remove,
@@ -67,5 +77,48 @@ PYBIND11_MODULE(blackboard, m) {
            "Set the key remappings", py::arg("remappings"))
       .def("get_remappings",
            &yasmin::blackboard::BlackboardPyWrapper::get_remappings,
-           "Get the key remappings");
+           "Get the key remappings")
+      .def("get_version", &yasmin::blackboard::BlackboardPyWrapper::get_version,
+           "Get the version of a key, which increases when it changes",
+           py::arg("key"))
+      .def("wait_for_change",
+           &yasmin::blackboard::BlackboardPyWrapper::wait_for_change,
+           "Wait until a key changes or a timeout in seconds passes",
+           py::arg("key"), py::arg("version"), py::arg("timeout"))
+      .def("add_watch", &yasmin::blackboard::BlackboardPyWrapper::add_watch,
+           "Add a callback called each time a key is set or removed",
+           py::arg("key"), py::arg("callback"))
+      .def("get_memory_usage",
+           &yasmin::blackboard::BlackboardPyWrapper::get_memory_usage,
+           "Get the estimated bytes held by the values of the blackboard")
+      .def("get_key_memory_usage",
+           &yasmin::blackboard::BlackboardPyWrapper::get_key_memory_usage,
+           "Get the estimated bytes held by the value of a key",
+           py::arg("key"))
+      .def("set_memory_budget",
+           &yasmin::blackboard::BlackboardPyWrapper::set_memory_budget,
+           "Set the maximum bytes held by the values, 0 for no limit",
+           py::arg("budget"))
+      .def("get_memory_budget",
+           &yasmin::blackboard::BlackboardPyWrapper::get_memory_budget,
+           "Get the maximum bytes held by the values, 0 if there is no limit")
+      .def("set_ttl", &yasmin::blackboard::BlackboardPyWrapper::set_ttl,
+           "Set the time to live in seconds of the values of a key",
+           py::arg("key"), py::arg("ttl"))
+      .def("is_stale", &yasmin::blackboard::BlackboardPyWrapper::is_stale,
+           "Check if the time to live of the value of a key has passed",
+           py::arg("key"))
+      .def("purge_stale",
+           &yasmin::blackboard::BlackboardPyWrapper::purge_stale,
+           "Remove the stale values of the blackboard")
+      .def("save_snapshot",
+           &yasmin::blackboard::BlackboardPyWrapper::save_snapshot,
+           "Write a snapshot of the blackboard to a file", py::arg("path"))
+      .def("restore_snapshot",
+           &yasmin::blackboard::BlackboardPyWrapper::restore_snapshot,
+           "Restore the keys of a snapshot file into the blackboard",
+           py::arg("path"))
+      .def("remove_watch",
+           &yasmin::blackboard::BlackboardPyWrapper::remove_watch,
+           "Remove a callback added with add_watch", py::arg("id"));
 }
@@ -0,0 +1,409 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "yasmin/blackboard/blackboard_snapshot.hpp"
+#include "yasmin/blackboard/blackboard_transaction.hpp"
+#include "yasmin/blackboard/serializer_registry.hpp"
+#include "yasmin/logs.hpp"
+
+using namespace yasmin::blackboard;
+
+namespace {
+
+/**
+ * @brief Round a size up to the alignment of the records.
+ * @param size The size.
+ * @return The aligned size.
+ */
+std::size_t align(std::size_t size) {
+  return (size + BlackboardSnapshot::ALIGNMENT - 1) &
+         ~(BlackboardSnapshot::ALIGNMENT - 1);
+}
+
+/**
+ * @brief Build the error of a failed system call on a snapshot file.
+ * @param action The action that failed.
+ * @param path The path of the file.
+ * @return The error.
+ */
+std::runtime_error file_error(const std::string &action,
+                              const std::string &path) {
+  return std::runtime_error("Cannot " + action + " blackboard snapshot '" +
+                            path + "': " + std::strerror(errno));
+}
+
+/**
+ * @brief Write a whole buffer to a file.
+ * @param fd The descriptor of the file.
+ * @param data The buffer.
+ * @return True if the buffer was written, false otherwise.
+ */
+bool write_all(int fd, const std::vector<std::uint8_t> &data) {
+  std::size_t offset = 0;
+
+  while (offset < data.size()) {
+    ssize_t written = ::write(fd, data.data() + offset, data.size() - offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    offset += written;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Wait until the entries of the directory of a file are on disk, so a
+ * rename of the file survives a crash.
+ * @param path The path of the file.
+ * @return True if the directory was synced, false otherwise.
+ */
+bool sync_directory(const std::string &path) {
+  std::size_t slash = path.find_last_of('/');
+  std::string directory = ".";
+  if (slash == 0) {
+    directory = "/";
+  } else if (slash != std::string::npos) {
+    directory = path.substr(0, slash);
+  }
+
+  int dir_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+  if (dir_fd < 0) {
+    return false;
+  }
+
+  bool synced = ::fsync(dir_fd) == 0;
+  ::close(dir_fd);
+  return synced;
+}
+
+/**
+ * @struct SnapshotEntry
+ * @brief Last record of a key found in a snapshot file.
+ */
+struct SnapshotEntry {
+  /// Name of the type, empty if the key was removed
+  std::string_view type;
+  /// Data of the value, inside the mapped file
+  const std::uint8_t *data;
+  /// Size of the data
+  std::size_t size;
+};
+
+} // namespace
+
+BlackboardSnapshot::BlackboardSnapshot(Blackboard &blackboard,
+                                       const std::string &path, bool sync)
+    : blackboard(blackboard), path(path), sync(sync) {}
+
+BlackboardSnapshot::~BlackboardSnapshot() {
+  if (this->fd >= 0) {
+    ::close(this->fd);
+  }
+}
+
+std::size_t BlackboardSnapshot::write() {
+
+  // Rewrite the file when most of it is made of old records
+  const std::size_t current_size =
+      sizeof(BlackboardSnapshotHeader) + this->live_size;
+  const bool full =
+      this->fd < 0 || this->file_size > COMPACT_RATIO * current_size;
+
+  std::vector<std::uint8_t> data;
+  std::size_t num_records = 0;
+
+  if (full) {
+    BlackboardSnapshotHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.format_version = FORMAT_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    SerializerRegistry::append(data, &header, sizeof(header));
+
+    this->written_keys.clear();
+    this->live_size = 0;
+  }
+
+  {
+    BlackboardTransaction transaction(this->blackboard);
+    std::vector<std::string> keys = transaction.get_keys();
+    auto written_it = this->written_keys.begin();
+
+    for (const std::string &key : keys) {
+
+      // Keys that are no longer in the blackboard were removed
+      while (written_it != this->written_keys.end() &&
+             written_it->first < key) {
+        this->live_size -= written_it->second.second;
+        append_record(data, written_it->first, "", nullptr, nullptr);
+        written_it = this->written_keys.erase(written_it);
+        num_records++;
+      }
+
+      std::uint64_t version = transaction.get_version(key);
+      if (written_it != this->written_keys.end() && written_it->first == key) {
+        if (written_it->second.first == version) {
+          ++written_it;
+          continue;
+        }
+      } else {
+        written_it = this->written_keys.insert(written_it, {key, {0, 0}});
+      }
+
+      // Keys without serializer are also marked as written, so they are
+      // only reported when they change
+      std::size_t record_size = transaction.visit(
+          key, [&](const BlackboardValueInterface &value) -> std::size_t {
+            std::shared_ptr<const BlackboardSerializer> serializer =
+                SerializerRegistry::find(value.get_type_index());
+
+            if (serializer == nullptr) {
+              YASMIN_LOG_WARN("Key '%s' of type '%s' has no serializer and is "
+                              "not stored in the blackboard snapshot",
+                              key.c_str(),
+                              TypeRegistry::get_name(value.get_type_index())
+                                  .c_str());
+              return 0;
+            }
+
+            return append_record(data, key, serializer->name, &value,
+                                 serializer.get());
+          });
+
+      this->live_size += record_size - written_it->second.second;
+      written_it->second = {version, record_size};
+      ++written_it;
+      num_records += record_size != 0;
+    }
+
+    while (written_it != this->written_keys.end()) {
+      this->live_size -= written_it->second.second;
+      append_record(data, written_it->first, "", nullptr, nullptr);
+      written_it = this->written_keys.erase(written_it);
+      num_records++;
+    }
+  }
+
+  if (full) {
+    // The new file replaces the previous one once it is complete
+    const std::string tmp_path = this->path + ".tmp";
+    int tmp_fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (tmp_fd < 0) {
+      throw file_error("create", tmp_path);
+    }
+
+    if (!write_all(tmp_fd, data) || (this->sync && ::fsync(tmp_fd) != 0) ||
+        ::rename(tmp_path.c_str(), this->path.c_str()) != 0) {
+      std::runtime_error error = file_error("write", tmp_path);
+      ::close(tmp_fd);
+      ::unlink(tmp_path.c_str());
+      this->written_keys.clear();
+      throw error;
+    }
+
+    if (this->fd >= 0) {
+      ::close(this->fd);
+    }
+    this->fd = tmp_fd;
+    this->file_size = data.size();
+
+    // The rename is only durable once the directory is on disk
+    if (this->sync && !sync_directory(this->path)) {
+      throw file_error("sync the directory of", this->path);
+    }
+
+  } else if (!data.empty()) {
+    this->write_data(data);
+  }
+
+  return num_records;
+}
+
+void BlackboardSnapshot::save(Blackboard &blackboard,
+                              const std::string &path) {
+  BlackboardSnapshot(blackboard, path).write();
+}
+
+std::size_t BlackboardSnapshot::restore(Blackboard &blackboard,
+                                        const std::string &path) {
+
+  YASMIN_LOG_DEBUG("Restoring blackboard snapshot '%s'", path.c_str());
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw file_error("open", path);
+  }
+
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) != 0) {
+    std::runtime_error error = file_error("read", path);
+    ::close(fd);
+    throw error;
+  }
+
+  const std::size_t size = file_stat.st_size;
+  if (size < sizeof(BlackboardSnapshotHeader)) {
+    ::close(fd);
+    throw std::runtime_error("File '" + path +
+                             "' is not a blackboard snapshot");
+  }
+
+  void *address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (address == MAP_FAILED) {
+    throw file_error("map", path);
+  }
+
+  std::unique_ptr<void, std::function<void(void *)>> mapping(
+      address, [size](void *address) { ::munmap(address, size); });
+  const std::uint8_t *file = static_cast<const std::uint8_t *>(address);
+
+  // Check the header
+  BlackboardSnapshotHeader header;
+  std::memcpy(&header, file, sizeof(header));
+
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+    throw std::runtime_error("File '" + path +
+                             "' is not a blackboard snapshot");
+  }
+
+  if (header.format_version != FORMAT_VERSION ||
+      header.byte_order != BYTE_ORDER_MARK) {
+    throw std::runtime_error("Blackboard snapshot '" + path +
+                             "' has version " +
+                             std::to_string(header.format_version) +
+                             " or another byte order, expected version " +
+                             std::to_string(FORMAT_VERSION));
+  }
+
+  // Find the last record of each key, reading the records in place
+  std::map<std::string_view, SnapshotEntry> entries;
+  std::size_t offset = sizeof(header);
+
+  while (offset + sizeof(BlackboardSnapshotRecord) <= size) {
+    const auto *record =
+        reinterpret_cast<const BlackboardSnapshotRecord *>(file + offset);
+    std::size_t key_offset = offset + sizeof(BlackboardSnapshotRecord);
+    std::size_t type_offset = key_offset + record->key_size;
+    std::size_t data_offset = align(type_offset + record->type_size);
+
+    // A record cut by a crash ends the snapshot
+    if (data_offset > size || record->data_size > size - data_offset) {
+      YASMIN_LOG_WARN("Ignoring incomplete record at the end of blackboard "
+                      "snapshot '%s'",
+                      path.c_str());
+      break;
+    }
+
+    entries[std::string_view(
+        reinterpret_cast<const char *>(file + key_offset), record->key_size)] =
+        SnapshotEntry{
+            std::string_view(reinterpret_cast<const char *>(file + type_offset),
+                             record->type_size),
+            file + data_offset, record->data_size};
+
+    offset = align(data_offset + record->data_size);
+  }
+
+  // Set all the keys at once
+  std::size_t num_keys = 0;
+  BlackboardTransaction transaction(blackboard);
+
+  for (const auto &[key_view, entry] : entries) {
+    std::string key(key_view);
+
+    if (entry.type.empty()) {
+      if (transaction.contains(key)) {
+        transaction.remove(key);
+      }
+      continue;
+    }
+
+    std::string type(entry.type);
+    std::shared_ptr<const BlackboardSerializer> serializer =
+        SerializerRegistry::find(type);
+
+    if (serializer == nullptr) {
+      YASMIN_LOG_WARN("Key '%s' of type '%s' has no serializer and is not "
+                      "restored from the blackboard snapshot",
+                      key.c_str(), type.c_str());
+      continue;
+    }
+
+    serializer->deserialize(transaction, key, entry.data, entry.size);
+    num_keys++;
+  }
+
+  return num_keys;
+}
+
+std::size_t BlackboardSnapshot::append_record(
+    std::vector<std::uint8_t> &data, const std::string &key,
+    const std::string &type, const BlackboardValueInterface *value,
+    const BlackboardSerializer *serializer) {
+
+  const std::size_t start = data.size();
+
+  BlackboardSnapshotRecord record{};
+  record.key_size = key.size();
+  record.type_size = type.size();
+  SerializerRegistry::append(data, &record, sizeof(record));
+  SerializerRegistry::append(data, key.data(), key.size());
+  SerializerRegistry::append(data, type.data(), type.size());
+  data.resize(align(data.size()), 0);
+
+  if (value != nullptr) {
+    const std::size_t data_start = data.size();
+    serializer->serialize(*value, data);
+    record.data_size = data.size() - data_start;
+    std::memcpy(data.data() + start, &record, sizeof(record));
+    data.resize(align(data.size()), 0);
+  }
+
+  return data.size() - start;
+}
+
+void BlackboardSnapshot::write_data(const std::vector<std::uint8_t> &data) {
+  if (!write_all(this->fd, data) || (this->sync && ::fsync(this->fd) != 0)) {
+    // The file may end with a partial record, so the next write is full
+    std::runtime_error error = file_error("write", this->path);
+    this->written_keys.clear();
+    ::close(this->fd);
+    this->fd = -1;
+    throw error;
+  }
+
+  this->file_size += data.size();
+}
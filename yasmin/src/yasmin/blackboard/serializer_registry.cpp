@@ -0,0 +1,191 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include "yasmin/blackboard/serializer_registry.hpp"
+
+using namespace yasmin::blackboard;
+
+namespace {
+
+/**
+ * @struct Serializers
+ * @brief Registered serializers, indexed by type and by name.
+ */
+struct Serializers {
+  /// Serializers of each type
+  std::unordered_map<std::type_index,
+                     std::shared_ptr<const BlackboardSerializer>>
+      by_type;
+  /// Serializers of each name
+  std::unordered_map<std::string, std::shared_ptr<const BlackboardSerializer>>
+      by_name;
+  /// Mutex for the serializers, shared by readers
+  std::shared_mutex mutex;
+
+  /** @brief Constructs the registry with the default serializers. */
+  Serializers() {
+    this->add(typeid(bool),
+              SerializerRegistry::make_trivial_serializer<bool>("bool"));
+    this->add(typeid(int),
+              SerializerRegistry::make_trivial_serializer<int>("int"));
+    this->add(typeid(long),
+              SerializerRegistry::make_trivial_serializer<long>("long"));
+    this->add(typeid(unsigned int),
+              SerializerRegistry::make_trivial_serializer<unsigned int>(
+                  "unsigned int"));
+    this->add(typeid(unsigned long),
+              SerializerRegistry::make_trivial_serializer<unsigned long>(
+                  "unsigned long"));
+    this->add(typeid(float),
+              SerializerRegistry::make_trivial_serializer<float>("float"));
+    this->add(typeid(double),
+              SerializerRegistry::make_trivial_serializer<double>("double"));
+
+    this->add(typeid(std::vector<int>),
+              SerializerRegistry::make_vector_serializer<int>("vector<int>"));
+    this->add(
+        typeid(std::vector<long>),
+        SerializerRegistry::make_vector_serializer<long>("vector<long>"));
+    this->add(
+        typeid(std::vector<float>),
+        SerializerRegistry::make_vector_serializer<float>("vector<float>"));
+    this->add(
+        typeid(std::vector<double>),
+        SerializerRegistry::make_vector_serializer<double>("vector<double>"));
+
+    this->add(typeid(std::string),
+              SerializerRegistry::make_serializer<std::string>(
+                  "string",
+                  [](const std::string &value,
+                     std::vector<std::uint8_t> &data) {
+                    SerializerRegistry::append(data, value.data(),
+                                               value.size());
+                  },
+                  [](const std::uint8_t *data, std::size_t size) {
+                    return std::string(reinterpret_cast<const char *>(data),
+                                       size);
+                  }));
+
+    // Bits of a vector of booleans are stored as bytes
+    this->add(typeid(std::vector<bool>),
+              SerializerRegistry::make_serializer<std::vector<bool>>(
+                  "vector<bool>",
+                  [](const std::vector<bool> &value,
+                     std::vector<std::uint8_t> &data) {
+                    data.insert(data.end(), value.begin(), value.end());
+                  },
+                  [](const std::uint8_t *data, std::size_t size) {
+                    return std::vector<bool>(data, data + size);
+                  }));
+
+    // Strings are stored with their size before them
+    this->add(typeid(std::vector<std::string>),
+              SerializerRegistry::make_serializer<std::vector<std::string>>(
+                  "vector<string>",
+                  [](const std::vector<std::string> &value,
+                     std::vector<std::uint8_t> &data) {
+                    for (const std::string &element : value) {
+                      std::uint64_t size = element.size();
+                      SerializerRegistry::append(data, &size, sizeof(size));
+                      SerializerRegistry::append(data, element.data(),
+                                                 element.size());
+                    }
+                  },
+                  [](const std::uint8_t *data, std::size_t size) {
+                    std::vector<std::string> value;
+                    std::size_t offset = 0;
+
+                    while (offset < size) {
+                      std::uint64_t element_size;
+                      if (size - offset < sizeof(element_size)) {
+                        break;
+                      }
+                      std::memcpy(&element_size, data + offset,
+                                  sizeof(element_size));
+                      offset += sizeof(element_size);
+
+                      if (size - offset < element_size) {
+                        break;
+                      }
+                      value.emplace_back(
+                          reinterpret_cast<const char *>(data + offset),
+                          element_size);
+                      offset += element_size;
+                    }
+
+                    SerializerRegistry::check_size("vector<string>", offset,
+                                                   size);
+                    return value;
+                  }));
+  }
+
+  /**
+   * @brief Adds a serializer.
+   * @param type The type of the values.
+   * @param serializer The serializer.
+   */
+  void add(const std::type_index &type, BlackboardSerializer serializer) {
+    auto shared_serializer =
+        std::make_shared<const BlackboardSerializer>(std::move(serializer));
+    this->by_type[type] = shared_serializer;
+    this->by_name[shared_serializer->name] = shared_serializer;
+  }
+};
+
+/**
+ * @brief Get the registered serializers, built on first use so they can be
+ * registered during static initialization.
+ * @return The serializers.
+ */
+Serializers &get_serializers() {
+  static Serializers serializers;
+  return serializers;
+}
+
+} // namespace
+
+void SerializerRegistry::register_serializer(const std::type_index &type,
+                                             BlackboardSerializer serializer) {
+  Serializers &serializers = get_serializers();
+  std::lock_guard<std::shared_mutex> lk(serializers.mutex);
+  serializers.add(type, std::move(serializer));
+}
+
+std::shared_ptr<const BlackboardSerializer>
+SerializerRegistry::find(const std::type_index &type) {
+  Serializers &serializers = get_serializers();
+  std::shared_lock<std::shared_mutex> lk(serializers.mutex);
+  auto it = serializers.by_type.find(type);
+  return it != serializers.by_type.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<const BlackboardSerializer>
+SerializerRegistry::find(const std::string &name) {
+  Serializers &serializers = get_serializers();
+  std::shared_lock<std::shared_mutex> lk(serializers.mutex);
+  auto it = serializers.by_name.find(name);
+  return it != serializers.by_name.end() ? it->second : nullptr;
+}
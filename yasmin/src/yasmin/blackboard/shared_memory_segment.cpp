@@ -0,0 +1,532 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "yasmin/blackboard/shared_memory_segment.hpp"
+#include "yasmin/blackboard/type_registry.hpp"
+#include "yasmin/logs.hpp"
+
+using namespace yasmin::blackboard;
+
+namespace {
+
+/// Size of the names in the segment, with the terminating null character
+constexpr std::size_t NAME_SIZE = SharedMemorySegment::MAX_NAME_SIZE + 1;
+/// Alignment of the slots, so writes to a key do not slow down the readers
+/// of the other ones by sharing a cache line
+constexpr std::size_t SLOT_ALIGNMENT = 64;
+/// Number of times to retry before yielding and checking if the writer of a
+/// slot is alive
+constexpr int MAX_SPINS = 128;
+/// Time to wait for the process that creates a segment to initialize it
+constexpr std::chrono::seconds OPEN_TIMEOUT(1);
+
+/**
+ * @struct SegmentHeader
+ * @brief Header at the start of a segment.
+ */
+struct SegmentHeader {
+  /// Bytes that identify the memory as a segment
+  char magic[8];
+  /// Flag set when the segment is initialized
+  std::atomic<std::uint32_t> ready;
+  /// Version of the layout of the memory
+  std::uint32_t format_version;
+  /// Number of fields
+  std::uint64_t num_fields;
+  /// Size of the segment
+  std::uint64_t size;
+};
+
+/**
+ * @struct FieldHeader
+ * @brief Description of a field in a segment, after the header.
+ */
+struct FieldHeader {
+  /// The key
+  char name[NAME_SIZE];
+  /// The name of the type of the value
+  char type[NAME_SIZE];
+  /// Size of the value
+  std::uint64_t size;
+  /// Offset of the slot from the start of the segment
+  std::uint64_t offset;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free &&
+                  std::atomic<std::uint32_t>::is_always_lock_free &&
+                  std::atomic<std::int32_t>::is_always_lock_free,
+              "Shared memory segments need lock-free atomics");
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+              "Futexes need 32-bit atomics");
+
+/**
+ * @brief Round a size up to the alignment of the slots.
+ * @param size The size.
+ * @return The aligned size.
+ */
+std::size_t align(std::size_t size) {
+  return (size + SLOT_ALIGNMENT - 1) & ~(SLOT_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Build the error of a failed system call on a segment.
+ * @param action The action that failed.
+ * @param name The name of the segment.
+ * @return The error.
+ */
+std::runtime_error segment_error(const std::string &action,
+                                 const std::string &name) {
+  return std::runtime_error("Cannot " + action + " shared memory segment '" +
+                            name + "': " + std::strerror(errno));
+}
+
+/**
+ * @brief Get the data of a slot.
+ * @param slot The slot.
+ * @return The words after the header of the slot.
+ */
+std::atomic<std::uint64_t> *get_data(SharedMemorySlot *slot) {
+  return reinterpret_cast<std::atomic<std::uint64_t> *>(slot + 1);
+}
+
+/**
+ * @brief Check if a process is alive.
+ * @param pid The process.
+ * @return False if the process does not exist, otherwise true.
+ */
+bool is_alive(std::int32_t pid) { return kill(pid, 0) == 0 || errno != ESRCH; }
+
+/**
+ * @brief Block until a counter of a slot changes or a timeout passes.
+ *
+ * On Linux, the thread sleeps in a futex shared by all the processes that
+ * map the segment. Elsewhere, the counter is polled.
+ *
+ * @param counter The counter.
+ * @param value The value of the counter already seen.
+ * @param timeout The maximum time to wait.
+ */
+void wait_counter(std::atomic<std::uint32_t> &counter, std::uint32_t value,
+                  std::chrono::nanoseconds timeout) {
+#ifdef __linux__
+  struct timespec ts;
+  ts.tv_sec = timeout.count() / 1000000000;
+  ts.tv_nsec = timeout.count() % 1000000000;
+  syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&counter), FUTEX_WAIT,
+          value, &ts, nullptr, 0);
+#else
+  (void)value;
+  std::this_thread::sleep_for(
+      std::min<std::chrono::nanoseconds>(timeout, std::chrono::milliseconds(1)));
+#endif
+}
+
+/**
+ * @brief Wake up the threads blocked on a counter of a slot.
+ * @param counter The counter.
+ */
+void wake_counter(std::atomic<std::uint32_t> &counter) {
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&counter), FUTEX_WAKE,
+          INT_MAX, nullptr, nullptr, 0);
+#else
+  (void)counter;
+#endif
+}
+
+/**
+ * @brief Acquire the right to write a slot.
+ *
+ * If the process that holds it died, it is taken over and the value it was
+ * writing, if any, is dropped.
+ *
+ * @param slot The slot.
+ * @param pid The process that writes the slot.
+ */
+void lock_slot(SharedMemorySlot &slot, std::int32_t pid) {
+  for (int spins = 0;; ++spins) {
+    std::int32_t writer = 0;
+    if (slot.writer.compare_exchange_weak(writer, pid,
+                                          std::memory_order_acquire,
+                                          std::memory_order_relaxed)) {
+      return;
+    }
+
+    if (spins < MAX_SPINS) {
+      continue;
+    }
+
+    if (writer != 0 && !is_alive(writer) &&
+        slot.writer.compare_exchange_strong(writer, pid,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+      YASMIN_LOG_WARN("Process %d died while writing a shared value", writer);
+
+      std::uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+      if (sequence % 2 != 0) {
+        slot.present.store(0, std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_release);
+        slot.changes.fetch_add(1, std::memory_order_seq_cst);
+        wake_counter(slot.changes);
+      }
+      return;
+    }
+
+    std::this_thread::yield();
+  }
+}
+
+/**
+ * @brief Release the right to write a slot.
+ * @param slot The slot.
+ */
+void unlock_slot(SharedMemorySlot &slot) {
+  slot.writer.store(0, std::memory_order_release);
+}
+
+} // namespace
+
+constexpr char SharedMemorySegment::MAGIC[8];
+
+SharedMemorySegment::SharedMemorySegment(const std::string &name,
+                                         const SharedMemoryLayout &layout)
+    : name(name.empty() || name[0] != '/' ? "/" + name : name),
+      pid(getpid()) {
+
+  const std::vector<SharedMemoryField> &fields = layout.get_fields();
+  std::vector<std::string> type_names;
+  std::set<std::string> names;
+
+  // Compute the offsets of the slots
+  std::vector<std::uint64_t> offsets;
+  std::size_t size =
+      align(sizeof(SegmentHeader) + fields.size() * sizeof(FieldHeader));
+
+  for (const SharedMemoryField &field : fields) {
+    type_names.push_back(TypeRegistry::get_name(field.type));
+
+    if (field.name.size() > MAX_NAME_SIZE ||
+        type_names.back().size() > MAX_NAME_SIZE) {
+      throw std::invalid_argument("Key '" + field.name +
+                                  "' or its type name is too long");
+    }
+
+    if (!names.insert(field.name).second) {
+      throw std::invalid_argument("Key '" + field.name +
+                                  "' is repeated in the layout");
+    }
+
+    offsets.push_back(size);
+    size += align(sizeof(SharedMemorySlot) +
+                  num_words(field.size) * sizeof(std::uint64_t));
+  }
+
+  // The first process creates the segment
+  bool created = true;
+  int fd = shm_open(this->name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+
+  if (fd < 0 && errno == EEXIST) {
+    created = false;
+    fd = shm_open(this->name.c_str(), O_RDWR, 0);
+  }
+
+  if (fd < 0) {
+    throw segment_error("open", this->name);
+  }
+
+  if (created && ftruncate(fd, size) != 0) {
+    std::runtime_error error = segment_error("resize", this->name);
+    close(fd);
+    shm_unlink(this->name.c_str());
+    throw error;
+  }
+
+  // The size is set at once by the process that creates the segment
+  auto deadline = std::chrono::steady_clock::now() + OPEN_TIMEOUT;
+  struct stat stat;
+
+  while (fstat(fd, &stat) == 0 && stat.st_size == 0 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  if (static_cast<std::size_t>(stat.st_size) != size) {
+    close(fd);
+    throw std::runtime_error("Shared memory segment '" + this->name +
+                             "' has another layout");
+  }
+
+  this->memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (this->memory == MAP_FAILED) {
+    this->memory = nullptr;
+    throw segment_error("map", this->name);
+  }
+
+  this->size = size;
+  char *memory = static_cast<char *>(this->memory);
+  auto *header = reinterpret_cast<SegmentHeader *>(memory);
+  auto *field_headers =
+      reinterpret_cast<FieldHeader *>(memory + sizeof(SegmentHeader));
+
+  if (created) {
+    // The memory of a new segment is filled with zeros
+    new (header) SegmentHeader();
+    std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+    header->format_version = FORMAT_VERSION;
+    header->num_fields = fields.size();
+    header->size = size;
+
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+      FieldHeader &field_header = field_headers[i];
+      std::strncpy(field_header.name, fields[i].name.c_str(), NAME_SIZE);
+      std::strncpy(field_header.type, type_names[i].c_str(), NAME_SIZE);
+      field_header.size = fields[i].size;
+      field_header.offset = offsets[i];
+      new (memory + offsets[i]) SharedMemorySlot();
+    }
+
+    header->ready.store(1, std::memory_order_release);
+
+  } else {
+    while (header->ready.load(std::memory_order_acquire) == 0 &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    bool valid = header->ready.load(std::memory_order_acquire) != 0 &&
+                 std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                 header->format_version == FORMAT_VERSION &&
+                 header->num_fields == fields.size();
+
+    for (std::size_t i = 0; valid && i < fields.size(); ++i) {
+      const FieldHeader &field_header = field_headers[i];
+      valid = fields[i].name == field_header.name &&
+              type_names[i] == field_header.type &&
+              fields[i].size == field_header.size &&
+              offsets[i] == field_header.offset;
+    }
+
+    if (!valid) {
+      munmap(this->memory, this->size);
+      this->memory = nullptr;
+      throw std::runtime_error("Shared memory segment '" + this->name +
+                               "' has another layout");
+    }
+  }
+
+  for (std::size_t i = 0; i < fields.size(); ++i) {
+    this->keys.push_back(fields[i].name);
+    this->slots.emplace(
+        fields[i].name,
+        Slot{fields[i],
+             reinterpret_cast<SharedMemorySlot *>(memory + offsets[i])});
+  }
+
+  YASMIN_LOG_DEBUG("%s shared memory segment '%s' with %zu keys",
+                   created ? "Created" : "Opened", this->name.c_str(),
+                   fields.size());
+}
+
+SharedMemorySegment::~SharedMemorySegment() {
+  if (this->memory != nullptr) {
+    munmap(this->memory, this->size);
+  }
+}
+
+bool SharedMemorySegment::unlink(const std::string &name) {
+  const std::string shm_name =
+      name.empty() || name[0] != '/' ? "/" + name : name;
+  return shm_unlink(shm_name.c_str()) == 0;
+}
+
+bool SharedMemorySegment::remove(const std::string &key) {
+  auto it = this->slots.find(key);
+  if (it == this->slots.end()) {
+    return false;
+  }
+  return this->write(it->second, nullptr, false);
+}
+
+bool SharedMemorySegment::contains(const std::string &key) const {
+  auto it = this->slots.find(key);
+  return it != this->slots.end() && this->read(it->second, nullptr);
+}
+
+std::uint64_t SharedMemorySegment::get_version(const std::string &key) const {
+  auto it = this->slots.find(key);
+  if (it == this->slots.end()) {
+    return 0;
+  }
+
+  // Each write adds 2 to the sequence
+  return it->second.slot->sequence.load(std::memory_order_acquire) / 2;
+}
+
+bool SharedMemorySegment::wait_for_change(
+    const std::string &key, std::uint64_t version,
+    std::chrono::steady_clock::time_point deadline) const {
+  auto it = this->slots.find(key);
+  if (it == this->slots.end()) {
+    return false;
+  }
+
+  SharedMemorySlot &header = *it->second.slot;
+  header.waiters.fetch_add(1, std::memory_order_seq_cst);
+
+  bool changed = false;
+  for (;;) {
+    // The counter is read first, so a write made after the check wakes the
+    // wait below
+    std::uint32_t changes = header.changes.load(std::memory_order_seq_cst);
+    if (header.sequence.load(std::memory_order_acquire) / 2 != version) {
+      changed = true;
+      break;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      break;
+    }
+
+    wait_counter(header.changes, changes, deadline - now);
+  }
+
+  header.waiters.fetch_sub(1, std::memory_order_relaxed);
+  return changed;
+}
+
+std::vector<std::string> SharedMemorySegment::get_keys() const {
+  std::vector<std::string> keys;
+
+  for (const std::string &key : this->keys) {
+    if (this->read(this->slots.at(key), nullptr)) {
+      keys.push_back(key);
+    }
+  }
+
+  return keys;
+}
+
+const SharedMemorySegment::Slot &
+SharedMemorySegment::get_slot(const std::string &key,
+                              std::type_index type) const {
+  auto it = this->slots.find(key);
+
+  if (it == this->slots.end()) {
+    throw std::runtime_error("Element '" + key +
+                             "' is not in the shared memory segment '" +
+                             this->name + "'");
+  }
+
+  if (it->second.field.type != type) {
+    throw std::runtime_error("Element '" + key + "' is of type '" +
+                             TypeRegistry::get_name(it->second.field.type) +
+                             "' in the blackboard");
+  }
+
+  return it->second;
+}
+
+bool SharedMemorySegment::read(const Slot &slot, std::uint64_t *words) const {
+  SharedMemorySlot &header = *slot.slot;
+  const std::atomic<std::uint64_t> *data = get_data(slot.slot);
+  const std::size_t size = words != nullptr ? num_words(slot.field.size) : 0;
+
+  for (int spins = 0;; ++spins) {
+    std::uint64_t sequence = header.sequence.load(std::memory_order_acquire);
+
+    if (sequence % 2 != 0) {
+      // Writers take a few nanoseconds, unless they died while writing
+      if (spins >= MAX_SPINS) {
+        std::int32_t writer = header.writer.load(std::memory_order_relaxed);
+        if (writer != 0 && !is_alive(writer)) {
+          lock_slot(header, this->pid);
+          unlock_slot(header);
+        }
+        std::this_thread::yield();
+      }
+      continue;
+    }
+
+    bool present = header.present.load(std::memory_order_relaxed) != 0;
+    for (std::size_t i = 0; i < size; ++i) {
+      words[i] = data[i].load(std::memory_order_relaxed);
+    }
+
+    // The copy is only valid if no writer changed the value meanwhile
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header.sequence.load(std::memory_order_relaxed) == sequence) {
+      return present;
+    }
+  }
+}
+
+bool SharedMemorySegment::write(const Slot &slot, const std::uint64_t *words,
+                                bool present) {
+  SharedMemorySlot &header = *slot.slot;
+  std::atomic<std::uint64_t> *data = get_data(slot.slot);
+
+  lock_slot(header, this->pid);
+
+  std::uint64_t sequence = header.sequence.load(std::memory_order_relaxed);
+  header.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  bool was_present = header.present.load(std::memory_order_relaxed) != 0;
+  if (words != nullptr) {
+    for (std::size_t i = 0; i < num_words(slot.field.size); ++i) {
+      data[i].store(words[i], std::memory_order_relaxed);
+    }
+  }
+  header.present.store(present ? 1 : 0, std::memory_order_relaxed);
+
+  header.sequence.store(sequence + 2, std::memory_order_release);
+  unlock_slot(header);
+
+  header.changes.fetch_add(1, std::memory_order_seq_cst);
+  if (header.waiters.load(std::memory_order_seq_cst) != 0) {
+    wake_counter(header.changes);
+  }
+
+  return was_present;
+}
@@ -0,0 +1,65 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <cstdlib>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+
+#ifdef __GNUG__     // If using GCC/G++
+#include <cxxabi.h> // For abi::__cxa_demangle
+#endif
+
+#include "yasmin/blackboard/type_registry.hpp"
+
+using namespace yasmin::blackboard;
+
+namespace {
+
+/// Demangled names of the types requested so far
+std::unordered_map<std::type_index, std::string> type_names;
+/// Mutex for the names, shared by readers
+std::shared_mutex type_names_mutex;
+
+} // namespace
+
+const std::string &TypeRegistry::get_name(const std::type_index &type) {
+  {
+    std::shared_lock<std::shared_mutex> lk(type_names_mutex);
+    auto it = type_names.find(type);
+    if (it != type_names.end()) {
+      return it->second;
+    }
+  }
+
+  std::string name = type.name(); // Get the mangled name of the type
+
+#ifdef __GNUG__ // If using GCC/G++
+  int status;
+  // Demangle the name using GCC's demangling function
+  char *demangled =
+      abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+  if (status == 0) {
+    name = demangled;
+  }
+  free(demangled);
+#endif
+
+  // References to the elements of the map remain valid after rehashing
+  std::lock_guard<std::shared_mutex> lk(type_names_mutex);
+  return type_names.emplace(type, name).first->second;
+}
@@ -15,22 +15,32 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <algorithm>
+#include <condition_variable>
 #include <exception>
+#include <map>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
 #include "yasmin/concurrence.hpp"
 #include "yasmin/logs.hpp"
+#include "yasmin/thread_pool.hpp"
+#include "yasmin/trace_recorder.hpp"
 
 using namespace yasmin;
 
 Concurrence::Concurrence(
     const std::map<std::string, std::shared_ptr<State>> &states,
-    const std::string &default_outcome, const OutcomeMap &outcome_map)
+    const std::string &default_outcome, const OutcomeMap &outcome_map,
+    JoinPolicy join_policy, std::size_t quorum,
+    const std::string &fail_fast_outcome, ConflictPolicy conflict_policy)
     : State(generate_possible_outcomes(outcome_map, default_outcome)),
       states(states), default_outcome(default_outcome),
-      outcome_map(outcome_map) {
+      outcome_map(outcome_map), join_policy(join_policy), quorum(quorum),
+      fail_fast_outcome(fail_fast_outcome), conflict_policy(conflict_policy),
+      branches(states.size()),
+      compiled_fail_fast_outcome(fail_fast_outcome) {
 
   // Require at least one state
   if (states.empty()) {
@@ -47,8 +57,18 @@ Concurrence::Concurrence(
     unique_instances.insert(state);
   }
 
-  // Validate outcome map and prepare intermediate outcomes map
+  // Assign a slot to each state
+  std::size_t index = 0;
+  for (const auto &[state_name, state] : states) {
+    this->branches[index].name = state_name;
+    this->branches[index].state = state;
+    index++;
+  }
+
+  // Validate outcome map and compile it into branch and outcome indices
   for (const auto &[outcome, requirements] : outcome_map) {
+    CompiledOutcome compiled_outcome{outcome, {}};
+
     if (requirements.empty()) {
       throw std::invalid_argument(
           "Outcome '" + outcome +
@@ -75,70 +95,231 @@ Concurrence::Concurrence(
             state->to_string() + "'");
       }
 
-      intermediate_outcome_map.insert({state_name, nullptr});
+      compiled_outcome.requirements.push_back(
+          {(std::size_t)std::distance(states.begin(), state_it),
+           state->get_outcome_set().index_of(intermediate_outcome)});
+    }
+
+    this->compiled_outcome_map.push_back(compiled_outcome);
+  }
+
+  // Validate the join policy
+  if (join_policy == JoinPolicy::QUORUM &&
+      (quorum == 0 || quorum > states.size())) {
+    throw std::invalid_argument(
+        "Quorum " + std::to_string(quorum) + " must be between 1 and " +
+        std::to_string(states.size()) + ", the number of concurrent states");
+  }
+
+  if (join_policy == JoinPolicy::FAIL_FAST) {
+    bool found = false;
+    for (const auto &[state_name, state] : states) {
+      if (state->get_outcomes().count(fail_fast_outcome)) {
+        found = true;
+        break;
+      }
+    }
+
+    if (!found) {
+      throw std::invalid_argument("Fail-fast outcome '" + fail_fast_outcome +
+                                  "' is not a valid outcome of any of the "
+                                  "concurrent states");
+    }
+  }
+}
+
+Concurrence::Execution &Concurrence::acquire_execution(
+    std::shared_ptr<blackboard::Blackboard> blackboard) {
+
+  std::unique_ptr<Execution> execution;
+  {
+    const std::lock_guard<std::mutex> lock(this->executions_mutex);
+    if (!this->free_executions.empty()) {
+      execution = std::move(this->free_executions.back());
+      this->free_executions.pop_back();
+    }
+  }
+
+  if (execution == nullptr) {
+    execution = std::make_unique<Execution>(this);
+  }
+
+  // Clear the slots of previous executions
+  for (BranchRun &branch_run : execution->branches) {
+    branch_run.outcome = NO_OUTCOME;
+    branch_run.order = SIZE_MAX;
+    branch_run.exception = nullptr;
+    branch_run.run.status.store(StateStatus::IDLE);
+
+    if (this->conflict_policy == ConflictPolicy::SHARED) {
+      branch_run.blackboard = blackboard;
+    } else {
+      branch_run.blackboard = blackboard->fork();
+    }
+  }
+
+  execution->run = this->get_current_run();
+  execution->running_branches.store(this->branches.size());
+  execution->finished_branches.store(0);
+  execution->joined.store(false);
+  execution->join_order.store(SIZE_MAX);
+
+  const std::lock_guard<std::mutex> lock(this->executions_mutex);
+  this->executions.push_back(std::move(execution));
+
+  // The run may have been canceled before the execution was registered
+  if (this->executions.back()->run != nullptr && this->is_canceled()) {
+    for (BranchRun &branch_run : this->executions.back()->branches) {
+      branch_run.run.status.store(StateStatus::CANCELED);
     }
   }
+
+  return *this->executions.back();
+}
+
+void Concurrence::release_execution(Execution &execution) {
+
+  // Release the forks, so their values are no longer shared
+  for (BranchRun &branch_run : execution.branches) {
+    branch_run.blackboard = nullptr;
+  }
+
+  const std::lock_guard<std::mutex> lock(this->executions_mutex);
+  auto it = std::find_if(this->executions.begin(), this->executions.end(),
+                         [&execution](const std::unique_ptr<Execution> &e) {
+                           return e.get() == &execution;
+                         });
+  this->free_executions.push_back(std::move(*it));
+  this->executions.erase(it);
 }
 
 std::string
 Concurrence::execute(std::shared_ptr<blackboard::Blackboard> blackboard) {
-  std::vector<std::thread> state_threads;
+  ThreadPool &pool = ThreadPool::get_instance();
+  Execution &execution = this->acquire_execution(blackboard);
 
-  // Initialize the parallel execution of all the states
-  for (const auto &[state_name, state] : states) {
-    state_threads.push_back(std::thread([this, state_name, state,
-                                         blackboard]() {
-      std::string outcome = (*state.get())(blackboard);
-      const std::lock_guard<std::mutex> lock(this->intermediate_outcome_mutex);
-      this->intermediate_outcome_map[state_name] =
-          std::make_shared<std::string>(outcome);
-    }));
+  // Start the states on idle workers, or on new workers when the pool is
+  // busy, so the states run at the same time and can wait for each other.
+  // The calling thread runs the last state.
+  const std::size_t last_branch = this->branches.size() - 1;
+
+  for (std::size_t i = 0; i < last_branch; ++i) {
+    const std::shared_ptr<BranchTask> &branch_task = execution.tasks[i];
+    branch_task->reset();
+    branch_task->queued = false;
+
+    // The execution outlives the run of the task, since it waits for every
+    // branch
+    if (!pool.try_start(branch_task)) {
+      YASMIN_LOG_DEBUG("No worker for state '%s', queuing it",
+                       this->branches[i].name.c_str());
+      branch_task->queued = true;
+      pool.submit(branch_task);
+    }
+  }
+
+  this->run_branch(execution, last_branch);
+
+  // Run the queued states that no worker has taken yet
+  for (std::size_t i = 0; i < last_branch; ++i) {
+    if (execution.tasks[i]->queued) {
+      execution.tasks[i]->try_run();
+    }
   }
 
   // Wait for states to finish
-  for (std::thread &state_thread : state_threads) {
-    if (state_thread.joinable()) {
-      state_thread.join();
+  {
+    std::unique_lock<std::mutex> lock(execution.join_mutex);
+    execution.join_cond.wait(lock, [&execution]() {
+      return execution.running_branches.load() == 0;
+    });
+  }
+
+  try {
+    std::string outcome = this->join(blackboard, execution);
+    this->release_execution(execution);
+    return outcome;
+
+  } catch (...) {
+    this->release_execution(execution);
+    throw;
+  }
+}
+
+std::string
+Concurrence::join(std::shared_ptr<blackboard::Blackboard> blackboard,
+                  const Execution &execution) {
+
+  // Outcomes and exceptions received after the join are discarded
+  const std::size_t last_order = execution.join_order.load();
+  const BranchRun *failed_branch = nullptr;
+
+  for (const BranchRun &branch_run : execution.branches) {
+    if (branch_run.exception && branch_run.order <= last_order &&
+        (failed_branch == nullptr ||
+         branch_run.order < failed_branch->order)) {
+      failed_branch = &branch_run;
     }
   }
 
+  if (failed_branch != nullptr) {
+    std::rethrow_exception(failed_branch->exception);
+  }
+
+  if (this->conflict_policy != ConflictPolicy::SHARED) {
+    this->merge_branches(blackboard, execution, last_order);
+  }
+
   // Handle a cancel
   if (is_canceled()) {
     return default_outcome; // ? not sure waht else to return here
   }
 
   // Build final outcome
-  std::set<std::string> satisfied_outcomes;
-  for (const auto &[outcome, requirements] : outcome_map) {
-    bool satisfied = true;
-    for (const auto &[state_name, expected_intermediate_outcome] :
-         requirements) {
-      std::shared_ptr<std::string> actual_intermediate_outcome =
-          intermediate_outcome_map.find(state_name)->second;
-      if (actual_intermediate_outcome == nullptr) {
+  auto is_satisfied = [this, &execution,
+                       last_order](const CompiledOutcome &compiled) {
+    for (const CompiledRequirement &requirement : compiled.requirements) {
+      const Branch &branch = this->branches[requirement.branch];
+      const BranchRun &branch_run = execution.branches[requirement.branch];
+
+      if (branch_run.outcome == NO_OUTCOME || branch_run.order > last_order) {
+        // States canceled by the join policy do not give an outcome
+        if (this->join_policy != JoinPolicy::ALL_COMPLETED) {
+          return false;
+        }
         throw std::runtime_error("An intermediate outcome for state '" +
-                                 state_name + "' was not received.");
+                                 branch.name + "' was not received.");
+      }
+
+      if (branch_run.outcome != requirement.outcome) {
+        return false;
       }
-      satisfied &=
-          *actual_intermediate_outcome == expected_intermediate_outcome;
     }
-    if (satisfied) {
-      satisfied_outcomes.insert(outcome);
+    return true;
+  };
+
+  const CompiledOutcome *satisfied_outcome = nullptr;
+  std::size_t num_satisfied_outcomes = 0;
+
+  for (const CompiledOutcome &compiled : this->compiled_outcome_map) {
+    if (is_satisfied(compiled)) {
+      satisfied_outcome = &compiled;
+      num_satisfied_outcomes++;
     }
   }
 
   // Handle different numbers of satisfied outcomes
-  if (satisfied_outcomes.size() == 0) {
+  if (num_satisfied_outcomes == 0) {
     return default_outcome;
-  } else if (satisfied_outcomes.size() > 1) {
+  } else if (num_satisfied_outcomes > 1) {
     std::string outcomes_string;
-    for (auto it = satisfied_outcomes.begin(); it != satisfied_outcomes.end();
-         ++it) {
-      outcomes_string += *it;
-
-      // Add a comma if this is not the last element
-      if (std::next(it) != satisfied_outcomes.end()) {
-        outcomes_string += ", ";
+    for (const CompiledOutcome &compiled : this->compiled_outcome_map) {
+      if (is_satisfied(compiled)) {
+        // Add a comma if this is not the first element
+        if (!outcomes_string.empty()) {
+          outcomes_string += ", ";
+        }
+        outcomes_string += compiled.outcome;
       }
     }
     // Due to how std::set works, this should only throw if the outcome strings
@@ -148,14 +329,127 @@ Concurrence::execute(std::shared_ptr<blackboard::Blackboard> blackboard) {
         ") after concurrent state execution (" + this->to_string());
   }
 
-  return *satisfied_outcomes.begin();
+  return satisfied_outcome->outcome;
 }
 
-void Concurrence::cancel_state() {
-  for (const auto &[state_name, state] : states) {
-    state->cancel_state();
+void Concurrence::run_branch(Execution &execution, std::size_t index) {
+  const Branch &branch = this->branches[index];
+  BranchRun &branch_run = execution.branches[index];
+
+  // Skip the state if the result is already fixed. The flag is checked again
+  // after marking the state as running, so the branch that fulfills the join
+  // policy either sees it running or this branch sees the join. A cancel of
+  // the run received before the state starts makes it start canceled.
+  if (!execution.joined.load()) {
+    branch_run.running.store(true);
+
+    if (execution.joined.load()) {
+      branch_run.running.store(false);
+
+    } else {
+      bool reached = false;
+      Outcome outcome;
+
+      try {
+        TraceScope trace(TraceRecorder::CONCURRENCE_EVENT, branch.name);
+        outcome = (*branch.state.get())(branch_run.blackboard, branch_run.run);
+        branch_run.outcome = branch.state->get_outcome_set().index_of(outcome);
+        trace.set_arg("outcome", outcome.c_str());
+      } catch (...) {
+        branch_run.exception = std::current_exception();
+      }
+
+      branch_run.running.store(false);
+      branch_run.order = execution.finished_branches.fetch_add(1);
+
+      if (branch_run.exception) {
+        reached = this->join_policy != JoinPolicy::ALL_COMPLETED;
+      } else {
+        reached = this->is_join_reached(branch_run.order + 1, outcome);
+      }
+
+      // Cancel the states that are still running in this execution
+      if (reached && !execution.joined.exchange(true)) {
+        execution.join_order.store(branch_run.order);
+
+        for (std::size_t i = 0; i < this->branches.size(); ++i) {
+          if (execution.branches[i].running.load()) {
+            this->branches[i].state->cancel_run(execution.branches[i].run);
+          }
+        }
+      }
+    }
+  }
+
+  // The last branch wakes up the thread waiting for the join. The counter is
+  // decremented under the lock, so the execution is not released while this
+  // branch still uses it.
+  {
+    const std::lock_guard<std::mutex> lock(execution.join_mutex);
+    if (execution.running_branches.fetch_sub(1) == 1) {
+      execution.join_cond.notify_all();
+    }
   }
+}
+
+void Concurrence::merge_branches(
+    std::shared_ptr<blackboard::Blackboard> blackboard,
+    const Execution &execution, std::size_t last_order) {
+
+  // Keys to merge from each branch, checked before merging anything
+  std::vector<std::vector<std::string>> branch_keys(this->branches.size());
+  // Branch that changed each key, to detect conflicts
+  std::map<std::string, const Branch *> changed_keys;
+
+  for (std::size_t i = 0; i < this->branches.size(); ++i) {
+    const Branch &branch = this->branches[i];
+
+    if (execution.branches[i].order > last_order) {
+      continue;
+    }
+
+    for (const std::string &key :
+         execution.branches[i].blackboard->get_changes()) {
+      auto [it, inserted] = changed_keys.insert({key, &branch});
+
+      if (!inserted && this->conflict_policy == ConflictPolicy::FAIL) {
+        throw std::runtime_error("Key '" + key +
+                                 "' of the blackboard was changed by the "
+                                 "concurrent states '" +
+                                 it->second->name + "' and '" + branch.name +
+                                 "'");
+      }
+
+      if (inserted || this->conflict_policy == ConflictPolicy::LAST_WINS) {
+        branch_keys[i].push_back(key);
+      }
+    }
+  }
+
+  for (std::size_t i = 0; i < this->branches.size(); ++i) {
+    if (!branch_keys[i].empty()) {
+      blackboard->merge(*execution.branches[i].blackboard, branch_keys[i]);
+    }
+  }
+}
+
+void Concurrence::cancel_state() {
+  // Cancel the run first, so an execution that has not been registered yet
+  // sees it in acquire_execution()
   yasmin::State::cancel_state();
+
+  const StateRun *run = this->get_canceled_run();
+  const std::lock_guard<std::mutex> lock(this->executions_mutex);
+
+  for (const auto &execution : this->executions) {
+    if (run != nullptr && execution->run != run) {
+      continue;
+    }
+
+    for (std::size_t i = 0; i < this->branches.size(); ++i) {
+      this->branches[i].state->cancel_run(execution->branches[i].run);
+    }
+  }
 }
 
 const std::map<std::string, std::shared_ptr<State>> &
@@ -171,6 +465,34 @@ const std::string &Concurrence::get_default_outcome() const {
   return this->default_outcome;
 }
 
+Concurrence::JoinPolicy Concurrence::get_join_policy() const {
+  return this->join_policy;
+}
+
+std::size_t Concurrence::get_quorum() const { return this->quorum; }
+
+const std::string &Concurrence::get_fail_fast_outcome() const {
+  return this->fail_fast_outcome;
+}
+
+Concurrence::ConflictPolicy Concurrence::get_conflict_policy() const {
+  return this->conflict_policy;
+}
+
+bool Concurrence::is_join_reached(std::size_t finished_states,
+                                  const Outcome &outcome) const {
+  switch (this->join_policy) {
+  case JoinPolicy::FIRST_COMPLETED:
+    return true;
+  case JoinPolicy::QUORUM:
+    return finished_states >= this->quorum;
+  case JoinPolicy::FAIL_FAST:
+    return outcome == this->compiled_fail_fast_outcome;
+  default:
+    return false;
+  }
+}
+
 std::set<std::string>
 Concurrence::generate_possible_outcomes(const OutcomeMap &outcome_map,
                                         const std::string &default_outcome) {
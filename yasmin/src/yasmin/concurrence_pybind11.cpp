@@ -34,11 +34,33 @@ PYBIND11_MODULE(concurrence, m) {
              std::shared_ptr<yasmin::Concurrence>>
       concurrence_class(m, "Concurrence");
 
+  // Export JoinPolicy enum inside Concurrence
+  using JoinPolicy = yasmin::Concurrence::JoinPolicy;
+  py::enum_<JoinPolicy>(concurrence_class, "JoinPolicy")
+      .value("ALL_COMPLETED", JoinPolicy::ALL_COMPLETED)
+      .value("FIRST_COMPLETED", JoinPolicy::FIRST_COMPLETED)
+      .value("QUORUM", JoinPolicy::QUORUM)
+      .value("FAIL_FAST", JoinPolicy::FAIL_FAST)
+      .export_values();
+
+  // Export ConflictPolicy enum inside Concurrence
+  using ConflictPolicy = yasmin::Concurrence::ConflictPolicy;
+  py::enum_<ConflictPolicy>(concurrence_class, "ConflictPolicy")
+      .value("SHARED", ConflictPolicy::SHARED)
+      .value("LAST_WINS", ConflictPolicy::LAST_WINS)
+      .value("FIRST_WINS", ConflictPolicy::FIRST_WINS)
+      .value("FAIL", ConflictPolicy::FAIL)
+      .export_values();
+
   concurrence_class
       .def(py::init<std::map<std::string, std::shared_ptr<yasmin::State>>,
-                    std::string, yasmin::Concurrence::OutcomeMap>(),
+                    std::string, yasmin::Concurrence::OutcomeMap,
+                    JoinPolicy, std::size_t, std::string, ConflictPolicy>(),
            py::arg("states"), py::arg("default_outcome"),
            py::arg("outcome_map") = yasmin::Concurrence::OutcomeMap(),
+           py::arg("join_policy") = JoinPolicy::ALL_COMPLETED,
+           py::arg("quorum") = 0, py::arg("fail_fast_outcome") = "",
+           py::arg("conflict_policy") = ConflictPolicy::SHARED,
            py::keep_alive<1, 2>()) // Keep states (arg 2) alive as long as self
                                    // (arg 1) is alive
       .def("get_states", &yasmin::Concurrence::get_states,
@@ -49,6 +71,15 @@ PYBIND11_MODULE(concurrence, m) {
            py::return_value_policy::reference_internal)
       .def("get_default_outcome", &yasmin::Concurrence::get_default_outcome,
            "Get the default outcome for this concurrence state")
+      .def("get_join_policy", &yasmin::Concurrence::get_join_policy,
+           "Get the join policy for this concurrence state")
+      .def("get_quorum", &yasmin::Concurrence::get_quorum,
+           "Get the number of finished states required by QUORUM")
+      .def("get_fail_fast_outcome",
+           &yasmin::Concurrence::get_fail_fast_outcome,
+           "Get the intermediate outcome that finishes FAIL_FAST")
+      .def("get_conflict_policy", &yasmin::Concurrence::get_conflict_policy,
+           "Get the conflict policy for this concurrence state")
       .def("cancel_state", &yasmin::Concurrence::cancel_state,
            "Cancel the current state execution")
       .def("to_string", &yasmin::Concurrence::to_string,
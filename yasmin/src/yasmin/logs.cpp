@@ -13,7 +13,14 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "yasmin/logs.hpp"
 
@@ -26,11 +33,13 @@ void default_log_message(LogLevel level, const char *file, const char *function,
 }
 
 // Initialize the log level to INFO
-LogLevel log_level = INFO;
+std::atomic<LogLevel> log_level{INFO};
 
 LogFunction log_message = default_log_message;
 
-void set_log_level(LogLevel new_log_level) { log_level = new_log_level; }
+void set_log_level(LogLevel new_log_level) {
+  log_level.store(new_log_level, std::memory_order_relaxed);
+}
 
 const char *log_level_to_name(LogLevel log_level) {
   switch (log_level) {
@@ -59,4 +68,375 @@ void set_loggers(LogFunction new_log_message) { log_message = new_log_message; }
 
 void set_default_loggers() { set_loggers(default_log_message); }
 
+void format_message(std::string &message, const char *text, ...) {
+  va_list args;
+  va_start(args, text);
+
+  // Calculate the required buffer size
+  int size = vsnprintf(nullptr, 0, text, args);
+  va_end(args);
+
+  if (size < 0) {
+    message.clear();
+    return;
+  }
+
+  message.resize(size + 1);
+  va_start(args, text);
+  vsnprintf(&message[0], message.size(), text, args);
+  va_end(args);
+
+  message.resize(size);
+}
+
+std::atomic<bool> async_logs_enabled{false};
+
+namespace {
+
+/**
+ * @struct LogRing
+ * @brief Lock-free buffer of records written by one thread and read by the
+ * background thread.
+ */
+struct LogRing {
+  /// The records, whose number is a power of two
+  std::vector<LogRecord> records;
+  /// Mask to wrap the positions of the records
+  std::size_t mask;
+  /// What to do when the buffer is full
+  LogOverflowPolicy overflow_policy;
+  /// Position of the next record to read, written by the background thread
+  alignas(64) std::atomic<std::size_t> head{0};
+  /// Position of the next record to write, written by the logging thread
+  alignas(64) std::atomic<std::size_t> tail{0};
+  /// Number of records dropped since the last report
+  std::atomic<std::uint64_t> dropped{0};
+  /// True when the buffer is no longer read by the background thread or its
+  /// thread finished
+  std::atomic<bool> closed{false};
+
+  explicit LogRing(std::size_t capacity, LogOverflowPolicy overflow_policy)
+      : records(capacity), mask(capacity - 1),
+        overflow_policy(overflow_policy) {}
+};
+
+/**
+ * @struct AsyncLogger
+ * @brief State of the asynchronous logging mode.
+ */
+struct AsyncLogger {
+  /// Mutex to protect the buffers, the thread and the flush tickets
+  std::mutex mutex;
+  /// Condition variable to wake the background thread
+  std::condition_variable wake_cond;
+  /// Condition variable to wait for flushes
+  std::condition_variable flush_cond;
+  /// The buffers of the logging threads
+  std::vector<std::shared_ptr<LogRing>> rings;
+  /// The options of the asynchronous mode
+  AsyncLogOptions options;
+  /// The background thread
+  std::thread thread;
+  /// Flag to stop the background thread
+  bool stop = false;
+  /// Number of flushes requested
+  std::uint64_t flush_requested = 0;
+  /// Number of flushes completed
+  std::uint64_t flush_done = 0;
+
+  ~AsyncLogger() { disable_async_logs(); }
+};
+
+AsyncLogger &get_async_logger() {
+  static AsyncLogger logger;
+  return logger;
+}
+
+/**
+ * @struct ThreadLogRing
+ * @brief Buffer of the current thread, closed when the thread finishes.
+ */
+struct ThreadLogRing {
+  /// The buffer of the thread
+  std::shared_ptr<LogRing> ring;
+  /// Position of the reserved record
+  std::size_t reserved = 0;
+  /// True for the background thread, which never waits for itself
+  bool background = false;
+
+  ~ThreadLogRing() {
+    if (this->ring) {
+      this->ring->closed.store(true, std::memory_order_release);
+    }
+  }
+};
+
+thread_local ThreadLogRing thread_log_ring;
+
+/**
+ * @brief Write the records of a buffer with the logging function.
+ * @param ring The buffer.
+ * @param message The string reused to format the messages.
+ * @return True if any record was written.
+ */
+bool drain_ring(LogRing &ring, std::string &message) {
+  std::size_t head = ring.head.load(std::memory_order_relaxed);
+  std::size_t tail = ring.tail.load(std::memory_order_acquire);
+
+  for (std::size_t i = head; i != tail; ++i) {
+    const LogRecord &record = ring.records[i & ring.mask];
+
+    if (record.site == nullptr) {
+      // Messages logged with log_text() carry their place
+      std::size_t offset = 0;
+      int line = LogArg<int>::decode(record.data, offset);
+      const char *file = LogArg<const char *>::decode(record.data, offset);
+      const char *function =
+          LogArg<const char *>::decode(record.data, offset);
+      const char *text = LogArg<const char *>::decode(record.data, offset);
+      log_message(record.level, file, function, line, text);
+
+    } else {
+      const char *text = record.text != nullptr
+                             ? record.text
+                             : reinterpret_cast<const char *>(record.data);
+
+      record.formatter(text, record.data, message);
+      log_message(record.level, record.site->file, record.site->function,
+                  record.site->line, message.c_str());
+    }
+
+    ring.head.store(i + 1, std::memory_order_release);
+  }
+
+  std::uint64_t dropped = ring.dropped.exchange(0, std::memory_order_relaxed);
+  if (dropped > 0) {
+    format_message(message, "Dropped %llu log messages",
+                   static_cast<unsigned long long>(dropped));
+    log_message(WARN, extract_filename(__FILE__), __FUNCTION__, __LINE__,
+                message.c_str());
+  }
+
+  return head != tail || dropped > 0;
+}
+
+/**
+ * @brief Loop of the background thread, which writes the records of all
+ * buffers.
+ */
+void run_async_logger() {
+  AsyncLogger &logger = get_async_logger();
+  thread_log_ring.background = true;
+  std::string message;
+
+  while (true) {
+    std::vector<std::shared_ptr<LogRing>> rings;
+    std::uint64_t flush_requested;
+    bool stop;
+
+    {
+      std::lock_guard<std::mutex> lock(logger.mutex);
+      rings = logger.rings;
+      flush_requested = logger.flush_requested;
+      stop = logger.stop;
+    }
+
+    bool written = false;
+    for (const auto &ring : rings) {
+      written |= drain_ring(*ring, message);
+    }
+
+    std::unique_lock<std::mutex> lock(logger.mutex);
+
+    // Remove the buffers of the finished threads once they are empty
+    logger.rings.erase(
+        std::remove_if(logger.rings.begin(), logger.rings.end(),
+                       [](const std::shared_ptr<LogRing> &ring) {
+                         return ring->closed.load(std::memory_order_acquire) &&
+                                ring->head.load(std::memory_order_relaxed) ==
+                                    ring->tail.load(std::memory_order_acquire);
+                       }),
+        logger.rings.end());
+
+    if (logger.flush_done < flush_requested) {
+      logger.flush_done = flush_requested;
+      logger.flush_cond.notify_all();
+    }
+
+    if (stop) {
+      break;
+    }
+
+    if (!written && logger.flush_requested == flush_requested &&
+        !logger.stop) {
+      logger.wake_cond.wait_for(lock, logger.options.flush_interval);
+    }
+  }
+}
+
+} // namespace
+
+LogRecord *reserve_log_record() {
+  ThreadLogRing &thread_ring = thread_log_ring;
+
+  if (!thread_ring.ring ||
+      thread_ring.ring->closed.load(std::memory_order_relaxed)) {
+    AsyncLogger &logger = get_async_logger();
+    std::lock_guard<std::mutex> lock(logger.mutex);
+
+    if (!async_logs_enabled.load(std::memory_order_relaxed)) {
+      return nullptr;
+    }
+
+    thread_ring.ring = std::make_shared<LogRing>(
+        logger.options.capacity, logger.options.overflow_policy);
+    logger.rings.push_back(thread_ring.ring);
+  }
+
+  LogRing &ring = *thread_ring.ring;
+  std::size_t tail = ring.tail.load(std::memory_order_relaxed);
+
+  while (tail - ring.head.load(std::memory_order_acquire) > ring.mask) {
+    if (ring.overflow_policy == LogOverflowPolicy::DROP ||
+        thread_ring.background) {
+      ring.dropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    get_async_logger().wake_cond.notify_one();
+    std::this_thread::yield();
+
+    // The message is written synchronously if the asynchronous mode is
+    // disabled while waiting
+    if (!async_logs_enabled.load(std::memory_order_relaxed)) {
+      return nullptr;
+    }
+  }
+
+  thread_ring.reserved = tail;
+  return &ring.records[tail & ring.mask];
+}
+
+void commit_log_record() {
+  LogRing &ring = *thread_log_ring.ring;
+  std::size_t tail = thread_log_ring.reserved + 1;
+
+  // Sequentially consistent with the closing of the buffer, so either
+  // disable_async_logs() sees the record or this thread sees the buffer
+  // closed and writes the record itself
+  ring.tail.store(tail, std::memory_order_seq_cst);
+
+  if (ring.closed.load(std::memory_order_seq_cst)) {
+    AsyncLogger &logger = get_async_logger();
+    std::lock_guard<std::mutex> lock(logger.mutex);
+    std::string message;
+    drain_ring(ring, message);
+    return;
+  }
+
+  // Wake the background thread before the buffer fills up
+  if (tail - ring.head.load(std::memory_order_relaxed) == ring.mask / 2 + 1) {
+    get_async_logger().wake_cond.notify_one();
+  }
+}
+
+void log_text(LogLevel level, const char *file, const char *function,
+              int line, const char *text) {
+
+  if (async_logs_enabled.load(std::memory_order_relaxed)) {
+    LogRecord *record = reserve_log_record();
+
+    // The message was dropped, unless the asynchronous mode was disabled
+    if (record == nullptr &&
+        async_logs_enabled.load(std::memory_order_relaxed)) {
+      return;
+    }
+
+    if (record != nullptr) {
+      record->level = level;
+      record->site = nullptr;
+      record->text = nullptr;
+      record->formatter = nullptr;
+      std::size_t offset = 0;
+
+      if (LogArg<int>::encode(record->data, offset, line) &&
+          LogArg<const char *>::encode(record->data, offset, file) &&
+          LogArg<const char *>::encode(record->data, offset, function) &&
+          LogArg<const char *>::encode(record->data, offset, text)) {
+        commit_log_record();
+        return;
+      }
+    }
+  }
+
+  log_message(level, file, function, line, text);
+}
+
+void enable_async_logs(const AsyncLogOptions &options) {
+  disable_async_logs();
+
+  AsyncLogger &logger = get_async_logger();
+  std::lock_guard<std::mutex> lock(logger.mutex);
+
+  std::size_t capacity = 1;
+  while (capacity < options.capacity) {
+    capacity <<= 1;
+  }
+
+  logger.options = options;
+  logger.options.capacity = capacity;
+  logger.stop = false;
+  logger.thread = std::thread(run_async_logger);
+  async_logs_enabled.store(true, std::memory_order_release);
+}
+
+void disable_async_logs() {
+  AsyncLogger &logger = get_async_logger();
+  std::thread thread;
+
+  {
+    std::lock_guard<std::mutex> lock(logger.mutex);
+
+    if (!logger.thread.joinable()) {
+      return;
+    }
+
+    async_logs_enabled.store(false, std::memory_order_release);
+    logger.stop = true;
+    thread = std::move(logger.thread);
+  }
+
+  logger.wake_cond.notify_one();
+  thread.join();
+  logger.flush_cond.notify_all();
+
+  // The buffers are not read anymore, so threads create new ones when the
+  // asynchronous mode is enabled again. The records committed after the
+  // last read are written here, and the ones committed after the buffer is
+  // closed are written by their thread.
+  std::lock_guard<std::mutex> lock(logger.mutex);
+  std::string message;
+  for (const auto &ring : logger.rings) {
+    ring->closed.store(true, std::memory_order_seq_cst);
+    drain_ring(*ring, message);
+  }
+  logger.rings.clear();
+}
+
+void flush_logs() {
+  AsyncLogger &logger = get_async_logger();
+  std::unique_lock<std::mutex> lock(logger.mutex);
+
+  if (!logger.thread.joinable() ||
+      logger.thread.get_id() == std::this_thread::get_id()) {
+    return;
+  }
+
+  std::uint64_t ticket = ++logger.flush_requested;
+  logger.wake_cond.notify_one();
+  logger.flush_cond.wait(lock, [&logger, ticket]() {
+    return logger.flush_done >= ticket || !logger.thread.joinable();
+  });
+}
+
 } // namespace yasmin
@@ -41,7 +41,7 @@ PYBIND11_MODULE(logs, m) {
 
   // Export log_level as a module attribute (read/write)
   m.def(
-      "get_log_level", []() { return yasmin::log_level; },
+      "get_log_level", []() { return yasmin::get_log_level(); },
       "Get the current log level");
 
   m.def(
@@ -55,54 +55,56 @@ PYBIND11_MODULE(logs, m) {
       [](yasmin::LogLevel level) { return yasmin::log_level_to_name(level); },
       py::arg("level"), "Convert a log level to its string name");
 
-  // Export log helper functions that can be called from Python
+  // Export log helper functions that can be called from Python. They use
+  // the asynchronous mode too, so the GIL is released in case they wait for
+  // the background thread, which may call a Python logger.
   m.def(
       "log_error",
       [](const std::string &file, const std::string &function, int line,
          const std::string &text) {
-        if (yasmin::log_level >= yasmin::ERROR) {
-          yasmin::log_message(yasmin::ERROR, file.c_str(), function.c_str(),
-                              line, text.c_str());
+        if (yasmin::get_log_level() >= yasmin::ERROR) {
+          yasmin::log_text(yasmin::ERROR, file.c_str(), function.c_str(),
+                           line, text.c_str());
         }
       },
       py::arg("file"), py::arg("function"), py::arg("line"), py::arg("text"),
-      "Log an error message");
+      py::call_guard<py::gil_scoped_release>(), "Log an error message");
 
   m.def(
       "log_warn",
       [](const std::string &file, const std::string &function, int line,
          const std::string &text) {
-        if (yasmin::log_level >= yasmin::WARN) {
-          yasmin::log_message(yasmin::WARN, file.c_str(), function.c_str(),
-                              line, text.c_str());
+        if (yasmin::get_log_level() >= yasmin::WARN) {
+          yasmin::log_text(yasmin::WARN, file.c_str(), function.c_str(),
+                           line, text.c_str());
         }
       },
       py::arg("file"), py::arg("function"), py::arg("line"), py::arg("text"),
-      "Log a warning message");
+      py::call_guard<py::gil_scoped_release>(), "Log a warning message");
 
   m.def(
       "log_info",
       [](const std::string &file, const std::string &function, int line,
          const std::string &text) {
-        if (yasmin::log_level >= yasmin::INFO) {
-          yasmin::log_message(yasmin::INFO, file.c_str(), function.c_str(),
-                              line, text.c_str());
+        if (yasmin::get_log_level() >= yasmin::INFO) {
+          yasmin::log_text(yasmin::INFO, file.c_str(), function.c_str(),
+                           line, text.c_str());
         }
       },
       py::arg("file"), py::arg("function"), py::arg("line"), py::arg("text"),
-      "Log an info message");
+      py::call_guard<py::gil_scoped_release>(), "Log an info message");
 
   m.def(
       "log_debug",
       [](const std::string &file, const std::string &function, int line,
          const std::string &text) {
-        if (yasmin::log_level >= yasmin::DEBUG) {
-          yasmin::log_message(yasmin::DEBUG, file.c_str(), function.c_str(),
-                              line, text.c_str());
+        if (yasmin::get_log_level() >= yasmin::DEBUG) {
+          yasmin::log_text(yasmin::DEBUG, file.c_str(), function.c_str(),
+                           line, text.c_str());
         }
       },
       py::arg("file"), py::arg("function"), py::arg("line"), py::arg("text"),
-      "Log a debug message");
+      py::call_guard<py::gil_scoped_release>(), "Log a debug message");
 
   // Export set_loggers with Python callback support
   m.def(
@@ -151,4 +153,43 @@ PYBIND11_MODULE(logs, m) {
   // Export set_default_loggers
   m.def("set_default_loggers", &yasmin::set_default_loggers,
         "Reset to the default logging function");
+
+  // Export the asynchronous logging mode
+  py::enum_<yasmin::LogOverflowPolicy>(m, "LogOverflowPolicy")
+      .value("DROP", yasmin::LogOverflowPolicy::DROP,
+             "Drop messages when the buffer of a thread is full.")
+      .value("BLOCK", yasmin::LogOverflowPolicy::BLOCK,
+             "Wait for free space when the buffer of a thread is full.");
+
+  // The GIL is released since the background thread may call a Python logger
+  m.def(
+      "enable_async_logs",
+      [](std::size_t capacity, yasmin::LogOverflowPolicy overflow_policy,
+         double flush_interval) {
+        yasmin::AsyncLogOptions options;
+        options.capacity = capacity;
+        options.overflow_policy = overflow_policy;
+        options.flush_interval = std::chrono::milliseconds(
+            static_cast<long long>(flush_interval * 1000.0));
+        yasmin::enable_async_logs(options);
+      },
+      py::arg("capacity") = 1024,
+      py::arg("overflow_policy") = yasmin::LogOverflowPolicy::DROP,
+      py::arg("flush_interval") = 0.01,
+      py::call_guard<py::gil_scoped_release>(),
+      "Log the messages of the C++ code from a background thread. The flush "
+      "interval is in seconds");
+
+  m.def("disable_async_logs", &yasmin::disable_async_logs,
+        py::call_guard<py::gil_scoped_release>(),
+        "Write the pending messages and log synchronously again");
+
+  m.def("flush_logs", &yasmin::flush_logs,
+        py::call_guard<py::gil_scoped_release>(),
+        "Wait until the messages logged so far are written");
+
+  m.def(
+      "is_async_logs_enabled",
+      []() { return yasmin::async_logs_enabled.load(); },
+      "Check if messages are logged asynchronously");
 }
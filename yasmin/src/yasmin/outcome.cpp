@@ -0,0 +1,113 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_set>
+
+#include "yasmin/outcome.hpp"
+
+using namespace yasmin;
+
+namespace {
+
+/// Mutex for the outcome symbol table
+std::shared_mutex &symbol_table_mutex() {
+  static std::shared_mutex mutex;
+  return mutex;
+}
+
+/// Outcome symbol table, elements are never removed so pointers stay valid
+std::unordered_set<std::string> &symbol_table() {
+  static std::unordered_set<std::string> table;
+  return table;
+}
+
+} // namespace
+
+const std::string *Outcome::intern(const std::string &name) {
+  {
+    std::shared_lock<std::shared_mutex> lk(symbol_table_mutex());
+    auto it = symbol_table().find(name);
+    if (it != symbol_table().end()) {
+      return &*it;
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> lk(symbol_table_mutex());
+  return &*symbol_table().insert(name).first;
+}
+
+const std::string *Outcome::empty_name() {
+  static const std::string *name = intern(std::string());
+  return name;
+}
+
+Outcome::Outcome() : name(empty_name()) {}
+
+Outcome::Outcome(const char *name) : Outcome(std::string(name)) {}
+
+Outcome::Outcome(const std::string &name) : name(intern(name)) {}
+
+std::optional<Outcome> Outcome::find(const std::string &name) {
+  std::shared_lock<std::shared_mutex> lk(symbol_table_mutex());
+  auto it = symbol_table().find(name);
+
+  if (it == symbol_table().end()) {
+    return std::nullopt;
+  }
+
+  return Outcome(&*it);
+}
+
+OutcomeSet::OutcomeSet(const std::set<std::string> &names) : names(names) {
+  this->outcomes.reserve(names.size());
+  for (const std::string &name : names) {
+    this->outcomes.push_back(Outcome(name));
+  }
+}
+
+std::shared_ptr<const OutcomeSet>
+OutcomeSet::intern(const std::set<std::string> &names) {
+  static std::mutex mutex;
+  static std::map<std::set<std::string>, std::weak_ptr<const OutcomeSet>>
+      table;
+
+  std::lock_guard<std::mutex> lk(mutex);
+
+  auto it = table.find(names);
+  if (it != table.end()) {
+    if (auto outcome_set = it->second.lock()) {
+      return outcome_set;
+    }
+  }
+
+  // Drop the sets that are no longer used by any state
+  for (auto entry = table.begin(); entry != table.end();) {
+    if (entry->second.expired()) {
+      entry = table.erase(entry);
+    } else {
+      ++entry;
+    }
+  }
+
+  auto outcome_set = std::make_shared<const OutcomeSet>(names);
+  table[names] = outcome_set;
+  return outcome_set;
+}
@@ -15,6 +15,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -24,44 +25,124 @@
 
 using namespace yasmin;
 
-State::State(const std::set<std::string> &outcomes) : outcomes(outcomes) {
+namespace {
+
+/// Innermost run executed by this thread, linked to the enclosing runs
+thread_local StateRun *current_run = nullptr;
+
+/// State and run being canceled by cancel_run() in this thread
+thread_local const State *canceled_state = nullptr;
+thread_local StateRun *canceled_run = nullptr;
+
+/// Links a run to the runs of this thread while the state executes
+class CurrentRunGuard {
+public:
+  explicit CurrentRunGuard(StateRun &run) : run(run) {
+    this->run.previous = current_run;
+    current_run = &this->run;
+  }
+
+  ~CurrentRunGuard() { current_run = this->run.previous; }
+
+private:
+  StateRun &run;
+};
+
+} // namespace
+
+State::State(const std::set<std::string> &outcomes)
+    : outcomes(OutcomeSet::intern(outcomes)) {
   if (outcomes.empty()) {
     throw std::logic_error("A state must have at least one possible outcome.");
   }
 }
 
-StateStatus State::get_status() const { return this->status.load(); }
+void State::add_outcomes(const std::set<std::string> &outcomes) {
+  std::set<std::string> names = this->outcomes->get_names();
+  names.insert(outcomes.begin(), outcomes.end());
+  this->outcomes = OutcomeSet::intern(names);
+}
+
+StateRun *State::get_current_run() const {
+  for (StateRun *run = current_run; run != nullptr; run = run->previous) {
+    if (run->state == this) {
+      return run;
+    }
+  }
+  return nullptr;
+}
+
+StateRun *State::get_canceled_run() const {
+  return canceled_state == this ? canceled_run : nullptr;
+}
+
+StateStatus State::get_status() const {
+  const StateRun *run = this->get_current_run();
 
-bool State::is_idle() const { return this->status.load() == StateStatus::IDLE; }
+  if (run == nullptr) {
+    return this->status.load();
+  }
+
+  // Cancels that target every execution also cancel this one
+  if (run->cancel_epoch != this->cancel_epoch.load()) {
+    return StateStatus::CANCELED;
+  }
+
+  return run->status.load();
+}
+
+bool State::is_idle() const { return this->get_status() == StateStatus::IDLE; }
 
 bool State::is_running() const {
-  return this->status.load() == StateStatus::RUNNING;
+  return this->get_status() == StateStatus::RUNNING;
 }
 
 bool State::is_canceled() const {
-  return this->status.load() == StateStatus::CANCELED;
+  return this->get_status() == StateStatus::CANCELED;
 }
 
 bool State::is_completed() const {
-  return this->status.load() == StateStatus::COMPLETED;
+  return this->get_status() == StateStatus::COMPLETED;
 }
 
-std::string
-State::operator()(std::shared_ptr<blackboard::Blackboard> blackboard) {
+Outcome State::operator()(std::shared_ptr<blackboard::Blackboard> blackboard) {
+  StateRun run;
+  return (*this)(blackboard, run);
+}
+
+Outcome State::operator()(std::shared_ptr<blackboard::Blackboard> blackboard,
+                          StateRun &run) {
   YASMIN_LOG_DEBUG("Executing state '%s'", this->to_string().c_str());
 
-  this->status.store(StateStatus::RUNNING);
+  run.state = this;
+  run.cancel_epoch = this->cancel_epoch.load();
+
+  // Start the run, unless it was canceled before starting. A cancel that
+  // arrives between the dispatch and this point must not be overwritten.
+  StateStatus start_status = run.status.load();
+  while (start_status != StateStatus::CANCELED &&
+         !run.status.compare_exchange_weak(start_status,
+                                           StateStatus::RUNNING)) {
+  }
+
+  this->status.store(start_status == StateStatus::CANCELED
+                         ? StateStatus::CANCELED
+                         : StateStatus::RUNNING);
+
+  CurrentRunGuard guard(run);
 
   // Execute the specific logic of the state
-  std::string outcome = this->execute(blackboard);
+  std::string outcome_name = this->execute(blackboard);
 
-  // Check if the outcome is valid
-  if (std::find(this->outcomes.begin(), this->outcomes.end(), outcome) ==
-      this->outcomes.end()) {
+  // Check if the outcome is valid against the outcomes of the state, so the
+  // global symbol table is not locked
+  std::optional<Outcome> outcome = this->outcomes->find(outcome_name);
+
+  if (!outcome) {
 
     // Construct a string representation of the possible outcomes
     std::string outcomes_string = "[";
-    auto outcomes = this->get_outcomes();
+    const auto &outcomes = this->get_outcomes();
 
     for (auto it = outcomes.begin(); it != outcomes.end(); ++it) {
       const auto &s = *it;
@@ -76,10 +157,11 @@ State::operator()(std::shared_ptr<blackboard::Blackboard> blackboard) {
     outcomes_string += "]";
 
     // Mark as idle before throwing exception
+    run.status.store(StateStatus::IDLE);
     this->status.store(StateStatus::IDLE);
 
     // Throw an exception if the outcome is not valid
-    throw std::logic_error("Outcome '" + outcome +
+    throw std::logic_error("Outcome '" + outcome_name +
                            "' does not belong to the outcomes of "
                            "the state '" +
                            this->to_string() +
@@ -87,11 +169,49 @@ State::operator()(std::shared_ptr<blackboard::Blackboard> blackboard) {
   }
 
   // Mark as completed if not canceled
-  if (this->status.load() != StateStatus::CANCELED) {
+  StateStatus running = StateStatus::RUNNING;
+  if (!this->is_canceled() &&
+      run.status.compare_exchange_strong(running, StateStatus::COMPLETED)) {
     this->status.store(StateStatus::COMPLETED);
+  } else {
+    run.status.store(StateStatus::CANCELED);
+    this->status.store(StateStatus::CANCELED);
   }
 
-  return outcome; // Return the valid outcome
+  return *outcome; // Return the valid outcome
 }
 
-std::set<std::string> const &State::get_outcomes() { return this->outcomes; }
+void State::cancel_state() {
+  YASMIN_LOG_INFO("Canceling state '%s'", this->to_string().c_str());
+
+  StateRun *run = this->get_canceled_run();
+  if (run != nullptr) {
+    run->status.store(StateStatus::CANCELED);
+  } else {
+    this->cancel_epoch.fetch_add(1);
+  }
+
+  this->status.store(StateStatus::CANCELED);
+}
+
+void State::cancel_run(StateRun &run) {
+  const State *previous_state = canceled_state;
+  StateRun *previous_run = canceled_run;
+  canceled_state = this;
+  canceled_run = &run;
+
+  try {
+    this->cancel_state();
+  } catch (...) {
+    canceled_state = previous_state;
+    canceled_run = previous_run;
+    throw;
+  }
+
+  canceled_state = previous_state;
+  canceled_run = previous_run;
+}
+
+std::set<std::string> const &State::get_outcomes() {
+  return this->outcomes->get_names();
+}
@@ -14,6 +14,7 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <algorithm>
+#include <chrono>
 #include <exception>
 #include <map>
 #include <memory>
@@ -28,16 +29,45 @@
 #include "yasmin/logs.hpp"
 #include "yasmin/state.hpp"
 #include "yasmin/state_machine.hpp"
+#include "yasmin/state_metrics.hpp"
+#include "yasmin/trace_recorder.hpp"
 
 using namespace yasmin;
 
+namespace {
+
+/// Path of the state being run by a parent state machine in this thread, so
+/// nested state machines run through their operator() know they are nested
+/// and key their metrics
+thread_local const std::string *parent_state_path = nullptr;
+
+/**
+ * @struct ParentStatePathGuard
+ * @brief Sets the path of the state run by a parent state machine during a
+ * scope.
+ */
+struct ParentStatePathGuard {
+  /// Path of the enclosing scope
+  const std::string *previous;
+
+  explicit ParentStatePathGuard(const std::string *path)
+      : previous(parent_state_path) {
+    parent_state_path = path;
+  }
+
+  ~ParentStatePathGuard() { parent_state_path = this->previous; }
+};
+
+} // namespace
+
 StateMachine::StateMachine(const std::set<std::string> &outcomes)
     : StateMachine("", outcomes) {}
 
 StateMachine::StateMachine(const std::string &name,
                            const std::set<std::string> &outcomes)
-    : State(outcomes), current_state_mutex(std::make_unique<std::mutex>()),
-      name(name) {}
+    : State(outcomes), name(name),
+      active_instance_mutex(std::make_unique<std::mutex>()),
+      validate_mutex(std::make_unique<std::mutex>()) {}
 
 StateMachine::~StateMachine() {
   this->states.clear();
@@ -55,8 +85,7 @@ void StateMachine::add_state(
                            "' already registered in the state machine");
   }
 
-  if (std::find(this->outcomes.begin(), this->outcomes.end(), name) !=
-      this->outcomes.end()) {
+  if (this->get_outcomes().find(name) != this->get_outcomes().end()) {
     throw std::logic_error("State name '" + name +
                            "' is already registered as an outcome");
   }
@@ -144,14 +173,35 @@ StateMachine::get_transitions() {
 }
 
 std::string StateMachine::get_current_state() {
-  const std::lock_guard<std::mutex> lock(*this->current_state_mutex.get());
-  return this->current_state;
+  const std::lock_guard<std::mutex> lock(*this->active_instance_mutex.get());
+
+  if (this->active_instances.empty()) {
+    return "";
+  }
+
+  return this->active_instances.back().second->get_current_state();
+}
+
+void StateMachine::add_active_instance(StateMachineInstance *instance) {
+  const std::lock_guard<std::mutex> lock(*this->active_instance_mutex.get());
+  this->active_instances.push_back({this->get_current_run(), instance});
+  this->active_instance_cond.notify_all();
+
+  // The run may have been canceled before the instance was registered
+  if (this->is_canceled()) {
+    instance->status.store(StateStatus::CANCELED);
+  }
 }
 
-void StateMachine::set_current_state(const std::string &state_name) {
-  const std::lock_guard<std::mutex> lock(*this->current_state_mutex.get());
-  this->current_state = state_name;
-  this->current_state_cond.notify_all();
+void StateMachine::remove_active_instance(StateMachineInstance *instance) {
+  const std::lock_guard<std::mutex> lock(*this->active_instance_mutex.get());
+  this->active_instances.erase(
+      std::find_if(this->active_instances.begin(),
+                   this->active_instances.end(),
+                   [instance](const auto &active_instance) {
+                     return active_instance.second == instance;
+                   }));
+  this->active_instance_cond.notify_all();
 }
 
 void StateMachine::add_start_cb(StartCallbackType cb,
@@ -175,6 +225,7 @@ void StateMachine::call_start_cbs(
 
   try {
     for (const auto &callback_pair : this->start_cbs) {
+      TraceScope trace(TraceRecorder::CALLBACK_EVENT, "start callback");
       const auto &cb = callback_pair.first;
       const auto &args = callback_pair.second;
       cb(blackboard, start_state, args);
@@ -193,6 +244,7 @@ void StateMachine::call_transition_cbs(
 
   try {
     for (const auto &callback_pair : this->transition_cbs) {
+      TraceScope trace(TraceRecorder::CALLBACK_EVENT, "transition callback");
       const auto &cb = callback_pair.first;
       const auto &args = callback_pair.second;
       cb(blackboard, from_state, to_state, outcome, args);
@@ -210,6 +262,7 @@ void StateMachine::call_end_cbs(
 
   try {
     for (const auto &callback_pair : this->end_cbs) {
+      TraceScope trace(TraceRecorder::CALLBACK_EVENT, "end callback");
       const auto &cb = callback_pair.first;
       const auto &args = callback_pair.second;
       cb(blackboard, outcome, args);
@@ -228,6 +281,14 @@ void StateMachine::validate(bool strict_mode) {
   if (this->validated.load() && !strict_mode) {
     YASMIN_LOG_DEBUG("State machine '%s' has already been validated",
                      this->to_string().c_str());
+    return;
+  }
+
+  const std::lock_guard<std::mutex> lock(*this->validate_mutex.get());
+
+  // Another instance may have validated it while waiting
+  if (this->validated.load() && !strict_mode) {
+    return;
   }
 
   // Check initial state
@@ -243,10 +304,10 @@ void StateMachine::validate(bool strict_mode) {
 
     const std::string &state_name = it->first;
     const std::shared_ptr<State> &state = it->second;
-    std::map<std::string, std::string> transitions =
+    const std::map<std::string, std::string> &transitions =
         this->transitions.at(state_name);
 
-    std::set<std::string> outcomes = state->get_outcomes();
+    const std::set<std::string> &outcomes = state->get_outcomes();
 
     if (strict_mode) {
       // Check if all outcomes of the state are in transitions
@@ -304,74 +365,273 @@ void StateMachine::validate(bool strict_mode) {
     }
   }
 
+  // Build the transition table used by execute
+  this->compile();
+
   // State machine has been validated
   this->validated.store(true);
 }
 
+int StateMachine::get_state_id(const std::string &state_name) const {
+
+  std::shared_ptr<const CompiledStateMachine> compiled = this->get_compiled();
+
+  for (std::size_t i = 0; compiled && i < compiled->states.size(); ++i) {
+    if (compiled->states[i].name == state_name) {
+      return i;
+    }
+  }
+
+  throw std::invalid_argument("State '" + state_name +
+                              "' is not in the state machine");
+}
+
+std::shared_ptr<const CompiledStateMachine>
+StateMachine::get_compiled() const {
+  const std::lock_guard<std::mutex> lock(*this->validate_mutex.get());
+  return this->compiled;
+}
+
+void StateMachine::compile() {
+
+  std::map<std::string, int> state_ids;
+
+  // The running instances keep the previous table
+  auto compiled = std::make_shared<CompiledStateMachine>();
+  compiled->states.reserve(this->states.size());
+
+  for (const auto &[state_name, state] : this->states) {
+    state_ids.insert({state_name, (int)compiled->states.size()});
+    compiled->states.push_back(
+        {state_name, state, dynamic_cast<StateMachine *>(state.get()),
+         this->remappings.at(state_name), {}});
+  }
+
+  for (CompiledState &compiled_state : compiled->states) {
+    const std::map<std::string, std::string> &transitions =
+        this->transitions.at(compiled_state.name);
+
+    for (const Outcome &outcome :
+         compiled_state.state->get_outcome_set().get_outcomes()) {
+
+      // Translate outcome using transitions
+      std::string target = outcome;
+      auto transition_it = transitions.find(outcome.str());
+      if (transition_it != transitions.end()) {
+        target = transition_it->second;
+      }
+
+      int next_state = INVALID_TARGET;
+      if (this->get_outcomes().find(target) != this->get_outcomes().end()) {
+        next_state = END_OF_MACHINE;
+      } else if (state_ids.find(target) != state_ids.end()) {
+        next_state = state_ids.at(target);
+      }
+
+      compiled_state.transitions.push_back(
+          {outcome, Outcome(target), next_state});
+    }
+  }
+
+  compiled->start_state = state_ids.at(this->start_state);
+  this->compiled = std::move(compiled);
+}
+
 std::string
 StateMachine::execute(std::shared_ptr<blackboard::Blackboard> blackboard) {
 
   this->validate();
 
+  StateMachineInstance instance(this, blackboard, false);
+  instance.set_status(StateStatus::RUNNING);
+  this->add_active_instance(&instance);
+
+  try {
+    Outcome outcome = instance.run();
+    this->remove_active_instance(&instance);
+    return outcome;
+
+  } catch (...) {
+    this->remove_active_instance(&instance);
+    throw;
+  }
+}
+
+std::string
+StateMachine::resume(std::shared_ptr<blackboard::Blackboard> blackboard,
+                     const std::string &state_name) {
+
+  this->validate();
+
+  StateMachineInstance instance(this, blackboard, false);
+  instance.resume_state = this->get_state_id(state_name);
+  instance.set_status(StateStatus::RUNNING);
+  this->add_active_instance(&instance);
+
+  try {
+    Outcome outcome = instance.run();
+    this->remove_active_instance(&instance);
+    return outcome;
+
+  } catch (...) {
+    this->remove_active_instance(&instance);
+    throw;
+  }
+}
+
+Outcome StateMachine::run(StateMachineInstance &instance) {
+
+  std::shared_ptr<blackboard::Blackboard> blackboard = instance.blackboard;
+
+  // Keep the compiled table for the whole run, even if the state machine is
+  // validated again meanwhile
+  std::shared_ptr<const CompiledStateMachine> graph = this->get_compiled();
+  {
+    const std::lock_guard<std::mutex> lock(instance.mutex);
+
+    // The views of the states are kept across runs of the instance until
+    // the remappings change with a new compiled table
+    if (instance.graph != graph) {
+      instance.state_blackboards.clear();
+    }
+
+    instance.graph = graph;
+  }
+
+  // Start from the state to resume, if any
+  int state_id = graph->start_state;
+  if (instance.resume_state >= 0) {
+    state_id = instance.resume_state;
+    instance.resume_state = -1;
+  }
+
+  // Key the metrics under the state of the parent state machine, if any
+  std::chrono::steady_clock::time_point start_time;
+  if (parent_state_path != nullptr) {
+    instance.path = *parent_state_path;
+    instance.nested = true;
+    parent_state_path = nullptr;
+  }
+
+  if (StateMetricsRegistry::is_enabled()) {
+    start_time = std::chrono::steady_clock::now();
+  }
+
+  TraceScope machine_trace(TraceRecorder::STATE_MACHINE_EVENT,
+                           this->name.empty() ? "StateMachine" : this->name);
+
+  const std::string &initial_state = graph->states[state_id].name;
   YASMIN_LOG_INFO("Executing state machine with initial state '%s'",
-                  this->start_state.c_str());
-  this->call_start_cbs(blackboard, this->start_state);
+                  initial_state.c_str());
+  this->call_start_cbs(blackboard, initial_state);
+
+  // The path may have changed since the previous execution
+  instance.state_metrics.clear();
+
+  instance.set_current_state(state_id);
+
+  while (!instance.is_canceled()) {
+
+    const CompiledState &current_state = graph->states[state_id];
+    std::shared_ptr<blackboard::Blackboard> state_blackboard =
+        instance.get_state_blackboard(state_id);
+
+    // Time the state only when metrics are enabled
+    StateMetrics *metrics = nullptr;
+    std::chrono::steady_clock::time_point state_start_time;
+    if (StateMetricsRegistry::is_enabled()) {
+      metrics = &instance.get_state_metrics(state_id);
+      state_start_time = std::chrono::steady_clock::now();
+    }
+
+    Outcome outcome;
+    {
+      TraceScope state_trace(TraceRecorder::STATE_EVENT, current_state.name);
 
-  this->set_current_state(this->start_state);
+      if (current_state.state_machine) {
+        ParentStatePathGuard guard(metrics ? &metrics->get_path()
+                                           : &current_state.name);
 
-  std::map<std::string, std::string> transitions;
-  std::map<std::string, std::string> remappings;
-  std::string outcome;
-  std::string old_outcome;
+        if (instance.nested_instances) {
+          outcome = instance.execute_child(current_state.state_machine,
+                                           state_blackboard);
+        } else {
+          outcome = (*current_state.state.get())(state_blackboard,
+                                                 instance.state_run);
+        }
 
-  while (!this->is_canceled()) {
+      } else {
+        outcome = (*current_state.state.get())(state_blackboard,
+                                               instance.state_run);
+      }
 
-    std::string current_state = this->get_current_state();
-    auto state = this->states.at(current_state);
-    transitions = this->transitions.at(current_state);
-    remappings = this->remappings.at(current_state);
-    blackboard->set_remappings(remappings);
+      // Outcomes are interned, so they outlive the scope
+      state_trace.set_arg("outcome", outcome.c_str());
+    }
 
-    outcome = (*state.get())(blackboard);
-    old_outcome = std::string(outcome);
+    if (metrics) {
+      metrics->record(std::chrono::steady_clock::now() - state_start_time,
+                      outcome);
+    }
 
     // Check outcome belongs to state
-    if (std::find(state->get_outcomes().begin(), state->get_outcomes().end(),
-                  outcome) == state->get_outcomes().end()) {
-      throw std::logic_error("Outcome '" + outcome +
+    auto transition_it =
+        std::find_if(current_state.transitions.begin(),
+                     current_state.transitions.end(),
+                     [&outcome](const CompiledTransition &t) {
+                       return t.outcome == outcome;
+                     });
+
+    if (transition_it == current_state.transitions.end()) {
+      throw std::logic_error("Outcome '" + outcome.str() +
                              "' is not registered in state " +
-                             this->current_state);
+                             current_state.name);
     }
 
-    // Translate outcome using transitions
-    if (transitions.find(outcome) != transitions.end()) {
-      outcome = transitions.at(outcome);
-    }
+    const CompiledTransition &transition = *transition_it;
 
     // Outcome is an outcome of the sm
-    if (std::find(this->outcomes.begin(), this->outcomes.end(), outcome) !=
-        this->outcomes.end()) {
+    if (transition.next_state == END_OF_MACHINE) {
+
+      instance.set_current_state(-1);
+      YASMIN_LOG_INFO("State machine ends with outcome '%s'",
+                      transition.target.c_str());
+
+      // Nested state machines are recorded as states of their parent
+      if (StateMetricsRegistry::is_enabled() && !instance.nested &&
+          !instance.path.empty() &&
+          start_time != std::chrono::steady_clock::time_point()) {
+        StateMetricsRegistry::get_metrics(instance.path, this->outcomes)
+            .record(std::chrono::steady_clock::now() - start_time,
+                    transition.target);
+      }
 
-      this->set_current_state("");
-      YASMIN_LOG_INFO("State machine ends with outcome '%s'", outcome.c_str());
-      this->call_end_cbs(blackboard, outcome);
+      machine_trace.set_arg("outcome", transition.target.c_str());
+      this->call_end_cbs(blackboard, transition.target);
 
-      return outcome;
+      return transition.target;
 
       // Outcome is a state
-    } else if (this->states.find(outcome) != this->states.end()) {
+    } else if (transition.next_state >= 0) {
 
       YASMIN_LOG_INFO("State machine transitioning '%s' : '%s' --> '%s'",
-                      this->current_state.c_str(), old_outcome.c_str(),
-                      outcome.c_str());
-      this->call_transition_cbs(blackboard, this->current_state, outcome,
-                                old_outcome);
+                      current_state.name.c_str(), outcome.c_str(),
+                      transition.target.c_str());
+
+      if (TraceRecorder::is_enabled()) {
+        TraceRecorder::record('i', TraceRecorder::TRANSITION_EVENT,
+                              outcome.c_str(), "to", transition.target.c_str());
+      }
+
+      this->call_transition_cbs(blackboard, current_state.name,
+                                transition.target, outcome);
 
-      this->set_current_state(outcome);
+      state_id = transition.next_state;
+      instance.set_current_state(state_id);
 
       // Outcome is not in the sm
     } else {
-      throw std::logic_error("Outcome '" + outcome +
+      throw std::logic_error("Outcome '" + transition.target.str() +
                              "' is not a state nor a state machine outcome");
     }
   }
@@ -397,21 +657,43 @@ std::string StateMachine::operator()() {
 
 void StateMachine::cancel_state() {
 
-  if (this->is_running()) {
-
-    auto current_state = this->get_current_state();
-
-    while (current_state.empty()) {
-      std::unique_lock<std::mutex> lock(*this->current_state_mutex.get());
-      this->current_state_cond.wait(lock);
-      current_state = this->get_current_state();
+  // Cancel only the execution of the run being canceled, if any
+  const StateRun *run = this->get_canceled_run();
+  auto is_running = [this, run]() {
+    return run != nullptr ? run->status.load() == StateStatus::RUNNING
+                          : this->is_running();
+  };
+  auto is_canceled_instance = [run](const auto &active_instance) {
+    return run == nullptr || active_instance.first == run;
+  };
+
+  if (is_running()) {
+
+    std::unique_lock<std::mutex> lock(*this->active_instance_mutex.get());
+    this->active_instance_cond.wait(lock, [&]() {
+      return std::any_of(this->active_instances.begin(),
+                         this->active_instances.end(), is_canceled_instance) ||
+             !is_running();
+    });
+
+    bool canceled = false;
+    for (const auto &active_instance : this->active_instances) {
+      if (is_canceled_instance(active_instance)) {
+        active_instance.second->cancel();
+        canceled = true;
+      }
     }
 
-    if (!current_state.empty()) {
-      this->states.at(current_state)->cancel_state();
+    if (canceled) {
       State::cancel_state();
+      return;
     }
   }
+
+  // A run that has not started yet starts canceled
+  if (run != nullptr) {
+    State::cancel_state();
+  }
 }
 
 std::string StateMachine::to_string() {
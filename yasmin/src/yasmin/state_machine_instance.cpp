@@ -0,0 +1,243 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/logs.hpp"
+#include "yasmin/state_machine.hpp"
+#include "yasmin/state_machine_instance.hpp"
+#include "yasmin/trace_recorder.hpp"
+
+using namespace yasmin;
+
+StateMachineInstance::StateMachineInstance(
+    std::shared_ptr<StateMachine> state_machine,
+    std::shared_ptr<blackboard::Blackboard> blackboard)
+    : StateMachineInstance(state_machine.get(), blackboard, true) {
+
+  if (state_machine == nullptr) {
+    throw std::invalid_argument("State machine cannot be null");
+  }
+
+  if (this->blackboard == nullptr) {
+    this->blackboard = std::make_shared<blackboard::Blackboard>();
+  }
+
+  this->state_machine_ptr = state_machine;
+  this->state_machine->validate();
+}
+
+StateMachineInstance::StateMachineInstance(
+    StateMachine *state_machine,
+    std::shared_ptr<blackboard::Blackboard> blackboard, bool nested_instances)
+    : state_machine(state_machine), blackboard(blackboard),
+      nested_instances(nested_instances), path(state_machine->get_name()) {}
+
+std::string StateMachineInstance::execute() {
+
+  if (this->is_running()) {
+    throw std::logic_error("State machine instance is already running");
+  }
+
+  this->set_status(StateStatus::RUNNING);
+  return this->run();
+}
+
+std::string StateMachineInstance::resume(const std::string &state_name) {
+
+  if (this->is_running()) {
+    throw std::logic_error("State machine instance is already running");
+  }
+
+  this->resume_state = this->state_machine->get_state_id(state_name);
+  this->set_status(StateStatus::RUNNING);
+  return this->run();
+}
+
+std::string StateMachineInstance::operator()() { return this->execute(); }
+
+Outcome StateMachineInstance::run() {
+
+  Outcome outcome;
+
+  try {
+    outcome = this->state_machine->run(*this);
+
+  } catch (...) {
+    // Mark as idle before rethrowing, unless it was canceled
+    if (this->is_running()) {
+      this->set_status(StateStatus::IDLE);
+    }
+
+    if (!this->nested && TraceRecorder::is_enabled()) {
+      TraceRecorder::dump();
+    }
+    throw;
+  }
+
+  // Root state machines write the trace when they end
+  if (!this->nested && TraceRecorder::is_enabled()) {
+    TraceRecorder::dump();
+  }
+
+  // Mark as completed if not canceled
+  if (this->is_running()) {
+    this->set_status(StateStatus::COMPLETED);
+  }
+
+  return outcome;
+}
+
+std::shared_ptr<blackboard::Blackboard>
+StateMachineInstance::get_state_blackboard(int state_id) {
+
+  const std::map<std::string, std::string> &remappings =
+      this->graph->states[state_id].remappings;
+
+  if (remappings.empty()) {
+    return this->blackboard;
+  }
+
+  if (this->state_blackboards.size() !=
+      this->graph->states.size()) {
+    this->state_blackboards.assign(
+        this->graph->states.size(), nullptr);
+  }
+
+  std::shared_ptr<blackboard::Blackboard> &state_blackboard =
+      this->state_blackboards[state_id];
+
+  if (state_blackboard == nullptr) {
+    state_blackboard =
+        std::make_shared<blackboard::BlackboardView>(this->blackboard,
+                                                     remappings);
+  }
+
+  return state_blackboard;
+}
+
+StateMetrics &StateMachineInstance::get_state_metrics(int state_id) {
+
+  if (this->state_metrics.size() !=
+      this->graph->states.size()) {
+    this->state_metrics.assign(this->graph->states.size(),
+                               nullptr);
+  }
+
+  StateMetrics *&metrics = this->state_metrics[state_id];
+
+  if (metrics == nullptr) {
+    const auto &compiled_state = this->graph->states[state_id];
+    std::string state_path = this->path.empty()
+                                 ? compiled_state.name
+                                 : this->path + "/" + compiled_state.name;
+
+    metrics = &StateMetricsRegistry::get_metrics(
+        state_path, OutcomeSet::intern(
+                        compiled_state.state->get_outcome_set().get_names()));
+  }
+
+  return *metrics;
+}
+
+Outcome StateMachineInstance::execute_child(
+    StateMachine *state_machine,
+    std::shared_ptr<blackboard::Blackboard> blackboard) {
+
+  // The nested state machine may have changed after the parent was validated
+  state_machine->validate();
+
+  StateMachineInstance *child =
+      new StateMachineInstance(state_machine, blackboard, true);
+  child->set_status(StateStatus::RUNNING);
+
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex);
+    this->child.reset(child);
+  }
+
+  try {
+    Outcome outcome = child->run();
+
+    const std::lock_guard<std::mutex> lock(this->mutex);
+    this->child.reset();
+    return outcome;
+
+  } catch (...) {
+    const std::lock_guard<std::mutex> lock(this->mutex);
+    this->child.reset();
+    throw;
+  }
+}
+
+void StateMachineInstance::cancel() {
+
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->cond.wait(lock, [this]() {
+    return this->current_state >= 0 || !this->is_running();
+  });
+
+  if (!this->is_running()) {
+    return;
+  }
+
+  YASMIN_LOG_INFO("Canceling state machine instance in state '%s'",
+                  this->graph->states[this->current_state]
+                      .name.c_str());
+
+  // Cancel the execution first, so no other state starts
+  this->status.store(StateStatus::CANCELED);
+  this->cond.notify_all();
+
+  if (this->child != nullptr) {
+    // Keep the lock so the nested instance is not destroyed meanwhile
+    this->child->cancel();
+
+  } else {
+    // Only the run of this instance is canceled, the state may be shared
+    std::shared_ptr<State> state =
+        this->graph->states[this->current_state].state;
+    lock.unlock();
+    state->cancel_run(this->state_run);
+  }
+}
+
+std::string StateMachineInstance::get_current_state() {
+  const std::lock_guard<std::mutex> lock(this->mutex);
+
+  if (this->current_state < 0) {
+    return "";
+  }
+
+  return this->graph->states[this->current_state].name;
+}
+
+void StateMachineInstance::set_current_state(int state_id) {
+  const std::lock_guard<std::mutex> lock(this->mutex);
+  this->current_state = state_id;
+  this->state_run.status.store(StateStatus::IDLE);
+  this->cond.notify_all();
+}
+
+void StateMachineInstance::set_status(StateStatus status) {
+  const std::lock_guard<std::mutex> lock(this->mutex);
+  this->status.store(status);
+  this->cond.notify_all();
+}
@@ -20,6 +20,7 @@
 #include "yasmin/blackboard/blackboard_pywrapper.hpp"
 #include "yasmin/pybind11_utils.hpp"
 #include "yasmin/state_machine.hpp"
+#include "yasmin/state_machine_instance.hpp"
 
 namespace py = pybind11;
 
@@ -153,4 +154,67 @@ PYBIND11_MODULE(state_machine, m) {
   // Add the __call__ operator using the utility function
   yasmin::pybind11_utils::add_call_operator<decltype(sm_class),
                                             yasmin::StateMachine>(sm_class);
+
+  // Export StateMachineInstance class
+  py::class_<yasmin::StateMachineInstance,
+             std::shared_ptr<yasmin::StateMachineInstance>>(
+      m, "StateMachineInstance")
+      .def(py::init([](std::shared_ptr<yasmin::StateMachine> state_machine,
+                       py::object blackboard_obj) {
+             return std::make_shared<yasmin::StateMachineInstance>(
+                 state_machine,
+                 yasmin::pybind11_utils::convert_blackboard_from_python(
+                     blackboard_obj));
+           }),
+           py::arg("state_machine"), py::arg("blackboard") = py::none(),
+           py::keep_alive<1, 2>()) // Keep state machine (arg 2) alive as
+                                   // long as self (arg 1) is alive
+      .def(
+          "execute",
+          [](yasmin::StateMachineInstance &self) {
+            // Release GIL to allow C++ threads to run
+            py::gil_scoped_release release;
+            return self.execute();
+          },
+          "Execute the state machine in this instance")
+      .def(
+          "resume",
+          [](yasmin::StateMachineInstance &self,
+             const std::string &state_name) {
+            // Release GIL to allow C++ threads to run
+            py::gil_scoped_release release;
+            return self.resume(state_name);
+          },
+          "Execute the state machine from a given state", py::arg("state_name"))
+      .def(
+          "__call__",
+          [](yasmin::StateMachineInstance &self) {
+            // Release GIL to allow C++ threads to run
+            py::gil_scoped_release release;
+            return self.execute();
+          },
+          "Execute the state machine in this instance")
+      .def("cancel", &yasmin::StateMachineInstance::cancel,
+           "Cancel the execution of this instance",
+           py::call_guard<py::gil_scoped_release>())
+      .def("get_current_state",
+           &yasmin::StateMachineInstance::get_current_state,
+           "Get the name of the current state being executed")
+      .def("get_status", &yasmin::StateMachineInstance::get_status,
+           "Gets the current status of the execution")
+      .def("is_idle", &yasmin::StateMachineInstance::is_idle,
+           "Checks if the execution is idle")
+      .def("is_running", &yasmin::StateMachineInstance::is_running,
+           "Checks if the execution is running")
+      .def("is_canceled", &yasmin::StateMachineInstance::is_canceled,
+           "Checks if the execution has been canceled")
+      .def("is_completed", &yasmin::StateMachineInstance::is_completed,
+           "Checks if the execution has completed")
+      .def(
+          "get_blackboard",
+          [](yasmin::StateMachineInstance &self) {
+            return yasmin::blackboard::BlackboardPyWrapper(
+                self.get_blackboard());
+          },
+          "Get the blackboard of this execution");
 }
@@ -0,0 +1,331 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "yasmin/state_metrics.hpp"
+
+using namespace yasmin;
+
+namespace {
+
+/// Metrics of the states, never removed so references remain valid
+std::unordered_map<std::string, std::unique_ptr<StateMetrics>> state_metrics;
+/// Mutex for the metrics, shared by readers
+std::shared_mutex state_metrics_mutex;
+
+/// Quantiles exported to OpenMetrics
+constexpr double EXPORTED_QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+/**
+ * @brief Escapes a label value of the OpenMetrics text format.
+ * @param value The label value.
+ * @return The escaped value.
+ */
+std::string escape_label(const std::string &value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      escaped += '\\';
+      escaped += c;
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+
+  return escaped;
+}
+
+} // namespace
+
+void LatencyHistogram::record(std::uint64_t value) {
+  value = std::min(value, MAX_VALUE);
+
+  this->buckets[get_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+  this->count.fetch_add(1, std::memory_order_relaxed);
+  this->sum.fetch_add(value, std::memory_order_relaxed);
+
+  std::uint64_t current = this->min.load(std::memory_order_relaxed);
+  while (value < current &&
+         !this->min.compare_exchange_weak(current, value,
+                                          std::memory_order_relaxed)) {
+  }
+
+  current = this->max.load(std::memory_order_relaxed);
+  while (value > current &&
+         !this->max.compare_exchange_weak(current, value,
+                                          std::memory_order_relaxed)) {
+  }
+}
+
+std::uint64_t LatencyHistogram::get_min() const {
+  std::uint64_t value = this->min.load(std::memory_order_relaxed);
+  return value == UINT64_MAX ? 0 : value;
+}
+
+double LatencyHistogram::get_mean() const {
+  std::uint64_t count = this->get_count();
+
+  if (count == 0) {
+    return 0.0;
+  }
+
+  return static_cast<double>(this->get_sum()) / static_cast<double>(count);
+}
+
+std::uint64_t LatencyHistogram::get_quantile(double quantile) const {
+
+  if (!(quantile >= 0.0 && quantile <= 1.0)) {
+    throw std::invalid_argument("Quantile must be between 0 and 1");
+  }
+
+  // Count the buckets, since other threads may be recording values
+  std::uint64_t counts[NUM_BUCKETS];
+  std::uint64_t total = 0;
+
+  for (int i = 0; i < NUM_BUCKETS; ++i) {
+    counts[i] = this->buckets[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+
+  if (total == 0) {
+    return 0;
+  }
+
+  std::uint64_t rank = static_cast<std::uint64_t>(
+      std::ceil(quantile * static_cast<double>(total)));
+  rank = std::max<std::uint64_t>(rank, 1);
+
+  std::uint64_t seen = 0;
+  for (int i = 0; i < NUM_BUCKETS; ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return std::min(get_bucket_upper_bound(i), this->get_max());
+    }
+  }
+
+  return this->get_max();
+}
+
+void LatencyHistogram::reset() {
+  for (auto &bucket : this->buckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+
+  this->count.store(0, std::memory_order_relaxed);
+  this->sum.store(0, std::memory_order_relaxed);
+  this->min.store(UINT64_MAX, std::memory_order_relaxed);
+  this->max.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::get_bucket(std::uint64_t value) {
+
+  if (value < SUB_BUCKETS) {
+    return static_cast<int>(value);
+  }
+
+  // Values are split by their highest bit and the next SUB_BUCKET_BITS bits
+#if defined(__GNUC__) || defined(__clang__)
+  int highest_bit = 63 - __builtin_clzll(value);
+#else
+  int highest_bit = SUB_BUCKET_BITS;
+  while ((value >> (highest_bit + 1)) != 0) {
+    ++highest_bit;
+  }
+#endif
+  int shift = highest_bit - SUB_BUCKET_BITS;
+
+  return SUB_BUCKETS + shift * SUB_BUCKETS +
+         static_cast<int>((value >> shift) - SUB_BUCKETS);
+}
+
+std::uint64_t LatencyHistogram::get_bucket_upper_bound(int bucket) {
+
+  if (bucket < SUB_BUCKETS) {
+    return static_cast<std::uint64_t>(bucket);
+  }
+
+  int shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+  std::uint64_t sub_bucket = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+  std::uint64_t lower = (SUB_BUCKETS + sub_bucket) << shift;
+
+  return lower + (std::uint64_t(1) << shift) - 1;
+}
+
+StateMetrics::StateMetrics(const std::string &path,
+                           std::shared_ptr<const OutcomeSet> outcomes)
+    : path(path), outcomes(outcomes),
+      outcome_counts(new std::atomic<std::uint64_t>[outcomes->get_outcomes()
+                                                        .size()]) {
+
+  for (std::size_t i = 0; i < this->outcomes->get_outcomes().size(); ++i) {
+    this->outcome_counts[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void StateMetrics::record(std::chrono::nanoseconds duration,
+                          const Outcome &outcome) {
+
+  this->latency.record(duration);
+
+  int index = this->outcomes->index_of(outcome);
+  if (index >= 0) {
+    this->outcome_counts[index].fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  const std::lock_guard<std::mutex> lock(this->other_outcome_counts_mutex);
+  this->other_outcome_counts[outcome.str()]++;
+}
+
+std::map<std::string, std::uint64_t> StateMetrics::get_outcome_counts() const {
+
+  std::map<std::string, std::uint64_t> counts;
+
+  const std::vector<Outcome> &outcomes = this->outcomes->get_outcomes();
+  for (std::size_t i = 0; i < outcomes.size(); ++i) {
+    std::uint64_t count =
+        this->outcome_counts[i].load(std::memory_order_relaxed);
+    if (count > 0) {
+      counts[outcomes[i].str()] = count;
+    }
+  }
+
+  const std::lock_guard<std::mutex> lock(this->other_outcome_counts_mutex);
+  for (const auto &[outcome, count] : this->other_outcome_counts) {
+    counts[outcome] += count;
+  }
+
+  return counts;
+}
+
+void StateMetrics::reset() {
+  this->latency.reset();
+
+  for (std::size_t i = 0; i < this->outcomes->get_outcomes().size(); ++i) {
+    this->outcome_counts[i].store(0, std::memory_order_relaxed);
+  }
+
+  const std::lock_guard<std::mutex> lock(this->other_outcome_counts_mutex);
+  this->other_outcome_counts.clear();
+}
+
+StateMetrics &
+StateMetricsRegistry::get_metrics(const std::string &path,
+                                  std::shared_ptr<const OutcomeSet> outcomes) {
+  {
+    std::shared_lock<std::shared_mutex> lk(state_metrics_mutex);
+    auto it = state_metrics.find(path);
+    if (it != state_metrics.end()) {
+      return *it->second;
+    }
+  }
+
+  std::lock_guard<std::shared_mutex> lk(state_metrics_mutex);
+  std::unique_ptr<StateMetrics> &metrics = state_metrics[path];
+
+  // Another thread may have created them while waiting
+  if (metrics == nullptr) {
+    metrics = std::make_unique<StateMetrics>(path, outcomes);
+  }
+
+  return *metrics;
+}
+
+const StateMetrics *StateMetricsRegistry::find_metrics(const std::string &path) {
+  std::shared_lock<std::shared_mutex> lk(state_metrics_mutex);
+  auto it = state_metrics.find(path);
+  return it != state_metrics.end() ? it->second.get() : nullptr;
+}
+
+std::vector<std::string> StateMetricsRegistry::get_paths() {
+  std::vector<std::string> paths;
+
+  {
+    std::shared_lock<std::shared_mutex> lk(state_metrics_mutex);
+    paths.reserve(state_metrics.size());
+    for (const auto &[path, metrics] : state_metrics) {
+      paths.push_back(path);
+    }
+  }
+
+  std::sort(paths.begin(), paths.end());
+  return paths;
+}
+
+void StateMetricsRegistry::reset() {
+  std::shared_lock<std::shared_mutex> lk(state_metrics_mutex);
+  for (auto &[path, metrics] : state_metrics) {
+    metrics->reset();
+  }
+}
+
+std::string StateMetricsRegistry::to_openmetrics() {
+
+  std::vector<std::string> paths = StateMetricsRegistry::get_paths();
+
+  std::ostringstream oss;
+  oss.precision(9);
+
+  oss << "# TYPE yasmin_state_duration_seconds summary\n"
+      << "# UNIT yasmin_state_duration_seconds seconds\n"
+      << "# HELP yasmin_state_duration_seconds Time from the entry to the "
+         "exit of each state.\n";
+
+  for (const std::string &path : paths) {
+    const LatencyHistogram &latency = find_metrics(path)->get_latency();
+    std::string label = "state=\"" + escape_label(path) + "\"";
+
+    for (double quantile : EXPORTED_QUANTILES) {
+      oss << "yasmin_state_duration_seconds{" << label << ",quantile=\""
+          << quantile << "\"} " << latency.get_quantile(quantile) * 1e-9
+          << "\n";
+    }
+
+    oss << "yasmin_state_duration_seconds_sum{" << label << "} "
+        << latency.get_sum() * 1e-9 << "\n"
+        << "yasmin_state_duration_seconds_count{" << label << "} "
+        << latency.get_count() << "\n";
+  }
+
+  oss << "# TYPE yasmin_state_outcomes counter\n"
+      << "# HELP yasmin_state_outcomes Outcomes returned by each state.\n";
+
+  for (const std::string &path : paths) {
+    std::string label = "state=\"" + escape_label(path) + "\"";
+
+    for (const auto &[outcome, count] :
+         find_metrics(path)->get_outcome_counts()) {
+      oss << "yasmin_state_outcomes_total{" << label << ",outcome=\""
+          << escape_label(outcome) << "\"} " << count << "\n";
+    }
+  }
+
+  oss << "# EOF\n";
+  return oss.str();
+}
@@ -0,0 +1,72 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "yasmin/state_metrics.hpp"
+
+namespace py = pybind11;
+
+PYBIND11_MODULE(state_metrics, m) {
+  m.doc() = "Python bindings for yasmin state metrics";
+
+  // Export LatencyHistogram class
+  py::class_<yasmin::LatencyHistogram>(m, "LatencyHistogram")
+      .def("get_count", &yasmin::LatencyHistogram::get_count,
+           "Get the number of recorded durations")
+      .def("get_sum", &yasmin::LatencyHistogram::get_sum,
+           "Get the sum of the recorded durations in nanoseconds")
+      .def("get_min", &yasmin::LatencyHistogram::get_min,
+           "Get the smallest recorded duration in nanoseconds")
+      .def("get_max", &yasmin::LatencyHistogram::get_max,
+           "Get the largest recorded duration in nanoseconds")
+      .def("get_mean", &yasmin::LatencyHistogram::get_mean,
+           "Get the mean of the recorded durations in nanoseconds")
+      .def("get_quantile", &yasmin::LatencyHistogram::get_quantile,
+           py::arg("quantile"),
+           "Get the duration in nanoseconds below which a fraction (0 to 1) "
+           "of the recorded durations fall");
+
+  // Export StateMetrics class, owned by the registry and never destroyed
+  py::class_<yasmin::StateMetrics>(m, "StateMetrics")
+      .def("get_path", &yasmin::StateMetrics::get_path,
+           "Get the fully qualified path of the state")
+      .def("get_latency", &yasmin::StateMetrics::get_latency,
+           py::return_value_policy::reference_internal,
+           "Get the histogram of the durations of the state")
+      .def("get_outcome_counts", &yasmin::StateMetrics::get_outcome_counts,
+           "Get how many times each outcome was returned");
+
+  // Export the registry as module functions
+  m.def("set_metrics_enabled", &yasmin::StateMetricsRegistry::set_enabled,
+        py::arg("enabled"), "Enable or disable recording state metrics");
+
+  m.def("is_metrics_enabled", &yasmin::StateMetricsRegistry::is_enabled,
+        "Check if state metrics are recorded");
+
+  m.def("find_state_metrics", &yasmin::StateMetricsRegistry::find_metrics,
+        py::arg("path"), py::return_value_policy::reference,
+        "Get the metrics of a state by its path, None if it has not run");
+
+  m.def("get_state_paths", &yasmin::StateMetricsRegistry::get_paths,
+        "Get the paths of the states with metrics");
+
+  m.def("reset_metrics", &yasmin::StateMetricsRegistry::reset,
+        "Remove the recorded executions of all states");
+
+  m.def("to_openmetrics", &yasmin::StateMetricsRegistry::to_openmetrics,
+        "Export the state metrics in the OpenMetrics text format");
+}
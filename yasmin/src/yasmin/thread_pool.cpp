@@ -0,0 +1,311 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <string>
+
+#include "yasmin/logs.hpp"
+#include "yasmin/thread_pool.hpp"
+
+using namespace yasmin;
+
+namespace {
+
+/// Size of the shared pool, 0 to use the number of hardware threads
+std::atomic<std::size_t> default_size{0};
+/// Maximum size of the shared pool, 0 to use four times the default size
+std::atomic<std::size_t> default_max_size{0};
+/// Flag to indicate if the shared pool has been created
+std::atomic_bool instance_created{false};
+
+/// Pool of the current thread, if it is a worker
+thread_local ThreadPool *current_pool = nullptr;
+/// Index of the current thread in its pool, if it is a worker
+thread_local std::size_t current_worker = 0;
+
+} // namespace
+
+ThreadPool::Task::Task(std::function<void()> function) : function(function) {}
+
+bool ThreadPool::Task::try_run() {
+  if (this->claimed.exchange(true)) {
+    return false;
+  }
+
+  this->run();
+  return true;
+}
+
+ThreadPool::ThreadPool(std::size_t size, std::size_t max_size) {
+
+  if (size == 0) {
+    size = ThreadPool::get_default_size();
+  }
+
+  if (max_size == 0) {
+    max_size = ThreadPool::get_default_max_size();
+  }
+
+  size = std::min(size, MAX_SIZE);
+  this->max_size = std::max(std::min(max_size, MAX_SIZE), size);
+
+  YASMIN_LOG_DEBUG("Creating thread pool with %zu threads of at most %zu",
+                   size, this->max_size);
+
+  // The queues are not moved when the pool grows, so workers can index them
+  for (std::size_t i = 0; i < this->max_size; ++i) {
+    this->queues.push_back(std::make_unique<WorkerQueue>());
+  }
+
+  std::lock_guard<std::mutex> lk(this->mutex);
+  this->threads.reserve(this->max_size);
+
+  for (std::size_t i = 0; i < size; ++i) {
+    this->start_worker();
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    this->stop = true;
+  }
+  this->cond.notify_all();
+
+  for (std::thread &thread : this->threads) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+std::size_t ThreadPool::get_submit_queue() {
+
+  // Workers push to their own queue, other threads spread the tasks
+  if (current_pool == this) {
+    return current_worker;
+  }
+
+  return this->next_queue.fetch_add(1) % this->num_workers.load();
+}
+
+void ThreadPool::start_worker() {
+  std::size_t index = this->threads.size();
+
+  // A starting worker is idle, so the pool does not grow again for it
+  this->idle++;
+  this->threads.emplace_back(&ThreadPool::worker_loop, this, index);
+  this->num_workers.store(index + 1);
+}
+
+std::shared_ptr<ThreadPool::Task>
+ThreadPool::submit(std::function<void()> function) {
+  auto task = std::make_shared<Task>(function);
+  this->submit(task);
+  return task;
+}
+
+void ThreadPool::submit(std::shared_ptr<Task> task) {
+
+  std::size_t index = this->get_submit_queue();
+
+  {
+    std::lock_guard<std::mutex> lk(this->queues[index]->mutex);
+    this->queues[index]->tasks.push_back(std::move(task));
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    this->pending.fetch_add(1);
+  }
+  this->cond.notify_one();
+}
+
+bool ThreadPool::try_submit(std::shared_ptr<Task> task) {
+
+  std::size_t index = this->get_submit_queue();
+
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+
+    // The idle workers may already be reserved by queued tasks
+    if (this->idle <= this->pending.load()) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> queue_lk(this->queues[index]->mutex);
+    this->queues[index]->tasks.push_back(std::move(task));
+    this->pending.fetch_add(1);
+  }
+  this->cond.notify_one();
+
+  return true;
+}
+
+bool ThreadPool::try_submit(Task &task) {
+  task.reset();
+
+  // The aliasing pointer does not own the task, so it allocates nothing
+  return this->try_submit(
+      std::shared_ptr<Task>(std::shared_ptr<Task>(), &task));
+}
+
+bool ThreadPool::try_start(std::shared_ptr<Task> task) {
+
+  std::size_t index = this->get_submit_queue();
+
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+
+    if (this->idle <= this->pending.load()) {
+
+      // All the workers are busy, so the task goes to a new one
+      if (this->stop || this->threads.size() >= this->max_size) {
+        return false;
+      }
+
+      index = this->threads.size();
+      YASMIN_LOG_DEBUG("Growing thread pool to %zu threads", index + 1);
+      this->start_worker();
+    }
+
+    std::lock_guard<std::mutex> queue_lk(this->queues[index]->mutex);
+    this->queues[index]->tasks.push_back(std::move(task));
+    this->pending.fetch_add(1);
+  }
+  this->cond.notify_one();
+
+  return true;
+}
+
+std::shared_ptr<ThreadPool::Task> ThreadPool::pop_task(std::size_t index) {
+
+  // Newest task of the own queue
+  {
+    WorkerQueue &queue = *this->queues[index];
+    std::lock_guard<std::mutex> lk(queue.mutex);
+    if (!queue.tasks.empty()) {
+      auto task = queue.tasks.back();
+      queue.tasks.pop_back();
+      return task;
+    }
+  }
+
+  // Oldest task of the other queues
+  std::size_t num_workers = this->num_workers.load();
+  for (std::size_t i = 1; i < num_workers; ++i) {
+    WorkerQueue &queue = *this->queues[(index + i) % num_workers];
+    std::lock_guard<std::mutex> lk(queue.mutex);
+    if (!queue.tasks.empty()) {
+      auto task = queue.tasks.front();
+      queue.tasks.pop_front();
+      return task;
+    }
+  }
+
+  return nullptr;
+}
+
+void ThreadPool::worker_loop(std::size_t index) {
+
+  current_pool = this;
+  current_worker = index;
+
+  // The worker was counted as idle when it was started
+  std::unique_lock<std::mutex> lk(this->mutex);
+
+  while (true) {
+    this->cond.wait(
+        lk, [this]() { return this->stop || this->pending.load() > 0; });
+    this->idle--;
+
+    if (this->stop && this->pending.load() == 0) {
+      return;
+    }
+
+    // Take one of the queued tasks, so try_submit() counts it as taken
+    this->pending.fetch_sub(1);
+    lk.unlock();
+
+    // The task is queued before it is counted, so it is found
+    std::shared_ptr<Task> task = this->pop_task(index);
+    while (task == nullptr) {
+      std::this_thread::yield();
+      task = this->pop_task(index);
+    }
+
+    // The task may have been run by the thread waiting for it
+    try {
+      task->try_run();
+    } catch (const std::exception &e) {
+      YASMIN_LOG_ERROR("Thread pool task failed: %s", e.what());
+    }
+
+    lk.lock();
+    this->idle++;
+  }
+}
+
+ThreadPool &ThreadPool::get_instance() {
+  static ThreadPool instance(ThreadPool::get_default_size(),
+                             ThreadPool::get_default_max_size());
+  instance_created.store(true);
+  return instance;
+}
+
+void ThreadPool::set_default_size(std::size_t size) {
+
+  if (instance_created.load()) {
+    throw std::logic_error(
+        "The size of the thread pool must be set before it is created");
+  }
+
+  default_size.store(std::min(size, MAX_SIZE));
+}
+
+std::size_t ThreadPool::get_default_size() {
+
+  std::size_t size = default_size.load();
+
+  if (size == 0) {
+    size = std::max<std::size_t>(std::thread::hardware_concurrency(), 2);
+  }
+
+  return std::min(size, MAX_SIZE);
+}
+
+void ThreadPool::set_default_max_size(std::size_t max_size) {
+
+  if (instance_created.load()) {
+    throw std::logic_error(
+        "The size of the thread pool must be set before it is created");
+  }
+
+  default_max_size.store(std::min(max_size, MAX_SIZE));
+}
+
+std::size_t ThreadPool::get_default_max_size() {
+
+  std::size_t max_size = default_max_size.load();
+
+  if (max_size == 0) {
+    max_size = 4 * ThreadPool::get_default_size();
+  }
+
+  return std::min(std::max(max_size, ThreadPool::get_default_size()),
+                  MAX_SIZE);
+}
@@ -0,0 +1,331 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "yasmin/logs.hpp"
+#include "yasmin/trace_recorder.hpp"
+
+using namespace yasmin;
+
+namespace {
+
+/**
+ * @struct TraceBuffer
+ * @brief Events recorded by one thread.
+ *
+ * The events are allocated in chunks as the thread records them, so threads
+ * that record few events do not keep a full buffer until it is cleared.
+ */
+struct TraceBuffer {
+  /// Number of events of each chunk
+  static constexpr std::size_t CHUNK_SIZE = 256;
+
+  /// Chunks of events, allocated by the owning thread before publishing them
+  std::vector<std::unique_ptr<TraceEvent[]>> chunks;
+  /// Maximum number of events
+  std::size_t capacity;
+  /// Number of recorded events, written by the owning thread
+  std::atomic<std::size_t> size{0};
+  /// Number of events dropped because the buffer was full
+  std::atomic<std::uint64_t> dropped{0};
+  /// True when the events were cleared, so the thread needs a new buffer
+  std::atomic<bool> closed{false};
+  /// Id of the thread
+  std::uint64_t thread_id;
+  /// Current nesting depth of the thread
+  std::uint16_t depth{0};
+
+  TraceBuffer(std::size_t capacity, std::uint64_t thread_id)
+      : chunks((capacity + CHUNK_SIZE - 1) / CHUNK_SIZE), capacity(capacity),
+        thread_id(thread_id) {}
+
+  /**
+   * @brief Gets a recorded event or the next one.
+   * @param index The index of the event, lower than the capacity.
+   * @return The event.
+   */
+  TraceEvent &get_event(std::size_t index) {
+    std::unique_ptr<TraceEvent[]> &chunk = this->chunks[index / CHUNK_SIZE];
+    if (!chunk) {
+      chunk.reset(new TraceEvent[CHUNK_SIZE]);
+    }
+    return chunk[index % CHUNK_SIZE];
+  }
+};
+
+/// Buffers of all threads, including finished ones
+std::vector<std::shared_ptr<TraceBuffer>> trace_buffers;
+/// Options of the recorder
+TraceOptions trace_options;
+/// Mutex for the buffers and the options
+std::mutex trace_mutex;
+
+/// Buffer of the current thread
+thread_local std::shared_ptr<TraceBuffer> thread_trace_buffer;
+
+/**
+ * @brief Gets the id of the current thread.
+ * @return The id shown by the operating system, if available.
+ */
+std::uint64_t get_thread_id() {
+#ifdef __linux__
+  return static_cast<std::uint64_t>(syscall(SYS_gettid));
+#else
+  return std::hash<std::thread::id>()(std::this_thread::get_id());
+#endif
+}
+
+/**
+ * @brief Gets the id of the current process.
+ * @return The process id, 0 if it is not available.
+ */
+std::uint64_t get_process_id() {
+#ifdef __linux__
+  return static_cast<std::uint64_t>(getpid());
+#else
+  return 0;
+#endif
+}
+
+/**
+ * @brief Copies a text into an event, truncating it if needed.
+ * @param dst The text of the event.
+ * @param src The text to copy.
+ */
+void copy_text(char (&dst)[TraceEvent::TEXT_SIZE], const char *src) {
+  std::size_t size = std::strlen(src);
+  if (size >= TraceEvent::TEXT_SIZE) {
+    size = TraceEvent::TEXT_SIZE - 1;
+  }
+  std::memcpy(dst, src, size);
+  dst[size] = '\0';
+}
+
+/**
+ * @brief Appends a JSON string.
+ * @param json The JSON text.
+ * @param value The string to escape.
+ */
+void append_json_string(std::string &json, const char *value) {
+  json += '"';
+
+  for (const char *c = value; *c != '\0'; ++c) {
+    switch (*c) {
+    case '"':
+      json += "\\\"";
+      break;
+    case '\\':
+      json += "\\\\";
+      break;
+    case '\n':
+      json += "\\n";
+      break;
+    default:
+      if (static_cast<unsigned char>(*c) < 0x20) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+        json += escaped;
+      } else {
+        json += *c;
+      }
+    }
+  }
+
+  json += '"';
+}
+
+} // namespace
+
+void TraceRecorder::start(const TraceOptions &options) {
+  TraceRecorder::clear();
+
+  const std::lock_guard<std::mutex> lock(trace_mutex);
+  trace_options = options;
+  TraceRecorder::enabled.store(true, std::memory_order_relaxed);
+}
+
+void TraceRecorder::stop() {
+  TraceRecorder::enabled.store(false, std::memory_order_relaxed);
+}
+
+void TraceRecorder::record(char phase, const char *category, const char *name,
+                           const char *arg_name, const char *arg) {
+
+  TraceBuffer *buffer = thread_trace_buffer.get();
+
+  if (buffer == nullptr || buffer->closed.load(std::memory_order_relaxed)) {
+    const std::lock_guard<std::mutex> lock(trace_mutex);
+    thread_trace_buffer = std::make_shared<TraceBuffer>(
+        trace_options.events_per_thread, get_thread_id());
+    trace_buffers.push_back(thread_trace_buffer);
+    buffer = thread_trace_buffer.get();
+  }
+
+  if (phase == 'E' && buffer->depth > 0) {
+    buffer->depth--;
+  }
+
+  std::size_t size = buffer->size.load(std::memory_order_relaxed);
+  if (size < buffer->capacity) {
+    // The chunk is published with the size, so exporting never allocates it
+    TraceEvent &event = buffer->get_event(size);
+    event.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+    event.phase = phase;
+    event.depth = buffer->depth;
+    event.category = category;
+    event.arg_name = arg_name;
+    copy_text(event.name, name);
+    copy_text(event.arg, arg);
+
+    // Publish the event to the threads exporting the trace
+    buffer->size.store(size + 1, std::memory_order_release);
+
+  } else {
+    buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (phase == 'B') {
+    buffer->depth++;
+  }
+}
+
+void TraceRecorder::clear() {
+  const std::lock_guard<std::mutex> lock(trace_mutex);
+
+  // The threads create new buffers, so they never write to cleared ones
+  for (const auto &buffer : trace_buffers) {
+    buffer->closed.store(true, std::memory_order_relaxed);
+  }
+  trace_buffers.clear();
+}
+
+std::uint64_t TraceRecorder::get_dropped_events() {
+  const std::lock_guard<std::mutex> lock(trace_mutex);
+
+  std::uint64_t dropped = 0;
+  for (const auto &buffer : trace_buffers) {
+    dropped += buffer->dropped.load(std::memory_order_relaxed);
+  }
+
+  return dropped;
+}
+
+std::string TraceRecorder::to_chrome_json() {
+
+  std::vector<std::shared_ptr<TraceBuffer>> buffers;
+  {
+    const std::lock_guard<std::mutex> lock(trace_mutex);
+    buffers = trace_buffers;
+  }
+
+  std::string pid = std::to_string(get_process_id());
+  std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  char number[32];
+  std::uint64_t dropped = 0;
+
+  for (const auto &buffer : buffers) {
+    std::string tid = std::to_string(buffer->thread_id);
+    std::size_t size = buffer->size.load(std::memory_order_acquire);
+
+    for (std::size_t i = 0; i < size; ++i) {
+      const TraceEvent &event = buffer->get_event(i);
+
+      json += first ? "\n" : ",\n";
+      first = false;
+
+      json += "{\"ph\":\"";
+      json += event.phase;
+      json += "\",\"cat\":";
+      append_json_string(json, event.category);
+
+      if (event.phase != 'E') {
+        json += ",\"name\":";
+        append_json_string(json, event.name);
+      }
+
+      // Timestamps are in microseconds
+      std::snprintf(number, sizeof(number), "%.3f", event.timestamp / 1000.0);
+      json += ",\"ts\":";
+      json += number;
+      json += ",\"pid\":" + pid + ",\"tid\":" + tid;
+
+      if (event.phase == 'i') {
+        json += ",\"s\":\"t\"";
+      }
+
+      json += ",\"args\":{\"depth\":" + std::to_string(event.depth);
+      if (event.arg_name != nullptr) {
+        json += ",";
+        append_json_string(json, event.arg_name);
+        json += ":";
+        append_json_string(json, event.arg);
+      }
+      json += "}}";
+    }
+
+    dropped += buffer->dropped.load(std::memory_order_relaxed);
+  }
+
+  json += "\n],\"otherData\":{\"dropped_events\":\"" +
+          std::to_string(dropped) + "\"}}\n";
+  return json;
+}
+
+void TraceRecorder::write_chrome_json(const std::string &path) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << TraceRecorder::to_chrome_json();
+
+  if (!file) {
+    throw std::runtime_error("Could not write the trace to '" + path + "'");
+  }
+}
+
+void TraceRecorder::dump() {
+  std::string path;
+  {
+    const std::lock_guard<std::mutex> lock(trace_mutex);
+    path = trace_options.output_path;
+  }
+
+  if (path.empty()) {
+    return;
+  }
+
+  try {
+    TraceRecorder::write_chrome_json(path);
+  } catch (const std::exception &e) {
+    YASMIN_LOG_ERROR("%s", e.what());
+  }
+}
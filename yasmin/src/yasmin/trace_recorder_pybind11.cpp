@@ -0,0 +1,59 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "yasmin/trace_recorder.hpp"
+
+namespace py = pybind11;
+
+PYBIND11_MODULE(trace_recorder, m) {
+  m.doc() = "Python bindings for the yasmin trace recorder";
+
+  // Export TraceOptions struct
+  py::class_<yasmin::TraceOptions>(m, "TraceOptions")
+      .def(py::init<>())
+      .def_readwrite("events_per_thread",
+                     &yasmin::TraceOptions::events_per_thread,
+                     "Number of events of the buffer of each thread")
+      .def_readwrite("output_path", &yasmin::TraceOptions::output_path,
+                     "File where the trace is written each time a root state "
+                     "machine ends, empty to only write it on demand");
+
+  // Export the recorder as module functions
+  m.def("start_trace", &yasmin::TraceRecorder::start,
+        py::arg("options") = yasmin::TraceOptions(),
+        "Start recording events, removing the recorded ones");
+
+  m.def("stop_trace", &yasmin::TraceRecorder::stop,
+        "Stop recording events, keeping the recorded ones");
+
+  m.def("is_trace_enabled", &yasmin::TraceRecorder::is_enabled,
+        "Check if events are recorded");
+
+  m.def("clear_trace", &yasmin::TraceRecorder::clear,
+        "Remove the recorded events");
+
+  m.def("get_dropped_trace_events", &yasmin::TraceRecorder::get_dropped_events,
+        "Get the number of events dropped because a buffer was full");
+
+  m.def("to_chrome_json", &yasmin::TraceRecorder::to_chrome_json,
+        "Export the recorded events in the Chrome trace event format");
+
+  m.def("write_chrome_json", &yasmin::TraceRecorder::write_chrome_json,
+        py::arg("path"),
+        "Write the recorded events in the Chrome trace event format");
+}
@@ -0,0 +1,439 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <fstream>
+#include <malloc.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/blackboard/blackboard_transaction.hpp"
+#include "yasmin/logs.hpp"
+
+using namespace yasmin;
+using namespace yasmin::blackboard;
+
+namespace {
+
+/// Number of keys read by a state on each tick
+constexpr int NUM_KEYS = 32;
+
+/// Number of updates of the soak benchmark
+constexpr int SOAK_ITERATIONS = 2000000;
+/// Maximum growth of the resident memory allowed in the soak benchmark
+constexpr long MAX_RSS_GROWTH_KB = 1024;
+
+/// Pose updated at a high rate, like a robot pose
+struct Pose {
+  std::string frame_id;
+  double position[3];
+  double orientation[4];
+};
+
+/// Resident set size of the process in kB, 0 if it is not available
+long get_rss_kb() {
+  std::ifstream statm("/proc/self/statm");
+  long size = 0;
+  long resident = 0;
+
+  if (!(statm >> size >> resident)) {
+    return 0;
+  }
+
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/// Overwrites the keys of a robot that runs for a long time
+void update_keys(Blackboard &blackboard, BlackboardKey<Pose> &pose_key,
+                 int i) {
+  Pose pose{"map", {(double)i, 0.0, 0.0}, {0.0, 0.0, 0.0, 1.0}};
+  blackboard.set(pose_key, pose);
+  blackboard.set<std::string>("status", i % 2 ? "RUNNING" : "IDLE");
+  blackboard.set<std::vector<double>>("ranges", std::vector<double>(360, i));
+
+  // Keys that change their type
+  if (i % 2) {
+    blackboard.set<int>("result", i);
+  } else {
+    blackboard.set<std::string>("result", "succeeded");
+  }
+}
+
+/// Bytes allocated in the heap, 0 if it is not available
+long get_heap_bytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  return mallinfo2().uordblks;
+#else
+  return 0;
+#endif
+}
+
+void fill_blackboard(Blackboard &blackboard) {
+  for (int i = 0; i < NUM_KEYS; ++i) {
+    blackboard.set<int>("key_" + std::to_string(i), i);
+  }
+}
+
+} // namespace
+
+static void BM_BlackboardGetString(benchmark::State &state) {
+  set_log_level(ERROR);
+  Blackboard blackboard;
+  fill_blackboard(blackboard);
+
+  std::vector<std::string> keys;
+  for (int i = 0; i < NUM_KEYS; ++i) {
+    keys.push_back("key_" + std::to_string(i));
+  }
+
+  for (auto _ : state) {
+    for (const std::string &key : keys) {
+      benchmark::DoNotOptimize(blackboard.get<int>(key));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * NUM_KEYS);
+}
+BENCHMARK(BM_BlackboardGetString);
+
+static void BM_BlackboardGetKey(benchmark::State &state) {
+  set_log_level(ERROR);
+  Blackboard blackboard;
+  fill_blackboard(blackboard);
+
+  std::vector<BlackboardKey<int>> keys;
+  for (int i = 0; i < NUM_KEYS; ++i) {
+    keys.push_back(blackboard.get_key<int>("key_" + std::to_string(i)));
+  }
+
+  for (auto _ : state) {
+    for (const BlackboardKey<int> &key : keys) {
+      benchmark::DoNotOptimize(blackboard.get(key));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * NUM_KEYS);
+}
+BENCHMARK(BM_BlackboardGetKey);
+
+static void BM_BlackboardSetString(benchmark::State &state) {
+  set_log_level(ERROR);
+  Blackboard blackboard;
+  fill_blackboard(blackboard);
+
+  for (auto _ : state) {
+    blackboard.set<int>("key_0", 1);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BlackboardSetString);
+
+static void BM_BlackboardSetKey(benchmark::State &state) {
+  set_log_level(ERROR);
+  Blackboard blackboard;
+  fill_blackboard(blackboard);
+  BlackboardKey<int> key = blackboard.get_key<int>("key_0");
+
+  for (auto _ : state) {
+    blackboard.set(key, 1);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BlackboardSetKey);
+
+static void BM_BlackboardSetNewType(benchmark::State &state) {
+  set_log_level(ERROR);
+  Blackboard blackboard;
+  fill_blackboard(blackboard);
+
+  // Each write changes the type, so a new value is stored
+  for (auto _ : state) {
+    blackboard.set<int>("key_0", 1);
+    blackboard.set<double>("key_0", 1.0);
+  }
+
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_BlackboardSetNewType);
+
+static void BM_BlackboardGetType(benchmark::State &state) {
+  set_log_level(ERROR);
+  Blackboard blackboard;
+  fill_blackboard(blackboard);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(blackboard.get_type_index("key_0"));
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BlackboardGetType);
+
+static void BM_BlackboardGetLargeCopy(benchmark::State &state) {
+  set_log_level(ERROR);
+  Blackboard blackboard;
+  blackboard.set<std::vector<float>>("cloud",
+                                     std::vector<float>(state.range(0)));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(blackboard.get<std::vector<float>>("cloud"));
+  }
+
+  state.SetBytesProcessed(state.iterations() * state.range(0) *
+                          sizeof(float));
+}
+BENCHMARK(BM_BlackboardGetLargeCopy)
+    ->RangeMultiplier(32)
+    ->Range(1024, 1 << 20);
+
+static void BM_BlackboardGetLargeShared(benchmark::State &state) {
+  set_log_level(ERROR);
+  Blackboard blackboard;
+  blackboard.set<std::vector<float>>("cloud",
+                                     std::vector<float>(state.range(0)));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        blackboard.get_shared<std::vector<float>>("cloud"));
+  }
+
+  state.SetBytesProcessed(state.iterations() * state.range(0) *
+                          sizeof(float));
+}
+BENCHMARK(BM_BlackboardGetLargeShared)
+    ->RangeMultiplier(32)
+    ->Range(1024, 1 << 20);
+
+/// Blackboard shared by the threads of the contention benchmarks
+static std::unique_ptr<Blackboard> contended_blackboard;
+
+static void BM_BlackboardContendedRead(benchmark::State &state) {
+  if (state.thread_index() == 0) {
+    set_log_level(ERROR);
+    contended_blackboard = std::make_unique<Blackboard>();
+    fill_blackboard(*contended_blackboard);
+  }
+
+  std::vector<std::string> keys;
+  for (int i = 0; i < NUM_KEYS; ++i) {
+    keys.push_back("key_" + std::to_string(i));
+  }
+
+  for (auto _ : state) {
+    for (const std::string &key : keys) {
+      benchmark::DoNotOptimize(contended_blackboard->get<int>(key));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * NUM_KEYS);
+}
+BENCHMARK(BM_BlackboardContendedRead)->ThreadRange(1, 16)->UseRealTime();
+
+static void BM_BlackboardContendedReadWrite(benchmark::State &state) {
+  if (state.thread_index() == 0) {
+    set_log_level(ERROR);
+    contended_blackboard = std::make_unique<Blackboard>();
+    fill_blackboard(*contended_blackboard);
+  }
+
+  const std::string write_key = "key_0";
+  const std::string read_key = "key_1";
+
+  // One of every eight accesses is a write
+  int i = 0;
+  for (auto _ : state) {
+    if (++i % 8 == 0) {
+      contended_blackboard->set<int>(write_key, i);
+    } else {
+      benchmark::DoNotOptimize(contended_blackboard->get<int>(read_key));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BlackboardContendedReadWrite)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+static void BM_BlackboardSetGroup(benchmark::State &state) {
+  set_log_level(ERROR);
+  Blackboard blackboard;
+  Pose pose{"map", {1.0, 2.0, 3.0}, {0.0, 0.0, 0.0, 1.0}};
+  std::vector<double> covariance(36, 0.1);
+  double stamp = 0.0;
+
+  // A pose with its covariance and timestamp, set one by one or at once
+  const bool transaction = state.range(0) != 0;
+
+  for (auto _ : state) {
+    stamp += 0.01;
+
+    if (transaction) {
+      BlackboardTransaction transaction(blackboard);
+      transaction.set<Pose>("pose", pose);
+      transaction.set<std::vector<double>>("covariance", covariance);
+      transaction.set<double>("stamp", stamp);
+    } else {
+      blackboard.set<Pose>("pose", pose);
+      blackboard.set<std::vector<double>>("covariance", covariance);
+      blackboard.set<double>("stamp", stamp);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * 3);
+}
+BENCHMARK(BM_BlackboardSetGroup)->ArgName("transaction")->Arg(0)->Arg(1);
+
+static void BM_BlackboardGetGroup(benchmark::State &state) {
+  set_log_level(ERROR);
+  Blackboard blackboard;
+  BlackboardKey<Pose> pose_key = blackboard.get_key<Pose>("pose");
+  BlackboardKey<std::vector<double>> covariance_key =
+      blackboard.get_key<std::vector<double>>("covariance");
+  BlackboardKey<double> stamp_key = blackboard.get_key<double>("stamp");
+
+  blackboard.set(pose_key, Pose{"map", {1.0, 2.0, 3.0}, {0.0, 0.0, 0.0, 1.0}});
+  blackboard.set(covariance_key, std::vector<double>(36, 0.1));
+  blackboard.set(stamp_key, 0.0);
+
+  const bool many = state.range(0) != 0;
+
+  for (auto _ : state) {
+    if (many) {
+      benchmark::DoNotOptimize(
+          blackboard.get_many(pose_key, covariance_key, stamp_key));
+    } else {
+      benchmark::DoNotOptimize(blackboard.get(pose_key));
+      benchmark::DoNotOptimize(blackboard.get(covariance_key));
+      benchmark::DoNotOptimize(blackboard.get(stamp_key));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * 3);
+}
+BENCHMARK(BM_BlackboardGetGroup)->ArgName("many")->Arg(0)->Arg(1);
+
+/// Waits for a key to reach a value, polling it or waiting for its changes
+void wait_for_value(Blackboard &blackboard, const std::string &key,
+                    int value, bool poll) {
+  while (true) {
+    std::uint64_t version = blackboard.get_version(key);
+
+    if (blackboard.get<int>(key) == value) {
+      return;
+    }
+
+    if (poll) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    } else {
+      blackboard.wait_for_change(key, version, std::chrono::seconds(1));
+    }
+  }
+}
+
+static void BM_BlackboardWakeUp(benchmark::State &state) {
+  set_log_level(ERROR);
+  Blackboard blackboard;
+  blackboard.set<int>("ping", 0);
+  blackboard.set<int>("pong", 0);
+
+  const bool poll = state.range(0) != 0;
+  std::atomic<bool> running{true};
+
+  // Another thread answers each ping with a pong
+  std::thread responder([&]() {
+    for (int i = 1; running.load(); ++i) {
+      wait_for_value(blackboard, "ping", i, poll);
+      blackboard.set<int>("pong", i);
+    }
+  });
+
+  int i = 0;
+  for (auto _ : state) {
+    blackboard.set<int>("ping", ++i);
+    wait_for_value(blackboard, "pong", i, poll);
+  }
+
+  running.store(false);
+  blackboard.set<int>("ping", i + 1);
+  responder.join();
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BlackboardWakeUp)
+    ->ArgName("poll")
+    ->Arg(0)
+    ->Arg(1)
+    ->UseRealTime();
+
+static void BM_BlackboardSmallValues(benchmark::State &state) {
+  set_log_level(ERROR);
+  long heap_bytes = 0;
+
+  // A few hundred flags and counters
+  for (auto _ : state) {
+    long initial_heap_bytes = get_heap_bytes();
+
+    {
+      Blackboard blackboard;
+      for (int i = 0; i < state.range(0); ++i) {
+        blackboard.set<bool>("flag_" + std::to_string(i), i % 2);
+        blackboard.set<int>("counter_" + std::to_string(i), i);
+        blackboard.set<double>("value_" + std::to_string(i), i);
+      }
+
+      heap_bytes = get_heap_bytes() - initial_heap_bytes;
+      benchmark::DoNotOptimize(blackboard.get<int>("counter_0"));
+    }
+  }
+
+  state.counters["heap_bytes_per_key"] = heap_bytes / (state.range(0) * 3.0);
+  state.SetItemsProcessed(state.iterations() * state.range(0) * 3);
+}
+BENCHMARK(BM_BlackboardSmallValues)->Arg(100);
+
+static void BM_BlackboardSoak(benchmark::State &state) {
+  set_log_level(ERROR);
+  Blackboard blackboard;
+  BlackboardKey<Pose> pose_key = blackboard.get_key<Pose>("pose");
+
+  // Warm up the allocator before measuring the resident memory
+  for (int i = 0; i < 10000; ++i) {
+    update_keys(blackboard, pose_key, i);
+  }
+
+  long initial_rss_kb = get_rss_kb();
+  int i = 0;
+
+  for (auto _ : state) {
+    update_keys(blackboard, pose_key, i++);
+  }
+
+  long rss_growth_kb = get_rss_kb() - initial_rss_kb;
+  state.counters["rss_growth_kb"] = rss_growth_kb;
+
+  if (rss_growth_kb > MAX_RSS_GROWTH_KB) {
+    state.SkipWithError("Resident memory grew while overwriting keys");
+  }
+}
+BENCHMARK(BM_BlackboardSoak)->Iterations(SOAK_ITERATIONS);
@@ -0,0 +1,186 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <benchmark/benchmark.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/cb_state.hpp"
+#include "yasmin/concurrence.hpp"
+#include "yasmin/logs.hpp"
+#include "yasmin/state.hpp"
+
+using namespace yasmin;
+
+namespace {
+
+std::map<std::string, std::shared_ptr<State>>
+create_states(std::size_t num_states) {
+  std::map<std::string, std::shared_ptr<State>> states;
+
+  for (std::size_t i = 0; i < num_states; ++i) {
+    states.insert({"STATE" + std::to_string(i),
+                   std::make_shared<CbState>(
+                       std::set<std::string>{"done"},
+                       [](std::shared_ptr<blackboard::Blackboard> blackboard) {
+                         (void)blackboard;
+                         return "done";
+                       })});
+  }
+
+  return states;
+}
+
+std::shared_ptr<Concurrence> create_concurrence(
+    const std::map<std::string, std::shared_ptr<State>> &states) {
+  return std::make_shared<Concurrence>(
+      states, "default",
+      Concurrence::OutcomeMap{{"done", {{states.begin()->first, "done"}}}});
+}
+
+/// Runs the states with a new thread for each one, as Concurrence used to do
+void run_thread_per_state(
+    const std::map<std::string, std::shared_ptr<State>> &states,
+    std::shared_ptr<blackboard::Blackboard> blackboard) {
+  std::vector<std::thread> state_threads;
+
+  for (const auto &[state_name, state] : states) {
+    state_threads.emplace_back(
+        [state, blackboard]() { (*state.get())(blackboard); });
+  }
+
+  for (std::thread &state_thread : state_threads) {
+    state_thread.join();
+  }
+}
+
+} // namespace
+
+static void BM_ConcurrenceThreadPerState(benchmark::State &state) {
+  set_log_level(ERROR);
+  auto states = create_states(state.range(0));
+  auto blackboard = std::make_shared<blackboard::Blackboard>();
+
+  for (auto _ : state) {
+    run_thread_per_state(states, blackboard);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConcurrenceThreadPerState)->RangeMultiplier(4)->Range(1, 64);
+
+static void BM_ConcurrenceThreadPool(benchmark::State &state) {
+  set_log_level(ERROR);
+  auto concurrence = create_concurrence(create_states(state.range(0)));
+  auto blackboard = std::make_shared<blackboard::Blackboard>();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize((*concurrence)(blackboard));
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConcurrenceThreadPool)->RangeMultiplier(4)->Range(1, 64);
+
+static void BM_NestedConcurrenceThreadPerState(benchmark::State &state) {
+  set_log_level(ERROR);
+  std::map<std::string, std::shared_ptr<State>> outer_states;
+
+  for (int i = 0; i < state.range(0); ++i) {
+    auto inner_states = create_states(state.range(0));
+    outer_states.insert(
+        {"INNER" + std::to_string(i),
+         std::make_shared<CbState>(
+             std::set<std::string>{"done"},
+             [inner_states](
+                 std::shared_ptr<blackboard::Blackboard> blackboard) {
+               run_thread_per_state(inner_states, blackboard);
+               return "done";
+             })});
+  }
+
+  auto blackboard = std::make_shared<blackboard::Blackboard>();
+
+  for (auto _ : state) {
+    run_thread_per_state(outer_states, blackboard);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          state.range(0));
+}
+BENCHMARK(BM_NestedConcurrenceThreadPerState)->DenseRange(2, 8, 2);
+
+static void BM_NestedConcurrenceThreadPool(benchmark::State &state) {
+  set_log_level(ERROR);
+  std::map<std::string, std::shared_ptr<State>> outer_states;
+
+  for (int i = 0; i < state.range(0); ++i) {
+    outer_states.insert({"INNER" + std::to_string(i),
+                         create_concurrence(create_states(state.range(0)))});
+  }
+
+  auto concurrence = create_concurrence(outer_states);
+  auto blackboard = std::make_shared<blackboard::Blackboard>();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize((*concurrence)(blackboard));
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          state.range(0));
+}
+BENCHMARK(BM_NestedConcurrenceThreadPool)->DenseRange(2, 8, 2);
+
+static void BM_ConcurrenceWrites(benchmark::State &state) {
+  set_log_level(ERROR);
+  std::map<std::string, std::shared_ptr<State>> states;
+
+  for (int i = 0; i < 8; ++i) {
+    std::string prefix = "state" + std::to_string(i) + "_";
+    states.insert({"STATE" + std::to_string(i),
+                   std::make_shared<CbState>(
+                       std::set<std::string>{"done"},
+                       [prefix](
+                           std::shared_ptr<blackboard::Blackboard> blackboard) {
+                         for (int j = 0; j < 100; ++j) {
+                           blackboard->set<int>(prefix + std::to_string(j), j);
+                         }
+                         return "done";
+                       })});
+  }
+
+  Concurrence concurrence(
+      states, "default", {}, Concurrence::JoinPolicy::ALL_COMPLETED, 0, "",
+      static_cast<Concurrence::ConflictPolicy>(state.range(0)));
+
+  // Values that are shared with the forks
+  auto blackboard = std::make_shared<blackboard::Blackboard>();
+  for (int i = 0; i < 64; ++i) {
+    blackboard->set<std::string>("key" + std::to_string(i), "value");
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(concurrence(blackboard));
+  }
+
+  state.SetItemsProcessed(state.iterations() * 8 * 100);
+}
+BENCHMARK(BM_ConcurrenceWrites)
+    ->Arg(static_cast<int>(Concurrence::ConflictPolicy::SHARED))
+    ->Arg(static_cast<int>(Concurrence::ConflictPolicy::LAST_WINS));
@@ -0,0 +1,125 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <benchmark/benchmark.h>
+#include <pybind11/embed.h>
+
+#include "yasmin/logs.hpp"
+
+namespace py = pybind11;
+
+namespace {
+
+/// Python states, callbacks and state machines of the benchmarks
+constexpr const char *PYTHON_STATES = R"(
+from yasmin import StateMachine, State, CbState
+
+
+class NextState(State):
+    def __init__(self):
+        super().__init__(["next"])
+
+    def execute(self, blackboard):
+        return "next"
+
+
+def next_cb(blackboard):
+    return "next"
+
+
+def transition_cb(blackboard, from_state, to_state, outcome, args):
+    pass
+
+
+def noop():
+    pass
+
+
+def create_state_machine(num_states, kind):
+    sm = StateMachine(outcomes=["done"])
+
+    for i in range(num_states):
+        target = f"STATE{i + 1}" if i + 1 < num_states else "done"
+        state = CbState(["next"], next_cb) if kind == 1 else NextState()
+        sm.add_state(f"STATE{i}", state, transitions={"next": target})
+
+    if kind == 2:
+        sm.add_transition_cb(transition_cb)
+
+    return sm
+)";
+
+/// Kinds of Python state machines, matching create_state_machine
+enum PythonStateKind { STATE = 0, CB_STATE = 1, TRANSITION_CB = 2 };
+
+/**
+ * @brief Starts the Python interpreter, once for all the benchmarks, and
+ * loads the Python states.
+ * @return The namespace of the Python states.
+ * @throws py::error_already_set If yasmin cannot be imported.
+ */
+py::dict get_python_states() {
+  static py::scoped_interpreter interpreter;
+
+  py::dict scope;
+  py::exec(PYTHON_STATES, scope);
+  return scope;
+}
+
+} // namespace
+
+static void BM_PythonCall(benchmark::State &state) {
+  yasmin::set_log_level(yasmin::ERROR);
+
+  // Cost of a call to Python without yasmin, as a baseline
+  try {
+    py::object noop = get_python_states()["noop"];
+
+    for (auto _ : state) {
+      noop();
+    }
+
+  } catch (const py::error_already_set &e) {
+    state.SkipWithError(e.what());
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PythonCall);
+
+static void BM_PythonStateMachine(benchmark::State &state) {
+  yasmin::set_log_level(yasmin::ERROR);
+
+  // The state machine releases the GIL and each Python state or callback
+  // acquires it again, as in a Python mission
+  try {
+    py::object sm = get_python_states()["create_state_machine"](
+        state.range(0), state.range(1));
+
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(sm());
+    }
+
+  } catch (const py::error_already_set &e) {
+    state.SkipWithError(e.what());
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetLabel("items are transitions");
+}
+BENCHMARK(BM_PythonStateMachine)
+    ->ArgNames({"states", "kind"})
+    ->ArgsProduct({{1, 64}, {PythonStateKind::STATE, PythonStateKind::CB_STATE,
+                             PythonStateKind::TRANSITION_CB}});
@@ -0,0 +1,225 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <benchmark/benchmark.h>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/cb_state.hpp"
+#include "yasmin/logs.hpp"
+#include "yasmin/state.hpp"
+#include "yasmin/state_machine.hpp"
+#include "yasmin/state_machine_instance.hpp"
+
+using namespace yasmin;
+
+namespace {
+
+std::shared_ptr<State> create_state() {
+  return std::make_shared<CbState>(
+      std::set<std::string>{"next"},
+      [](std::shared_ptr<blackboard::Blackboard> blackboard) {
+        (void)blackboard;
+        return "next";
+      });
+}
+
+/// Creates a state machine that runs its states one after the other
+std::shared_ptr<StateMachine> create_flat_state_machine(int num_states) {
+  auto sm = std::make_shared<StateMachine>(std::set<std::string>{"done"});
+
+  for (int i = 0; i < num_states; ++i) {
+    std::string target =
+        i + 1 < num_states ? "STATE" + std::to_string(i + 1) : "done";
+    sm->add_state("STATE" + std::to_string(i), create_state(),
+                  {{"next", target}});
+  }
+
+  return sm;
+}
+
+/// Creates state machines nested in each other, each one running a state
+/// before its nested state machine
+std::shared_ptr<StateMachine> create_nested_state_machine(int depth) {
+  auto sm = std::make_shared<StateMachine>(std::set<std::string>{"done"});
+
+  if (depth <= 1) {
+    sm->add_state("STATE", create_state(), {{"next", "done"}});
+    return sm;
+  }
+
+  sm->add_state("STATE", create_state(), {{"next", "NESTED"}});
+  sm->add_state("NESTED", create_nested_state_machine(depth - 1),
+                {{"done", "done"}});
+  return sm;
+}
+
+/// Creates a state machine whose states read and write the blackboard,
+/// with their keys remapped or not
+std::shared_ptr<StateMachine> create_blackboard_state_machine(int num_states,
+                                                              bool remapped) {
+  auto sm = std::make_shared<StateMachine>(std::set<std::string>{"done"});
+
+  for (int i = 0; i < num_states; ++i) {
+    std::string target =
+        i + 1 < num_states ? "STATE" + std::to_string(i + 1) : "done";
+    std::map<std::string, std::string> remappings;
+
+    if (remapped) {
+      remappings = {{"input", "input_" + std::to_string(i)},
+                    {"output", "output_" + std::to_string(i)}};
+    }
+
+    sm->add_state(
+        "STATE" + std::to_string(i),
+        std::make_shared<CbState>(
+            std::set<std::string>{"next"},
+            [](std::shared_ptr<blackboard::Blackboard> blackboard) {
+              blackboard->set<int>("output", blackboard->get<int>("input"));
+              return "next";
+            }),
+        {{"next", target}}, remappings);
+  }
+
+  return sm;
+}
+
+} // namespace
+
+static void BM_StateMachineFlat(benchmark::State &state) {
+  set_log_level(ERROR);
+  auto sm = create_flat_state_machine(state.range(0));
+  auto blackboard = std::make_shared<blackboard::Blackboard>();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sm->execute(blackboard));
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StateMachineFlat)->RangeMultiplier(8)->Range(1, 512);
+
+static void BM_StateMachineInstance(benchmark::State &state) {
+  set_log_level(ERROR);
+  auto sm = create_flat_state_machine(state.range(0));
+  auto blackboard = std::make_shared<blackboard::Blackboard>();
+
+  // A new instance for each execution, as concurrent missions do
+  for (auto _ : state) {
+    StateMachineInstance instance(sm, blackboard);
+    benchmark::DoNotOptimize(instance.execute());
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StateMachineInstance)->RangeMultiplier(8)->Range(1, 512);
+
+static void BM_StateMachineNested(benchmark::State &state) {
+  set_log_level(ERROR);
+  auto sm = create_nested_state_machine(state.range(0));
+  auto blackboard = std::make_shared<blackboard::Blackboard>();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sm->execute(blackboard));
+  }
+
+  // Each level runs a state and its nested state machine
+  state.SetItemsProcessed(state.iterations() * (2 * state.range(0) - 1));
+}
+BENCHMARK(BM_StateMachineNested)->RangeMultiplier(2)->Range(1, 32);
+
+static void BM_StateMachineRemapping(benchmark::State &state) {
+  set_log_level(ERROR);
+  constexpr int NUM_STATES = 16;
+  const bool remapped = state.range(0) != 0;
+
+  auto sm = create_blackboard_state_machine(NUM_STATES, remapped);
+  auto blackboard = std::make_shared<blackboard::Blackboard>();
+  blackboard->set<int>("input", 0);
+
+  for (int i = 0; i < NUM_STATES; ++i) {
+    blackboard->set<int>("input_" + std::to_string(i), i);
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sm->execute(blackboard));
+  }
+
+  state.SetItemsProcessed(state.iterations() * NUM_STATES);
+}
+BENCHMARK(BM_StateMachineRemapping)->ArgName("remapped")->Arg(0)->Arg(1);
+
+static void BM_StateMachineInstanceRemapping(benchmark::State &state) {
+  set_log_level(ERROR);
+  constexpr int NUM_STATES = 16;
+  const bool remapped = state.range(0) != 0;
+
+  auto sm = create_blackboard_state_machine(NUM_STATES, remapped);
+  auto blackboard = std::make_shared<blackboard::Blackboard>();
+  blackboard->set<int>("input", 0);
+
+  for (int i = 0; i < NUM_STATES; ++i) {
+    blackboard->set<int>("input_" + std::to_string(i), i);
+  }
+
+  // The instance keeps the views of the states across its runs
+  StateMachineInstance instance(sm, blackboard);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(instance.execute());
+  }
+
+  state.SetItemsProcessed(state.iterations() * NUM_STATES);
+}
+BENCHMARK(BM_StateMachineInstanceRemapping)
+    ->ArgName("remapped")
+    ->Arg(0)
+    ->Arg(1);
+
+static void BM_StateMachineValidate(benchmark::State &state) {
+  set_log_level(ERROR);
+  auto sm = create_flat_state_machine(state.range(0));
+
+  // Strict validation is never cached, so each call checks every state
+  for (auto _ : state) {
+    sm->validate(true);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_StateMachineValidate)
+    ->RangeMultiplier(4)
+    ->Range(4, 4096)
+    ->Complexity();
+
+static void BM_StateMachineValidateNested(benchmark::State &state) {
+  set_log_level(ERROR);
+  auto sm = create_nested_state_machine(state.range(0));
+
+  for (auto _ : state) {
+    sm->validate(true);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_StateMachineValidateNested)
+    ->RangeMultiplier(2)
+    ->Range(1, 64)
+    ->Complexity();
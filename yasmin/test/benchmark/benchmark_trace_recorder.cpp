@@ -0,0 +1,70 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <benchmark/benchmark.h>
+#include <thread>
+
+#include "yasmin/trace_recorder.hpp"
+
+using namespace yasmin;
+
+static void BM_TraceScope(benchmark::State &state) {
+  TraceOptions options;
+  options.events_per_thread = 1 << 16;
+
+  if (state.range(0)) {
+    TraceRecorder::start(options);
+  }
+
+  std::size_t events = 0;
+  for (auto _ : state) {
+    TraceScope scope(TraceRecorder::STATE_EVENT, "state");
+
+    // Restart before the buffer is full, so no event is dropped
+    events += 2;
+    if (state.range(0) && events >= options.events_per_thread) {
+      TraceRecorder::start(options);
+      events = 0;
+    }
+  }
+
+  TraceRecorder::stop();
+  TraceRecorder::clear();
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TraceScope)->Arg(0)->Arg(1);
+
+static void BM_TraceShortThreads(benchmark::State &state) {
+  TraceRecorder::start();
+
+  for (auto _ : state) {
+    std::thread thread([&state]() {
+      for (int i = 0; i < state.range(0); ++i) {
+        TraceScope scope(TraceRecorder::STATE_EVENT, "state");
+      }
+    });
+    thread.join();
+
+    // Each finished thread keeps its events until they are cleared
+    state.PauseTiming();
+    TraceRecorder::clear();
+    state.ResumeTiming();
+  }
+
+  TraceRecorder::stop();
+  TraceRecorder::clear();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TraceShortThreads)->Arg(1)->Arg(1024);
@@ -13,13 +13,44 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <typeindex>
+#include <vector>
 
 #include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/blackboard/blackboard_snapshot.hpp"
+#include "yasmin/blackboard/blackboard_transaction.hpp"
+#include "yasmin/blackboard/serializer_registry.hpp"
+#include "yasmin/blackboard/shared_memory_segment.hpp"
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace yasmin::blackboard;
 
+/// Value that counts its live instances
+struct CountedValue {
+  static int instances;
+  int value;
+
+  CountedValue(int value = 0) : value(value) { instances++; }
+  CountedValue(const CountedValue &other) : value(other.value) { instances++; }
+  CountedValue &operator=(const CountedValue &other) = default;
+  ~CountedValue() { instances--; }
+};
+
+int CountedValue::instances = 0;
+
 class TestBlackboard : public ::testing::Test {
 protected:
   Blackboard blackboard;
@@ -53,12 +84,778 @@ TEST_F(TestBlackboard, TestType) {
   EXPECT_EQ(blackboard.get_type("foo"), "int");
 }
 
+TEST_F(TestBlackboard, TestTypeIndex) {
+  blackboard.set<std::vector<int>>("foo", {1, 2});
+  EXPECT_EQ(blackboard.get_type_index("foo"),
+            std::type_index(typeid(std::vector<int>)));
+  EXPECT_EQ(blackboard.get_type("foo"),
+            TypeRegistry::get_name(typeid(std::vector<int>)));
+  EXPECT_EQ(&TypeRegistry::get_name(typeid(std::vector<int>)),
+            &TypeRegistry::get_name(typeid(std::vector<int>)));
+  EXPECT_THROW(blackboard.get_type_index("bar"), std::runtime_error);
+}
+
 TEST_F(TestBlackboard, TestRemappings) {
   blackboard.set<std::string>("bar", "foo");
   blackboard.set_remappings({{"foo", "bar"}});
   EXPECT_EQ(blackboard.get<std::string>("bar"), "foo");
 }
 
+TEST_F(TestBlackboard, TestKey) {
+  BlackboardKey<int> key = blackboard.get_key<int>("foo");
+  EXPECT_TRUE(key.is_valid());
+  EXPECT_FALSE(blackboard.contains(key));
+
+  blackboard.set(key, 10);
+  EXPECT_TRUE(blackboard.contains("foo"));
+  EXPECT_EQ(blackboard.get(key), 10);
+
+  blackboard.set<int>("foo", 20);
+  EXPECT_EQ(blackboard.get(key), 20);
+
+  blackboard.remove("foo");
+  EXPECT_FALSE(blackboard.contains(key));
+  EXPECT_THROW(blackboard.get(key), std::runtime_error);
+}
+
+TEST_F(TestBlackboard, TestKeyType) {
+  blackboard.set<std::string>("foo", "foo");
+  BlackboardKey<int> key = blackboard.get_key<int>("foo");
+  EXPECT_THROW(blackboard.get(key), std::runtime_error);
+  EXPECT_THROW(blackboard.get<int>("foo"), std::runtime_error);
+}
+
+TEST_F(TestBlackboard, TestKeyRemappings) {
+  blackboard.set<std::string>("bar", "foo");
+  blackboard.set_remappings({{"foo", "bar"}});
+  BlackboardKey<std::string> key = blackboard.get_key<std::string>("foo");
+  blackboard.set_remappings({});
+
+  EXPECT_EQ(key.get_name(), "bar");
+  EXPECT_EQ(blackboard.get(key), "foo");
+}
+
+TEST_F(TestBlackboard, TestKeyOtherBlackboard) {
+  Blackboard other;
+  BlackboardKey<int> key = other.get_key<int>("foo");
+  EXPECT_THROW(blackboard.set(key, 10), std::invalid_argument);
+}
+
+TEST_F(TestBlackboard, TestOverwrite) {
+  for (int i = 0; i < 100; ++i) {
+    blackboard.set<CountedValue>("foo", CountedValue(i));
+  }
+
+  EXPECT_EQ(CountedValue::instances, 1);
+  EXPECT_EQ(blackboard.get<CountedValue>("foo").value, 99);
+
+  // A type change frees the old value
+  blackboard.set<int>("foo", 10);
+  EXPECT_EQ(CountedValue::instances, 0);
+  EXPECT_EQ(blackboard.get_type("foo"), "int");
+  EXPECT_EQ(blackboard.size(), 1);
+
+  blackboard.set<CountedValue>("foo", CountedValue(1));
+  blackboard.remove("foo");
+  EXPECT_EQ(CountedValue::instances, 0);
+}
+
+TEST_F(TestBlackboard, TestGetShared) {
+  std::vector<int> values(1000, 1);
+  const int *data = values.data();
+
+  // The buffer is moved in and read without copies
+  blackboard.set<std::vector<int>>("foo", std::move(values));
+  std::shared_ptr<const std::vector<int>> snapshot =
+      blackboard.get_shared<std::vector<int>>("foo");
+  EXPECT_EQ(snapshot->data(), data);
+
+  // Writes do not modify the snapshot
+  blackboard.set<std::vector<int>>("foo", std::vector<int>(1000, 2));
+  EXPECT_EQ(snapshot->at(0), 1);
+  EXPECT_EQ(blackboard.get<std::vector<int>>("foo").at(0), 2);
+
+  blackboard.remove("foo");
+  EXPECT_EQ(snapshot->size(), 1000);
+}
+
+TEST_F(TestBlackboard, TestInlineValue) {
+  EXPECT_TRUE(BlackboardValue<int>::IS_INLINE);
+  EXPECT_TRUE(BlackboardValue<double>::IS_INLINE);
+  EXPECT_FALSE(BlackboardValue<std::string>::IS_INLINE);
+
+  // Short strings are overwritten in place in their buffer
+  blackboard.set<std::string>("bar", "bar");
+  std::shared_ptr<const std::string> buffer =
+      blackboard.get_shared<std::string>("bar");
+  const std::string *address = buffer.get();
+  buffer.reset();
+  blackboard.set<std::string>("bar", "baz");
+  EXPECT_EQ(blackboard.get_shared<std::string>("bar").get(), address);
+  blackboard.remove("bar");
+
+  blackboard.set<int>("foo", 1);
+  std::shared_ptr<const int> snapshot = blackboard.get_shared<int>("foo");
+  blackboard.set<int>("foo", 2);
+
+  EXPECT_EQ(*snapshot, 1);
+  EXPECT_EQ(blackboard.get<int>("foo"), 2);
+
+  // Change between an inline value and a value in a buffer
+  blackboard.set<std::string>("foo", "foo");
+  EXPECT_EQ(blackboard.get<std::string>("foo"), "foo");
+  blackboard.set<bool>("foo", true);
+  EXPECT_TRUE(blackboard.get<bool>("foo"));
+}
+
+TEST_F(TestBlackboard, TestKeyGetShared) {
+  BlackboardKey<std::string> key = blackboard.get_key<std::string>("foo");
+  blackboard.set(key, std::string("foo"));
+  EXPECT_EQ(*blackboard.get_shared(key), "foo");
+}
+
+TEST_F(TestBlackboard, TestConcurrentAccess) {
+  blackboard.set<int>("foo", 0);
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([this, i]() {
+      for (int j = 0; j < 1000; ++j) {
+        if (i == 0) {
+          blackboard.set<int>("foo", j);
+        } else {
+          EXPECT_GE(blackboard.get<int>("foo"), 0);
+          EXPECT_TRUE(blackboard.contains("foo"));
+        }
+      }
+    });
+  }
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(blackboard.get<int>("foo"), 999);
+}
+
+TEST_F(TestBlackboard, TestVersion) {
+  EXPECT_EQ(blackboard.get_version("foo"), 0);
+
+  blackboard.set<int>("foo", 1);
+  blackboard.set<int>("foo", 2);
+  EXPECT_EQ(blackboard.get_version("foo"), 2);
+
+  // The entry of a removed key is erased, and its versions are not reused
+  blackboard.remove("foo");
+  EXPECT_EQ(blackboard.get_version("foo"), 0);
+  blackboard.set<int>("foo", 3);
+  EXPECT_EQ(blackboard.get_version("foo"), 4);
+
+  // The entry of a key handle is kept
+  BlackboardKey<int> key = blackboard.get_key<int>("foo");
+  blackboard.remove("foo");
+  EXPECT_EQ(blackboard.get_version("foo"), 5);
+  EXPECT_FALSE(blackboard.contains(key));
+  blackboard.set(key, 4);
+  EXPECT_EQ(blackboard.get_version("foo"), 6);
+}
+
+TEST_F(TestBlackboard, TestWaitForChange) {
+  blackboard.set<int>("foo", 0);
+  std::uint64_t version = blackboard.get_version("foo");
+
+  EXPECT_FALSE(blackboard.wait_for_change("foo", version,
+                                          std::chrono::milliseconds(10)));
+
+  std::thread writer([this]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    blackboard.set<int>("foo", 1);
+  });
+
+  EXPECT_TRUE(blackboard.wait_for_change("foo", version,
+                                         std::chrono::seconds(5)));
+  EXPECT_EQ(blackboard.get<int>("foo"), 1);
+  writer.join();
+
+  // Changes made before waiting are not missed
+  EXPECT_TRUE(blackboard.wait_for_change("foo", version,
+                                         std::chrono::milliseconds(0)));
+}
+
+TEST_F(TestBlackboard, TestWaitForChangeInFork) {
+  auto base = std::make_shared<Blackboard>();
+  base->set<int>("foo", 0);
+  std::shared_ptr<Blackboard> fork = base->fork();
+  std::shared_ptr<Blackboard> nested_fork = fork->fork();
+  std::uint64_t version = nested_fork->get_version("foo");
+
+  // The writes to the bases wake up the threads waiting in the forks
+  std::thread writer([&base]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    base->set<int>("foo", 1);
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(nested_fork->wait_for_change("foo", version,
+                                           std::chrono::seconds(5)));
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+            std::chrono::seconds(1));
+  EXPECT_EQ(nested_fork->get<int>("foo"), 1);
+  writer.join();
+}
+
+TEST_F(TestBlackboard, TestWatch) {
+  std::vector<std::string> changes;
+  std::size_t id = blackboard.add_watch(
+      "foo", [&changes](const std::string &key) { changes.push_back(key); });
+
+  blackboard.set<int>("foo", 1);
+  blackboard.set<int>("bar", 1);
+  blackboard.remove("foo");
+  EXPECT_EQ(changes, (std::vector<std::string>{"foo", "foo"}));
+
+  EXPECT_TRUE(blackboard.remove_watch(id));
+  EXPECT_FALSE(blackboard.remove_watch(id));
+  blackboard.set<int>("foo", 2);
+  EXPECT_EQ(changes.size(), 2);
+}
+
+TEST_F(TestBlackboard, TestWatchCallback) {
+  std::atomic<int> value{0};
+
+  // Callbacks run without the lock, so they can use the blackboard
+  std::size_t id = blackboard.add_watch("foo", [&](const std::string &key) {
+    value.store(blackboard.get<int>(key));
+  });
+
+  blackboard.set<int>("foo", 10);
+  EXPECT_EQ(value.load(), 10);
+  blackboard.remove_watch(id);
+}
+
+TEST_F(TestBlackboard, TestSetGetMany) {
+  blackboard.set_remappings({{"foo", "baz"}});
+  blackboard.set_many<int>({{"foo", 1}, {"bar", 2}});
+  EXPECT_EQ(blackboard.get_many<int>({"bar", "foo"}),
+            (std::vector<int>{2, 1}));
+  EXPECT_TRUE(blackboard.contains("baz"));
+  EXPECT_THROW(blackboard.get_many<int>({"foo", "qux"}), std::runtime_error);
+
+  BlackboardKey<int> int_key = blackboard.get_key<int>("foo");
+  BlackboardKey<std::string> string_key =
+      blackboard.get_key<std::string>("qux");
+  blackboard.set<std::string>("qux", "qux");
+  EXPECT_EQ(blackboard.get_many(int_key, string_key),
+            std::make_tuple(1, std::string("qux")));
+}
+
+TEST_F(TestBlackboard, TestTransaction) {
+  blackboard.set<int>("foo", 1);
+  std::vector<std::string> changes;
+  blackboard.add_watch(
+      "foo", [&changes](const std::string &key) { changes.push_back(key); });
+
+  {
+    BlackboardTransaction transaction(blackboard);
+    transaction.set<int>("foo", transaction.get<int>("foo") + 1);
+    transaction.set<int>("foo", transaction.get<int>("foo") + 1);
+    transaction.set<std::string>("bar", "bar");
+    transaction.remove("bar");
+    EXPECT_FALSE(transaction.contains("bar"));
+
+    // The watches are called once after the commit
+    EXPECT_TRUE(changes.empty());
+  }
+
+  EXPECT_EQ(changes, (std::vector<std::string>{"foo"}));
+  EXPECT_EQ(blackboard.get<int>("foo"), 3);
+  EXPECT_FALSE(blackboard.contains("bar"));
+
+  BlackboardTransaction transaction(blackboard);
+  transaction.commit();
+  EXPECT_THROW(transaction.set<int>("foo", 1), std::logic_error);
+  EXPECT_THROW(transaction.commit(), std::logic_error);
+}
+
+TEST_F(TestBlackboard, TestTransactionConsistency) {
+  blackboard.set_many<int>({{"foo", 0}, {"bar", 0}});
+  std::atomic<bool> running{true};
+
+  std::thread writer([this, &running]() {
+    for (int i = 1; running.load(); ++i) {
+      BlackboardTransaction transaction(blackboard);
+      transaction.set<int>("foo", i);
+      transaction.set<int>("bar", i);
+    }
+  });
+
+  // Readers never see a group of keys half-written
+  for (int i = 0; i < 1000; ++i) {
+    std::vector<int> values = blackboard.get_many<int>({"foo", "bar"});
+    EXPECT_EQ(values[0], values[1]);
+  }
+
+  running.store(false);
+  writer.join();
+}
+
+TEST_F(TestBlackboard, TestMemoryUsage) {
+  blackboard.set<int>("int", 1);
+  blackboard.set<std::vector<double>>("vector", std::vector<double>(100));
+  EXPECT_EQ(blackboard.get_memory_usage("int"), sizeof(int));
+  EXPECT_GE(blackboard.get_memory_usage("vector"), 100 * sizeof(double));
+  EXPECT_EQ(blackboard.get_memory_usage("missing"), 0);
+  EXPECT_EQ(blackboard.get_memory_usage(),
+            blackboard.get_memory_usage("int") +
+                blackboard.get_memory_usage("vector"));
+
+  blackboard.remove("vector");
+  EXPECT_EQ(blackboard.get_memory_usage(), sizeof(int));
+  EXPECT_NE(blackboard.to_string().find("4 bytes"), std::string::npos);
+}
+
+TEST_F(TestBlackboard, TestMemoryBudget) {
+  const std::vector<double> values(100);
+  const std::size_t size = BlackboardValueSize<std::vector<double>>::get(values);
+  blackboard.set_memory_budget(2 * size);
+
+  std::vector<std::string> changes;
+  blackboard.add_watch("a", [&changes](const std::string &key) {
+    changes.push_back(key);
+  });
+
+  blackboard.set("a", values);
+  blackboard.set("b", values);
+  blackboard.get<std::vector<double>>("a");
+
+  // The least recently used value is evicted
+  blackboard.set("c", values);
+  EXPECT_TRUE(blackboard.contains("a"));
+  EXPECT_FALSE(blackboard.contains("b"));
+  EXPECT_TRUE(blackboard.contains("c"));
+  EXPECT_LE(blackboard.get_memory_usage(), 2 * size);
+
+  blackboard.set_memory_budget(size);
+  EXPECT_FALSE(blackboard.contains("a"));
+  EXPECT_EQ(blackboard.size(), 1);
+  // The watch is called when the key is set and when it is evicted
+  EXPECT_EQ(changes, (std::vector<std::string>{"a", "a"}));
+}
+
+TEST_F(TestBlackboard, TestTtl) {
+  blackboard.set_ttl("pose", std::chrono::milliseconds(20));
+  blackboard.set<int>("pose", 1);
+  blackboard.set<int>("other", 1);
+  EXPECT_TRUE(blackboard.contains("pose"));
+  EXPECT_FALSE(blackboard.is_stale("pose"));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  EXPECT_FALSE(blackboard.contains("pose"));
+  EXPECT_TRUE(blackboard.is_stale("pose"));
+  EXPECT_FALSE(blackboard.is_stale("missing"));
+  EXPECT_THROW(blackboard.get<int>("pose"), std::runtime_error);
+  EXPECT_EQ(blackboard.size(), 1);
+
+  // A new value is fresh again
+  blackboard.set<int>("pose", 2);
+  EXPECT_EQ(blackboard.get<int>("pose"), 2);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  EXPECT_EQ(blackboard.purge_stale(), 1);
+  EXPECT_FALSE(blackboard.is_stale("pose"));
+  EXPECT_EQ(blackboard.get_memory_usage(), sizeof(int));
+
+  blackboard.set_ttl("pose", std::chrono::nanoseconds(0));
+  blackboard.set<int>("pose", 3);
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  EXPECT_TRUE(blackboard.contains("pose"));
+}
+
+TEST(TestBlackboardView, TestView) {
+  auto blackboard = std::make_shared<Blackboard>();
+  auto view = std::make_shared<BlackboardView>(
+      blackboard, std::map<std::string, std::string>{{"foo", "bar"}});
+  auto nested_view = std::make_shared<BlackboardView>(
+      view, std::map<std::string, std::string>{{"baz", "foo"}});
+
+  view->set<std::string>("foo", "foo");
+  EXPECT_EQ(blackboard->get<std::string>("bar"), "foo");
+  EXPECT_EQ(nested_view->get<std::string>("baz"), "foo");
+  EXPECT_EQ(nested_view->size(), 1);
+  EXPECT_TRUE(blackboard->get_remappings().empty());
+
+  // Key handles can be used with every blackboard sharing the storage
+  BlackboardKey<std::string> key = nested_view->get_key<std::string>("baz");
+  EXPECT_EQ(key.get_name(), "bar");
+  EXPECT_EQ(blackboard->get(key), "foo");
+}
+
+TEST_F(TestBlackboard, TestCopy) {
+  blackboard.set<std::string>("foo", "foo");
+  Blackboard copy(blackboard);
+  blackboard.set<std::string>("foo", "bar");
+
+  EXPECT_EQ(copy.size(), 1);
+  EXPECT_EQ(copy.get<std::string>("foo"), "foo");
+}
+
+TEST(TestBlackboardFork, TestFork) {
+  auto blackboard = std::make_shared<Blackboard>();
+  blackboard->set<std::string>("foo", "foo");
+  blackboard->set<int>("bar", 1);
+  BlackboardKey<std::string> key = blackboard->get_key<std::string>("foo");
+
+  auto fork = blackboard->fork();
+  EXPECT_EQ(fork->size(), 2);
+  EXPECT_EQ(fork->get_shared<std::string>("foo"),
+            blackboard->get_shared<std::string>("foo"));
+  EXPECT_TRUE(fork->get_changes().empty());
+
+  fork->set<std::string>("foo", "bar");
+  fork->remove("bar");
+  fork->set<int>("baz", 2);
+  EXPECT_EQ(blackboard->get<std::string>("foo"), "foo");
+  EXPECT_TRUE(blackboard->contains("bar"));
+  EXPECT_FALSE(blackboard->contains("baz"));
+
+  std::vector<std::string> changes = fork->get_changes();
+  EXPECT_EQ(changes, (std::vector<std::string>{"bar", "baz", "foo"}));
+
+  blackboard->merge(*fork, changes);
+  EXPECT_EQ(blackboard->size(), 2);
+  EXPECT_EQ(blackboard->get(key), "bar");
+  EXPECT_FALSE(blackboard->contains("bar"));
+  EXPECT_EQ(blackboard->get<int>("baz"), 2);
+
+  // Writing a merged value does not change the fork
+  blackboard->set<std::string>("foo", "baz");
+  EXPECT_EQ(fork->get<std::string>("foo"), "bar");
+
+  EXPECT_THROW(fork->merge(*blackboard, changes), std::invalid_argument);
+}
+
+TEST(TestBlackboardFork, TestForkKey) {
+  auto blackboard = std::make_shared<Blackboard>();
+  blackboard->set<int>("foo", 1);
+  BlackboardKey<int> key = blackboard->get_key<int>("foo");
+  BlackboardKey<int> missing = blackboard->get_key<int>("bar");
+
+  // The keys of the base read through the fork until it changes them
+  auto fork = blackboard->fork();
+  EXPECT_EQ(fork->get(key), 1);
+  EXPECT_FALSE(fork->contains(missing));
+
+  fork->set(key, 2);
+  fork->set(missing, 3);
+  EXPECT_EQ(fork->get(key), 2);
+  EXPECT_EQ(*fork->get_shared(missing), 3);
+  EXPECT_EQ(blackboard->get(key), 1);
+  EXPECT_FALSE(blackboard->contains(missing));
+
+  // The keys of a fork do not belong to its base
+  BlackboardKey<int> fork_key = fork->get_key<int>("foo");
+  EXPECT_THROW(blackboard->get(fork_key), std::invalid_argument);
+
+  blackboard->merge(*fork, fork->get_changes());
+  EXPECT_EQ(blackboard->get(key), 2);
+  EXPECT_EQ(blackboard->get(missing), 3);
+}
+
+TEST(TestBlackboardFork, TestForkVersion) {
+  auto blackboard = std::make_shared<Blackboard>();
+  blackboard->set<int>("foo", 1);
+
+  auto fork = blackboard->fork();
+  std::uint64_t version = fork->get_version("foo");
+  EXPECT_EQ(version, 1);
+
+  fork->set<int>("foo", 2);
+  EXPECT_GT(fork->get_version("foo"), version);
+
+  // Changes of the fork are notified when it is merged
+  std::vector<std::string> changes;
+  blackboard->add_watch(
+      "foo", [&changes](const std::string &key) { changes.push_back(key); });
+  EXPECT_TRUE(changes.empty());
+
+  blackboard->merge(*fork, fork->get_changes());
+  EXPECT_EQ(changes, (std::vector<std::string>{"foo"}));
+  EXPECT_EQ(blackboard->get_version("foo"), 2);
+}
+
+TEST(TestBlackboardFork, TestForkTtl) {
+  auto blackboard = std::make_shared<Blackboard>();
+  blackboard->set_ttl("pose", std::chrono::milliseconds(20));
+
+  // The time to live of the base applies to the merged values
+  auto fork = blackboard->fork();
+  fork->set<int>("pose", 1);
+  blackboard->merge(*fork, fork->get_changes());
+  EXPECT_TRUE(blackboard->contains("pose"));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  EXPECT_TRUE(blackboard->is_stale("pose"));
+  EXPECT_EQ(blackboard->purge_stale(), 1);
+}
+
+TEST(TestBlackboardFork, TestForkView) {
+  auto blackboard = std::make_shared<Blackboard>();
+  auto view = std::make_shared<BlackboardView>(
+      blackboard, std::map<std::string, std::string>{{"foo", "bar"}});
+
+  auto fork = view->fork();
+  fork->set<std::string>("foo", "foo");
+  EXPECT_EQ(fork->get_changes(), (std::vector<std::string>{"bar"}));
+
+  view->merge(*fork, fork->get_changes());
+  EXPECT_EQ(blackboard->get<std::string>("bar"), "foo");
+}
+
+/// Value with a serializer registered by the tests
+struct Point {
+  double x;
+  double y;
+};
+
+TEST(TestBlackboardSnapshot, TestSaveRestore) {
+  const std::string path = ::testing::TempDir() + "test_snapshot.bin";
+  SerializerRegistry::register_serializer(
+      typeid(Point), SerializerRegistry::make_trivial_serializer<Point>(
+                         "test/Point"));
+
+  Blackboard blackboard;
+  blackboard.set<bool>("bool", true);
+  blackboard.set<int>("int", -1);
+  blackboard.set<double>("double", 0.5);
+  blackboard.set<std::string>("string", "foo");
+  blackboard.set<std::vector<double>>("vector", {1.0, 2.0});
+  blackboard.set<std::vector<bool>>("bools", {true, false, true});
+  blackboard.set<std::vector<std::string>>("strings", {"foo", "", "bar"});
+  blackboard.set<Point>("point", {1.0, 2.0});
+  blackboard.set<CountedValue>("counted", CountedValue(1));
+  BlackboardSnapshot::save(blackboard, path);
+
+  Blackboard restored;
+  restored.set<int>("other", 1);
+  EXPECT_EQ(BlackboardSnapshot::restore(restored, path), 8);
+
+  // Values without serializer are skipped
+  EXPECT_FALSE(restored.contains("counted"));
+  EXPECT_EQ(restored.size(), 9);
+  EXPECT_TRUE(restored.get<bool>("bool"));
+  EXPECT_EQ(restored.get<int>("int"), -1);
+  EXPECT_EQ(restored.get<double>("double"), 0.5);
+  EXPECT_EQ(restored.get<std::string>("string"), "foo");
+  EXPECT_EQ(restored.get<std::vector<double>>("vector"),
+            (std::vector<double>{1.0, 2.0}));
+  EXPECT_EQ(restored.get<std::vector<bool>>("bools"),
+            (std::vector<bool>{true, false, true}));
+  EXPECT_EQ(restored.get<std::vector<std::string>>("strings"),
+            (std::vector<std::string>{"foo", "", "bar"}));
+  EXPECT_EQ(restored.get<Point>("point").y, 2.0);
+
+  std::remove(path.c_str());
+  EXPECT_THROW(BlackboardSnapshot::restore(restored, path),
+               std::runtime_error);
+}
+
+TEST(TestBlackboardSnapshot, TestIncremental) {
+  const std::string path = ::testing::TempDir() + "test_incremental.bin";
+  Blackboard blackboard;
+  blackboard.set<int>("foo", 1);
+  blackboard.set<int>("bar", 1);
+  blackboard.set<std::string>("baz", "baz");
+
+  BlackboardSnapshot snapshot(blackboard, path);
+  EXPECT_EQ(snapshot.write(), 3);
+  EXPECT_EQ(snapshot.write(), 0);
+
+  // Only the changes are appended
+  blackboard.set<int>("foo", 2);
+  blackboard.remove("bar");
+  EXPECT_EQ(snapshot.write(), 2);
+
+  // A record cut by a crash is ignored
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    file.write("\x03\x00\x00", 3);
+  }
+
+  Blackboard restored;
+  restored.set<int>("bar", 0);
+  EXPECT_EQ(BlackboardSnapshot::restore(restored, path), 2);
+  EXPECT_EQ(restored.get<int>("foo"), 2);
+  EXPECT_FALSE(restored.contains("bar"));
+  EXPECT_EQ(restored.get<std::string>("baz"), "baz");
+
+  std::remove(path.c_str());
+}
+
+TEST(TestBlackboardSnapshot, TestCompaction) {
+  const std::string path = ::testing::TempDir() + "test_compaction.bin";
+  Blackboard blackboard;
+  BlackboardSnapshot snapshot(blackboard, path);
+
+  for (int i = 0; i < 100; ++i) {
+    blackboard.set<int>("foo", i);
+    snapshot.write();
+  }
+
+  // The old records are dropped when the file is rewritten
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  EXPECT_LT(file.tellg(), 200);
+
+  Blackboard restored;
+  BlackboardSnapshot::restore(restored, path);
+  EXPECT_EQ(restored.get<int>("foo"), 99);
+
+  std::remove(path.c_str());
+}
+
+TEST(TestBlackboardSnapshot, TestSync) {
+  const std::string path = ::testing::TempDir() + "test_sync.bin";
+  Blackboard blackboard;
+  blackboard.set<int>("foo", 1);
+
+  // The file and its directory are synced when it is rewritten
+  BlackboardSnapshot snapshot(blackboard, path, true);
+  EXPECT_EQ(snapshot.write(), 1);
+
+  Blackboard restored;
+  EXPECT_EQ(BlackboardSnapshot::restore(restored, path), 1);
+  EXPECT_EQ(restored.get<int>("foo"), 1);
+
+  std::remove(path.c_str());
+}
+
+TEST(TestBlackboardSnapshot, TestFailedRename) {
+  // A directory that is not empty cannot be replaced by the file
+  const std::string path = ::testing::TempDir() + "test_failed_rename";
+  const std::string child = path + "/child";
+  ASSERT_EQ(::mkdir(path.c_str(), 0755), 0);
+  ASSERT_EQ(::mkdir(child.c_str(), 0755), 0);
+
+  Blackboard blackboard;
+  blackboard.set<int>("foo", 1);
+  EXPECT_THROW(BlackboardSnapshot::save(blackboard, path),
+               std::runtime_error);
+
+  // The temporary file is removed
+  EXPECT_NE(::access((path + ".tmp").c_str(), F_OK), 0);
+
+  ::rmdir(child.c_str());
+  ::rmdir(path.c_str());
+}
+
+class TestSharedMemory : public ::testing::Test {
+protected:
+  const std::string name = "yasmin_test_" + std::to_string(getpid());
+  SharedMemoryLayout layout;
+
+  void SetUp() override {
+    layout.add<int>("counter").add<Point>("point").add<bool>("flag");
+  }
+
+  void TearDown() override { SharedMemorySegment::unlink(name); }
+};
+
+TEST_F(TestSharedMemory, TestSetGet) {
+  Blackboard writer(std::make_shared<SharedMemorySegment>(name, layout));
+  Blackboard reader(std::make_shared<SharedMemorySegment>(name, layout));
+
+  writer.set<int>("counter", 3);
+  writer.set<Point>("point", {1.0, 2.0});
+  writer.set<std::string>("local", "foo");
+
+  EXPECT_EQ(reader.get<int>("counter"), 3);
+  EXPECT_EQ(reader.get<Point>("point").y, 2.0);
+  EXPECT_EQ(reader.get_type("counter"), "int");
+  EXPECT_FALSE(reader.contains("flag"));
+  EXPECT_FALSE(reader.contains("local"));
+  EXPECT_EQ(reader.size(), 2);
+  EXPECT_EQ(writer.size(), 3);
+
+  // Shared keys keep the type of the layout
+  EXPECT_THROW(writer.set<double>("counter", 1.0), std::runtime_error);
+  EXPECT_THROW(reader.get<double>("counter"), std::runtime_error);
+
+  reader.remove("counter");
+  EXPECT_FALSE(writer.contains("counter"));
+  EXPECT_THROW(writer.get<int>("counter"), std::runtime_error);
+  EXPECT_THROW(writer.remove("counter"), std::runtime_error);
+}
+
+TEST_F(TestSharedMemory, TestKeyRemappings) {
+  Blackboard blackboard(std::make_shared<SharedMemorySegment>(name, layout));
+  blackboard.set_remappings({{"count", "counter"}});
+
+  BlackboardKey<int> key = blackboard.get_key<int>("count");
+  blackboard.set(key, 5);
+  EXPECT_EQ(blackboard.get<int>("counter"), 5);
+  EXPECT_EQ(*blackboard.get_shared(key), 5);
+
+  // Views and forks write the shared keys to the segment
+  auto parent = std::make_shared<Blackboard>(blackboard.get_segment());
+  BlackboardView view(parent, {{"c", "counter"}});
+  view.set<int>("c", 6);
+  EXPECT_EQ(blackboard.get(key), 6);
+  parent->fork()->set<int>("counter", 7);
+  EXPECT_EQ(blackboard.get(key), 7);
+}
+
+TEST_F(TestSharedMemory, TestLayout) {
+  SharedMemorySegment segment(name, layout);
+
+  SharedMemoryLayout other;
+  other.add<int>("counter").add<Point>("point").add<int>("flag");
+  EXPECT_THROW(SharedMemorySegment(name, other), std::runtime_error);
+
+  SharedMemoryLayout repeated;
+  repeated.add<int>("counter").add<int>("counter");
+  EXPECT_THROW(SharedMemorySegment(name + "_repeated", repeated),
+               std::invalid_argument);
+}
+
+TEST_F(TestSharedMemory, TestTransaction) {
+  Blackboard blackboard(std::make_shared<SharedMemorySegment>(name, layout));
+  blackboard.set<std::string>("local", "foo");
+
+  {
+    BlackboardTransaction transaction(blackboard);
+    transaction.set<int>("counter", 1);
+    transaction.set<bool>("flag", true);
+    EXPECT_EQ(transaction.get<int>("counter"), 1);
+    EXPECT_EQ(transaction.get_keys(),
+              (std::vector<std::string>{"counter", "flag", "local"}));
+  }
+
+  EXPECT_TRUE(blackboard.get<bool>("flag"));
+}
+
+TEST_F(TestSharedMemory, TestWaitForChangeProcess) {
+  Blackboard blackboard(std::make_shared<SharedMemorySegment>(name, layout));
+  std::uint64_t version = blackboard.get_version("counter");
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    Blackboard child(std::make_shared<SharedMemorySegment>(name, layout));
+    child.set<int>("counter", 42);
+    _exit(0);
+  }
+
+  EXPECT_TRUE(blackboard.wait_for_change("counter", version,
+                                         std::chrono::seconds(5)));
+  EXPECT_EQ(blackboard.get<int>("counter"), 42);
+  EXPECT_FALSE(blackboard.wait_for_change(
+      "counter", blackboard.get_version("counter"),
+      std::chrono::milliseconds(10)));
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  EXPECT_EQ(status, 0);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -14,7 +14,12 @@
 # along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 
+import os
+import tempfile
+import threading
+import time
 import unittest
+import numpy as np
 from yasmin import Blackboard
 
 
@@ -220,6 +225,109 @@ class TestBlackboard(unittest.TestCase):
         self.assertEqual(0.0, self.blackboard["zero_float"])
         self.assertEqual("", self.blackboard["empty_string"])
 
+    def test_wait_for_change(self):
+        """Test waiting for a key changed by another thread"""
+        self.blackboard["foo"] = 0
+        version = self.blackboard.get_version("foo")
+        self.assertFalse(self.blackboard.wait_for_change("foo", version, 0.01))
+
+        def writer():
+            time.sleep(0.01)
+            self.blackboard["foo"] = 1
+
+        thread = threading.Thread(target=writer)
+        thread.start()
+        self.assertTrue(self.blackboard.wait_for_change("foo", version, 5.0))
+        thread.join()
+        self.assertEqual(1, self.blackboard["foo"])
+
+    def test_watch(self):
+        """Test callbacks called when a key changes"""
+        changes = []
+        watch_id = self.blackboard.add_watch("foo", changes.append)
+
+        self.blackboard["foo"] = 1
+        self.blackboard["bar"] = 1
+        self.assertEqual(["foo"], changes)
+
+        self.assertTrue(self.blackboard.remove_watch(watch_id))
+        self.blackboard["foo"] = 2
+        self.assertEqual(["foo"], changes)
+
+    def test_set_get_many(self):
+        """Test setting and getting several values at once"""
+        self.blackboard.set_many({"foo": 1, "bar": "bar", "baz": [1, 2]})
+        self.assertEqual(
+            [1, "bar", [1, 2]], self.blackboard.get_many(["foo", "bar", "baz"])
+        )
+        self.assertEqual(3, len(self.blackboard))
+
+        with self.assertRaises(Exception):
+            self.blackboard.get_many(["foo", "qux"])
+
+    def test_snapshot(self):
+        """Test saving and restoring a snapshot of the blackboard"""
+        path = os.path.join(tempfile.mkdtemp(), "snapshot.bin")
+        self.blackboard["foo"] = 1
+        self.blackboard["bar"] = "bar"
+        self.blackboard["baz"] = 0.5
+        self.blackboard["qux"] = [1, 2]
+        self.blackboard.save_snapshot(path)
+
+        # Python objects without a serializer are skipped
+        restored = Blackboard()
+        self.assertEqual(3, restored.restore_snapshot(path))
+        self.assertEqual(1, restored["foo"])
+        self.assertEqual("bar", restored["bar"])
+        self.assertEqual(0.5, restored["baz"])
+        self.assertFalse("qux" in restored)
+        os.remove(path)
+
+
+    def test_memory_budget(self):
+        """Test the memory accounting and budget of the blackboard"""
+        self.blackboard["foo"] = "a" * 100
+        self.assertGreaterEqual(self.blackboard.get_key_memory_usage("foo"), 100)
+        self.assertEqual(0, self.blackboard.get_key_memory_usage("bar"))
+
+        self.blackboard.set_memory_budget(self.blackboard.get_memory_usage())
+        self.blackboard["bar"] = "b" * 100
+        self.assertFalse("foo" in self.blackboard)
+        self.assertTrue("bar" in self.blackboard)
+
+    def test_ttl(self):
+        """Test values that become stale"""
+        self.blackboard.set_ttl("foo", 0.02)
+        self.blackboard["foo"] = 1
+        self.assertFalse(self.blackboard.is_stale("foo"))
+
+        time.sleep(0.03)
+        self.assertFalse("foo" in self.blackboard)
+        self.assertTrue(self.blackboard.is_stale("foo"))
+        self.assertEqual(1, self.blackboard.purge_stale())
+
+    def test_numpy(self):
+        """Test NumPy arrays stored as native vectors"""
+        for dtype in (np.float64, np.float32, np.uint8, np.int64):
+            scan = np.arange(10, dtype=dtype)
+            self.blackboard["scan"] = scan
+            self.assertGreaterEqual(
+                self.blackboard.get_key_memory_usage("scan"), scan.nbytes
+            )
+
+            # The arrays share the buffer of the value and cannot change it
+            first = self.blackboard["scan"]
+            second = self.blackboard["scan"]
+            self.assertIsInstance(first, np.ndarray)
+            self.assertEqual(dtype, first.dtype)
+            np.testing.assert_array_equal(scan, first)
+            self.assertTrue(np.shares_memory(first, second))
+            self.assertFalse(first.flags.writeable)
+
+        # Other arrays are kept as Python objects
+        grid = np.zeros((2, 2))
+        self.blackboard["grid"] = grid
+        self.assertIs(grid, self.blackboard["grid"])
 
 if __name__ == "__main__":
     unittest.main()
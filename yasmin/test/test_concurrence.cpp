@@ -13,7 +13,10 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+#include <atomic>
+#include <algorithm>
 #include <chrono>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <memory>
@@ -21,8 +24,10 @@
 #include <thread>
 
 #include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/cb_state.hpp"
 #include "yasmin/concurrence.hpp"
 #include "yasmin/state.hpp"
+#include "yasmin/thread_pool.hpp"
 
 using namespace yasmin;
 
@@ -54,6 +59,52 @@ public:
   }
 };
 
+class WaitState : public State {
+public:
+  WaitState() : State({"done", "canceled"}) {}
+
+  std::string
+  execute(std::shared_ptr<blackboard::Blackboard> blackboard) override {
+    for (int i = 0; i < 500 && !this->is_canceled(); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return this->is_canceled() ? "canceled" : "done";
+  }
+};
+
+class SlowStartState : public WaitState {
+public:
+  std::atomic_bool started_canceled{false};
+
+  std::string
+  execute(std::shared_ptr<blackboard::Blackboard> blackboard) override {
+    this->started_canceled.store(this->is_canceled());
+    return WaitState::execute(blackboard);
+  }
+
+  // Delays the start of the state, which is logged before the state starts
+  // and after the start of the concurrence
+  std::string to_string() override {
+    if (this->calls.fetch_add(1) == 1) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    return "SlowStartState";
+  }
+
+private:
+  std::atomic_int calls{0};
+};
+
+std::shared_ptr<State> create_fast_state(const std::string &outcome) {
+  return std::make_shared<CbState>(
+      std::set<std::string>{outcome},
+      [outcome](std::shared_ptr<blackboard::Blackboard> blackboard) {
+        // Give the other states time to start
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return outcome;
+      });
+}
+
 class TestConcurrence : public ::testing::Test {
 protected:
   std::shared_ptr<FooState> foo_state;
@@ -96,7 +147,472 @@ TEST_F(TestConcurrence, TestStr) {
               "Concurrence [BAR (BarState), FOO (FooState), FOO2 (FooState)]");
 }
 
+TEST_F(TestConcurrence, TestNestedConcurrence) {
+  std::map<std::string, std::shared_ptr<State>> outer_states;
+
+  // More nested branches than workers in the shared pool
+  std::size_t num_branches = ThreadPool::get_instance().size() + 2;
+
+  for (std::size_t i = 0; i < num_branches; ++i) {
+    std::map<std::string, std::shared_ptr<State>> inner_states;
+
+    for (std::size_t j = 0; j < num_branches; ++j) {
+      inner_states.insert(
+          {"STATE" + std::to_string(j),
+           std::make_shared<CbState>(
+               std::set<std::string>{"done"},
+               [](std::shared_ptr<blackboard::Blackboard> blackboard) {
+                 return "done";
+               })});
+    }
+
+    outer_states.insert({"INNER" + std::to_string(i),
+                         std::make_shared<Concurrence>(
+                             inner_states, "default",
+                             Concurrence::OutcomeMap{
+                                 {"done", {{"STATE0", "done"}}}})});
+  }
+
+  Concurrence outer(outer_states, "default",
+                    Concurrence::OutcomeMap{{"done", {{"INNER0", "done"}}}});
+
+  EXPECT_EQ(outer(blackboard), "done");
+}
+
+TEST_F(TestConcurrence, TestStateException) {
+  std::map<std::string, std::shared_ptr<State>> states = {
+      {"FOO", foo_state},
+      {"FAIL", std::make_shared<CbState>(
+                   std::set<std::string>{"outcome1"},
+                   [](std::shared_ptr<blackboard::Blackboard> blackboard)
+                       -> std::string { throw std::runtime_error("fail"); })}};
+
+  Concurrence concurrence(states, "default", {});
+
+  EXPECT_THROW(concurrence(blackboard), std::runtime_error);
+}
+
+TEST_F(TestConcurrence, TestRepeatedCall) {
+  auto toggle_state = std::make_shared<CbState>(
+      std::set<std::string>{"even", "odd"},
+      [](std::shared_ptr<blackboard::Blackboard> blackboard) {
+        int count = blackboard->get<int>("count");
+        blackboard->set<int>("count", count + 1);
+        return count % 2 == 0 ? "even" : "odd";
+      });
+
+  Concurrence concurrence({{"TOGGLE", toggle_state}, {"FOO", foo_state}},
+                          "default",
+                          {{"outcome1", {{"TOGGLE", "even"}}},
+                           {"outcome2", {{"TOGGLE", "odd"}}}});
+
+  blackboard->set<int>("count", 0);
+  EXPECT_EQ(concurrence(blackboard), "outcome1");
+  EXPECT_EQ(concurrence(blackboard), "outcome2");
+  EXPECT_EQ(concurrence(blackboard), "outcome1");
+}
+
+TEST_F(TestConcurrence, TestMultipleSatisfiedOutcomes) {
+  Concurrence concurrence({{"FOO", foo_state}, {"BAR", bar_state}}, "default",
+                          {{"outcome1", {{"FOO", "outcome1"}}},
+                           {"outcome2", {{"BAR", "outcome2"}}}});
+
+  EXPECT_THROW(concurrence(blackboard), std::logic_error);
+}
+
+TEST_F(TestConcurrence, TestFirstCompleted) {
+  auto wait_state = std::make_shared<WaitState>();
+  Concurrence concurrence(
+      {{"FAST", create_fast_state("succeeded")}, {"WAIT", wait_state}},
+      "default", {{"succeeded", {{"FAST", "succeeded"}}}},
+      Concurrence::JoinPolicy::FIRST_COMPLETED);
+
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(concurrence(blackboard), "succeeded");
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+  EXPECT_TRUE(wait_state->is_canceled());
+
+  // The next execution must not see the previous intermediate outcomes
+  EXPECT_EQ(concurrence(blackboard), "succeeded");
+}
+
+TEST_F(TestConcurrence, TestCancelBeforeStart) {
+  auto slow_start_state = std::make_shared<SlowStartState>();
+  Concurrence concurrence(
+      {{"FAST", create_fast_state("succeeded")}, {"WAIT", slow_start_state}},
+      "default", {{"succeeded", {{"FAST", "succeeded"}}}},
+      Concurrence::JoinPolicy::FIRST_COMPLETED);
+
+  // The start of the state is logged, and delayed, only at the DEBUG level
+  set_log_level(LogLevel::DEBUG);
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(concurrence(blackboard), "succeeded");
+  set_log_level(LogLevel::INFO);
+
+  // The cancel received while the state was starting is not lost
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+  EXPECT_TRUE(slow_start_state->started_canceled.load());
+  EXPECT_TRUE(slow_start_state->is_canceled());
+}
+
+TEST_F(TestConcurrence, TestQuorum) {
+  auto wait_state = std::make_shared<WaitState>();
+  Concurrence concurrence({{"FAST1", create_fast_state("succeeded")},
+                           {"FAST2", create_fast_state("succeeded")},
+                           {"WAIT", wait_state}},
+                          "default",
+                          {{"succeeded",
+                            {{"FAST1", "succeeded"}, {"FAST2", "succeeded"}}},
+                           {"done", {{"WAIT", "done"}}}},
+                          Concurrence::JoinPolicy::QUORUM, 2);
+
+  EXPECT_EQ(concurrence(blackboard), "succeeded");
+  EXPECT_TRUE(wait_state->is_canceled());
+}
+
+TEST_F(TestConcurrence, TestFailFast) {
+  auto wait_state = std::make_shared<WaitState>();
+  Concurrence concurrence(
+      {{"FAIL", create_fast_state("aborted")}, {"WAIT", wait_state}},
+      "default",
+      {{"aborted", {{"FAIL", "aborted"}}}, {"done", {{"WAIT", "done"}}}},
+      Concurrence::JoinPolicy::FAIL_FAST, 0, "aborted");
+
+  EXPECT_EQ(concurrence(blackboard), "aborted");
+  EXPECT_TRUE(wait_state->is_canceled());
+}
+
+TEST_F(TestConcurrence, TestInvalidJoinPolicy) {
+  std::map<std::string, std::shared_ptr<State>> states = {
+      {"FOO", foo_state}, {"BAR", bar_state}};
+
+  EXPECT_THROW(Concurrence(states, "default", {},
+                           Concurrence::JoinPolicy::QUORUM, 3),
+               std::invalid_argument);
+  EXPECT_THROW(Concurrence(states, "default", {},
+                           Concurrence::JoinPolicy::FAIL_FAST, 0, "aborted"),
+               std::invalid_argument);
+}
+
+std::shared_ptr<State> create_writer_state(const std::string &value) {
+  return std::make_shared<CbState>(
+      std::set<std::string>{"done"},
+      [value](std::shared_ptr<blackboard::Blackboard> blackboard) {
+        blackboard->set<std::string>("value", value);
+        blackboard->set<bool>(value, true);
+        return "done";
+      });
+}
+
+TEST_F(TestConcurrence, TestConflictPolicy) {
+  std::map<std::string, std::shared_ptr<State>> states = {
+      {"A", create_writer_state("a")},
+      {"B", create_writer_state("b")},
+      {"C", create_writer_state("c")}};
+
+  // The forks are merged in the order of the states, whatever the timing
+  for (int i = 0; i < 10; ++i) {
+    auto last_wins = std::make_shared<blackboard::Blackboard>();
+    Concurrence(states, "done", {}, Concurrence::JoinPolicy::ALL_COMPLETED, 0,
+                "", Concurrence::ConflictPolicy::LAST_WINS)(last_wins);
+    EXPECT_EQ(last_wins->get<std::string>("value"), "c");
+    EXPECT_EQ(last_wins->size(), 4);
+
+    auto first_wins = std::make_shared<blackboard::Blackboard>();
+    Concurrence(states, "done", {}, Concurrence::JoinPolicy::ALL_COMPLETED, 0,
+                "", Concurrence::ConflictPolicy::FIRST_WINS)(first_wins);
+    EXPECT_EQ(first_wins->get<std::string>("value"), "a");
+    EXPECT_EQ(first_wins->size(), 4);
+  }
+
+  // Nothing is merged if there is a conflict
+  Concurrence fail(states, "done", {}, Concurrence::JoinPolicy::ALL_COMPLETED,
+                   0, "", Concurrence::ConflictPolicy::FAIL);
+  EXPECT_THROW(fail(blackboard), std::runtime_error);
+  EXPECT_EQ(blackboard->size(), 0);
+}
+
+TEST_F(TestConcurrence, TestConflictPolicyJoin) {
+  auto slow_state = std::make_shared<CbState>(
+      std::set<std::string>{"done"},
+      [](std::shared_ptr<blackboard::Blackboard> blackboard) {
+        blackboard->set<bool>("slow", true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        return "done";
+      });
+
+  Concurrence concurrence(
+      {{"FAST", create_fast_state("succeeded")}, {"SLOW", slow_state}},
+      "default", {{"succeeded", {{"FAST", "succeeded"}}}},
+      Concurrence::JoinPolicy::FIRST_COMPLETED, 0, "",
+      Concurrence::ConflictPolicy::FAIL);
+
+  // The changes of the states canceled by the join policy are discarded
+  blackboard->set<bool>("slow", false);
+  EXPECT_EQ(concurrence(blackboard), "succeeded");
+  EXPECT_FALSE(blackboard->get<bool>("slow"));
+}
+
+TEST_F(TestConcurrence, TestConflictPolicyKey) {
+  blackboard->set<int>("counter", 1);
+  auto key = blackboard->get_key<int>("counter");
+
+  // The key of the parent blackboard is used in the fork of the state
+  auto key_state = std::make_shared<CbState>(
+      std::set<std::string>{"done"},
+      [key](std::shared_ptr<blackboard::Blackboard> blackboard) {
+        blackboard->set(key, blackboard->get(key) + 1);
+        return "done";
+      });
+
+  Concurrence concurrence({{"KEY", key_state}}, "done", {},
+                          Concurrence::JoinPolicy::ALL_COMPLETED, 0, "",
+                          Concurrence::ConflictPolicy::LAST_WINS);
+
+  EXPECT_EQ(concurrence(blackboard), "done");
+  EXPECT_EQ(blackboard->get(key), 2);
+}
+
+std::shared_ptr<State> create_waiting_state(const std::string &key,
+                                            const std::string &other_key) {
+  return std::make_shared<CbState>(
+      std::set<std::string>{"done", "timeout"},
+      [key, other_key](std::shared_ptr<blackboard::Blackboard> blackboard) {
+        blackboard->set<bool>(key, true);
+        for (int i = 0; i < 200; ++i) {
+          if (blackboard->contains(other_key)) {
+            return "done";
+          }
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return "timeout";
+      });
+}
+
+TEST_F(TestConcurrence, TestSaturatedThreadPool) {
+  // Keep all the workers of the shared pool busy
+  ThreadPool &pool = ThreadPool::get_instance();
+  std::atomic_bool release{false};
+  std::atomic<std::size_t> started{0};
+
+  // The pool must be able to grow for two of the states
+  ASSERT_LE(pool.size() + 2, pool.get_max_size());
+
+  for (std::size_t i = 0; i < pool.size(); ++i) {
+    pool.submit([&release, &started]() {
+      started++;
+      while (!release.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      started--;
+    });
+  }
+
+  while (started.load() < pool.size()) {
+    std::this_thread::yield();
+  }
+
+  // Each state waits for another one, so they must run at the same time
+  Concurrence concurrence(
+      {{"A", create_waiting_state("a", "b")},
+       {"B", create_waiting_state("b", "c")},
+       {"C", create_waiting_state("c", "a")}},
+      "default", {{"done", {{"A", "done"}, {"B", "done"}, {"C", "done"}}}});
+
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(concurrence(blackboard), "done");
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+  release.store(true);
+  while (started.load() > 0) {
+    std::this_thread::yield();
+  }
+}
+
+/// Gets the number of threads of the process
+std::size_t get_num_threads() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+
+  while (std::getline(status, line)) {
+    if (line.rfind("Threads:", 0) == 0) {
+      return std::stoul(line.substr(8));
+    }
+  }
+
+  return 0;
+}
+
+TEST_F(TestConcurrence, TestNestedConcurrenceBoundedThreads) {
+  ThreadPool &pool = ThreadPool::get_instance();
+  const std::size_t max_size = pool.get_max_size();
+
+  // Twice as many sleeping states as the pool can run at once
+  std::map<std::string, std::shared_ptr<State>> outer_states;
+
+  for (std::size_t i = 0; i < 4; ++i) {
+    std::map<std::string, std::shared_ptr<State>> inner_states;
+
+    for (std::size_t j = 0; j < max_size / 2; ++j) {
+      inner_states.insert(
+          {"STATE" + std::to_string(j),
+           std::make_shared<CbState>(
+               std::set<std::string>{"done"},
+               [](std::shared_ptr<blackboard::Blackboard> blackboard) {
+                 std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                 return "done";
+               })});
+    }
+
+    outer_states.insert({"INNER" + std::to_string(i),
+                         std::make_shared<Concurrence>(
+                             inner_states, "default",
+                             Concurrence::OutcomeMap{
+                                 {"done", {{"STATE0", "done"}}}})});
+  }
+
+  Concurrence outer(outer_states, "default",
+                    Concurrence::OutcomeMap{{"done", {{"INNER0", "done"}}}});
+
+  // Sample the number of threads while the concurrence runs
+  const std::size_t num_threads = get_num_threads();
+  const std::size_t num_workers = pool.size();
+  std::atomic_bool done{false};
+  std::atomic<std::size_t> peak_threads{0};
+  std::thread monitor([&done, &peak_threads]() {
+    while (!done.load()) {
+      peak_threads.store(std::max(peak_threads.load(), get_num_threads()));
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+
+  EXPECT_EQ(outer(blackboard), "done");
+
+  done.store(true);
+  monitor.join();
+
+  // The pool only grows to its maximum size, plus the monitor thread
+  EXPECT_GT(num_threads, 0u);
+  EXPECT_LE(peak_threads.load(), num_threads + max_size - num_workers + 1);
+  EXPECT_LE(pool.size(), max_size);
+}
+
+TEST(TestThreadPool, TestSubmit) {
+  ThreadPool pool(2);
+  std::atomic<int> counter{0};
+  std::vector<std::shared_ptr<ThreadPool::Task>> tasks;
+
+  for (int i = 0; i < 100; ++i) {
+    tasks.push_back(pool.submit([&counter]() { counter++; }));
+  }
+
+  int run_by_caller = 0;
+  for (auto &task : tasks) {
+    run_by_caller += task->try_run();
+  }
+
+  while (counter.load() < 100) {
+    std::this_thread::yield();
+  }
+
+  EXPECT_EQ(pool.size(), 2);
+  EXPECT_EQ(counter.load(), 100);
+  EXPECT_LE(run_by_caller, 100);
+}
+
+TEST(TestThreadPool, TestTrySubmit) {
+  std::atomic_bool release{false};
+  std::atomic_int counter{0};
+  ThreadPool pool(1);
+
+  // Wait until the worker is idle
+  auto task = std::make_shared<ThreadPool::Task>([&release, &counter]() {
+    counter++;
+    while (!release.load()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+  while (!pool.try_submit(task)) {
+    std::this_thread::yield();
+  }
+
+  while (counter.load() == 0) {
+    std::this_thread::yield();
+  }
+
+  // The only worker is busy
+  EXPECT_FALSE(pool.try_submit(
+      std::make_shared<ThreadPool::Task>([&counter]() { counter++; })));
+
+  release.store(true);
+  EXPECT_EQ(counter.load(), 1);
+}
+
+TEST(TestThreadPool, TestTryStart) {
+  ThreadPool pool(1, 2);
+  std::atomic_bool release{false};
+  std::atomic<int> started{0};
+
+  auto make_task = [&release, &started]() {
+    return std::make_shared<ThreadPool::Task>([&release, &started]() {
+      started++;
+      while (!release.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+  };
+
+  // The pool grows when its workers are busy, up to its maximum size
+  EXPECT_TRUE(pool.try_start(make_task()));
+  while (started.load() < 1) {
+    std::this_thread::yield();
+  }
+
+  EXPECT_TRUE(pool.try_start(make_task()));
+  EXPECT_EQ(pool.size(), 2u);
+  while (started.load() < 2) {
+    std::this_thread::yield();
+  }
+
+  EXPECT_FALSE(pool.try_start(make_task()));
+  EXPECT_EQ(pool.size(), 2u);
+  EXPECT_EQ(pool.get_max_size(), 2u);
+
+  release.store(true);
+}
+
+class CounterTask : public ThreadPool::Task {
+public:
+  std::atomic_int counter{0};
+
+protected:
+  void run() override { this->counter++; }
+};
+
+TEST(TestThreadPool, TestTrySubmitOwnedTask) {
+  CounterTask task;
+  ThreadPool pool(1);
+
+  // The same task runs again each time it is submitted
+  for (int i = 1; i <= 3; ++i) {
+    while (!pool.try_submit(task)) {
+      std::this_thread::yield();
+    }
+    while (task.counter.load() < i) {
+      std::this_thread::yield();
+    }
+  }
+
+  EXPECT_EQ(task.counter.load(), 3);
+  EXPECT_FALSE(task.try_run());
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
+
+  // A small pool that has to grow, and to queue the states once it is full
+  ThreadPool::set_default_size(2);
+  ThreadPool::set_default_max_size(32);
+
   return RUN_ALL_TESTS();
 }
@@ -17,7 +17,7 @@
 
 import unittest
 import time
-from yasmin import State, Concurrence
+from yasmin import State, CbState, Concurrence, Blackboard
 
 
 class FooState(State):
@@ -46,6 +46,19 @@ class BarState(State):
         return "outcome2"
 
 
+class WaitState(State):
+    def __init__(self):
+        super().__init__(["done", "canceled"])
+
+    def execute(self, blackboard):
+        for _ in range(500):
+            if self.is_canceled():
+                return "canceled"
+            time.sleep(0.01)
+
+        return "done"
+
+
 class TestState(unittest.TestCase):
 
     def setUp(self):
@@ -73,6 +86,42 @@ class TestState(unittest.TestCase):
         self.state.cancel_state()
         self.assertTrue(self.state.is_canceled())
 
+    def test_first_completed(self):
+        wait_state = WaitState()
+        state = Concurrence(
+            states={"FOO": self.foo_state, "WAIT": wait_state},
+            default_outcome="default",
+            outcome_map={"outcome1": {"FOO": "outcome1"}},
+            join_policy=Concurrence.JoinPolicy.FIRST_COMPLETED,
+        )
+
+        start = time.time()
+        self.assertEqual("outcome1", state())
+        self.assertLess(time.time() - start, 2.0)
+        self.assertTrue(wait_state.is_canceled())
+
+    def test_conflict_policy(self):
+        def create_writer(value):
+            def write(blackboard):
+                blackboard["value"] = value
+                blackboard[value] = True
+                return "done"
+
+            return CbState(["done"], write)
+
+        blackboard = Blackboard()
+        state = Concurrence(
+            states={"A": create_writer("a"), "B": create_writer("b")},
+            default_outcome="done",
+            outcome_map={},
+            conflict_policy=Concurrence.ConflictPolicy.LAST_WINS,
+        )
+
+        self.assertEqual("done", state(blackboard))
+        self.assertEqual("b", blackboard["value"])
+        self.assertTrue(blackboard["a"])
+        self.assertTrue(blackboard["b"])
+
     def test_str(self):
         self.assertEqual(
             "Concurrence [BAR (BarState), FOO (FooState), FOO2 (FooState)]",
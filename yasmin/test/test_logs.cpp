@@ -0,0 +1,263 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "yasmin/logs.hpp"
+
+using namespace yasmin;
+
+/// Message received by the logging function
+struct LoggedMessage {
+  LogLevel level;
+  std::string file;
+  std::string function;
+  int line;
+  std::string text;
+};
+
+/// Messages received by the logging function
+std::vector<LoggedMessage> messages;
+/// Mutex for the messages
+std::mutex messages_mutex;
+/// Flag to keep the logging function waiting
+std::atomic_bool block_logger{false};
+/// Flag to indicate that the logging function is waiting
+std::atomic_bool logger_blocked{false};
+
+void capture_log_message(LogLevel level, const char *file,
+                         const char *function, int line, const char *text) {
+  while (block_logger.load()) {
+    logger_blocked.store(true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  const std::lock_guard<std::mutex> lock(messages_mutex);
+  messages.push_back({level, file, function, line, text});
+}
+
+class TestLogs : public ::testing::Test {
+protected:
+  void SetUp() override {
+    messages.clear();
+    block_logger.store(false);
+    logger_blocked.store(false);
+    set_log_level(INFO);
+    set_loggers(capture_log_message);
+  }
+
+  void TearDown() override {
+    block_logger.store(false);
+    disable_async_logs();
+    set_default_loggers();
+  }
+
+  std::vector<LoggedMessage> get_messages() {
+    const std::lock_guard<std::mutex> lock(messages_mutex);
+    return messages;
+  }
+};
+
+TEST_F(TestLogs, TestDropReportsDroppedMessages) {
+  AsyncLogOptions options;
+  options.capacity = 4;
+  options.overflow_policy = LogOverflowPolicy::DROP;
+  enable_async_logs(options);
+
+  // The background thread keeps the first record until it is written
+  block_logger.store(true);
+  YASMIN_LOG_INFO("first");
+  while (!logger_blocked.load()) {
+    std::this_thread::yield();
+  }
+
+  for (int i = 0; i < 10; ++i) {
+    YASMIN_LOG_INFO("message %d", i);
+  }
+
+  block_logger.store(false);
+  flush_logs();
+
+  // The drops are reported once the record being written is done
+  std::vector<LoggedMessage> logged = this->get_messages();
+  ASSERT_EQ(logged.size(), 5u);
+  EXPECT_EQ(logged[0].text, "first");
+  EXPECT_EQ(logged[1].level, WARN);
+  EXPECT_EQ(logged[1].text, "Dropped 7 log messages");
+  EXPECT_EQ(logged[2].text, "message 0");
+  EXPECT_EQ(logged[4].text, "message 2");
+}
+
+TEST_F(TestLogs, TestBlockKeepsAllMessages) {
+  AsyncLogOptions options;
+  options.capacity = 4;
+  options.overflow_policy = LogOverflowPolicy::BLOCK;
+  enable_async_logs(options);
+
+  constexpr int NUM_THREADS = 4;
+  constexpr int NUM_MESSAGES = 500;
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    threads.emplace_back([i]() {
+      for (int j = 0; j < NUM_MESSAGES; ++j) {
+        YASMIN_LOG_INFO("thread %d message %d", i, j);
+      }
+    });
+  }
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  flush_logs();
+
+  // The messages of each thread keep their order
+  std::vector<LoggedMessage> logged = this->get_messages();
+  ASSERT_EQ(logged.size(), std::size_t(NUM_THREADS * NUM_MESSAGES));
+
+  std::vector<int> next_message(NUM_THREADS, 0);
+  for (const LoggedMessage &message : logged) {
+    int thread = -1;
+    int index = -1;
+    ASSERT_EQ(std::sscanf(message.text.c_str(), "thread %d message %d",
+                          &thread, &index),
+              2);
+    EXPECT_EQ(index, next_message[thread]++);
+  }
+}
+
+TEST_F(TestLogs, TestFlushWaitsForEarlierMessages) {
+  // The background thread would not wake up by itself during the test
+  AsyncLogOptions options;
+  options.flush_interval = std::chrono::seconds(10);
+  enable_async_logs(options);
+
+  for (int i = 0; i < 100; ++i) {
+    YASMIN_LOG_INFO("message %d", i);
+  }
+
+  flush_logs();
+  std::vector<LoggedMessage> logged = this->get_messages();
+  ASSERT_EQ(logged.size(), 100u);
+  EXPECT_EQ(logged.back().text, "message 99");
+}
+
+TEST_F(TestLogs, TestDisableWritesCommittedMessages) {
+  AsyncLogOptions options;
+  options.capacity = 64;
+  options.overflow_policy = LogOverflowPolicy::BLOCK;
+
+  // Messages are committed while the asynchronous mode stops
+  for (int round = 0; round < 20; ++round) {
+    {
+      const std::lock_guard<std::mutex> lock(messages_mutex);
+      messages.clear();
+    }
+
+    enable_async_logs(options);
+    std::atomic_bool stop{false};
+    std::atomic<std::size_t> sent{0};
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&stop, &sent]() {
+        while (!stop.load()) {
+          YASMIN_LOG_INFO("message");
+          sent++;
+        }
+      });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    disable_async_logs();
+    stop.store(true);
+
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+
+    ASSERT_EQ(this->get_messages().size(), sent.load());
+  }
+}
+
+TEST_F(TestLogs, TestFinishedThreadIsDrained) {
+  AsyncLogOptions options;
+  options.flush_interval = std::chrono::seconds(10);
+  enable_async_logs(options);
+
+  std::thread thread([]() {
+    for (int i = 0; i < 10; ++i) {
+      YASMIN_LOG_INFO("message %d", i);
+    }
+  });
+  thread.join();
+
+  flush_logs();
+  std::vector<LoggedMessage> logged = this->get_messages();
+  ASSERT_EQ(logged.size(), 10u);
+  EXPECT_EQ(logged.back().text, "message 9");
+}
+
+TEST_F(TestLogs, TestStrings) {
+  AsyncLogOptions options;
+  options.flush_interval = std::chrono::seconds(10);
+  enable_async_logs(options);
+
+  // Strings that do not fit in a record are logged synchronously, whole
+  char value[] = "value";
+  char *mutable_value = value;
+  std::string long_value(2 * LOG_RECORD_DATA_SIZE, 'x');
+  YASMIN_LOG_INFO("short %s", mutable_value);
+  YASMIN_LOG_INFO("long %s", long_value.c_str());
+  flush_logs();
+
+  std::vector<LoggedMessage> logged = this->get_messages();
+  ASSERT_EQ(logged.size(), 2u);
+  EXPECT_EQ(logged[0].text, "long " + long_value);
+  EXPECT_EQ(logged[1].text, "short value");
+}
+
+TEST_F(TestLogs, TestLogText) {
+  AsyncLogOptions options;
+  options.flush_interval = std::chrono::seconds(10);
+  enable_async_logs(options);
+
+  // The place of the message is copied with it
+  log_text(WARN, "script.py", "main", 7, "from Python");
+  std::string long_text(2 * LOG_RECORD_DATA_SIZE, 'x');
+  log_text(INFO, "script.py", "main", 8, long_text.c_str());
+  flush_logs();
+
+  std::vector<LoggedMessage> logged = this->get_messages();
+  ASSERT_EQ(logged.size(), 2u);
+  EXPECT_EQ(logged[0].text, long_text);
+  EXPECT_EQ(logged[1].level, WARN);
+  EXPECT_EQ(logged[1].file, "script.py");
+  EXPECT_EQ(logged[1].function, "main");
+  EXPECT_EQ(logged[1].line, 7);
+  EXPECT_EQ(logged[1].text, "from Python");
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
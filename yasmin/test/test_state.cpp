@@ -82,6 +82,62 @@ TEST_F(TestState, TestInitException) {
   }
 }
 
+TEST_F(TestState, TestInvalidOutcome) {
+  class BazState : public State {
+  public:
+    BazState() : State({"outcome1"}) {}
+
+    std::string
+    execute(std::shared_ptr<blackboard::Blackboard> blackboard) override {
+      return "outcome2";
+    }
+  };
+
+  try {
+    BazState baz_state;
+    baz_state(blackboard);
+    FAIL() << "Expected std::logic_error";
+  } catch (const std::logic_error &e) {
+    EXPECT_TRUE(std::string(e.what()).find(
+                    "Outcome 'outcome2' does not belong to the outcomes") !=
+                std::string::npos);
+  }
+}
+
+TEST_F(TestState, TestSharedOutcomeSet) {
+  auto other_state = std::make_shared<FooState>();
+  EXPECT_EQ(&state->get_outcome_set(), &other_state->get_outcome_set());
+}
+
+TEST(TestOutcome, TestInterned) {
+  Outcome outcome1("outcome1");
+  Outcome outcome2(std::string("outcome1"));
+  EXPECT_TRUE(outcome1 == outcome2);
+  EXPECT_EQ(&outcome1.str(), &outcome2.str());
+  EXPECT_EQ(outcome1, "outcome1");
+  EXPECT_NE(outcome1, Outcome("outcome2"));
+  EXPECT_FALSE(Outcome::find("not_registered_outcome").has_value());
+}
+
+TEST(TestOutcome, TestEmpty) {
+  Outcome outcome1;
+  Outcome outcome2;
+  EXPECT_EQ(outcome1, outcome2);
+  EXPECT_EQ(outcome1, Outcome(""));
+  EXPECT_TRUE(outcome1.str().empty());
+}
+
+TEST(TestOutcome, TestOutcomeSetFind) {
+  auto outcome_set = OutcomeSet::intern({"outcome1", "outcome2"});
+  EXPECT_EQ(outcome_set->find("outcome2"), Outcome("outcome2"));
+  EXPECT_FALSE(outcome_set->find("outcome3").has_value());
+
+  // Released sets are built again
+  outcome_set.reset();
+  outcome_set = OutcomeSet::intern({"outcome1", "outcome2"});
+  EXPECT_TRUE(outcome_set->contains(Outcome("outcome1")));
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
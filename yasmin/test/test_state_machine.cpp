@@ -13,13 +13,20 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+#include <atomic>
+#include <chrono>
 #include <gtest/gtest.h>
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "yasmin/blackboard/blackboard.hpp"
 #include "yasmin/state.hpp"
+#include "yasmin/cb_state.hpp"
+#include "yasmin/concurrence.hpp"
 #include "yasmin/state_machine.hpp"
+#include "yasmin/state_machine_instance.hpp"
 
 using namespace yasmin;
 
@@ -53,6 +60,23 @@ public:
   }
 };
 
+class WaitState : public State {
+public:
+  WaitState() : State({"done", "canceled"}) {}
+
+  std::string
+  execute(std::shared_ptr<blackboard::Blackboard> blackboard) override {
+    (void)blackboard;
+    for (int i = 0; i < 30; ++i) {
+      if (this->is_canceled()) {
+        return "canceled";
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return "done";
+  }
+};
+
 class TestStateMachine : public ::testing::Test {
 protected:
   std::shared_ptr<StateMachine> sm;
@@ -262,6 +286,264 @@ TEST_F(TestStateMachine, TestValidateWrongState) {
   }
 }
 
+TEST_F(TestStateMachine, TestExecuteAfterAddingState) {
+  EXPECT_EQ((*sm)(blackboard), "outcome4");
+
+  sm->add_state("BAZ", std::make_shared<BarState>(),
+                std::map<std::string, std::string>{{"outcome2", "outcome5"}});
+  sm->set_start_state("BAZ");
+
+  EXPECT_EQ((*sm)(blackboard), "outcome5");
+  EXPECT_EQ(sm->get_current_state(), "");
+}
+
+TEST_F(TestStateMachine, TestInstancesShareStateMachine) {
+  auto counter_state = std::make_shared<CbState>(
+      std::set<std::string>{"loop", "done"},
+      [](std::shared_ptr<blackboard::Blackboard> blackboard) {
+        int counter = blackboard->get<int>("counter") + 1;
+        blackboard->set<int>("counter", counter);
+        return counter < 100 ? "loop" : "done";
+      });
+
+  auto nested_sm =
+      std::make_shared<StateMachine>(std::set<std::string>{"done"});
+  nested_sm->add_state("COUNT", counter_state, {{"loop", "COUNT"}});
+
+  auto shared_sm =
+      std::make_shared<StateMachine>(std::set<std::string>{"outcome"});
+  shared_sm->add_state("NESTED", nested_sm, {{"done", "outcome"}});
+
+  std::vector<std::shared_ptr<StateMachineInstance>> instances;
+  std::vector<std::thread> threads;
+  std::vector<std::string> outcomes(8);
+
+  for (std::size_t i = 0; i < outcomes.size(); ++i) {
+    auto instance_blackboard = std::make_shared<blackboard::Blackboard>();
+    instance_blackboard->set<int>("counter", 0);
+    instances.push_back(
+        std::make_shared<StateMachineInstance>(shared_sm, instance_blackboard));
+  }
+
+  for (std::size_t i = 0; i < outcomes.size(); ++i) {
+    threads.emplace_back(
+        [&outcomes, &instances, i]() { outcomes[i] = (*instances[i])(); });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (std::size_t i = 0; i < outcomes.size(); ++i) {
+    EXPECT_EQ(outcomes[i], "outcome");
+    EXPECT_TRUE(instances[i]->is_completed());
+    EXPECT_EQ(instances[i]->get_current_state(), "");
+    EXPECT_EQ(instances[i]->get_blackboard()->get<int>("counter"), 100);
+  }
+}
+
+TEST_F(TestStateMachine, TestValidateWhileRunning) {
+  auto counter_state = std::make_shared<CbState>(
+      std::set<std::string>{"loop", "done"},
+      [](std::shared_ptr<blackboard::Blackboard> blackboard) {
+        int counter = blackboard->get<int>("counter") + 1;
+        blackboard->set<int>("counter", counter);
+        return counter < 2000 ? "loop" : "done";
+      });
+
+  auto shared_sm =
+      std::make_shared<StateMachine>(std::set<std::string>{"done"});
+  shared_sm->add_state("COUNT", counter_state, {{"loop", "COUNT"}});
+
+  std::vector<std::shared_ptr<StateMachineInstance>> instances;
+  for (int i = 0; i < 4; ++i) {
+    auto instance_blackboard = std::make_shared<blackboard::Blackboard>();
+    instance_blackboard->set<int>("counter", 0);
+    instances.push_back(
+        std::make_shared<StateMachineInstance>(shared_sm, instance_blackboard));
+  }
+
+  std::atomic<int> running{(int)instances.size()};
+  std::vector<std::thread> threads;
+  for (auto &instance : instances) {
+    threads.emplace_back([&running, instance]() {
+      (*instance)();
+      running--;
+    });
+  }
+
+  // Each validation publishes a new table, the running instances keep theirs
+  while (running.load() > 0) {
+    shared_sm->validate(true);
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (auto &instance : instances) {
+    EXPECT_TRUE(instance->is_completed());
+    EXPECT_EQ(instance->get_blackboard()->get<int>("counter"), 2000);
+  }
+}
+
+TEST_F(TestStateMachine, TestResume) {
+  std::vector<std::string> start_states;
+  sm->add_start_cb([&start_states](std::shared_ptr<blackboard::Blackboard>,
+                                   const std::string &start_state,
+                                   const std::vector<std::string> &) {
+    start_states.push_back(start_state);
+  });
+
+  EXPECT_EQ(sm->resume(blackboard, "BAR"), "outcome4");
+  EXPECT_EQ(start_states, (std::vector<std::string>{"BAR"}));
+  EXPECT_EQ(sm->get_current_state(), "");
+
+  // The next execution starts from the start state again
+  StateMachineInstance instance(sm, blackboard);
+  EXPECT_EQ(instance.execute(), "outcome4");
+  EXPECT_EQ(start_states, (std::vector<std::string>{"BAR", "FOO"}));
+
+  EXPECT_EQ(instance.resume("BAR"), "outcome4");
+  EXPECT_THROW(sm->resume(blackboard, "BAZ"), std::invalid_argument);
+  EXPECT_THROW(instance.resume("BAZ"), std::invalid_argument);
+}
+
+TEST_F(TestStateMachine, TestCancelInstance) {
+  auto wait_state = std::make_shared<CbState>(
+      std::set<std::string>{"loop"},
+      [](std::shared_ptr<blackboard::Blackboard> blackboard) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return "loop";
+      });
+
+  auto loop_sm =
+      std::make_shared<StateMachine>(std::set<std::string>{"outcome"});
+  loop_sm->add_state("WAIT", wait_state, {{"loop", "WAIT"}});
+
+  StateMachineInstance instance(loop_sm);
+  std::thread thread([&instance]() {
+    EXPECT_THROW(instance.execute(), std::runtime_error);
+  });
+
+  while (instance.get_current_state().empty()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  EXPECT_EQ(instance.get_current_state(), "WAIT");
+  instance.cancel();
+  thread.join();
+
+  EXPECT_TRUE(instance.is_canceled());
+  EXPECT_TRUE(loop_sm->is_idle());
+}
+
+TEST_F(TestStateMachine, TestCancelSharedConcurrence) {
+  auto concurrence = std::make_shared<Concurrence>(
+      std::map<std::string, std::shared_ptr<State>>{
+          {"A", std::make_shared<WaitState>()},
+          {"B", std::make_shared<WaitState>()}},
+      "canceled",
+      Concurrence::OutcomeMap{{"done", {{"A", "done"}, {"B", "done"}}}});
+
+  auto shared_sm = std::make_shared<StateMachine>(
+      std::set<std::string>{"done", "canceled"});
+  shared_sm->add_state("CONCURRENCE", concurrence);
+
+  StateMachineInstance canceled_instance(shared_sm);
+  StateMachineInstance other_instance(shared_sm);
+  std::string canceled_outcome;
+  std::string other_outcome;
+
+  std::thread canceled_thread([&canceled_instance, &canceled_outcome]() {
+    canceled_outcome = canceled_instance.execute();
+  });
+  std::thread other_thread([&other_instance, &other_outcome]() {
+    other_outcome = other_instance.execute();
+  });
+
+  while (canceled_instance.get_current_state().empty() ||
+         other_instance.get_current_state().empty()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // Only the branches of the canceled instance are canceled
+  canceled_instance.cancel();
+  canceled_thread.join();
+  other_thread.join();
+
+  EXPECT_EQ(canceled_outcome, "canceled");
+  EXPECT_TRUE(canceled_instance.is_canceled());
+  EXPECT_EQ(other_outcome, "done");
+  EXPECT_TRUE(other_instance.is_completed());
+}
+
+TEST_F(TestStateMachine, TestRemappings) {
+  auto copy_state = std::make_shared<CbState>(
+      std::set<std::string>{"done"},
+      [](std::shared_ptr<blackboard::Blackboard> blackboard) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        blackboard->set<int>("output", blackboard->get<int>("input") + 1);
+        return "done";
+      });
+
+  // Nested remappings are composed: input -> value -> a_in
+  auto create_branch = [&copy_state](const std::string &name) {
+    auto inner_sm =
+        std::make_shared<StateMachine>(std::set<std::string>{"done"});
+    inner_sm->add_state("COPY", copy_state, {},
+                        {{"input", "value"}, {"output", "result"}});
+
+    auto branch_sm =
+        std::make_shared<StateMachine>(std::set<std::string>{"done"});
+    branch_sm->add_state("INNER", inner_sm, {},
+                         {{"value", name + "_in"}, {"result", name + "_out"}});
+    return branch_sm;
+  };
+
+  // Each branch runs with its own remappings at the same time
+  auto concurrence = std::make_shared<Concurrence>(
+      std::map<std::string, std::shared_ptr<State>>{{"A", create_branch("a")},
+                                                    {"B", create_branch("b")}},
+      "done", Concurrence::OutcomeMap{});
+
+  auto root_sm = std::make_shared<StateMachine>(std::set<std::string>{"done"});
+  root_sm->add_state("CONCURRENCE", concurrence);
+
+  blackboard->set<int>("a_in", 10);
+  blackboard->set<int>("b_in", 20);
+  EXPECT_EQ((*root_sm)(blackboard), "done");
+
+  EXPECT_EQ(blackboard->get<int>("a_out"), 11);
+  EXPECT_EQ(blackboard->get<int>("b_out"), 21);
+  EXPECT_FALSE(blackboard->contains("output"));
+  EXPECT_TRUE(blackboard->get_remappings().empty());
+}
+
+TEST_F(TestStateMachine, TestRemappingsReusedInstance) {
+  auto copy_state = std::make_shared<CbState>(
+      std::set<std::string>{"done"},
+      [](std::shared_ptr<blackboard::Blackboard> blackboard) {
+        blackboard->set<int>("output", blackboard->get<int>("input") + 1);
+        return "done";
+      });
+
+  auto copy_sm = std::make_shared<StateMachine>(std::set<std::string>{"done"});
+  copy_sm->add_state("COPY", copy_state, {},
+                     {{"input", "value"}, {"output", "result"}});
+
+  // The views kept by the instance read the values of each run
+  StateMachineInstance instance(copy_sm, blackboard);
+
+  for (int i = 0; i < 3; ++i) {
+    blackboard->set<int>("value", i);
+    EXPECT_EQ(instance.execute(), "done");
+    EXPECT_EQ(blackboard->get<int>("result"), i + 1);
+  }
+
+  EXPECT_FALSE(blackboard->contains("output"));
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
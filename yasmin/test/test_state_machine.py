@@ -15,7 +15,7 @@
 
 
 import unittest
-from yasmin import StateMachine, State
+from yasmin import StateMachine, StateMachineInstance, State, Blackboard
 
 
 class FooState(State):
@@ -76,6 +76,14 @@ class TestStateMachine(unittest.TestCase):
         self.assertTrue(isinstance(self.sm.get_states()["FOO"]["state"], FooState))
         self.assertTrue(isinstance(self.sm.get_states()["BAR"]["state"], BarState))
 
+    def test_instance_call(self):
+        blackboard = Blackboard()
+        instance = StateMachineInstance(self.sm, blackboard)
+        self.assertEqual("outcome4", instance())
+        self.assertTrue(instance.is_completed())
+        self.assertEqual("", instance.get_current_state())
+        self.assertEqual("Counter: 3", instance.get_blackboard()["foo_str"])
+
     def test_get_start_state(self):
         self.assertEqual("FOO", self.sm.get_start_state())
         self.sm.set_start_state("BAR")
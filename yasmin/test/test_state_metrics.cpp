@@ -0,0 +1,232 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/state.hpp"
+#include "yasmin/state_machine.hpp"
+#include "yasmin/state_machine_instance.hpp"
+#include "yasmin/state_metrics.hpp"
+
+using namespace yasmin;
+
+class FooState : public State {
+private:
+  int counter;
+
+public:
+  FooState() : State({"outcome1", "outcome2"}), counter(0) {}
+
+  std::string
+  execute(std::shared_ptr<blackboard::Blackboard> blackboard) override {
+    (void)blackboard;
+    if (counter < 3) {
+      counter++;
+      return "outcome1";
+    } else {
+      counter = 0;
+      return "outcome2";
+    }
+  }
+};
+
+class SleepState : public State {
+public:
+  SleepState() : State({"outcome2"}) {}
+
+  std::string
+  execute(std::shared_ptr<blackboard::Blackboard> blackboard) override {
+    (void)blackboard;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    return "outcome2";
+  }
+};
+
+class TestLatencyHistogram : public ::testing::Test {
+protected:
+  LatencyHistogram histogram;
+};
+
+TEST_F(TestLatencyHistogram, TestEmpty) {
+  EXPECT_EQ(histogram.get_count(), 0);
+  EXPECT_EQ(histogram.get_min(), 0);
+  EXPECT_EQ(histogram.get_max(), 0);
+  EXPECT_EQ(histogram.get_mean(), 0.0);
+  EXPECT_EQ(histogram.get_quantile(0.99), 0);
+}
+
+TEST_F(TestLatencyHistogram, TestBuckets) {
+  // Each value falls in a bucket whose bounds are within the relative error
+  for (std::uint64_t value : std::vector<std::uint64_t>{
+           0, 1, 31, 32, 63, 64, 1000, 123456789,
+           LatencyHistogram::MAX_VALUE}) {
+    int bucket = LatencyHistogram::get_bucket(value);
+    EXPECT_LT(bucket, LatencyHistogram::NUM_BUCKETS);
+
+    std::uint64_t upper = LatencyHistogram::get_bucket_upper_bound(bucket);
+    EXPECT_GE(upper, value);
+    EXPECT_LE(upper - value, value / LatencyHistogram::SUB_BUCKETS);
+
+    if (bucket > 0) {
+      EXPECT_LT(LatencyHistogram::get_bucket_upper_bound(bucket - 1), value);
+    }
+  }
+
+  EXPECT_EQ(LatencyHistogram::get_bucket(LatencyHistogram::MAX_VALUE),
+            LatencyHistogram::NUM_BUCKETS - 1);
+}
+
+TEST_F(TestLatencyHistogram, TestQuantiles) {
+  for (std::uint64_t i = 1; i <= 1000; ++i) {
+    histogram.record(i * 1000);
+  }
+
+  EXPECT_EQ(histogram.get_count(), 1000);
+  EXPECT_EQ(histogram.get_min(), 1000);
+  EXPECT_EQ(histogram.get_max(), 1000000);
+  EXPECT_DOUBLE_EQ(histogram.get_mean(), 500500.0);
+
+  EXPECT_NEAR(histogram.get_quantile(0.5), 500000, 500000 / 32);
+  EXPECT_NEAR(histogram.get_quantile(0.99), 990000, 990000 / 32);
+  EXPECT_EQ(histogram.get_quantile(1.0), 1000000);
+
+  EXPECT_THROW(histogram.get_quantile(1.5), std::invalid_argument);
+}
+
+TEST_F(TestLatencyHistogram, TestConcurrentRecord) {
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([this]() {
+      for (int j = 0; j < 10000; ++j) {
+        histogram.record(std::uint64_t(j));
+      }
+    });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(histogram.get_count(), 40000);
+  EXPECT_EQ(histogram.get_max(), 9999);
+
+  histogram.reset();
+  EXPECT_EQ(histogram.get_count(), 0);
+  EXPECT_EQ(histogram.get_quantile(0.5), 0);
+}
+
+class TestStateMetrics : public ::testing::Test {
+protected:
+  std::shared_ptr<StateMachine> sm;
+
+  void SetUp() override {
+    StateMetricsRegistry::reset();
+    StateMetricsRegistry::set_enabled(true);
+
+    auto nested_sm =
+        std::make_shared<StateMachine>(std::set<std::string>{"outcome4"});
+    nested_sm->add_state("SLEEP", std::make_shared<SleepState>(),
+                         {{"outcome2", "outcome4"}});
+
+    sm = std::make_shared<StateMachine>(
+        "ROOT", std::set<std::string>{"outcome4", "outcome5"});
+    sm->add_state("FOO", std::make_shared<FooState>(),
+                  {{"outcome1", "NESTED"}, {"outcome2", "outcome5"}});
+    sm->add_state("NESTED", nested_sm, {{"outcome4", "FOO"}});
+  }
+
+  void TearDown() override { StateMetricsRegistry::set_enabled(false); }
+};
+
+TEST_F(TestStateMetrics, TestDisabled) {
+  StateMetricsRegistry::set_enabled(false);
+  EXPECT_EQ(sm->execute(), "outcome5");
+
+  const StateMetrics *metrics = StateMetricsRegistry::find_metrics("ROOT/FOO");
+  EXPECT_TRUE(metrics == nullptr || metrics->get_latency().get_count() == 0);
+}
+
+TEST_F(TestStateMetrics, TestExecute) {
+  EXPECT_EQ(sm->execute(), "outcome5");
+
+  const StateMetrics *foo = StateMetricsRegistry::find_metrics("ROOT/FOO");
+  ASSERT_NE(foo, nullptr);
+  EXPECT_EQ(foo->get_latency().get_count(), 4);
+  EXPECT_EQ(foo->get_outcome_counts(),
+            (std::map<std::string, std::uint64_t>{{"outcome1", 3},
+                                                  {"outcome2", 1}}));
+
+  // Nested state machines are keyed by their path in the parent
+  const StateMetrics *sleep =
+      StateMetricsRegistry::find_metrics("ROOT/NESTED/SLEEP");
+  ASSERT_NE(sleep, nullptr);
+  EXPECT_EQ(sleep->get_latency().get_count(), 3);
+  EXPECT_GE(sleep->get_latency().get_quantile(0.5), 2000000);
+
+  const StateMetrics *nested = StateMetricsRegistry::find_metrics("ROOT/NESTED");
+  ASSERT_NE(nested, nullptr);
+  EXPECT_EQ(nested->get_outcome_counts().at("outcome4"), 3);
+  EXPECT_GE(nested->get_latency().get_min(),
+            sleep->get_latency().get_min());
+
+  const StateMetrics *root = StateMetricsRegistry::find_metrics("ROOT");
+  ASSERT_NE(root, nullptr);
+  EXPECT_EQ(root->get_outcome_counts().at("outcome5"), 1);
+}
+
+TEST_F(TestStateMetrics, TestInstance) {
+  StateMachineInstance instance(sm);
+  EXPECT_EQ(instance.execute(), "outcome5");
+
+  const StateMetrics *sleep =
+      StateMetricsRegistry::find_metrics("ROOT/NESTED/SLEEP");
+  ASSERT_NE(sleep, nullptr);
+  EXPECT_EQ(sleep->get_latency().get_count(), 3);
+  EXPECT_EQ(StateMetricsRegistry::find_metrics("ROOT")
+                ->get_latency()
+                .get_count(),
+            1);
+}
+
+TEST_F(TestStateMetrics, TestOpenMetrics) {
+  sm->execute();
+
+  std::string text = StateMetricsRegistry::to_openmetrics();
+
+  EXPECT_NE(text.find("# TYPE yasmin_state_duration_seconds summary"),
+            std::string::npos);
+  EXPECT_NE(text.find("yasmin_state_duration_seconds{state=\"ROOT/FOO\","
+                      "quantile=\"0.99\"}"),
+            std::string::npos);
+  EXPECT_NE(text.find("yasmin_state_duration_seconds_count{state=\"ROOT/"
+                      "NESTED/SLEEP\"} 3"),
+            std::string::npos);
+  EXPECT_NE(text.find("yasmin_state_outcomes_total{state=\"ROOT/FOO\","
+                      "outcome=\"outcome1\"} 3"),
+            std::string::npos);
+  EXPECT_EQ(text.substr(text.size() - 6), "# EOF\n");
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
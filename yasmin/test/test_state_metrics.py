@@ -0,0 +1,122 @@
+# Copyright (C) 2025 Miguel Ángel González Santamarta
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+import time
+import unittest
+from yasmin import StateMachine, StateMachineInstance, State
+from yasmin.state_metrics import (
+    set_metrics_enabled,
+    is_metrics_enabled,
+    find_state_metrics,
+    get_state_paths,
+    reset_metrics,
+    to_openmetrics,
+)
+
+
+class FooState(State):
+    def __init__(self):
+        super().__init__(["outcome1", "outcome2"])
+        self.counter = 0
+
+    def execute(self, blackboard):
+        if self.counter < 3:
+            self.counter += 1
+            return "outcome1"
+
+        else:
+            self.counter = 0
+            return "outcome2"
+
+
+class SleepState(State):
+    def __init__(self):
+        super().__init__(["outcome2"])
+
+    def execute(self, blackboard):
+        time.sleep(0.002)
+        return "outcome2"
+
+
+class TestStateMetrics(unittest.TestCase):
+
+    def setUp(self):
+        reset_metrics()
+        set_metrics_enabled(True)
+
+        nested_sm = StateMachine(outcomes=["outcome4"])
+        nested_sm.add_state(
+            "SLEEP",
+            SleepState(),
+            transitions={"outcome2": "outcome4"},
+        )
+
+        self.sm = StateMachine(outcomes=["outcome4", "outcome5"])
+        self.sm.set_name("ROOT")
+        self.sm.add_state(
+            "FOO",
+            FooState(),
+            transitions={
+                "outcome1": "NESTED",
+                "outcome2": "outcome5",
+            },
+        )
+        self.sm.add_state(
+            "NESTED",
+            nested_sm,
+            transitions={"outcome4": "FOO"},
+        )
+
+    def tearDown(self):
+        set_metrics_enabled(False)
+
+    def test_enabled(self):
+        self.assertTrue(is_metrics_enabled())
+
+    def test_execute(self):
+        self.assertEqual("outcome5", self.sm())
+
+        foo = find_state_metrics("ROOT/FOO")
+        self.assertIsNotNone(foo)
+        self.assertEqual(4, foo.get_latency().get_count())
+        self.assertEqual({"outcome1": 3, "outcome2": 1}, foo.get_outcome_counts())
+
+        sleep = find_state_metrics("ROOT/NESTED/SLEEP")
+        self.assertIsNotNone(sleep)
+        self.assertEqual(3, sleep.get_latency().get_count())
+        self.assertGreaterEqual(sleep.get_latency().get_quantile(0.99), 2000000)
+
+        self.assertIn("ROOT/NESTED", get_state_paths())
+
+    def test_instance(self):
+        instance = StateMachineInstance(self.sm)
+        self.assertEqual("outcome5", instance.execute())
+
+        self.assertEqual(1, find_state_metrics("ROOT").get_latency().get_count())
+
+    def test_openmetrics(self):
+        self.sm()
+
+        text = to_openmetrics()
+        self.assertIn(
+            'yasmin_state_outcomes_total{state="ROOT/FOO",outcome="outcome1"} 3',
+            text,
+        )
+        self.assertTrue(text.endswith("# EOF\n"))
+
+
+if __name__ == "__main__":
+    unittest.main()
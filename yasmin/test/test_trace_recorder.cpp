@@ -0,0 +1,164 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "yasmin/blackboard/blackboard.hpp"
+#include "yasmin/cb_state.hpp"
+#include "yasmin/concurrence.hpp"
+#include "yasmin/state_machine.hpp"
+#include "yasmin/trace_recorder.hpp"
+
+using namespace yasmin;
+
+std::shared_ptr<State> create_state(const std::string &outcome) {
+  return std::make_shared<CbState>(
+      std::set<std::string>{outcome},
+      [outcome](std::shared_ptr<blackboard::Blackboard> blackboard) {
+        (void)blackboard;
+        return outcome;
+      });
+}
+
+std::size_t count(const std::string &text, const std::string &pattern) {
+  std::size_t n = 0;
+  for (std::size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + 1)) {
+    n++;
+  }
+  return n;
+}
+
+class TestTraceRecorder : public ::testing::Test {
+protected:
+  std::shared_ptr<StateMachine> sm;
+
+  void SetUp() override {
+    auto concurrence = std::make_shared<Concurrence>(
+        std::map<std::string, std::shared_ptr<State>>{
+            {"LEFT", create_state("done")}, {"RIGHT", create_state("done")}},
+        "default",
+        Concurrence::OutcomeMap{
+            {"done", {{"LEFT", "done"}, {"RIGHT", "done"}}}});
+
+    auto nested_sm =
+        std::make_shared<StateMachine>(std::set<std::string>{"outcome4"});
+    nested_sm->add_state("CONCURRENCE", concurrence, {{"done", "outcome4"}});
+
+    sm = std::make_shared<StateMachine>(
+        "ROOT", std::set<std::string>{"outcome5"});
+    sm->add_state("FOO", create_state("outcome1"), {{"outcome1", "NESTED"}});
+    sm->add_state("NESTED", nested_sm, {{"outcome4", "outcome5"}});
+    sm->add_transition_cb(
+        [](std::shared_ptr<blackboard::Blackboard>, const std::string &,
+           const std::string &, const std::string &,
+           const std::vector<std::string> &) {});
+  }
+
+  void TearDown() override {
+    TraceRecorder::stop();
+    TraceRecorder::clear();
+  }
+};
+
+TEST_F(TestTraceRecorder, TestDisabled) {
+  sm->execute();
+  EXPECT_EQ(count(TraceRecorder::to_chrome_json(), "\"ph\""), 0);
+}
+
+TEST_F(TestTraceRecorder, TestExecute) {
+  TraceRecorder::start();
+  EXPECT_TRUE(TraceRecorder::is_enabled());
+  EXPECT_EQ(sm->execute(), "outcome5");
+
+  std::string json = TraceRecorder::to_chrome_json();
+
+  EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0);
+  EXPECT_NE(json.find("\"cat\":\"state_machine\",\"name\":\"ROOT\""),
+            std::string::npos);
+  EXPECT_NE(json.find("\"cat\":\"state\",\"name\":\"FOO\""), std::string::npos);
+  EXPECT_NE(json.find("\"cat\":\"state\",\"name\":\"CONCURRENCE\""),
+            std::string::npos);
+  EXPECT_NE(json.find("\"cat\":\"concurrence\",\"name\":\"LEFT\""),
+            std::string::npos);
+  EXPECT_NE(json.find("\"cat\":\"concurrence\",\"name\":\"RIGHT\""),
+            std::string::npos);
+  EXPECT_NE(json.find("\"cat\":\"transition\",\"name\":\"outcome1\""),
+            std::string::npos);
+  EXPECT_NE(json.find("\"cat\":\"callback\",\"name\":\"transition callback\""),
+            std::string::npos);
+  EXPECT_NE(json.find("\"outcome\":\"outcome5\""), std::string::npos);
+
+  // Nested states are deeper than the state that runs them
+  EXPECT_NE(json.find("\"name\":\"CONCURRENCE\",\"ts\""), std::string::npos);
+  EXPECT_NE(json.find("\"args\":{\"depth\":3}"), std::string::npos);
+
+  // Every begin event has its end event
+  EXPECT_EQ(count(json, "\"ph\":\"B\""), count(json, "\"ph\":\"E\""));
+  EXPECT_EQ(count(json, "\"ph\":\"B\""), 8);
+}
+
+TEST_F(TestTraceRecorder, TestOutputFile) {
+  std::string path = ::testing::TempDir() + "yasmin_trace.json";
+  std::remove(path.c_str());
+
+  TraceOptions options;
+  options.output_path = path;
+  TraceRecorder::start(options);
+  sm->execute();
+
+  std::ifstream file(path);
+  ASSERT_TRUE(file.good());
+  std::stringstream content;
+  content << file.rdbuf();
+
+  EXPECT_EQ(content.str(), TraceRecorder::to_chrome_json());
+  std::remove(path.c_str());
+}
+
+TEST_F(TestTraceRecorder, TestDroppedEvents) {
+  TraceOptions options;
+  options.events_per_thread = 4;
+  TraceRecorder::start(options);
+
+  for (int i = 0; i < 10; ++i) {
+    TraceRecorder::record('i', TraceRecorder::STATE_EVENT, "event");
+  }
+
+  EXPECT_EQ(TraceRecorder::get_dropped_events(), 6);
+  EXPECT_NE(TraceRecorder::to_chrome_json().find("\"dropped_events\":\"6\""),
+            std::string::npos);
+}
+
+TEST_F(TestTraceRecorder, TestClear) {
+  TraceRecorder::start();
+  TraceRecorder::record('i', TraceRecorder::STATE_EVENT, "event");
+  TraceRecorder::clear();
+  EXPECT_EQ(count(TraceRecorder::to_chrome_json(), "\"ph\""), 0);
+
+  TraceRecorder::record('i', TraceRecorder::STATE_EVENT, "quote\"d");
+  EXPECT_NE(TraceRecorder::to_chrome_json().find("\"name\":\"quote\\\"d\""),
+            std::string::npos);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,112 @@
+# Copyright (C) 2025 Miguel Ángel González Santamarta
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+import os
+import tempfile
+import unittest
+from yasmin import StateMachine, State
+from yasmin.trace_recorder import (
+    TraceOptions,
+    start_trace,
+    stop_trace,
+    is_trace_enabled,
+    clear_trace,
+    get_dropped_trace_events,
+    to_chrome_json,
+    write_chrome_json,
+)
+
+
+class FooState(State):
+    def __init__(self):
+        super().__init__(["outcome1"])
+
+    def execute(self, blackboard):
+        return "outcome1"
+
+
+class BarState(State):
+    def __init__(self):
+        super().__init__(["outcome2"])
+
+    def execute(self, blackboard):
+        return "outcome2"
+
+
+class TestTraceRecorder(unittest.TestCase):
+
+    def setUp(self):
+        self.sm = StateMachine(outcomes=["outcome4"])
+        self.sm.set_name("ROOT")
+        self.sm.add_state(
+            "FOO",
+            FooState(),
+            transitions={"outcome1": "BAR"},
+        )
+        self.sm.add_state(
+            "BAR",
+            BarState(),
+            transitions={"outcome2": "outcome4"},
+        )
+
+    def tearDown(self):
+        stop_trace()
+        clear_trace()
+
+    def test_disabled(self):
+        self.sm()
+        self.assertFalse(is_trace_enabled())
+        self.assertNotIn('"ph"', to_chrome_json())
+
+    def test_execute(self):
+        start_trace()
+        self.assertTrue(is_trace_enabled())
+        self.assertEqual("outcome4", self.sm())
+
+        json = to_chrome_json()
+        self.assertIn('"cat":"state_machine","name":"ROOT"', json)
+        self.assertIn('"cat":"state","name":"FOO"', json)
+        self.assertIn('"cat":"state","name":"BAR"', json)
+        self.assertIn('"cat":"transition","name":"outcome1"', json)
+        self.assertEqual(json.count('"ph":"B"'), json.count('"ph":"E"'))
+        self.assertEqual(0, get_dropped_trace_events())
+
+    def test_output_file(self):
+        path = os.path.join(tempfile.mkdtemp(), "trace.json")
+
+        options = TraceOptions()
+        options.output_path = path
+        start_trace(options)
+        self.sm()
+
+        with open(path) as f:
+            self.assertEqual(to_chrome_json(), f.read())
+
+        write_chrome_json(path)
+        with self.assertRaises(RuntimeError):
+            write_chrome_json(os.path.join(path, "trace.json"))
+
+    def test_dropped_events(self):
+        options = TraceOptions()
+        options.events_per_thread = 2
+        start_trace(options)
+        self.sm()
+
+        self.assertGreater(get_dropped_trace_events(), 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
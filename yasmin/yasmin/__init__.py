@@ -22,7 +22,7 @@ from yasmin.state import State
 from yasmin.concurrence import Concurrence
 from yasmin.cb_state import CbState
 from yasmin.blackboard import Blackboard
-from yasmin.state_machine import StateMachine
+from yasmin.state_machine import StateMachine, StateMachineInstance
 from yasmin.logs import (
     LogLevel,
     get_log_level,
@@ -30,6 +30,10 @@ from yasmin.logs import (
     log_level_to_name,
     set_loggers,
     set_default_loggers,
+    LogOverflowPolicy,
+    enable_async_logs,
+    disable_async_logs,
+    flush_logs,
     log_error,
     log_warn,
     log_info,
@@ -161,12 +165,17 @@ __all__ = [
     CbState,
     Blackboard,
     StateMachine,
+    StateMachineInstance,
     get_log_level,
     set_log_level,
     log_level_to_name,
     set_loggers,
     set_default_loggers,
     set_py_loggers,
+    LogOverflowPolicy,
+    enable_async_logs,
+    disable_async_logs,
+    flush_logs,
     YASMIN_LOG_ERROR,
     YASMIN_LOG_WARN,
     YASMIN_LOG_INFO,
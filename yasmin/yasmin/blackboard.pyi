@@ -13,7 +13,7 @@
 # You should have received a copy of the GNU General Public License
 # along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
-from typing import Any, Dict
+from typing import Any, Callable, Dict, List
 
 class Blackboard:
     def __init__(self) -> None: ...
@@ -23,6 +23,8 @@ class Blackboard:
     def get(self, key: str) -> Any: ...
     def __getitem__(self, key: str) -> Any: ...
     def __getattr__(self, name): ...
+    def set_many(self, values: Dict[str, Any]) -> None: ...
+    def get_many(self, keys: List[str]) -> List[Any]: ...
     def remove(self, key: str) -> None: ...
     def __delitem__(self, key: str) -> None: ...
     def contains(self, key: str) -> bool: ...
@@ -33,3 +35,16 @@ class Blackboard:
     def __str__(self) -> str: ...
     def set_remappings(self, remappings: Dict[str, str]) -> None: ...
     def get_remappings(self) -> Dict[str, str]: ...
+    def get_version(self, key: str) -> int: ...
+    def wait_for_change(self, key: str, version: int, timeout: float) -> bool: ...
+    def add_watch(self, key: str, callback: Callable[[str], None]) -> int: ...
+    def remove_watch(self, id: int) -> bool: ...
+    def get_memory_usage(self) -> int: ...
+    def get_key_memory_usage(self, key: str) -> int: ...
+    def set_memory_budget(self, budget: int) -> None: ...
+    def get_memory_budget(self) -> int: ...
+    def set_ttl(self, key: str, ttl: float) -> None: ...
+    def is_stale(self, key: str) -> bool: ...
+    def purge_stale(self) -> int: ...
+    def save_snapshot(self, path: str) -> None: ...
+    def restore_snapshot(self, path: str) -> int: ...
@@ -13,20 +13,51 @@
 # You should have received a copy of the GNU General Public License
 # along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+from enum import Enum
 from typing import Dict
 from yasmin.state import State
 from yasmin.blackboard import Blackboard
 
 class Concurrence(State):
+    class JoinPolicy(Enum):
+        ALL_COMPLETED: int
+        FIRST_COMPLETED: int
+        QUORUM: int
+        FAIL_FAST: int
+
+    class ConflictPolicy(Enum):
+        SHARED: int
+        LAST_WINS: int
+        FIRST_WINS: int
+        FAIL: int
+
+    ALL_COMPLETED: JoinPolicy
+    FIRST_COMPLETED: JoinPolicy
+    QUORUM: JoinPolicy
+    FAIL_FAST: JoinPolicy
+
+    SHARED: ConflictPolicy
+    LAST_WINS: ConflictPolicy
+    FIRST_WINS: ConflictPolicy
+    FAIL: ConflictPolicy
+
     def __init__(
         self,
         states: Dict[str, State],
         default_outcome: str,
         outcome_map: Dict[str, Dict[str, str]],
+        join_policy: JoinPolicy = JoinPolicy.ALL_COMPLETED,
+        quorum: int = 0,
+        fail_fast_outcome: str = "",
+        conflict_policy: ConflictPolicy = ConflictPolicy.SHARED,
     ) -> None: ...
     def get_states(self) -> Dict[str, State]: ...
     def get_outcome_map(self) -> Dict[str, Dict[str, str]]: ...
     def get_default_outcome(self) -> str: ...
+    def get_join_policy(self) -> JoinPolicy: ...
+    def get_quorum(self) -> int: ...
+    def get_fail_fast_outcome(self) -> str: ...
+    def get_conflict_policy(self) -> ConflictPolicy: ...
     def cancel_state(self) -> None: ...
     def to_string(self) -> str: ...
     def __str__(self) -> str: ...
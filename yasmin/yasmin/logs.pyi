@@ -22,6 +22,10 @@ class LogLevel(Enum):
     INFO: int
     DEBUG: int
 
+class LogOverflowPolicy(Enum):
+    DROP: int
+    BLOCK: int
+
 def get_log_level() -> LogLevel: ...
 def set_log_level(level: LogLevel) -> None: ...
 def log_level_to_name(level: LogLevel) -> str: ...
@@ -31,3 +35,11 @@ def log_info(file: str, function: str, line: int, text: str) -> None: ...
 def log_debug(file: str, function: str, line: int, text: str) -> None: ...
 def set_loggers(log_function: Callable[[LogLevel, str, str, int, str], None]) -> None: ...
 def set_default_loggers() -> None: ...
+def enable_async_logs(
+    capacity: int = 1024,
+    overflow_policy: LogOverflowPolicy = LogOverflowPolicy.DROP,
+    flush_interval: float = 0.01,
+) -> None: ...
+def disable_async_logs() -> None: ...
+def flush_logs() -> None: ...
+def is_async_logs_enabled() -> bool: ...
@@ -14,7 +14,7 @@
 # along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 from typing import Callable, Dict, List, Set, overload, Any
-from yasmin.state import State
+from yasmin.state import State, StateStatus
 from yasmin.blackboard import Blackboard
 
 class StateMachine(State):
@@ -53,3 +53,19 @@ class StateMachine(State):
     def to_string(self) -> str: ...
     def __str__(self) -> str: ...
     def __call__(self, blackboard: Blackboard) -> str: ...
+
+class StateMachineInstance:
+    def __init__(
+        self, state_machine: StateMachine, blackboard: Blackboard = None
+    ) -> None: ...
+    def execute(self) -> str: ...
+    def resume(self, state_name: str) -> str: ...
+    def cancel(self) -> None: ...
+    def get_current_state(self) -> str: ...
+    def get_status(self) -> StateStatus: ...
+    def is_idle(self) -> bool: ...
+    def is_running(self) -> bool: ...
+    def is_canceled(self) -> bool: ...
+    def is_completed(self) -> bool: ...
+    def get_blackboard(self) -> Blackboard: ...
+    def __call__(self) -> str: ...
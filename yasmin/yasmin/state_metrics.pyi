@@ -0,0 +1,36 @@
+# Copyright (C) 2025 Miguel Ángel González Santamarta
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+from typing import Dict, List, Optional
+
+class LatencyHistogram:
+    def get_count(self) -> int: ...
+    def get_sum(self) -> int: ...
+    def get_min(self) -> int: ...
+    def get_max(self) -> int: ...
+    def get_mean(self) -> float: ...
+    def get_quantile(self, quantile: float) -> int: ...
+
+class StateMetrics:
+    def get_path(self) -> str: ...
+    def get_latency(self) -> LatencyHistogram: ...
+    def get_outcome_counts(self) -> Dict[str, int]: ...
+
+def set_metrics_enabled(enabled: bool) -> None: ...
+def is_metrics_enabled() -> bool: ...
+def find_state_metrics(path: str) -> Optional[StateMetrics]: ...
+def get_state_paths() -> List[str]: ...
+def reset_metrics() -> None: ...
+def to_openmetrics() -> str: ...
@@ -0,0 +1,28 @@
+# Copyright (C) 2025 Miguel Ángel González Santamarta
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+class TraceOptions:
+    events_per_thread: int
+    output_path: str
+    def __init__(self) -> None: ...
+
+def start_trace(options: TraceOptions = ...) -> None: ...
+def stop_trace() -> None: ...
+def is_trace_enabled() -> bool: ...
+def clear_trace() -> None: ...
+def get_dropped_trace_events() -> int: ...
+def to_chrome_json() -> str: ...
+def write_chrome_json(path: str) -> None: ...
@@ -57,7 +57,7 @@ print_result(std::shared_ptr<yasmin::blackboard::Blackboard> blackboard) {
   }
   ss << "]";
 
-  YASMIN_LOG_INFO(ss.str().c_str());
+  YASMIN_LOG_INFO("%s", ss.str().c_str());
 
   return yasmin_ros::basic_outcomes::SUCCEED;
 }
@@ -141,7 +141,7 @@ public:
     }
     ss << "]";
 
-    YASMIN_LOG_INFO(ss.str().c_str());
+    YASMIN_LOG_INFO("%s", ss.str().c_str());
   };
 };
 
@@ -191,9 +191,9 @@ int main(int argc, char *argv[]) {
   // Execute the state machine
   try {
     std::string outcome = (*sm.get())(blackboard);
-    YASMIN_LOG_INFO(outcome.c_str());
+    YASMIN_LOG_INFO("%s", outcome.c_str());
   } catch (const std::exception &e) {
-    YASMIN_LOG_WARN(e.what());
+    YASMIN_LOG_WARN("%s", e.what());
   }
 
   rclcpp::shutdown();
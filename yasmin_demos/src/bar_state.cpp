@@ -47,7 +47,7 @@ BarState::execute(std::shared_ptr<yasmin::blackboard::Blackboard> blackboard) {
   YASMIN_LOG_INFO("Executing state BAR");
   std::this_thread::sleep_for(std::chrono::seconds(3));
 
-  YASMIN_LOG_INFO(blackboard->get<std::string>("foo_str").c_str());
+  YASMIN_LOG_INFO("%s", blackboard->get<std::string>("foo_str").c_str());
 
   return "outcome3";
 };
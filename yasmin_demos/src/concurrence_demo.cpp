@@ -107,7 +107,7 @@ public:
     std::this_thread::sleep_for(std::chrono::seconds(4));
 
     if (blackboard->contains("foo_str")) {
-      YASMIN_LOG_INFO(blackboard->get<std::string>("foo_str").c_str());
+      YASMIN_LOG_INFO("%s", blackboard->get<std::string>("foo_str").c_str());
     } else {
       YASMIN_LOG_INFO("blackboard does not yet contains 'foo_str'");
     }
@@ -166,9 +166,9 @@ int main(int argc, char *argv[]) {
   // Execute the state machine
   try {
     std::string outcome = (*sm.get())();
-    YASMIN_LOG_INFO(outcome.c_str());
+    YASMIN_LOG_INFO("%s", outcome.c_str());
   } catch (const std::exception &e) {
-    YASMIN_LOG_WARN(e.what());
+    YASMIN_LOG_WARN("%s", e.what());
   }
 
   rclcpp::shutdown();
@@ -60,9 +60,9 @@ int main(int argc, char *argv[]) {
   // Execute the state machine
   try {
     std::string outcome = (*sm.get())();
-    YASMIN_LOG_INFO(outcome.c_str());
+    YASMIN_LOG_INFO("%s", outcome.c_str());
   } catch (const std::exception &e) {
-    YASMIN_LOG_WARN(e.what());
+    YASMIN_LOG_WARN("%s", e.what());
   }
 
   // Shutdown ROS 2
@@ -99,7 +99,7 @@ public:
     YASMIN_LOG_INFO("Executing state BAR");
     std::this_thread::sleep_for(std::chrono::seconds(3));
 
-    YASMIN_LOG_INFO(blackboard->get<std::string>("foo_str").c_str());
+    YASMIN_LOG_INFO("%s", blackboard->get<std::string>("foo_str").c_str());
 
     return "outcome3";
   }
@@ -150,9 +150,9 @@ int main(int argc, char *argv[]) {
   // Execute the state machine
   try {
     std::string outcome = (*sm.get())();
-    YASMIN_LOG_INFO(outcome.c_str());
+    YASMIN_LOG_INFO("%s", outcome.c_str());
   } catch (const std::exception &e) {
-    YASMIN_LOG_WARN(e.what());
+    YASMIN_LOG_WARN("%s", e.what());
   }
 
   rclcpp::shutdown();
@@ -59,7 +59,7 @@ std::string
 print_sum(std::shared_ptr<yasmin::blackboard::Blackboard> blackboard) {
   std::stringstream ss;
   ss << "Sum: " << blackboard->get<int>("sum");
-  YASMIN_LOG_INFO(ss.str().c_str());
+  YASMIN_LOG_INFO("%s", ss.str().c_str());
   return yasmin_ros::basic_outcomes::SUCCEED;
 }
 
@@ -175,9 +175,9 @@ int main(int argc, char *argv[]) {
   // Execute the state machine.
   try {
     std::string outcome = (*sm.get())();
-    YASMIN_LOG_INFO(outcome.c_str());
+    YASMIN_LOG_INFO("%s", outcome.c_str());
   } catch (const std::exception &e) {
-    YASMIN_LOG_WARN(e.what());
+    YASMIN_LOG_WARN("%s", e.what());
   }
 
   rclcpp::shutdown();
@@ -0,0 +1,69 @@
+// Copyright (C) 2025 Miguel Ángel González Santamarta
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#ifndef YASMIN_ROS__MESSAGE_SERIALIZER_HPP
+#define YASMIN_ROS__MESSAGE_SERIALIZER_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "rclcpp/serialization.hpp"
+#include "rclcpp/serialized_message.hpp"
+#include "rosidl_runtime_cpp/traits.hpp"
+#include "yasmin/blackboard/serializer_registry.hpp"
+
+namespace yasmin_ros {
+
+/**
+ * @brief Registers the serializer of a ROS 2 message type, so blackboard
+ * snapshots can store values of the type.
+ *
+ * Messages are stored in their CDR serialized form and the type is named
+ * after the message, like "geometry_msgs/msg/Pose".
+ *
+ * @tparam MsgT The type of the message.
+ */
+template <typename MsgT> void register_message_serializer() {
+  yasmin::blackboard::SerializerRegistry::register_serializer<MsgT>(
+      rosidl_generator_traits::name<MsgT>(),
+      [](const MsgT &msg, std::vector<std::uint8_t> &data) {
+        rclcpp::SerializedMessage serialized_msg;
+        rclcpp::Serialization<MsgT>().serialize_message(&msg, &serialized_msg);
+
+        const rcl_serialized_message_t &rcl_msg =
+            serialized_msg.get_rcl_serialized_message();
+        data.insert(data.end(), rcl_msg.buffer,
+                    rcl_msg.buffer + rcl_msg.buffer_length);
+      },
+      [](const std::uint8_t *data, std::size_t size) {
+        rclcpp::SerializedMessage serialized_msg(size);
+        rcl_serialized_message_t &rcl_msg =
+            serialized_msg.get_rcl_serialized_message();
+        std::memcpy(rcl_msg.buffer, data, size);
+        rcl_msg.buffer_length = size;
+
+        MsgT msg;
+        rclcpp::Serialization<MsgT>().deserialize_message(&serialized_msg,
+                                                          &msg);
+        return msg;
+      });
+}
+
+} // namespace yasmin_ros
+
+#endif // YASMIN_ROS__MESSAGE_SERIALIZER_HPP
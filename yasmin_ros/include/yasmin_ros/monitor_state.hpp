@@ -121,13 +121,11 @@ public:
 
     // set outcomes
     if (timeout > 0) {
-      this->outcomes.insert(basic_outcomes::TIMEOUT);
+      this->add_outcomes({basic_outcomes::TIMEOUT});
     }
 
     if (outcomes.size() > 0) {
-      for (const std::string &outcome : outcomes) {
-        this->outcomes.insert(outcome);
-      }
+      this->add_outcomes(outcomes);
     }
 
     if (node == nullptr) {
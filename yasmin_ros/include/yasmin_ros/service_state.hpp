@@ -199,11 +199,11 @@ public:
         response_timeout(response_timeout), maximum_retry(maximum_retry) {
 
     if (this->wait_timeout > 0 || this->response_timeout > 0) {
-      this->outcomes.insert(basic_outcomes::TIMEOUT);
+      this->add_outcomes({basic_outcomes::TIMEOUT});
     }
 
     if (!outcomes.empty()) {
-      this->outcomes.insert(outcomes.begin(), outcomes.end());
+      this->add_outcomes(outcomes);
     }
 
     // Assign the appropriate ROS 2 node